@@ -0,0 +1,117 @@
+#include <chrono>
+#include <cstdint>
+#include <print>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+import diffusionx;
+
+// 守护进程：绑定套接字并常驻，直到客户端发送关闭请求
+int serve(const std::string &path, const std::string &cache_directory) {
+    auto daemon = SimulationDaemon::bind(path, 0, cache_directory);
+    if (!daemon) {
+        std::println("启动守护进程失败: {}", daemon.error().message);
+        return 1;
+    }
+    std::println("守护进程监听于 {}", path);
+    auto connections = daemon->serve();
+    if (!connections) {
+        std::println("守护进程出错: {}", connections.error().message);
+        return 1;
+    }
+    std::println("守护进程退出，共服务 {} 个连接", *connections);
+    return 0;
+}
+
+// 客户端：对一组参数点提交小作业，流式接收路径并计算矩
+int client(const std::string &path, bool shutdown) {
+    auto connection = DaemonClient::connect(path);
+    for (int attempt = 0; !connection && attempt < 100; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        connection = DaemonClient::connect(path);
+    }
+    if (!connection) {
+        std::println("连接守护进程失败: {}", connection.error().message);
+        return 1;
+    }
+
+    // 参数扫描：不同 Hurst 指数的分数布朗运动路径
+    for (double hurst: {0.3, 0.5, 0.7}) {
+        DaemonJob job;
+        job.process = DaemonProcess::Fbm;
+        job.parameters[0] = hurst;
+        job.parameters[1] = 0.0;
+        job.particles = 100;
+        size_t received = 0;
+        auto stats = connection->paths(job, [&](uint64_t, const vec_pair &) { ++received; });
+        if (!stats) {
+            std::println("作业失败: {}", stats.error().message);
+            return 1;
+        }
+        std::println("H = {}: 收到 {} 条路径，耗时 {} 微秒", hurst, received, stats->elapsed_us);
+    }
+
+    // 矩作业：布朗运动的均方位移，重复提交时命中结果缓存
+    DaemonJob msd;
+    msd.observable = DaemonObservable::RawMoment;
+    msd.parameters[1] = 1.0;
+    msd.duration = 10.0;
+    msd.particles = 1000;
+    for (int repeat = 0; repeat < 2; ++repeat) {
+        auto start = std::chrono::steady_clock::now();
+        auto value = connection->value(msd);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        if (!value) {
+            std::println("作业失败: {}", value.error().message);
+            return 1;
+        }
+        std::println("均方位移: {:.3f}（理论值 20），耗时 {} 微秒", *value, elapsed.count());
+    }
+
+    if (auto status = connection->status()) {
+        std::println("守护进程状态: 作业 {} 个，线程池 {} 个线程，fGn 谱 {} 个，FFTW 计划 {} 个",
+                     status->jobs, status->pool_threads, status->fbm_spectra, status->fbm_plans);
+    }
+    if (shutdown) {
+        if (auto res = connection->shutdown(); !res) {
+            std::println("关闭守护进程失败: {}", res.error().message);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::string mode = argc > 1 ? argv[1] : "demo";
+    std::string path = argc > 2 ? argv[2] : "/tmp/diffusionx.sock";
+    if (mode == "serve") {
+        return serve(path, argc > 3 ? argv[3] : "");
+    }
+    if (mode == "client") {
+        return client(path, false);
+    }
+    if (mode == "shutdown") {
+        auto connection = DaemonClient::connect(path);
+        return connection && connection->shutdown() ? 0 : 1;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    // 演示：子进程运行守护进程，父进程作为客户端
+    pid_t child = fork();
+    if (child == 0) {
+        return serve(path, ".diffusionx-cache");
+    }
+    int code = client(path, true);
+    int status = 0;
+    waitpid(child, &status, 0);
+    return code != 0 ? code : (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+#else
+    std::println("当前平台不支持守护进程示例");
+    return 0;
+#endif
+}
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstdint>
+#include <print>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+import diffusionx;
+
+constexpr SharedEnsembleLayout layout{.slots = 8, .rows = 256, .columns = 64};
+constexpr double duration = 100.0;
+constexpr double time_step = 0.01;
+constexpr int default_wait_seconds = 30;
+
+// 生产者：模拟布朗运动粒子系综，按块写入共享内存；
+// 环形缓冲写满后等待消费者确认，超过 wait_seconds 秒无确认则放弃
+int produce(const std::string &name, int wait_seconds) {
+    auto writer = SharedEnsembleWriter::create(
+        name, layout,
+        {.wait_for_readers = true,
+         .unlink_on_close = false,
+         .reader_timeout = std::chrono::seconds(wait_seconds)});
+    if (!writer) {
+        std::println("创建共享内存失败: {}", writer.error().message);
+        return 1;
+    }
+    Bm bm(0.0, 1.0);
+    auto chunks = stream_ensemble(bm, duration, time_step, *writer);
+    if (!chunks) {
+        std::println("模拟失败: {}", chunks.error().message);
+        return 1;
+    }
+    std::println("生产者发布了 {} 个数据块", *chunks);
+    return 0;
+}
+
+// 消费者：映射共享内存，原地读取数据块并计算系综均方位移；
+// 最多等待 wait_seconds 秒让生产者创建共享内存
+int consume(const std::string &name, int wait_seconds) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(wait_seconds);
+    auto reader = SharedEnsembleReader::open(name);
+    while (!reader && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        reader = SharedEnsembleReader::open(name);
+    }
+    if (!reader) {
+        std::println("打开共享内存失败: {}", reader.error().message);
+        return 1;
+    }
+    // 从环形缓冲中仍保留的最早数据块开始读
+    uint64_t published = reader->published();
+    uint64_t slots = reader->layout().slots;
+    uint64_t first = published > slots ? published - slots : 0;
+    uint64_t index = first;
+    double msd = 0.0;
+    while (true) {
+        auto chunk = reader->wait(index, std::chrono::milliseconds(5000));
+        if (!chunk) {
+            std::println("读取失败: {}", chunk.error().message);
+            return 1;
+        }
+        if (!chunk->has_value()) {
+            break;
+        }
+        const auto &c = **chunk;
+        double sum = 0.0;
+        for (size_t j = 0; j < c.columns; ++j) {
+            double x = c.values[((c.rows - 1) * c.columns) + j];
+            sum += x * x;
+        }
+        if (!reader->validate(c)) {
+            std::println("数据块 {} 在读取时被覆盖", c.index);
+            return 1;
+        }
+        msd = sum / static_cast<double>(c.columns);
+        reader->acknowledge(++index);
+    }
+    std::println("消费者读取了 {} 个数据块，t = {} 时的均方位移: {:.3f}（理论值 {:.3f}）",
+                 index - first, duration, msd, 2.0 * duration);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::string mode = argc > 1 ? argv[1] : "demo";
+    std::string name = argc > 2 ? argv[2] : "/diffusionx_shared_ensemble";
+    int wait_seconds = argc > 3 ? std::stoi(argv[3]) : default_wait_seconds;
+    if (mode == "produce") {
+        return produce(name, wait_seconds);
+    }
+    if (mode == "consume") {
+        int code = consume(name, wait_seconds);
+        SharedEnsembleWriter::remove(name);
+        return code;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    // 演示：父进程生产，子进程消费
+    pid_t child = fork();
+    if (child == 0) {
+        return consume(name, wait_seconds);
+    }
+    int code = produce(name, wait_seconds);
+    int status = 0;
+    waitpid(child, &status, 0);
+    SharedEnsembleWriter::remove(name);
+    return code != 0 ? code : (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+#else
+    std::println("当前平台不支持共享内存示例");
+    return 0;
+#endif
+}
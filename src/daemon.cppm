@@ -0,0 +1,1050 @@
+/**
+ * @file daemon.cppm
+ * @brief Warm simulation daemon and client over a Unix-domain socket
+ *
+ * Short jobs (small ensembles over many parameter points) spend much of
+ * their time on per-process setup: starting worker threads, seeding the
+ * thread-local generators, computing fGn spectra and FFTW plans, opening the
+ * result cache. `SimulationDaemon` keeps all of it resident: it enables the
+ * persistent worker pool, keeps the FBM spectrum and plan cache between jobs
+ * and holds one result cache, and serves job specs sent by
+ * `DaemonClient` over a local socket. Paths are streamed back as they are
+ * simulated.
+ *
+ * Protocol: every message is a `DaemonFrame` header followed by `length`
+ * payload bytes, in native byte order (client and daemon run on the same
+ * machine and library version).
+ * - Submit (client): a `DaemonJob`. The daemon answers with one Path message
+ *   per particle (Paths jobs) or one Value message (moment jobs), then Done,
+ *   or with Failed.
+ * - Status (client): answered by Status with a `DaemonStatus`.
+ * - Shutdown (client): answered by Done; the daemon then stops.
+ *
+ * Supported on POSIX systems (Linux, macOS); elsewhere binding or
+ * connecting returns `Error::NotImplemented`.
+ */
+
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define DIFFUSIONX_HAS_UNIX_SOCKETS 1
+#endif
+
+export module diffusionx.daemon;
+
+import diffusionx.error;
+import diffusionx.parallel;
+import diffusionx.random.normal;
+import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.cache;
+import diffusionx.simulation.basic.utils;
+import diffusionx.simulation.continuous.bm;
+import diffusionx.simulation.continuous.fbm;
+import diffusionx.simulation.continuous.levy;
+import diffusionx.simulation.continuous.ou;
+
+using std::string;
+using std::vector;
+
+/**
+ * @brief Version of the wire protocol, carried in every frame
+ */
+export constexpr uint32_t daemon_protocol_version = 1;
+
+/**
+ * @brief Largest accepted payload (1 GiB)
+ */
+constexpr uint64_t daemon_max_payload = uint64_t{1} << 30;
+
+/**
+ * @brief Largest number of particles of one job
+ */
+export constexpr uint64_t daemon_max_particles = uint64_t{1} << 24;
+
+/**
+ * @brief Largest number of steps duration / time_step of one path
+ *
+ * Keeps a streamed path (two arrays of doubles) well below the payload limit.
+ */
+export constexpr uint64_t daemon_max_steps = uint64_t{1} << 24;
+
+/**
+ * @brief Memory budget of one batch of streamed paths (256 MiB)
+ */
+constexpr uint64_t daemon_batch_bytes = uint64_t{1} << 28;
+
+/**
+ * @brief Message types of the daemon protocol
+ */
+export enum class DaemonMessage : uint16_t {
+    Submit, ///< Client: run a job
+    Status, ///< Client: query, daemon: report of the warm state
+    Shutdown, ///< Client: stop the daemon
+    Path, ///< Daemon: one simulated path
+    Value, ///< Daemon: result of a moment job
+    Done, ///< Daemon: job finished, with its statistics
+    Failed, ///< Daemon: job failed, with the error message
+};
+
+/**
+ * @brief Processes the daemon can simulate
+ *
+ * `DaemonJob::parameters` holds the constructor arguments in order:
+ * - Bm: start_position, diffusion_coefficient
+ * - OrnsteinUhlenbeck: theta, mu, sigma, start_position
+ * - Fbm: hurst, start_position
+ * - Levy: alpha, beta, sigma, mu, start_position
+ */
+export enum class DaemonProcess : uint32_t {
+    Bm,
+    OrnsteinUhlenbeck,
+    Fbm,
+    Levy,
+};
+
+/**
+ * @brief What a job computes
+ */
+export enum class DaemonObservable : uint32_t {
+    Paths, ///< Stream every path back
+    RawMoment, ///< E[X(T)^order]
+    CentralMoment, ///< E[(X(T) - E[X(T)])^order]
+};
+
+/**
+ * @brief Job specification, sent as is over the socket
+ */
+export struct DaemonJob {
+    DaemonProcess process = DaemonProcess::Bm; ///< Process to simulate
+    DaemonObservable observable = DaemonObservable::Paths; ///< Quantity to compute
+    double parameters[5] = {0.0, 0.5, 0.0, 0.0, 0.0}; ///< Constructor arguments
+    double duration = 1.0; ///< Duration T of each path
+    double time_step = 0.01; ///< Time step of the grid
+    uint64_t particles = 1; ///< Number of paths
+    int32_t order = 2; ///< Order of moment jobs
+    uint32_t reserved = 0; ///< Must be zero
+};
+
+/**
+ * @brief Statistics of a finished job
+ */
+export struct DaemonJobStats {
+    uint64_t particles = 0; ///< Paths simulated (0 on a result cache hit)
+    uint64_t elapsed_us = 0; ///< Time spent by the daemon, in microseconds
+    uint32_t cache_hit = 0; ///< 1 if the result came from the result cache
+    uint32_t reserved = 0; ///< Zero
+};
+
+/**
+ * @brief Warm state of a daemon
+ */
+export struct DaemonStatus {
+    uint64_t jobs = 0; ///< Jobs served so far
+    uint64_t pool_threads = 0; ///< Threads of the persistent worker pool
+    uint64_t fbm_spectra = 0; ///< Cached fGn spectra
+    uint64_t fbm_plans = 0; ///< Cached FFTW plans
+    uint64_t cache_hits = 0; ///< Moment jobs answered from the result cache
+    double uptime = 0.0; ///< Seconds since the daemon was bound
+};
+
+/**
+ * @brief Header of every message
+ */
+export struct DaemonFrame {
+    uint32_t version = daemon_protocol_version; ///< daemon_protocol_version
+    DaemonMessage type = DaemonMessage::Done; ///< Message type
+    uint16_t reserved = 0; ///< Zero
+    uint64_t job = 0; ///< Job the message belongs to
+    uint64_t length = 0; ///< Payload bytes that follow
+};
+
+static_assert(std::is_trivially_copyable_v<DaemonJob> &&
+              std::is_trivially_copyable_v<DaemonJobStats> &&
+              std::is_trivially_copyable_v<DaemonStatus> &&
+              std::is_trivially_copyable_v<DaemonFrame>);
+
+/**
+ * @brief A message received by a client
+ */
+export struct DaemonReply {
+    DaemonMessage type = DaemonMessage::Done; ///< Message type
+    uint64_t job = 0; ///< Job the message belongs to
+    uint64_t particle = 0; ///< Particle index (Path)
+    vec_pair path; ///< Times and positions (Path)
+    double value = 0.0; ///< Result (Value)
+    DaemonJobStats stats; ///< Job statistics (Done)
+    DaemonStatus status; ///< Warm state (Status)
+    string message; ///< Error message (Failed)
+};
+
+/**
+ * @brief A socket descriptor, closed on destruction
+ */
+class SocketHandle {
+    int m_fd = -1; ///< Descriptor, or -1
+
+public:
+    SocketHandle() = default;
+
+    explicit SocketHandle(int fd) : m_fd(fd) {
+    }
+
+    SocketHandle(const SocketHandle &) = delete;
+    auto operator=(const SocketHandle &) -> SocketHandle & = delete;
+
+    SocketHandle(SocketHandle &&other) noexcept : m_fd(std::exchange(other.m_fd, -1)) {
+    }
+
+    auto operator=(SocketHandle &&other) noexcept -> SocketHandle & {
+        if (this != &other) {
+            reset();
+            m_fd = std::exchange(other.m_fd, -1);
+        }
+        return *this;
+    }
+
+    ~SocketHandle() {
+        reset();
+    }
+
+    void reset() {
+#if defined(DIFFUSIONX_HAS_UNIX_SOCKETS)
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+#endif
+        m_fd = -1;
+    }
+
+    [[nodiscard]] auto get() const -> int {
+        return m_fd;
+    }
+};
+
+#if defined(DIFFUSIONX_HAS_UNIX_SOCKETS)
+auto unix_address(const string &path) -> Result<sockaddr_un> {
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return Err(Error::InvalidArgument(std::format(
+            "Socket path must have 1 to {} characters, but got '{}'",
+            sizeof(address.sun_path) - 1, path)));
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return Ok(address);
+}
+
+auto socket_write(int fd, const void *data, size_t bytes) -> Result<int> {
+#if defined(MSG_NOSIGNAL)
+    constexpr int flags = MSG_NOSIGNAL;
+#else
+    constexpr int flags = 0;
+#endif
+    const auto *p = static_cast<const char *>(data);
+    while (bytes > 0) {
+        ssize_t n = ::send(fd, p, bytes, flags);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return Err(Error::IoError(std::format("send failed: {}", std::strerror(errno))));
+        }
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return Ok(0);
+}
+
+/**
+ * @brief Reads exactly `bytes` bytes
+ * @return Result containing false on end of stream before the first byte
+ */
+auto socket_read(int fd, void *data, size_t bytes) -> Result<bool> {
+    auto *p = static_cast<char *>(data);
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t n = ::recv(fd, p + done, bytes - done, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n == 0 && done == 0) {
+            return Ok(false);
+        }
+        if (n <= 0) {
+            return Err(Error::IoError(n == 0
+                                          ? string("Connection closed in the middle of a message")
+                                          : std::format("recv failed: {}", std::strerror(errno))));
+        }
+        done += static_cast<size_t>(n);
+    }
+    return Ok(true);
+}
+#endif
+
+auto send_frame(int fd, DaemonMessage type, uint64_t job, std::span<const std::span<const char> > parts)
+    -> Result<int> {
+#if defined(DIFFUSIONX_HAS_UNIX_SOCKETS)
+    DaemonFrame frame;
+    frame.type = type;
+    frame.job = job;
+    for (auto part: parts) {
+        frame.length += part.size();
+    }
+    if (auto res = socket_write(fd, &frame, sizeof(frame)); !res) {
+        return res;
+    }
+    for (auto part: parts) {
+        if (auto res = socket_write(fd, part.data(), part.size()); !res) {
+            return res;
+        }
+    }
+    return Ok(0);
+#else
+    return Err(Error::NotImplemented("Unix-domain sockets are not supported on this platform"));
+#endif
+}
+
+template<typename T>
+auto bytes_of(const T &value) -> std::span<const char> {
+    return {reinterpret_cast<const char *>(&value), sizeof(T)};
+}
+
+/**
+ * @brief Reads one message
+ * @return Result containing the header and payload, None at end of stream,
+ * or an Error
+ */
+auto receive_frame(int fd) -> Result<Option<std::pair<DaemonFrame, string> > > {
+#if defined(DIFFUSIONX_HAS_UNIX_SOCKETS)
+    DaemonFrame frame;
+    auto got = socket_read(fd, &frame, sizeof(frame));
+    if (!got) {
+        return Err(got.error());
+    }
+    if (!got.value()) {
+        return Ok(Option<std::pair<DaemonFrame, string> >(std::nullopt));
+    }
+    if (frame.version != daemon_protocol_version) {
+        return Err(Error::IoError(std::format("Unsupported protocol version {}", frame.version)));
+    }
+    if (frame.length > daemon_max_payload) {
+        return Err(Error::IoError(std::format("Message of {} bytes is too large", frame.length)));
+    }
+    string payload(frame.length, '\0');
+    if (frame.length > 0) {
+        auto body = socket_read(fd, payload.data(), payload.size());
+        if (!body) {
+            return Err(body.error());
+        }
+        if (!body.value()) {
+            return Err(Error::IoError("Connection closed in the middle of a message"));
+        }
+    }
+    return Ok(Option<std::pair<DaemonFrame, string> >(std::pair(frame, std::move(payload))));
+#else
+    return Err(Error::NotImplemented("Unix-domain sockets are not supported on this platform"));
+#endif
+}
+
+/**
+ * @brief Runs one simulation call, turning exceptions into an Error
+ *
+ * Worker threads of `run_placed` must not throw: an exception escaping one
+ * would terminate the daemon.
+ */
+template<typename F>
+auto guarded(F &&f) -> decltype(f()) {
+    try {
+        return f();
+    } catch (const std::exception &e) {
+        return Err(Error::SimulationFailed(std::format("Simulation aborted: {}", e.what())));
+    }
+}
+
+/**
+ * @brief Builds the process of a job
+ */
+auto make_daemon_process(const DaemonJob &job) -> Result<std::unique_ptr<ContinuousProcess> > {
+    const auto *p = job.parameters;
+    try {
+        switch (job.process) {
+            case DaemonProcess::Bm:
+                return Ok(std::unique_ptr<ContinuousProcess>(std::make_unique<Bm>(p[0], p[1])));
+            case DaemonProcess::OrnsteinUhlenbeck:
+                return Ok(std::unique_ptr<ContinuousProcess>(
+                    std::make_unique<OrnsteinUhlenbeck>(p[0], p[1], p[2], p[3])));
+            case DaemonProcess::Fbm:
+                return Ok(std::unique_ptr<ContinuousProcess>(std::make_unique<FBM>(p[0], p[1])));
+            case DaemonProcess::Levy:
+                return Ok(std::unique_ptr<ContinuousProcess>(
+                    std::make_unique<Levy>(p[0], p[1], p[2], p[3], p[4])));
+        }
+    } catch (const std::invalid_argument &e) {
+        return Err(Error::InvalidArgument(e.what()));
+    }
+    return Err(Error::InvalidArgument(
+        std::format("Unknown process {}", static_cast<uint32_t>(job.process))));
+}
+
+/**
+ * @brief Describes a moment job for the result cache
+ */
+auto daemon_job_key(const DaemonJob &job) -> JobKey {
+    auto key = JobKey("daemon.moment")
+            .add("process", static_cast<uint32_t>(job.process))
+            .add("observable", static_cast<uint32_t>(job.observable))
+            .add("parameters", std::span<const double>(job.parameters))
+            .add("duration", job.duration)
+            .add("time_step", job.time_step)
+            .add("particles", job.particles)
+            .add("order", job.order);
+    return key;
+}
+
+/**
+ * @brief Local simulation server keeping its setup warm between jobs
+ *
+ * Each connection is served by its own thread and may submit any number of
+ * jobs, one after the other. Jobs run on the persistent worker pool; jobs of
+ * other connections running at the same time use their own threads.
+ *
+ * Example:
+ * @code
+ * auto daemon = SimulationDaemon::bind("/tmp/diffusionx.sock");
+ * daemon->serve(); // until a client sends Shutdown
+ * @endcode
+ */
+export class SimulationDaemon {
+    SocketHandle m_listener; ///< Listening socket
+    string m_path; ///< Socket path, removed on destruction
+    size_t m_workers; ///< Workers per job
+    std::unique_ptr<ResultCache> m_cache; ///< Result cache of moment jobs, if any
+    std::chrono::steady_clock::time_point m_started; ///< When the daemon was bound
+    std::unique_ptr<std::atomic<bool> > m_stop; ///< Set to stop serving
+    std::unique_ptr<std::atomic<uint64_t> > m_jobs; ///< Jobs served
+    std::unique_ptr<std::atomic<uint64_t> > m_cache_hits; ///< Result cache hits
+
+    SimulationDaemon(SocketHandle listener, string path, size_t workers,
+                     std::unique_ptr<ResultCache> cache)
+        : m_listener(std::move(listener)), m_path(std::move(path)), m_workers(workers),
+          m_cache(std::move(cache)), m_started(std::chrono::steady_clock::now()),
+          m_stop(std::make_unique<std::atomic<bool> >(false)),
+          m_jobs(std::make_unique<std::atomic<uint64_t> >(0)),
+          m_cache_hits(std::make_unique<std::atomic<uint64_t> >(0)) {
+    }
+
+    [[nodiscard]] auto status() const -> DaemonStatus {
+        auto [spectra, plans] = fbm_cache_entries();
+        DaemonStatus s;
+        s.jobs = m_jobs->load();
+        s.pool_threads = persistent_worker_count();
+        s.fbm_spectra = spectra;
+        s.fbm_plans = plans;
+        s.cache_hits = m_cache_hits->load();
+        s.uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count();
+        return s;
+    }
+
+    auto run_paths(int fd, uint64_t id, const DaemonJob &job, ContinuousProcess &process) -> Result<int> {
+        // Simulate a batch in parallel, then stream it while the next one waits
+        auto steps = static_cast<uint64_t>(std::ceil(job.duration / job.time_step)) + 1;
+        size_t batch = std::clamp<uint64_t>(daemon_batch_bytes / (2 * sizeof(double) * steps), 1,
+                                            std::max<size_t>(1, 4 * m_workers));
+        vector<Result<vec_pair> > paths;
+        for (uint64_t first = 0; first < job.particles; first += batch) {
+            size_t count = std::min<uint64_t>(batch, job.particles - first);
+            paths.assign(count, Err(Error::SimulationFailed("Path was not simulated")));
+            run_placed(count, m_workers, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    paths[i] = guarded([&] { return process.simulate(job.duration, job.time_step); });
+                }
+            });
+            for (size_t i = 0; i < count; ++i) {
+                if (!paths[i]) {
+                    return Err(paths[i].error());
+                }
+                const auto &[t, x] = paths[i].value();
+                uint64_t header[2] = {first + i, t.size()};
+                std::span<const char> parts[] = {
+                    bytes_of(header),
+                    {reinterpret_cast<const char *>(t.data()), t.size() * sizeof(double)},
+                    {reinterpret_cast<const char *>(x.data()), x.size() * sizeof(double)},
+                };
+                if (auto res = send_frame(fd, DaemonMessage::Path, id, parts); !res) {
+                    return res;
+                }
+            }
+        }
+        return Ok(0);
+    }
+
+    auto run_moment(const DaemonJob &job, ContinuousProcess &process) -> Result<double> {
+        if (job.order < 0) {
+            return Err(Error::InvalidArgument("The order must be non-negative"));
+        }
+        vector<double> ends(job.particles);
+        std::mutex mutex;
+        Option<Error> error;
+        std::atomic<bool> failed{false};
+        run_placed(job.particles, m_workers, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end && !failed.load(std::memory_order_relaxed); ++i) {
+                auto value = guarded([&] { return process.end(job.duration, job.time_step); });
+                if (!value) {
+                    std::lock_guard lock(mutex);
+                    if (!error.has_value()) {
+                        error = value.error();
+                    }
+                    failed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                ends[i] = value.value();
+            }
+        });
+        if (error.has_value()) {
+            return Err(std::move(error.value()));
+        }
+        double center = 0.0;
+        if (job.observable == DaemonObservable::CentralMoment) {
+            for (double x: ends) {
+                center += x;
+            }
+            center /= static_cast<double>(ends.size());
+        }
+        double sum = 0.0;
+        for (double x: ends) {
+            sum += std::pow(x - center, job.order);
+        }
+        return Ok(sum / static_cast<double>(ends.size()));
+    }
+
+    auto run_job(int fd, uint64_t id, const DaemonJob &job) -> Result<int> {
+        auto started = std::chrono::steady_clock::now();
+        DaemonJobStats stats;
+        if (!std::isfinite(job.duration) || !std::isfinite(job.time_step) ||
+            job.duration <= 0 || job.time_step <= 0) {
+            return Err(Error::InvalidArgument("Duration and time step must be positive and finite"));
+        }
+        if (job.duration / job.time_step > static_cast<double>(daemon_max_steps)) {
+            return Err(Error::InvalidArgument(std::format(
+                "A path may have at most {} steps", daemon_max_steps)));
+        }
+        if (!std::ranges::all_of(job.parameters, [](double p) { return std::isfinite(p); })) {
+            return Err(Error::InvalidArgument("Process parameters must be finite"));
+        }
+        if (job.particles == 0 || job.particles > daemon_max_particles) {
+            return Err(Error::InvalidArgument(std::format(
+                "The number of particles must be between 1 and {}", daemon_max_particles)));
+        }
+        auto process = make_daemon_process(job);
+        if (!process) {
+            return Err(process.error());
+        }
+        if (job.observable == DaemonObservable::Paths) {
+            if (auto res = run_paths(fd, id, job, *process.value()); !res) {
+                return res;
+            }
+            stats.particles = job.particles;
+        } else if (job.observable == DaemonObservable::RawMoment ||
+                   job.observable == DaemonObservable::CentralMoment) {
+            auto key = daemon_job_key(job);
+            Option<double> value;
+            if (m_cache) {
+                if (auto cached = m_cache->get_values(key); cached && cached->size() == 1) {
+                    value = cached->front();
+                    stats.cache_hit = 1;
+                    m_cache_hits->fetch_add(1);
+                }
+            }
+            if (!value.has_value()) {
+                auto computed = run_moment(job, *process.value());
+                if (!computed) {
+                    return Err(computed.error());
+                }
+                value = computed.value();
+                stats.particles = job.particles;
+                if (m_cache) {
+                    // A failed store only costs a recomputation next time
+                    (void) m_cache->put_values(key, std::span<const double>(&computed.value(), 1));
+                }
+            }
+            if (auto res = send_frame(fd, DaemonMessage::Value, id,
+                                      std::array{bytes_of(value.value())}); !res) {
+                return res;
+            }
+        } else {
+            return Err(Error::InvalidArgument(
+                std::format("Unknown observable {}", static_cast<uint32_t>(job.observable))));
+        }
+        stats.elapsed_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started).count());
+        m_jobs->fetch_add(1);
+        return send_frame(fd, DaemonMessage::Done, id, std::array{bytes_of(stats)});
+    }
+
+    void serve_connection(int fd) {
+        while (!m_stop->load()) {
+            auto received = receive_frame(fd);
+            if (!received || !received->has_value()) {
+                return;
+            }
+            auto &[frame, payload] = received->value();
+            Result<int> res = Ok(0);
+            switch (frame.type) {
+                case DaemonMessage::Submit: {
+                    if (payload.size() != sizeof(DaemonJob)) {
+                        res = Err(Error::InvalidArgument("Malformed job"));
+                        break;
+                    }
+                    DaemonJob job;
+                    std::memcpy(&job, payload.data(), sizeof(job));
+                    // A job must never take the daemon down, whatever it asks for
+                    try {
+                        res = run_job(fd, frame.job, job);
+                    } catch (const std::exception &e) {
+                        res = Err(Error::SimulationFailed(std::format("Job aborted: {}", e.what())));
+                    }
+                    break;
+                }
+                case DaemonMessage::Status: {
+                    auto s = status();
+                    res = send_frame(fd, DaemonMessage::Status, frame.job, std::array{bytes_of(s)});
+                    break;
+                }
+                case DaemonMessage::Shutdown: {
+                    DaemonJobStats stats;
+                    (void) send_frame(fd, DaemonMessage::Done, frame.job, std::array{bytes_of(stats)});
+                    stop();
+                    return;
+                }
+                default:
+                    res = Err(Error::InvalidArgument(std::format(
+                        "Unexpected message {}", static_cast<uint16_t>(frame.type))));
+                    break;
+            }
+            if (!res) {
+                auto &message = res.error().message;
+                if (!send_frame(fd, DaemonMessage::Failed, frame.job,
+                                std::array{std::span<const char>(message.data(), message.size())})) {
+                    return;
+                }
+            }
+        }
+    }
+
+public:
+    SimulationDaemon(SimulationDaemon &&) noexcept = default;
+    auto operator=(SimulationDaemon &&) noexcept -> SimulationDaemon & = default;
+
+    ~SimulationDaemon() {
+#if defined(DIFFUSIONX_HAS_UNIX_SOCKETS)
+        if (m_listener.get() >= 0) {
+            ::unlink(m_path.c_str());
+        }
+#endif
+    }
+
+    /**
+     * @brief Binds a daemon to a socket path and warms it up
+     * @param path Filesystem path of the socket; an existing socket is
+     * replaced, any other existing file is an error
+     * @param workers Worker threads per job (0: default_workers())
+     * @param cache_directory Directory of the result cache for moment jobs,
+     * or empty to run without one
+     * @return Result containing the daemon, or an Error
+     *
+     * Enables the persistent worker pool for the whole process, starts its
+     * threads and seeds their normal generators.
+     */
+    static auto bind(const string &path, size_t workers = 0, const string &cache_directory = "")
+        -> Result<SimulationDaemon> {
+#if defined(DIFFUSIONX_HAS_UNIX_SOCKETS)
+        auto address = unix_address(path);
+        if (!address) {
+            return Err(address.error());
+        }
+        SocketHandle listener(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (listener.get() < 0) {
+            return Err(Error::IoError(std::format("socket failed: {}", std::strerror(errno))));
+        }
+        struct stat existing{};
+        if (::lstat(path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                return Err(Error::IoError(
+                    std::format("Cannot listen on '{}': the file exists and is not a socket", path)));
+            }
+            ::unlink(path.c_str());
+        }
+        if (::bind(listener.get(), reinterpret_cast<const sockaddr *>(&address.value()),
+                   sizeof(sockaddr_un)) != 0 ||
+            ::listen(listener.get(), 16) != 0) {
+            return Err(Error::IoError(
+                std::format("Cannot listen on '{}': {}", path, std::strerror(errno))));
+        }
+        std::unique_ptr<ResultCache> cache;
+        if (!cache_directory.empty()) {
+            cache = std::make_unique<ResultCache>(cache_directory);
+        }
+        workers = workers == 0 ? default_workers() : workers;
+        set_persistent_workers(true);
+        if (auto warm = randn(workers * 1024, 0.0, 1.0); !warm) {
+            return Err(warm.error());
+        }
+        return Ok(SimulationDaemon(std::move(listener), path, workers, std::move(cache)));
+#else
+        return Err(Error::NotImplemented("Unix-domain sockets are not supported on this platform"));
+#endif
+    }
+
+    /**
+     * @brief Gets the socket path
+     * @return The socket path
+     */
+    [[nodiscard]] auto get_path() const -> const string & {
+        return m_path;
+    }
+
+    /**
+     * @brief Serves connections until a client sends Shutdown or `stop` is called
+     * @return Result containing the number of connections served, or an Error
+     *
+     * Threads of closed connections are joined while serving, so a
+     * long-running daemon only holds threads of open connections.
+     */
+    auto serve() -> Result<size_t> {
+#if defined(DIFFUSIONX_HAS_UNIX_SOCKETS)
+        struct Connection {
+            size_t id; ///< Sequence number of the connection
+            std::thread thread; ///< Thread serving it
+        };
+        std::mutex mutex;
+        vector<int> open;
+        vector<size_t> finished; // Connections whose thread is about to return
+        vector<Connection> threads;
+        size_t connections = 0;
+        auto reap = [&] {
+            vector<size_t> done;
+            {
+                std::lock_guard lock(mutex);
+                done.swap(finished);
+            }
+            for (size_t id: done) {
+                auto it = std::ranges::find(threads, id, &Connection::id);
+                it->thread.join();
+                threads.erase(it);
+            }
+        };
+        while (!m_stop->load()) {
+            reap();
+            pollfd listener{m_listener.get(), POLLIN, 0};
+            int ready = ::poll(&listener, 1, 100);
+            if (ready < 0 && errno != EINTR) {
+                m_stop->store(true);
+                break;
+            }
+            if (ready <= 0) {
+                continue;
+            }
+            int fd = ::accept(m_listener.get(), nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+#if defined(SO_NOSIGPIPE)
+            int one = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+            {
+                std::lock_guard lock(mutex);
+                open.push_back(fd);
+            }
+            size_t id = connections++;
+            threads.push_back({id, std::thread([this, fd, id, &mutex, &open, &finished] {
+                serve_connection(fd);
+                std::lock_guard lock(mutex);
+                std::erase(open, fd);
+                ::close(fd);
+                finished.push_back(id);
+            })});
+        }
+        {
+            // Wake connections blocked waiting for their next message
+            std::lock_guard lock(mutex);
+            for (int fd: open) {
+                ::shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (auto &connection: threads) {
+            connection.thread.join();
+        }
+        return Ok(connections);
+#else
+        return Err(Error::NotImplemented("Unix-domain sockets are not supported on this platform"));
+#endif
+    }
+
+    /**
+     * @brief Makes `serve` return; safe to call from any thread
+     */
+    void stop() {
+        m_stop->store(true);
+    }
+};
+
+/**
+ * @brief Client of a `SimulationDaemon`
+ *
+ * Example:
+ * @code
+ * auto client = DaemonClient::connect("/tmp/diffusionx.sock");
+ * DaemonJob job;
+ * job.observable = DaemonObservable::RawMoment;
+ * job.particles = 1000;
+ * auto msd = client->value(job);
+ * @endcode
+ */
+export class DaemonClient {
+    SocketHandle m_socket; ///< Connection to the daemon
+    uint64_t m_next_job = 1; ///< Id of the next submitted job
+
+    explicit DaemonClient(SocketHandle socket) : m_socket(std::move(socket)) {
+    }
+
+    auto expect_done(uint64_t id) -> Result<DaemonJobStats> {
+        auto reply = receive();
+        if (!reply) {
+            return Err(reply.error());
+        }
+        if (reply->job != id || reply->type != DaemonMessage::Done) {
+            return Err(Error::IoError("Unexpected reply from the daemon"));
+        }
+        return Ok(reply->stats);
+    }
+
+public:
+    /**
+     * @brief Connects to a daemon
+     * @param path Filesystem path of the daemon socket
+     * @return Result containing the client, or an Error
+     */
+    static auto connect(const string &path) -> Result<DaemonClient> {
+#if defined(DIFFUSIONX_HAS_UNIX_SOCKETS)
+        auto address = unix_address(path);
+        if (!address) {
+            return Err(address.error());
+        }
+        SocketHandle socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (socket.get() < 0) {
+            return Err(Error::IoError(std::format("socket failed: {}", std::strerror(errno))));
+        }
+#if defined(SO_NOSIGPIPE)
+        int one = 1;
+        ::setsockopt(socket.get(), SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        if (::connect(socket.get(), reinterpret_cast<const sockaddr *>(&address.value()),
+                      sizeof(sockaddr_un)) != 0) {
+            return Err(Error::IoError(
+                std::format("Cannot connect to '{}': {}", path, std::strerror(errno))));
+        }
+        return Ok(DaemonClient(std::move(socket)));
+#else
+        return Err(Error::NotImplemented("Unix-domain sockets are not supported on this platform"));
+#endif
+    }
+
+    /**
+     * @brief Submits a job without waiting for its results
+     * @param job The job
+     * @return Result containing the job id carried by its replies, or an Error
+     */
+    auto submit(const DaemonJob &job) -> Result<uint64_t> {
+        uint64_t id = m_next_job++;
+        if (auto res = send_frame(m_socket.get(), DaemonMessage::Submit, id, std::array{bytes_of(job)});
+            !res) {
+            return Err(res.error());
+        }
+        return Ok(id);
+    }
+
+    /**
+     * @brief Receives the next message from the daemon
+     * @return Result containing the message, or an Error if the connection
+     * broke (a Failed message is returned as a reply, not as an Error)
+     */
+    auto receive() -> Result<DaemonReply> {
+        auto received = receive_frame(m_socket.get());
+        if (!received) {
+            return Err(received.error());
+        }
+        if (!received->has_value()) {
+            return Err(Error::IoError("The daemon closed the connection"));
+        }
+        const auto &[frame, payload] = received->value();
+        DaemonReply reply;
+        reply.type = frame.type;
+        reply.job = frame.job;
+        auto malformed = Err(Error::IoError("Malformed reply from the daemon"));
+        switch (frame.type) {
+            case DaemonMessage::Path: {
+                uint64_t header[2];
+                if (payload.size() < sizeof(header)) {
+                    return malformed;
+                }
+                std::memcpy(header, payload.data(), sizeof(header));
+                if (payload.size() != sizeof(header) + (2 * header[1] * sizeof(double))) {
+                    return malformed;
+                }
+                reply.particle = header[0];
+                reply.path.first.resize(header[1]);
+                reply.path.second.resize(header[1]);
+                const char *values = payload.data() + sizeof(header);
+                std::memcpy(reply.path.first.data(), values, header[1] * sizeof(double));
+                std::memcpy(reply.path.second.data(), values + (header[1] * sizeof(double)),
+                            header[1] * sizeof(double));
+                break;
+            }
+            case DaemonMessage::Value:
+                if (payload.size() != sizeof(double)) {
+                    return malformed;
+                }
+                std::memcpy(&reply.value, payload.data(), sizeof(double));
+                break;
+            case DaemonMessage::Done:
+                if (payload.size() != sizeof(DaemonJobStats)) {
+                    return malformed;
+                }
+                std::memcpy(&reply.stats, payload.data(), sizeof(DaemonJobStats));
+                break;
+            case DaemonMessage::Status:
+                if (payload.size() != sizeof(DaemonStatus)) {
+                    return malformed;
+                }
+                std::memcpy(&reply.status, payload.data(), sizeof(DaemonStatus));
+                break;
+            case DaemonMessage::Failed:
+                reply.message = payload;
+                break;
+            default:
+                return malformed;
+        }
+        return Ok(std::move(reply));
+    }
+
+    /**
+     * @brief Runs a moment job
+     * @param job The job; its observable must be a moment
+     * @return Result containing the moment, or an Error
+     */
+    auto value(const DaemonJob &job) -> Result<double> {
+        auto id = submit(job);
+        if (!id) {
+            return Err(id.error());
+        }
+        auto reply = receive();
+        if (!reply) {
+            return Err(reply.error());
+        }
+        if (reply->type == DaemonMessage::Failed) {
+            return Err(Error(reply->message));
+        }
+        if (reply->job != id.value() || reply->type != DaemonMessage::Value) {
+            return Err(Error::IoError("Unexpected reply from the daemon"));
+        }
+        double result = reply->value;
+        if (auto done = expect_done(id.value()); !done) {
+            return Err(done.error());
+        }
+        return Ok(result);
+    }
+
+    /**
+     * @brief Runs a Paths job, handing each path over as it arrives
+     * @tparam F Callable (uint64_t particle, const vec_pair &path)
+     * @param job The job; its observable must be Paths
+     * @param on_path Called once per particle, in particle order
+     * @return Result containing the job statistics, or an Error
+     */
+    template<typename F>
+    auto paths(const DaemonJob &job, F &&on_path) -> Result<DaemonJobStats> {
+        auto id = submit(job);
+        if (!id) {
+            return Err(id.error());
+        }
+        while (true) {
+            auto reply = receive();
+            if (!reply) {
+                return Err(reply.error());
+            }
+            if (reply->job != id.value()) {
+                return Err(Error::IoError("Unexpected reply from the daemon"));
+            }
+            switch (reply->type) {
+                case DaemonMessage::Path:
+                    on_path(reply->particle, reply->path);
+                    break;
+                case DaemonMessage::Done:
+                    return Ok(reply->stats);
+                case DaemonMessage::Failed:
+                    return Err(Error(reply->message));
+                default:
+                    return Err(Error::IoError("Unexpected reply from the daemon"));
+            }
+        }
+    }
+
+    /**
+     * @brief Queries the warm state of the daemon
+     * @return Result containing the status, or an Error
+     */
+    auto status() -> Result<DaemonStatus> {
+        uint64_t id = m_next_job++;
+        if (auto res = send_frame(m_socket.get(), DaemonMessage::Status, id, {}); !res) {
+            return Err(res.error());
+        }
+        auto reply = receive();
+        if (!reply) {
+            return Err(reply.error());
+        }
+        if (reply->job != id || reply->type != DaemonMessage::Status) {
+            return Err(Error::IoError("Unexpected reply from the daemon"));
+        }
+        return Ok(reply->status);
+    }
+
+    /**
+     * @brief Asks the daemon to stop
+     * @return Result containing 0 once the daemon acknowledged, or an Error
+     */
+    auto shutdown() -> Result<int> {
+        uint64_t id = m_next_job++;
+        if (auto res = send_frame(m_socket.get(), DaemonMessage::Shutdown, id, {}); !res) {
+            return Err(res.error());
+        }
+        if (auto done = expect_done(id); !done) {
+            return Err(done.error());
+        }
+        return Ok(0);
+    }
+};
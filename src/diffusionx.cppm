@@ -18,5 +18,8 @@
 export module diffusionx;
 
 export import diffusionx.error;
+export import diffusionx.memory;
+export import diffusionx.parallel;
 export import diffusionx.random;
 export import diffusionx.simulation;
+export import diffusionx.daemon;
@@ -0,0 +1,377 @@
+/**
+ * @file memory.cppm
+ * @brief Allocator for large simulation buffers
+ *
+ * This module provides `BufferAllocator`, a standard-conforming allocator for
+ * the large scratch buffers of long-path simulations (increments, stepping
+ * blocks, ensemble storage), and the `buffer<T>` vector alias that uses it.
+ *
+ * - Every allocation is aligned to at least 64 bytes (one cache line).
+ * - Allocations of at least `large_buffer_threshold` bytes are rounded up to
+ *   whole 2 MiB pages, aligned to 2 MiB and advised for transparent huge
+ *   pages with `madvise(MADV_HUGEPAGE)` where available.
+ * - Elements are default-initialized, so `buffer<double>(n)` does not write
+ *   zeros that would be overwritten right away; pages are first touched by
+ *   the code that fills them.
+ * - Freed large blocks are kept in a bounded pool and reused, so simulating
+ *   particle after particle does not return memory to the system each time.
+ *   `trim_buffer_pool` hands pooled blocks back.
+ * - Inside an `UntouchedBufferScope`, large allocations drop their physical
+ *   pages first, so code relying on first-touch NUMA placement does not get
+ *   memory already placed by another thread.
+ *
+ * Huge pages and pooling can be switched off with `set_buffer_options` or by
+ * setting the `DIFFUSIONX_LARGE_BUFFERS=off` environment variable, and
+ * `buffer_stats` reports what the allocator did, to measure the effect.
+ */
+
+module;
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+export module diffusionx.memory;
+
+using std::vector;
+
+/**
+ * @brief Alignment of every buffer allocation (one cache line)
+ */
+export constexpr size_t buffer_alignment = 64;
+
+/**
+ * @brief Size and alignment of large allocations (one huge page)
+ */
+export constexpr size_t huge_page_size = size_t{2} << 20;
+
+/**
+ * @brief Allocations of at least this many bytes are treated as large
+ */
+export constexpr size_t large_buffer_threshold = size_t{1} << 20;
+
+/**
+ * @brief Runtime options of the buffer allocator
+ */
+export struct BufferOptions {
+    bool huge_pages = true; ///< Advise large allocations for huge pages
+    bool pooling = true; ///< Keep freed large allocations for reuse
+    size_t pool_bytes = size_t{256} << 20; ///< Maximum number of pooled bytes
+};
+
+/**
+ * @brief Counters of the buffer allocator
+ */
+export struct BufferStats {
+    size_t allocations = 0; ///< Number of allocations
+    size_t large_allocations = 0; ///< Number of large allocations
+    size_t pool_hits = 0; ///< Large allocations served from the pool
+    size_t untouched = 0; ///< Large allocations whose pages were dropped
+    size_t huge_page_advised = 0; ///< Large allocations advised for huge pages
+    size_t pooled_bytes = 0; ///< Bytes currently held by the pool
+};
+
+/**
+ * @brief Global state of the buffer allocator
+ */
+struct BufferState {
+    std::mutex mutex; ///< Guards options, pool and pooled_bytes
+    BufferOptions options; ///< Current options
+    std::multimap<size_t, void *> pool; ///< Free large blocks by size
+    size_t pooled_bytes = 0; ///< Bytes held by the pool
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> large_allocations{0};
+    std::atomic<size_t> pool_hits{0};
+    std::atomic<size_t> untouched{0};
+    std::atomic<size_t> huge_page_advised{0};
+
+    BufferState() {
+        const char *value = std::getenv("DIFFUSIONX_LARGE_BUFFERS");
+        if (value != nullptr && std::string_view(value) == "off") {
+            options.huge_pages = false;
+            options.pooling = false;
+        }
+    }
+};
+
+auto buffer_state() -> BufferState & {
+    // Never destroyed, so buffers freed during static destruction stay valid
+    static auto *state = new BufferState;
+    return *state;
+}
+
+/// Number of live `UntouchedBufferScope`s of this thread
+thread_local size_t untouched_scopes = 0;
+
+auto round_to_huge_pages(size_t bytes) -> size_t {
+    return (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+}
+
+/**
+ * @brief Drops the physical pages of a large block, keeping the mapping
+ *
+ * The next write to each page faults in a zeroed page on the NUMA node of
+ * the writing thread. Blocks are huge-page aligned and sized, and their
+ * allocator metadata lies outside them.
+ */
+auto drop_pages(void *block, size_t bytes) -> bool {
+#if defined(__linux__) && defined(MADV_DONTNEED)
+    return madvise(block, bytes, MADV_DONTNEED) == 0;
+#else
+    (void) block;
+    (void) bytes;
+    return false;
+#endif
+}
+
+/**
+ * @brief Makes the large buffer allocations of this thread untouched
+ *
+ * While a scope is alive, large allocations on the constructing thread
+ * (pooled or new) come without physical pages, so their pages are placed by
+ * whichever threads write them first. Scopes nest.
+ *
+ * Example:
+ * @code
+ * buffer<double> values;
+ * {
+ *     UntouchedBufferScope scope;
+ *     values.resize(n); // no page placed yet
+ * }
+ * // fill values from the workers that will read them
+ * @endcode
+ */
+export class UntouchedBufferScope {
+public:
+    UntouchedBufferScope() {
+        ++untouched_scopes;
+    }
+
+    ~UntouchedBufferScope() {
+        --untouched_scopes;
+    }
+
+    UntouchedBufferScope(const UntouchedBufferScope &) = delete;
+    auto operator=(const UntouchedBufferScope &) -> UntouchedBufferScope & = delete;
+};
+
+/**
+ * @brief Sets the options of the buffer allocator
+ * @param options The new options
+ *
+ * Disabling pooling releases the pooled blocks.
+ */
+export void set_buffer_options(const BufferOptions &options) {
+    auto &state = buffer_state();
+    std::lock_guard lock(state.mutex);
+    state.options = options;
+    if (!options.pooling) {
+        for (auto &[size, block]: state.pool) {
+            std::free(block);
+        }
+        state.pool.clear();
+        state.pooled_bytes = 0;
+    }
+}
+
+/**
+ * @brief Releases pooled blocks to the system
+ * @param keep_bytes Number of pooled bytes that may stay pooled
+ * @return The number of bytes released
+ *
+ * Releases the largest blocks first. Call it between phases of a
+ * long-running process to hand back memory the next phase will not use.
+ */
+export auto trim_buffer_pool(size_t keep_bytes = 0) -> size_t {
+    auto &state = buffer_state();
+    std::lock_guard lock(state.mutex);
+    size_t released = 0;
+    while (state.pooled_bytes > keep_bytes && !state.pool.empty()) {
+        auto it = std::prev(state.pool.end());
+        std::free(it->second);
+        state.pooled_bytes -= it->first;
+        released += it->first;
+        state.pool.erase(it);
+    }
+    return released;
+}
+
+/**
+ * @brief Gets the options of the buffer allocator
+ * @return The current options
+ */
+export auto get_buffer_options() -> BufferOptions {
+    auto &state = buffer_state();
+    std::lock_guard lock(state.mutex);
+    return state.options;
+}
+
+/**
+ * @brief Gets the counters of the buffer allocator
+ * @return The counters since the start or the last reset
+ */
+export auto buffer_stats() -> BufferStats {
+    auto &state = buffer_state();
+    BufferStats stats;
+    stats.allocations = state.allocations.load(std::memory_order_relaxed);
+    stats.large_allocations = state.large_allocations.load(std::memory_order_relaxed);
+    stats.pool_hits = state.pool_hits.load(std::memory_order_relaxed);
+    stats.untouched = state.untouched.load(std::memory_order_relaxed);
+    stats.huge_page_advised = state.huge_page_advised.load(std::memory_order_relaxed);
+    std::lock_guard lock(state.mutex);
+    stats.pooled_bytes = state.pooled_bytes;
+    return stats;
+}
+
+/**
+ * @brief Resets the counters of the buffer allocator
+ */
+export void reset_buffer_stats() {
+    auto &state = buffer_state();
+    state.allocations.store(0, std::memory_order_relaxed);
+    state.large_allocations.store(0, std::memory_order_relaxed);
+    state.pool_hits.store(0, std::memory_order_relaxed);
+    state.untouched.store(0, std::memory_order_relaxed);
+    state.huge_page_advised.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Allocates uninitialized storage for a buffer
+ * @param bytes The number of bytes
+ * @return Pointer to storage aligned to at least `buffer_alignment`
+ * @throws std::bad_alloc if the allocation fails
+ */
+export auto allocate_buffer(size_t bytes) -> void * {
+    auto &state = buffer_state();
+    state.allocations.fetch_add(1, std::memory_order_relaxed);
+    if (bytes < large_buffer_threshold) {
+        return ::operator new(bytes, std::align_val_t{buffer_alignment});
+    }
+    state.large_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t rounded = round_to_huge_pages(bytes);
+    // Pooled blocks and recycled heap memory were placed by earlier writers
+    auto untouched = [&](void *block) {
+        if (untouched_scopes > 0 && drop_pages(block, rounded)) {
+            state.untouched.fetch_add(1, std::memory_order_relaxed);
+        }
+        return block;
+    };
+    bool huge_pages = false;
+    {
+        std::lock_guard lock(state.mutex);
+        if (auto it = state.pool.find(rounded); it != state.pool.end()) {
+            void *block = it->second;
+            state.pool.erase(it);
+            state.pooled_bytes -= rounded;
+            state.pool_hits.fetch_add(1, std::memory_order_relaxed);
+            return untouched(block);
+        }
+        huge_pages = state.options.huge_pages;
+    }
+    void *block = std::aligned_alloc(huge_page_size, rounded);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (huge_pages && madvise(block, rounded, MADV_HUGEPAGE) == 0) {
+        state.huge_page_advised.fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+    return untouched(block);
+}
+
+/**
+ * @brief Releases storage obtained from `allocate_buffer`
+ * @param block The storage
+ * @param bytes The number of bytes passed to `allocate_buffer`
+ */
+export void deallocate_buffer(void *block, size_t bytes) noexcept {
+    if (block == nullptr) {
+        return;
+    }
+    if (bytes < large_buffer_threshold) {
+        ::operator delete(block, std::align_val_t{buffer_alignment});
+        return;
+    }
+    auto &state = buffer_state();
+    size_t rounded = round_to_huge_pages(bytes);
+    {
+        std::lock_guard lock(state.mutex);
+        if (state.options.pooling &&
+            state.pooled_bytes + rounded <= state.options.pool_bytes) {
+            state.pool.emplace(rounded, block);
+            state.pooled_bytes += rounded;
+            return;
+        }
+    }
+    std::free(block);
+}
+
+/**
+ * @brief Allocator for large simulation buffers
+ * @tparam T The element type
+ *
+ * Stateless, so all instances compare equal. `construct` without arguments
+ * default-initializes, so resizing a vector of doubles leaves the new
+ * elements uninitialized.
+ */
+export template<typename T>
+struct BufferAllocator {
+    using value_type = T;
+
+    BufferAllocator() noexcept = default;
+
+    template<typename U>
+    BufferAllocator(const BufferAllocator<U> &) noexcept {
+    }
+
+    [[nodiscard]] auto allocate(size_t n) -> T * {
+        if (n > std::allocator_traits<BufferAllocator>::max_size(*this)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(allocate_buffer(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) noexcept {
+        deallocate_buffer(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    void construct(U *p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new (static_cast<void *>(p)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U *p, Args &&... args) {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    friend auto operator==(const BufferAllocator &, const BufferAllocator<U> &) noexcept
+        -> bool {
+        return true;
+    }
+};
+
+/**
+ * @brief Vector using `BufferAllocator`, for large scratch buffers
+ * @tparam T The element type
+ *
+ * Elements added by the size constructor or `resize` are default-initialized,
+ * i.e. left uninitialized for arithmetic types.
+ */
+export template<typename T>
+using buffer = std::vector<T, BufferAllocator<T> >;
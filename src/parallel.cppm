@@ -0,0 +1,519 @@
+/**
+ * @file parallel.cppm
+ * @brief Parallel helpers and NUMA-aware placement of worker threads
+ *
+ * This module runs the worker threads of the parallel helpers (`run_placed`),
+ * discovers the NUMA topology of the machine and plans where the workers
+ * run. Workers are partitioned by NUMA
+ * node in contiguous blocks, so that contiguous ranges of an output buffer
+ * are written (and therefore first-touched) by workers of the same node.
+ * Pinning is optional and can be selected at runtime with
+ * `set_thread_pinning` or the `DIFFUSIONX_PIN` environment variable
+ * (`none`, `node` or `core`).
+ *
+ * Every parallel call records a placement report (node, requested CPU and
+ * observed CPU of each worker), available through `last_placement_report`.
+ *
+ * By default every parallel call starts and joins its own threads. Long-lived
+ * processes that issue many short calls can switch to a persistent pool with
+ * `set_persistent_workers`; its threads keep their thread-local generators
+ * seeded between calls.
+ */
+
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+export module diffusionx.parallel;
+
+using std::string;
+using std::vector;
+
+/**
+ * @brief Pinning policy for worker threads
+ */
+export enum class ThreadPinning {
+    None, ///< Workers are scheduled freely by the operating system
+    Node, ///< Each worker is restricted to the CPUs of its NUMA node
+    Core, ///< Each worker is pinned to a single CPU of its NUMA node
+};
+
+/**
+ * @brief A NUMA node and the CPUs that belong to it
+ */
+export struct NumaNode {
+    int id = 0; ///< Node id as reported by the operating system
+    vector<int> cpus; ///< CPUs of the node usable by this process
+};
+
+/**
+ * @brief Placement of a single worker thread
+ */
+export struct WorkerPlacement {
+    size_t worker = 0; ///< Worker index
+    int node = 0; ///< NUMA node the worker is assigned to
+    int cpu = -1; ///< CPU the worker is pinned to, or -1 if not pinned to one
+    int observed_cpu = -1; ///< CPU the worker was running on, or -1 if unknown
+    size_t begin = 0; ///< First index of the worker's range
+    size_t end = 0; ///< One past the last index of the worker's range
+};
+
+/**
+ * @brief Placement of the workers of one parallel call
+ */
+export struct PlacementReport {
+    ThreadPinning pinning = ThreadPinning::None; ///< Pinning policy in effect
+    size_t nodes = 1; ///< Number of NUMA nodes
+    vector<WorkerPlacement> workers; ///< Placement of each worker
+
+    /**
+     * @brief Formats the report, one line per worker
+     * @return The formatted report
+     */
+    [[nodiscard]] auto to_string() const -> string {
+        constexpr std::string_view names[] = {"none", "node", "core"};
+        string out = std::format("placement: pinning={} nodes={} workers={}\n",
+                                 names[static_cast<int>(pinning)], nodes,
+                                 workers.size());
+        for (const auto &w: workers) {
+            out += std::format("  worker {}: node {} cpu {} observed {} range [{}, {})\n",
+                               w.worker, w.node, w.cpu, w.observed_cpu, w.begin,
+                               w.end);
+        }
+        return out;
+    }
+};
+
+/**
+ * @brief Parses a Linux CPU list such as "0-3,8-11"
+ */
+auto parse_cpu_list(std::string_view text) -> vector<int> {
+    vector<int> cpus;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = std::min(text.find(',', pos), text.size());
+        auto item = text.substr(pos, comma - pos);
+        size_t dash = item.find('-');
+        int lo = std::atoi(string(item.substr(0, dash)).c_str());
+        int hi = dash == std::string_view::npos
+                     ? lo
+                     : std::atoi(string(item.substr(dash + 1)).c_str());
+        for (int cpu = lo; cpu <= hi; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+auto discover_topology() -> vector<NumaNode> {
+    vector<NumaNode> nodes;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool has_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    std::ifstream online("/sys/devices/system/node/online");
+    string line;
+    if (online && std::getline(online, line)) {
+        for (int id: parse_cpu_list(line)) {
+            std::ifstream list(std::format("/sys/devices/system/node/node{}/cpulist", id));
+            string cpus;
+            if (!list || !std::getline(list, cpus)) {
+                continue;
+            }
+            NumaNode node{id, {}};
+            for (int cpu: parse_cpu_list(cpus)) {
+                if (!has_mask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            if (!node.cpus.empty()) {
+                nodes.push_back(std::move(node));
+            }
+        }
+    }
+#endif
+    if (nodes.empty()) {
+        unsigned n = std::max(1U, std::thread::hardware_concurrency());
+        NumaNode node{0, {}};
+        for (unsigned cpu = 0; cpu < n; ++cpu) {
+            node.cpus.push_back(static_cast<int>(cpu));
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+/**
+ * @brief Gets the NUMA topology of the machine
+ * @return The NUMA nodes with at least one usable CPU, discovered once
+ *
+ * Falls back to a single node holding all CPUs when the topology cannot be
+ * read (e.g. on non-Linux systems).
+ */
+export auto numa_topology() -> const vector<NumaNode> & {
+    static const vector<NumaNode> nodes = discover_topology();
+    return nodes;
+}
+
+auto pinning_from_environment() -> ThreadPinning {
+    const char *value = std::getenv("DIFFUSIONX_PIN");
+    if (value == nullptr) {
+        return ThreadPinning::None;
+    }
+    std::string_view v(value);
+    if (v == "core") {
+        return ThreadPinning::Core;
+    }
+    if (v == "node") {
+        return ThreadPinning::Node;
+    }
+    return ThreadPinning::None;
+}
+
+auto pinning_setting() -> std::atomic<ThreadPinning> & {
+    static std::atomic<ThreadPinning> setting{pinning_from_environment()};
+    return setting;
+}
+
+/**
+ * @brief Sets the pinning policy of the parallel helpers
+ * @param pinning The pinning policy
+ */
+export void set_thread_pinning(ThreadPinning pinning) {
+    pinning_setting().store(pinning, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the pinning policy of the parallel helpers
+ * @return The pinning policy
+ */
+export auto get_thread_pinning() -> ThreadPinning {
+    return pinning_setting().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Plans the placement of workers over the index range [0, n)
+ * @param num_workers The number of workers
+ * @param n The size of the index range
+ * @return The report with node, CPU and range of each worker filled in
+ *
+ * Workers are assigned to NUMA nodes in contiguous blocks, proportionally to
+ * the number of CPUs of each node, and receive contiguous index ranges.
+ */
+export auto plan_workers(size_t num_workers, size_t n) -> PlacementReport {
+    const auto &nodes = numa_topology();
+    PlacementReport report;
+    report.pinning = get_thread_pinning();
+    report.nodes = nodes.size();
+    report.workers.resize(num_workers);
+
+    size_t total_cpus = 0;
+    for (const auto &node: nodes) {
+        total_cpus += node.cpus.size();
+    }
+    size_t chunk = num_workers == 0 ? 0 : (n + num_workers - 1) / num_workers;
+    size_t node_index = 0;
+    size_t cpus_before = 0;
+    size_t first_worker_of_node = 0;
+    for (size_t i = 0; i < num_workers; ++i) {
+        // Worker i sits at position (i + 0.5) / num_workers of the CPU list
+        size_t slot = ((2 * i + 1) * total_cpus) / (2 * num_workers);
+        while (slot >= cpus_before + nodes[node_index].cpus.size()) {
+            cpus_before += nodes[node_index].cpus.size();
+            ++node_index;
+            first_worker_of_node = i;
+        }
+        const auto &node = nodes[node_index];
+        auto &w = report.workers[i];
+        w.worker = i;
+        w.node = node.id;
+        if (report.pinning == ThreadPinning::Core) {
+            w.cpu = node.cpus[(i - first_worker_of_node) % node.cpus.size()];
+        }
+        w.begin = std::min(i * chunk, n);
+        w.end = std::min(w.begin + chunk, n);
+    }
+    return report;
+}
+
+#if defined(__linux__)
+/// CPUs the process may run on, read at startup before any worker is pinned
+const cpu_set_t process_cpus = [] {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return set;
+}();
+#endif
+
+/// Whether `place_current_thread` restricted the affinity of this thread
+thread_local bool thread_pinned = false;
+
+/**
+ * @brief Applies a planned placement to the calling thread
+ * @param report The planned placement
+ * @param worker The worker index of the calling thread
+ *
+ * Records the CPU the thread runs on after pinning in the report entry of
+ * the worker. Pinning failures are ignored: the worker then runs unpinned.
+ * Without pinning, a thread pinned by an earlier call (e.g. a persistent
+ * pool worker) gets the CPUs of the process back.
+ */
+export void place_current_thread(PlacementReport &report, size_t worker) {
+    auto &w = report.workers[worker];
+#if defined(__linux__)
+    if (report.pinning == ThreadPinning::None) {
+        if (thread_pinned) {
+            pthread_setaffinity_np(pthread_self(), sizeof(process_cpus), &process_cpus);
+            thread_pinned = false;
+        }
+    } else {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (report.pinning == ThreadPinning::Core) {
+            CPU_SET(w.cpu, &set);
+        } else {
+            for (const auto &node: numa_topology()) {
+                if (node.id == w.node) {
+                    for (int cpu: node.cpus) {
+                        CPU_SET(cpu, &set);
+                    }
+                }
+            }
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        thread_pinned = true;
+    }
+    w.observed_cpu = sched_getcpu();
+#endif
+}
+
+auto last_report_storage() -> std::pair<std::mutex, PlacementReport> & {
+    static std::pair<std::mutex, PlacementReport> storage;
+    return storage;
+}
+
+/**
+ * @brief Stores the report of a finished parallel call
+ * @param report The placement report
+ */
+export void record_placement(PlacementReport report) {
+    auto &[mutex, last] = last_report_storage();
+    std::lock_guard lock(mutex);
+    last = std::move(report);
+}
+
+/**
+ * @brief Gets the placement report of the most recent parallel call
+ * @return The placement report
+ */
+export auto last_placement_report() -> PlacementReport {
+    auto &[mutex, last] = last_report_storage();
+    std::lock_guard lock(mutex);
+    return last;
+}
+
+/**
+ * @brief Persistent worker threads for the parallel helpers
+ *
+ * Threads are started on demand and wait for the next call. Only one call
+ * runs on the pool at a time; the others fall back to their own threads.
+ */
+class WorkerPool {
+    std::mutex m_busy; ///< Held by the call running on the pool
+    std::mutex m_mutex; ///< Protects the fields below
+    std::condition_variable m_wake; ///< Signals a new call or shutdown
+    std::condition_variable m_done; ///< Signals the end of a worker's share
+    vector<std::thread> m_threads; ///< Pool threads
+    std::function<void(size_t)> m_task; ///< Work of worker i in the current call
+    size_t m_workers = 0; ///< Workers taking part in the current call
+    size_t m_remaining = 0; ///< Workers of the current call still running
+    uint64_t m_generation = 0; ///< Number of calls so far
+    bool m_stop = false; ///< Set on destruction
+
+    void work(size_t index) {
+        in_pool_worker() = true;
+        uint64_t seen = 0;
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) {
+                return;
+            }
+            seen = m_generation;
+            if (index >= m_workers) {
+                continue;
+            }
+            lock.unlock();
+            m_task(index);
+            lock.lock();
+            if (--m_remaining == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+public:
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool &) = delete;
+    auto operator=(const WorkerPool &) -> WorkerPool & = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto &thread: m_threads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Whether the calling thread is a pool worker
+     */
+    static auto in_pool_worker() -> bool & {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    /**
+     * @brief Runs task(i) for i in [0, workers) on the pool
+     * @return False if the pool is busy with another call
+     */
+    auto try_run(size_t workers, std::function<void(size_t)> task) -> bool {
+        std::unique_lock busy(m_busy, std::try_to_lock);
+        if (!busy.owns_lock()) {
+            return false;
+        }
+        std::unique_lock lock(m_mutex);
+        while (m_threads.size() < workers) {
+            m_threads.emplace_back([this, i = m_threads.size()] { work(i); });
+        }
+        m_task = std::move(task);
+        m_workers = workers;
+        m_remaining = workers;
+        ++m_generation;
+        m_wake.notify_all();
+        m_done.wait(lock, [&] { return m_remaining == 0; });
+        m_task = nullptr;
+        return true;
+    }
+
+    /**
+     * @brief Gets the number of pool threads started so far
+     */
+    auto size() -> size_t {
+        std::lock_guard lock(m_mutex);
+        return m_threads.size();
+    }
+};
+
+auto worker_pool() -> WorkerPool & {
+    static WorkerPool pool;
+    return pool;
+}
+
+auto persistent_setting() -> std::atomic<bool> & {
+    static std::atomic<bool> setting{false};
+    return setting;
+}
+
+/**
+ * @brief Selects whether the parallel helpers use a persistent thread pool
+ * @param enabled True to keep worker threads alive between calls
+ *
+ * With the pool enabled, a parallel call issued from inside a worker runs
+ * inline on that worker instead of starting nested threads.
+ */
+export void set_persistent_workers(bool enabled) {
+    persistent_setting().store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets whether the parallel helpers use a persistent thread pool
+ * @return True if worker threads are kept alive between calls
+ */
+export auto get_persistent_workers() -> bool {
+    return persistent_setting().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the number of threads of the persistent pool
+ * @return The number of pool threads started so far
+ */
+export auto persistent_worker_count() -> size_t {
+    return worker_pool().size();
+}
+
+/**
+ * @brief Runs `body(begin, end)` over [0, n) on placed worker threads
+ * @tparam F Callable taking (size_t begin, size_t end)
+ * @param n The size of the index range
+ * @param num_workers The number of workers (clamped to [1, n])
+ * @param body The work of one worker
+ *
+ * Each worker is placed according to the pinning policy before it runs, so
+ * memory it touches first is allocated on its NUMA node.
+ */
+export template<typename F>
+    requires std::invocable<F &, size_t, size_t>
+void run_placed(size_t n, size_t num_workers, F &&body) {
+    if (n == 0) {
+        return;
+    }
+    num_workers = std::clamp<size_t>(num_workers, 1, n);
+    if (get_persistent_workers() && WorkerPool::in_pool_worker()) {
+        body(size_t{0}, n);
+        return;
+    }
+    auto report = plan_workers(num_workers, n);
+    auto task = [&report, &body](size_t i) {
+        place_current_thread(report, i);
+        body(report.workers[i].begin, report.workers[i].end);
+    };
+    if (!get_persistent_workers() || !worker_pool().try_run(num_workers, task)) {
+        vector<std::thread> threads;
+        threads.reserve(num_workers);
+        for (size_t i = 0; i < num_workers; ++i) {
+            threads.emplace_back(task, i);
+        }
+        for (auto &thread: threads) {
+            if (thread.joinable())
+                thread.join();
+        }
+    }
+    record_placement(std::move(report));
+}
+
+/**
+ * @brief Default number of workers of the parallel helpers
+ * @return std::thread::hardware_concurrency(), or 1 if unknown
+ */
+export auto default_workers() -> size_t {
+    size_t n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
@@ -5,7 +5,9 @@
  * This module provides a comprehensive collection of random number generators
  * and probability distributions for stochastic simulations. It includes:
  * - Utility functions for random number generation
- * - Uniform, normal, exponential, gamma, Poisson, and stable distributions
+ * - Uniform, normal, exponential, gamma, inverse Gaussian, Poisson, and stable
+ *   distributions
+ * - Alias tables and guide tables for empirical distributions
  * - Thread-safe parallel generation capabilities
  * - Modern C++23 module interface
  */
@@ -17,4 +19,6 @@ export import diffusionx.random.exponential;
 export import diffusionx.random.normal;
 export import diffusionx.random.gamma;
 export import diffusionx.random.poisson;
-export import diffusionx.random.stable;
\ No newline at end of file
+export import diffusionx.random.stable;
+export import diffusionx.random.alias;
+export import diffusionx.random.inverse_gaussian;
\ No newline at end of file
@@ -0,0 +1,315 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.random.alias;
+
+import diffusionx.error;
+import diffusionx.random.utils;
+
+using std::format;
+using std::vector;
+
+/**
+ * @brief Number of random words drawn at once by the bulk samplers
+ */
+constexpr size_t alias_block_size = 256;
+
+/**
+ * @brief Walker/Vose alias table for sampling a finite distribution in O(1)
+ *
+ * The table is built once from a probability mass function over the
+ * indices 0..n-1. A draw uses a single 32-bit random word: the high half of
+ * word * n selects a column and the low half, uniform within the column up
+ * to 2^-32, decides between the column and its alias. `fill` draws its
+ * random words in blocks and then resolves them in a branch-free loop that
+ * compilers turn into vector gathers.
+ */
+export class AliasTable {
+    vector<uint32_t> m_threshold; ///< Acceptance threshold of each column, scaled by 2^32
+    vector<uint32_t> m_alias; ///< Alias of each column
+    vector<double> m_probability; ///< Normalized probability of each index
+
+public:
+    /**
+     * @brief Builds the table from (unnormalized) weights
+     * @param weights Non-negative weights, at least one of them positive
+     * @throws std::invalid_argument if the weights are empty, negative, not
+     * finite, all zero, or more than 2^32 - 1
+     */
+    explicit AliasTable(const vector<double> &weights) {
+        size_t n = weights.size();
+        if (n == 0 || n > UINT32_MAX) {
+            throw std::invalid_argument(
+                format("The number of weights must be in [1, 2^32 - 1], but got {}", n));
+        }
+        double total = 0.0;
+        for (double w: weights) {
+            if (!std::isfinite(w) || w < 0) {
+                throw std::invalid_argument(
+                    format("Weights must be finite and non-negative, but got {}", w));
+            }
+            total += w;
+        }
+        if (total <= 0) {
+            throw std::invalid_argument("At least one weight must be positive");
+        }
+
+        // Vose's method: columns scaled so that their mean is 1, then each
+        // small column is topped up by one large column
+        m_probability.resize(n);
+        vector<double> scaled(n);
+        vector<uint32_t> small;
+        vector<uint32_t> large;
+        for (size_t i = 0; i < n; ++i) {
+            m_probability[i] = weights[i] / total;
+            scaled[i] = m_probability[i] * static_cast<double>(n);
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+        m_threshold.assign(n, UINT32_MAX);
+        m_alias.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            m_alias[i] = static_cast<uint32_t>(i);
+        }
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            uint32_t l = large.back();
+            small.pop_back();
+            large.pop_back();
+            m_threshold[s] = static_cast<uint32_t>(scaled[s] * 0x1.0p32);
+            m_alias[s] = l;
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+            (scaled[l] < 1.0 ? small : large).push_back(l);
+        }
+        // Columns left over are full up to rounding and keep alias = self,
+        // so their threshold does not matter
+    }
+
+    /**
+     * @brief Gets the number of outcomes
+     * @return The number of indices n
+     */
+    [[nodiscard]] auto size() const -> size_t {
+        return m_alias.size();
+    }
+
+    /**
+     * @brief Gets the probability of an index
+     * @param i The index
+     * @return The normalized weight of i
+     */
+    [[nodiscard]] auto probability(size_t i) const -> double {
+        return m_probability[i];
+    }
+
+    /**
+     * @brief Draws an index
+     * @param gen The random number generator
+     * @return An index in [0, size())
+     */
+    [[nodiscard]] auto draw(std::mt19937 &gen) const -> uint32_t {
+        uint64_t product = static_cast<uint64_t>(gen()) * m_alias.size();
+        auto column = static_cast<uint32_t>(product >> 32);
+        return static_cast<uint32_t>(product) < m_threshold[column]
+                   ? column
+                   : m_alias[column];
+    }
+
+    /**
+     * @brief Fills a buffer with independent draws
+     * @param out The output buffer
+     * @param gen The random number generator
+     */
+    void fill(std::span<uint32_t> out, std::mt19937 &gen) const {
+        std::array<uint32_t, alias_block_size> words{};
+        uint64_t n = m_alias.size();
+        const uint32_t *threshold = m_threshold.data();
+        const uint32_t *alias = m_alias.data();
+        for (size_t done = 0; done < out.size(); done += alias_block_size) {
+            size_t count = std::min(alias_block_size, out.size() - done);
+            for (size_t k = 0; k < count; ++k) {
+                words[k] = static_cast<uint32_t>(gen());
+            }
+            uint32_t *dst = out.data() + done;
+            for (size_t k = 0; k < count; ++k) {
+                uint64_t product = static_cast<uint64_t>(words[k]) * n;
+                auto column = static_cast<uint32_t>(product >> 32);
+                dst[k] = static_cast<uint32_t>(product) < threshold[column]
+                             ? column
+                             : alias[column];
+            }
+        }
+    }
+
+    /**
+     * @brief Generates independent draws in parallel
+     * @param n The number of draws
+     * @return Result containing n indices, or an Error
+     */
+    [[nodiscard]] auto sample(size_t n) const -> Result<vector<uint32_t> > {
+        vector<uint32_t> result(n);
+        run_placed(n, default_workers(), [this, &result](size_t start, size_t end) {
+            thread_local static std::mt19937 gen = generator();
+            fill(std::span(result).subspan(start, end - start), gen);
+        });
+        return Ok(std::move(result));
+    }
+};
+
+/**
+ * @brief Inverse-CDF sampler of a piecewise-uniform (histogram) distribution
+ *
+ * The distribution has density proportional to weights[j] on
+ * [edges[j], edges[j+1]). An empirical distribution of samples x_1 < ... < x_m
+ * with linear interpolation of its CDF is the special case edges = x and equal
+ * weights. A guide table of n entries points, for each interval
+ * [k/n, (k+1)/n) of the uniform variate, at the first bin it can fall in, so
+ * the inverse CDF needs O(1) comparisons on average instead of a scan or a
+ * binary search.
+ */
+export class GuideTable {
+    vector<double> m_edges; ///< Bin edges, strictly increasing
+    vector<double> m_cdf; ///< CDF at the edges, from 0 to 1
+    vector<uint32_t> m_guide; ///< First candidate bin for each guide interval
+    double m_mean = 0.0; ///< Mean of the distribution
+    double m_variance = 0.0; ///< Variance of the distribution
+
+public:
+    /**
+     * @brief Builds the sampler of a histogram
+     * @param edges The n + 1 bin edges, strictly increasing and finite
+     * @param weights The n non-negative bin weights, at least one positive
+     * @throws std::invalid_argument if the histogram is malformed
+     */
+    GuideTable(const vector<double> &edges, const vector<double> &weights)
+        : m_edges(edges) {
+        size_t n = weights.size();
+        if (n == 0 || n >= UINT32_MAX || edges.size() != n + 1) {
+            throw std::invalid_argument(
+                format("Expected n + 1 edges for n weights, but got {} edges and {} weights",
+                       edges.size(), n));
+        }
+        for (size_t j = 0; j <= n; ++j) {
+            if (!std::isfinite(edges[j]) || (j > 0 && edges[j] <= edges[j - 1])) {
+                throw std::invalid_argument("Edges must be finite and strictly increasing");
+            }
+        }
+        double total = 0.0;
+        for (double w: weights) {
+            if (!std::isfinite(w) || w < 0) {
+                throw std::invalid_argument(
+                    format("Weights must be finite and non-negative, but got {}", w));
+            }
+            total += w;
+        }
+        if (total <= 0) {
+            throw std::invalid_argument("At least one weight must be positive");
+        }
+
+        m_cdf.resize(n + 1);
+        m_cdf[0] = 0.0;
+        double second = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            double p = weights[j] / total;
+            double a = edges[j];
+            double b = edges[j + 1];
+            m_cdf[j + 1] = m_cdf[j] + p;
+            m_mean += p * (a + b) / 2.0;
+            second += p * ((a * a) + (a * b) + (b * b)) / 3.0;
+        }
+        m_variance = std::max(0.0, second - (m_mean * m_mean));
+        // Rounding must not leave room for u past the last non-empty bin
+        size_t last = n;
+        while (weights[last - 1] <= 0) {
+            --last;
+        }
+        std::fill(m_cdf.begin() + static_cast<std::ptrdiff_t>(last), m_cdf.end(), 1.0);
+
+        m_guide.resize(n);
+        size_t j = 0;
+        for (size_t k = 0; k < n; ++k) {
+            double u = static_cast<double>(k) / static_cast<double>(n);
+            while (m_cdf[j + 1] <= u) {
+                ++j;
+            }
+            m_guide[k] = static_cast<uint32_t>(j);
+        }
+    }
+
+    /**
+     * @brief Evaluates the inverse CDF
+     * @param u A probability in [0, 1)
+     * @return The u-quantile of the distribution
+     */
+    [[nodiscard]] auto quantile(double u) const -> double {
+        size_t n = m_guide.size();
+        size_t j = m_guide[std::min(n - 1, static_cast<size_t>(u * static_cast<double>(n)))];
+        while (m_cdf[j + 1] <= u && j + 1 < n) {
+            ++j;
+        }
+        double width = m_cdf[j + 1] - m_cdf[j];
+        double fraction = width > 0 ? (u - m_cdf[j]) / width : 0.0;
+        return m_edges[j] + (fraction * (m_edges[j + 1] - m_edges[j]));
+    }
+
+    /**
+     * @brief Draws a value
+     * @param gen The random number generator
+     * @return A value distributed according to the histogram
+     */
+    [[nodiscard]] auto draw(std::mt19937 &gen) const -> double {
+        uint64_t high = gen();
+        uint64_t low = gen();
+        return quantile(static_cast<double>((high << 21) | (low >> 11)) * 0x1.0p-53);
+    }
+
+    /**
+     * @brief Fills a buffer with independent draws
+     * @param out The output buffer
+     * @param gen The random number generator
+     */
+    void fill(std::span<double> out, std::mt19937 &gen) const {
+        for (double &x: out) {
+            x = draw(gen);
+        }
+    }
+
+    /**
+     * @brief Generates independent draws in parallel
+     * @param n The number of draws
+     * @return Result containing n values, or an Error
+     */
+    [[nodiscard]] auto sample(size_t n) const -> Result<vector<double> > {
+        vector<double> result(n);
+        run_placed(n, default_workers(), [this, &result](size_t start, size_t end) {
+            thread_local static std::mt19937 gen = generator();
+            fill(std::span(result).subspan(start, end - start), gen);
+        });
+        return Ok(std::move(result));
+    }
+
+    /**
+     * @brief Gets the mean of the distribution
+     * @return The mean
+     */
+    [[nodiscard]] auto mean() const -> double {
+        return m_mean;
+    }
+
+    /**
+     * @brief Gets the variance of the distribution
+     * @return The variance
+     */
+    [[nodiscard]] auto variance() const -> double {
+        return m_variance;
+    }
+};
@@ -2,6 +2,7 @@ module;
 
 #include <format>
 #include <random>
+#include <span>
 #include <vector>
 
 export module diffusionx.random.normal;
@@ -42,6 +43,33 @@ auto randn(size_t n, T mean = 0, T stddev = 1) -> Result<vector<T> > {
     return Ok(parallel_generate<T>(n, sampler));
 }
 
+/**
+ * @brief Fills a buffer with normally distributed random values
+ * @tparam T The floating-point type for the generated values
+ * @param out The buffer to fill
+ * @param mean The mean (μ) of the normal distribution
+ * @param stddev The standard deviation (σ) of the normal distribution (must be positive)
+ * @return Result indicating success or an Error
+ *
+ * Same as `randn(n, mean, stddev)` but writes into caller-provided storage,
+ * e.g. an uninitialized `buffer<T>`.
+ */
+export template<Float T = double>
+auto randn(std::span<T> out, T mean = 0, T stddev = 1) -> Result<int> {
+    if (stddev <= 0) {
+        return Err(Error::InvalidArgument(format(
+            "The standard deviation `stddev` must be positive, but got {}",
+            stddev)));
+    }
+    auto sampler = [mean, stddev]() mutable -> T {
+        thread_local static std::mt19937 gen = generator();
+        std::normal_distribution<T> dist(mean, stddev);
+        return dist(gen);
+    };
+    parallel_fill<T>(out, sampler);
+    return Ok(0);
+}
+
 /**
  * @brief Generates a single normally distributed random value
  * @tparam T The floating-point type for the generated value
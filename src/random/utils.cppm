@@ -2,6 +2,7 @@ module;
 
 #include <random>
 #include <concepts>
+#include <span>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -9,6 +10,9 @@ module;
 
 export module diffusionx.random.utils;
 
+export import diffusionx.parallel;
+import diffusionx.memory;
+
 export template<typename T>
 concept Float = std::is_floating_point_v<T>;
 
@@ -32,6 +36,31 @@ export inline auto generator() -> std::mt19937 {
     return std::mt19937(rd());
 }
 
+/**
+ * @brief Fills a buffer with random values in parallel
+ * @tparam T The type of values to generate
+ * @tparam F The type of the sampling function
+ * @param out The buffer to fill
+ * @param sampler A callable that generates a single random value of type T
+ *
+ * The buffer is split into contiguous ranges, one per worker thread, and
+ * workers are placed by NUMA node (see `diffusionx.parallel`). If
+ * the buffer is freshly allocated and uninitialized (e.g. a `buffer<T>`),
+ * each range is first touched by its own worker.
+ *
+ * @note Each worker uses its own copy of the sampler
+ */
+export template<typename T, typename F>
+    requires (std::invocable<F> && std::same_as<std::invoke_result_t<F>, T>)
+void parallel_fill(std::span<T> out, F sampler) {
+    run_placed(out.size(), default_workers(), [&out, &sampler](size_t start, size_t end) {
+        F local = sampler;
+        for (size_t j = start; j < end; ++j) {
+            out[j] = local();
+        }
+    });
+}
+
 /**
  * @brief Generates random values in parallel using multiple threads
  * @tparam T The type of values to generate
@@ -52,39 +81,31 @@ export template<typename T, typename F>
     requires (std::invocable<F> && std::same_as<std::invoke_result_t<F>, T>)
 auto parallel_generate(size_t n, F sampler) -> vector<T> {
     vector<T> result(n);
-    if (n == 0) {
-        return result;
-    }
-
-    size_t num_threads = std::thread::hardware_concurrency();
-    if (num_threads == 0) {
-        num_threads = 1; // Fallback if hardware_concurrency is not available
-        // or returns 0
-    }
-    if (std::cmp_less(n , num_threads)) {
-        // If n is small, no need for many threads
-        num_threads = static_cast<unsigned int>(n);
-    }
-
-    vector<std::thread> threads;
-    threads.reserve(num_threads);
-
-    size_t chunk_size = (n + num_threads - 1) / num_threads;
-
-    for (unsigned int i = 0; i < num_threads; ++i) {
-        size_t start = i * chunk_size;
-        size_t end = std::min(start + chunk_size, n);
-        threads.emplace_back([&result, start, end, sampler]() mutable {
-            for (size_t j = start; j < end; ++j) {
-                result[j] = sampler();
-            }
-        });
-    }
+    parallel_fill<T>(std::span(result), std::move(sampler));
+    return result;
+}
 
-    for (auto &thread: threads) {
-        if (thread.joinable())
-            thread.join();
+/**
+ * @brief Generates random values in parallel into first-touch storage
+ * @tparam T The type of values to generate
+ * @tparam F The type of the sampling function
+ * @param n The number of values to generate
+ * @param sampler A callable that generates a single random value of type T
+ * @return A buffer containing n randomly generated values
+ *
+ * Unlike `parallel_generate`, the storage is not zero-initialized by the
+ * calling thread, and a large buffer is allocated without physical pages
+ * even when it is recycled from the buffer pool, so its pages end up on the
+ * NUMA nodes of the workers that wrote them.
+ */
+export template<typename T, typename F>
+    requires (std::invocable<F> && std::same_as<std::invoke_result_t<F>, T>)
+auto parallel_generate_first_touch(size_t n, F sampler) -> buffer<T> {
+    buffer<T> result;
+    {
+        UntouchedBufferScope untouched;
+        result.resize(n);
     }
-
+    parallel_fill<T>(std::span(result), std::move(sampler));
     return result;
 }
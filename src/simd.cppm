@@ -0,0 +1,785 @@
+/**
+ * @file simd.cppm
+ * @brief Vectorized elementary functions over spans
+ *
+ * This module provides batch versions of `exp`, `log`, `sin`, `cos`, `tan`,
+ * `atan` and `pow` for the sampling and simulation kernels of the library.
+ * The kernels are branch-free ports of the fdlibm algorithms written so that
+ * the compiler can vectorize them; on x86-64 ELF targets every kernel is
+ * compiled for AVX-512, AVX2 and baseline x86-64 (`target_clones`), and the
+ * best version for the running CPU is selected at load time.
+ *
+ * The compensated arithmetic of the kernels requires that multiplications
+ * and additions are not contracted into FMA instructions, and the selects
+ * must be if-converted by the vectorizer, so this file is compiled with
+ * `-ffp-contract=off -fno-trapping-math` (see CMakeLists.txt). The variants
+ * then return bit-identical results.
+ *
+ * Accuracy tiers (errors measured against long double references):
+ * - `Accuracy::Ulp1`: at most 1 ulp. `exp`, `log`, `sin`, `cos` and `atan`
+ *   are vectorized; `tan` and `pow` use the scalar C library.
+ * - `Accuracy::Ulp4`: at most 4 ulp. As `Ulp1`, plus vectorized `tan`
+ *   (sin / cos) and `pow` (double-double logarithm followed by `exp`).
+ * - `Accuracy::Fast`: relative error at most 1e-8 (for `pow`, at most
+ *   1e-8 * max(1, |y ln x|)). Shorter polynomials and a one-step argument
+ *   reduction, meant for Monte Carlo sampling.
+ *
+ * Special values (NaN, infinities, zeros, negative arguments of `log` and
+ * `pow`, huge arguments of `sin`/`cos`/`tan`) follow the C library in every
+ * tier; the rare lanes that need it are recomputed with the scalar function.
+ */
+
+module;
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+
+export module diffusionx.simd;
+
+import diffusionx.error;
+
+#if defined(__x86_64__) && defined(__ELF__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(DIFFUSIONX_NO_MULTIVERSIONING)
+#define DIFFUSIONX_MULTIVERSIONING 1
+#define DIFFUSIONX_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define DIFFUSIONX_TARGET_CLONES
+#endif
+
+// Iterations of the kernel loops are independent; out may alias x element-wise
+#if defined(__clang__)
+#define DIFFUSIONX_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define DIFFUSIONX_IVDEP _Pragma("GCC ivdep")
+#else
+#define DIFFUSIONX_IVDEP
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DIFFUSIONX_INLINE [[gnu::always_inline]] inline
+#else
+#define DIFFUSIONX_INLINE inline
+#endif
+
+/**
+ * @brief Accuracy tier of the vectorized functions
+ */
+export enum class Accuracy {
+    Ulp1, ///< At most 1 ulp
+    Ulp4, ///< At most 4 ulp
+    Fast, ///< Relative error at most 1e-8
+};
+
+/**
+ * @brief Gets the instruction set the vectorized kernels run with
+ * @return "avx512f", "avx2" or "default"
+ */
+export auto simd_isa() -> std::string_view {
+#if defined(DIFFUSIONX_MULTIVERSIONING)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return "avx512f";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return "avx2";
+    }
+#endif
+    return "default";
+}
+
+// ---------------------------------------------------------------------------
+// Bit manipulation helpers (vectorizable replacements for casts and rint)
+// ---------------------------------------------------------------------------
+
+constexpr double round_magic = 0x1.8p52;
+constexpr uint64_t round_magic_bits = 0x4338000000000000ULL;
+constexpr double inf = std::numeric_limits<double>::infinity();
+
+DIFFUSIONX_INLINE auto to_bits(double x) -> uint64_t {
+    return std::bit_cast<uint64_t>(x);
+}
+
+DIFFUSIONX_INLINE auto from_bits(uint64_t b) -> double {
+    return std::bit_cast<double>(b);
+}
+
+/// Rounds |v| < 2^51 to the nearest integer, returned as double and as int
+DIFFUSIONX_INLINE auto round_to_int(double v, int64_t &k) -> double {
+    double shifted = v + round_magic;
+    k = static_cast<int64_t>(to_bits(shifted) - round_magic_bits);
+    return shifted - round_magic;
+}
+
+/// Converts |k| < 2^51 to double without a 64-bit integer conversion
+DIFFUSIONX_INLINE auto int_to_double(int64_t k) -> double {
+    return from_bits(round_magic_bits + static_cast<uint64_t>(k)) - round_magic;
+}
+
+/// 2^k for k in [-1022, 1023]
+DIFFUSIONX_INLINE auto exp2_int(int64_t k) -> double {
+    return from_bits(static_cast<uint64_t>(k + 1023) << 52);
+}
+
+/// Error-free product a * b = p + e (Dekker), without relying on FMA
+DIFFUSIONX_INLINE auto dekker_product(double a, double b, double &e) -> double {
+    constexpr double split = 134217729.0; // 2^27 + 1
+    double p = a * b;
+    double ta = split * a;
+    double a_hi = ta - (ta - a);
+    double a_lo = a - a_hi;
+    double tb = split * b;
+    double b_hi = tb - (tb - b);
+    double b_lo = b - b_hi;
+    e = (((a_hi * b_hi - p) + a_hi * b_lo) + a_lo * b_hi) + a_lo * b_lo;
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// exp
+// ---------------------------------------------------------------------------
+
+constexpr double ln2_hi = 6.93147180369123816490e-01;
+constexpr double ln2_lo = 1.90821492927058770002e-10;
+constexpr double inv_ln2 = 1.44269504088896338700e+00;
+constexpr double exp_overflow = 7.09782712893383973096e+02;
+constexpr double exp_underflow = -7.45133219101941108420e+02;
+
+/// exp(x + dx) for |dx| much smaller than ulp(x), fdlibm e_exp.c kernel
+DIFFUSIONX_INLINE auto exp_core(double x, double dx) -> double {
+    constexpr double P1 = 1.66666666666666019037e-01;
+    constexpr double P2 = -2.77777777770155933842e-03;
+    constexpr double P3 = 6.61375632143793436117e-05;
+    constexpr double P4 = -1.65339022054652515390e-06;
+    constexpr double P5 = 4.13813679705723846039e-08;
+
+    double xc = std::min(std::max(x, -750.0), 750.0);
+    int64_t k = 0;
+    double kd = round_to_int(xc * inv_ln2, k);
+    double hi = xc - kd * ln2_hi;
+    double lo = kd * ln2_lo - dx;
+    double r = hi - lo;
+    double t = r * r;
+    double c = r - t * (P1 + t * (P2 + t * (P3 + t * (P4 + t * P5))));
+    double y = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+    int64_t k1 = k >> 1;
+    y = (y * exp2_int(k1)) * exp2_int(k - k1);
+
+    y = x > exp_overflow ? inf : y;
+    y = x < exp_underflow ? 0.0 : y;
+    return x != x ? x : y;
+}
+
+DIFFUSIONX_INLINE auto exp_fast(double x) -> double {
+    double xc = std::min(std::max(x, -750.0), 750.0);
+    int64_t k = 0;
+    double kd = round_to_int(xc * inv_ln2, k);
+    double r = (xc - kd * ln2_hi) - kd * ln2_lo;
+    double p = 1.0 + r * (1.0 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 +
+               r * (1.0 / 120 + r * (1.0 / 720 + r * (1.0 / 5040)))))));
+    int64_t k1 = k >> 1;
+    double y = (p * exp2_int(k1)) * exp2_int(k - k1);
+
+    y = x > exp_overflow ? inf : y;
+    y = x < exp_underflow ? 0.0 : y;
+    return x != x ? x : y;
+}
+
+// ---------------------------------------------------------------------------
+// log
+// ---------------------------------------------------------------------------
+
+constexpr double Lg1 = 6.666666666666735130e-01;
+constexpr double Lg2 = 3.999999999940941908e-01;
+constexpr double Lg3 = 2.857142874366239149e-01;
+constexpr double Lg4 = 2.222219843214978396e-01;
+constexpr double Lg5 = 1.818357216161805012e-01;
+constexpr double Lg6 = 1.531383769920937332e-01;
+constexpr double Lg7 = 1.479819860511658591e-01;
+
+/**
+ * @brief Splits x > 0 into 2^k * (1 + f) with 1 + f in [sqrt(2)/2, sqrt(2))
+ * @return f; hx receives the high mantissa bits used by the fdlibm selectors
+ */
+DIFFUSIONX_INLINE auto log_reduce(double x, double &dk, uint64_t &hx) -> double {
+    bool subnormal = x < 0x1p-1022;
+    double xs = subnormal ? x * 0x1p54 : x;
+    uint64_t bx = to_bits(xs);
+    uint64_t high = bx >> 32;
+    int64_t k = static_cast<int64_t>((high >> 20) & 0x7ff) - 1023 - (subnormal ? 54 : 0);
+    hx = high & 0x000fffff;
+    uint64_t i = (hx + 0x95f64) & 0x100000;
+    double m = from_bits(((hx | (i ^ 0x3ff00000)) << 32) | (bx & 0xffffffffULL));
+    k += static_cast<int64_t>(i >> 20);
+    dk = int_to_double(k);
+    return m - 1.0;
+}
+
+DIFFUSIONX_INLINE auto log_special(double x, double y) -> double {
+    y = x == inf ? inf : y;
+    y = x == 0.0 ? -inf : y;
+    y = x < 0.0 ? std::numeric_limits<double>::quiet_NaN() : y;
+    return x != x ? x : y;
+}
+
+/// log(x), fdlibm e_log.c kernel
+DIFFUSIONX_INLINE auto log_core(double x) -> double {
+    double dk = 0.0;
+    uint64_t hx = 0;
+    double f = log_reduce(x, dk, hx);
+    double s = f / (2.0 + f);
+    double z = s * s;
+    double w = z * z;
+    double t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    double t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    double R = t2 + t1;
+    double hfsq = 0.5 * f * f;
+    auto i = static_cast<int64_t>(hx) - 0x6147a;
+    auto j = 0x6b851 - static_cast<int64_t>(hx);
+    double large = dk * ln2_hi - ((hfsq - (s * (hfsq + R) + dk * ln2_lo)) - f);
+    double small = dk * ln2_hi - ((s * (f - R) - dk * ln2_lo) - f);
+    return log_special(x, (i | j) > 0 ? large : small);
+}
+
+DIFFUSIONX_INLINE auto log_fast(double x) -> double {
+    double dk = 0.0;
+    uint64_t hx = 0;
+    double f = log_reduce(x, dk, hx);
+    double s = f / (2.0 + f);
+    double z = s * s;
+    double w = z * z;
+    double R = z * (Lg1 + w * Lg3) + w * (Lg2 + w * Lg4);
+    double hfsq = 0.5 * f * f;
+    return log_special(x, dk * ln2_hi - ((hfsq - (s * (hfsq + R) + dk * ln2_lo)) - f));
+}
+
+/// log(x) as hi + lo with about 2^-65 relative error, for pow
+DIFFUSIONX_INLINE auto log_double_double(double x, double &lo) -> double {
+    double dk = 0.0;
+    uint64_t hx = 0;
+    double f = log_reduce(x, dk, hx);
+    // s = f / (2 + f) = s_hi + s_lo
+    double t_hi = 2.0 + f;
+    double t_lo = (2.0 - t_hi) + f;
+    double s_hi = f / t_hi;
+    double e = 0.0;
+    double p = dekker_product(s_hi, t_hi, e);
+    double s_lo = (((f - p) - e) - s_hi * t_lo) / t_hi;
+    // log(1 + f) = 2s + s R(s^2)
+    double z = s_hi * s_hi;
+    double w = z * z;
+    double R = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7))) +
+               w * (Lg2 + w * (Lg4 + w * Lg6));
+    double a = dk * ln2_hi;
+    double b = 2.0 * s_hi;
+    double hi = a + b;
+    double tail = (a - hi) + b; // |a| >= |b| or a == 0
+    tail += dk * ln2_lo + 2.0 * s_lo + s_hi * R;
+    double sum = hi + tail;
+    lo = tail - (sum - hi);
+    return sum;
+}
+
+// ---------------------------------------------------------------------------
+// sin, cos, tan
+// ---------------------------------------------------------------------------
+
+constexpr double inv_pio2 = 6.36619772367581382433e-01;
+constexpr double pio2_1 = 1.57079632673412561417e+00;
+constexpr double pio2_1t = 6.07710050650619224932e-11;
+constexpr double pio2_2 = 6.07710050630396597660e-11;
+constexpr double pio2_2t = 2.02226624879595063154e-21;
+constexpr double pio2_3 = 2.02226624871116645580e-21;
+constexpr double pio2_3t = 8.47842766036889956997e-32;
+
+/// Largest |x| reduced by the vector kernels (fdlibm medium-size range)
+constexpr double trig_limit = 0x1p19 * 1.57079632679489661923;
+
+constexpr double S1 = -1.66666666666666324348e-01;
+constexpr double S2 = 8.33333333332248946124e-03;
+constexpr double S3 = -1.98412698298579493134e-04;
+constexpr double S4 = 2.75573137070700676789e-06;
+constexpr double S5 = -2.50507602534068634195e-08;
+constexpr double S6 = 1.58969099521155010221e-10;
+
+constexpr double C1 = 4.16666666666666019037e-02;
+constexpr double C2 = -1.38888888888741095749e-03;
+constexpr double C3 = 2.48015872894767294178e-05;
+constexpr double C4 = -2.75573143513906633035e-07;
+constexpr double C5 = 2.08757232129817482790e-09;
+constexpr double C6 = -1.13596475577881948265e-11;
+
+DIFFUSIONX_INLINE auto biased_exponent(double x) -> int64_t {
+    return static_cast<int64_t>((to_bits(x) >> 52) & 0x7ff);
+}
+
+/**
+ * @brief x - n pi/2 = y0 + y1 for |x| <= trig_limit (fdlibm e_rem_pio2.c)
+ *
+ * All three rounds are computed and the result of the first round that
+ * loses less than 16 (second round: 49) bits to cancellation is selected.
+ */
+DIFFUSIONX_INLINE auto trig_reduce(double x, int64_t &n, double &y1) -> double {
+    double fn = round_to_int(std::min(std::max(x, -trig_limit), trig_limit) * inv_pio2, n);
+    int64_t j = biased_exponent(x);
+    double r1 = x - fn * pio2_1;
+    double w1 = fn * pio2_1t;
+    double y1_0 = r1 - w1;
+
+    double w = fn * pio2_2;
+    double r2 = r1 - w;
+    double w2 = fn * pio2_2t - ((r1 - r2) - w);
+    double y2_0 = r2 - w2;
+
+    w = fn * pio2_3;
+    double r3 = r2 - w;
+    double w3 = fn * pio2_3t - ((r2 - r3) - w);
+
+    bool second = j - biased_exponent(y1_0) > 16;
+    bool third = second && j - biased_exponent(y2_0) > 49;
+    double r = third ? r3 : (second ? r2 : r1);
+    double wr = third ? w3 : (second ? w2 : w1);
+    double y0 = r - wr;
+    y1 = (r - y0) - wr;
+    return y0;
+}
+
+/// x - n pi/2 with a single Cody-Waite round, for the fast tier
+DIFFUSIONX_INLINE auto trig_reduce_fast(double x, int64_t &n) -> double {
+    double fn = round_to_int(std::min(std::max(x, -trig_limit), trig_limit) * inv_pio2, n);
+    return (x - fn * pio2_1) - fn * pio2_1t;
+}
+
+/// sin(x + y) on [-pi/4, pi/4], fdlibm k_sin.c
+DIFFUSIONX_INLINE auto sin_kernel(double x, double y) -> double {
+    double z = x * x;
+    double v = z * x;
+    double r = S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)));
+    return x - ((z * (0.5 * y - v * r) - y) - v * S1);
+}
+
+/// cos(x + y) on [-pi/4, pi/4], fdlibm k_cos.c
+DIFFUSIONX_INLINE auto cos_kernel(double x, double y) -> double {
+    double z = x * x;
+    double r = z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+    double hz = 0.5 * z;
+    double w = 1.0 - hz;
+    return w + (((1.0 - w) - hz) + (z * r - x * y));
+}
+
+DIFFUSIONX_INLINE auto sin_kernel_fast(double x) -> double {
+    double z = x * x;
+    return x + x * z * (S1 + z * (S2 + z * (S3 + z * S4)));
+}
+
+DIFFUSIONX_INLINE auto cos_kernel_fast(double x) -> double {
+    double z = x * x;
+    return 1.0 - 0.5 * z + z * z * (C1 + z * (C2 + z * (C3 + z * C4)));
+}
+
+/// Picks ±sin or ±cos of the reduced argument for quadrant q
+DIFFUSIONX_INLINE auto quadrant_select(int64_t q, double s, double c) -> double {
+    double v = (q & 1) != 0 ? c : s;
+    return (q & 2) != 0 ? -v : v;
+}
+
+// ---------------------------------------------------------------------------
+// atan
+// ---------------------------------------------------------------------------
+
+/// atan(x), fdlibm s_atan.c with the range selection done by selects
+DIFFUSIONX_INLINE auto atan_core(double x, bool fast) -> double {
+    constexpr double aT[] = {
+        3.33333333333329318027e-01, -1.99999999998764832476e-01,
+        1.42857142725034663711e-01, -1.11111104054623557880e-01,
+        9.09088713343650656196e-02, -7.69187620504482999495e-02,
+        6.66107313738753120669e-02, -5.83357013379057348645e-02,
+        4.97687799461593236017e-02, -3.65315727442169155270e-02,
+        1.62858201153657823623e-02,
+    };
+    double ax = std::abs(x);
+    // Reduction ax -> (a ax - b) / (c + d ax) with offset hi + lo, one
+    // interval at a time so that every choice is a two-way select
+    double a = 1.0;
+    double b = 0.0;
+    double c = 1.0;
+    double d = 0.0;
+    double hi = 0.0;
+    double lo = 0.0;
+    bool r = ax >= 0.4375; // 7/16
+    a = r ? 2.0 : a;
+    b = r ? 1.0 : b;
+    c = r ? 2.0 : c;
+    d = r ? 1.0 : d;
+    hi = r ? 4.63647609000806093515e-01 : hi;
+    lo = r ? 2.26987774529616870924e-17 : lo;
+    r = ax >= 0.6875; // 11/16
+    a = r ? 1.0 : a;
+    c = r ? 1.0 : c;
+    hi = r ? 7.85398163397448278999e-01 : hi;
+    lo = r ? 3.06161699786838301793e-17 : lo;
+    r = ax >= 1.1875; // 19/16
+    b = r ? 1.5 : b;
+    d = r ? 1.5 : d;
+    hi = r ? 9.82793723247329054082e-01 : hi;
+    lo = r ? 1.39033110312309984516e-17 : lo;
+    r = ax >= 2.4375; // 39/16
+    a = r ? 0.0 : a;
+    b = r ? 1.0 : b;
+    c = r ? 0.0 : c;
+    d = r ? 1.0 : d;
+    hi = r ? 1.57079632679489655800e+00 : hi;
+    lo = r ? 6.12323399573676603587e-17 : lo;
+    double t = (a * ax - b) / (c + d * ax);
+    double z = t * t;
+    double w = z * z;
+    double s1 = 0.0;
+    double s2 = 0.0;
+    if (fast) {
+        s1 = z * (aT[0] + w * (aT[2] + w * (aT[4] + w * (aT[6] + w * aT[8]))));
+        s2 = w * (aT[1] + w * (aT[3] + w * (aT[5] + w * aT[7])));
+    } else {
+        s1 = z * (aT[0] + w * (aT[2] + w * (aT[4] + w * (aT[6] + w * (aT[8] + w * aT[10])))));
+        s2 = w * (aT[1] + w * (aT[3] + w * (aT[5] + w * (aT[7] + w * aT[9]))));
+    }
+    double y = hi - ((t * (s1 + s2) - lo) - t);
+    y = ax == inf ? 1.57079632679489655800e+00 : y;
+    y = x < 0 ? -y : y;
+    return x != x ? x : y;
+}
+
+// ---------------------------------------------------------------------------
+// Kernels, compiled once per instruction set
+// ---------------------------------------------------------------------------
+
+DIFFUSIONX_TARGET_CLONES
+void exp_loop(const double *x, double *out, size_t n, bool fast) {
+    if (fast) {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = exp_fast(x[i]);
+        }
+    } else {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = exp_core(x[i], 0.0);
+        }
+    }
+}
+
+DIFFUSIONX_TARGET_CLONES
+void log_loop(const double *x, double *out, size_t n, bool fast) {
+    if (fast) {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = log_fast(x[i]);
+        }
+    } else {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = log_core(x[i]);
+        }
+    }
+}
+
+/// Trigonometric function evaluated by `trig_loop`
+enum class TrigFunction { Sin, Cos, Tan };
+
+/// sin, cos (shift 1) or tan of x
+template<bool Fast, bool Tan>
+DIFFUSIONX_INLINE auto trig_element(double x, int64_t shift) -> double {
+    int64_t q = 0;
+    double s = 0.0;
+    double c = 0.0;
+    if constexpr (Fast) {
+        double y0 = trig_reduce_fast(x, q);
+        s = sin_kernel_fast(y0);
+        c = cos_kernel_fast(y0);
+    } else {
+        double y1 = 0.0;
+        double y0 = trig_reduce(x, q, y1);
+        s = sin_kernel(y0, y1);
+        c = cos_kernel(y0, y1);
+    }
+    if constexpr (Tan) {
+        return (q & 1) != 0 ? -c / s : s / c;
+    } else {
+        return quadrant_select(q + shift, s, c);
+    }
+}
+
+DIFFUSIONX_TARGET_CLONES
+void trig_loop(const double *x, double *out, size_t n, TrigFunction f, bool fast) {
+    int64_t shift = f == TrigFunction::Cos ? 1 : 0;
+    if (f == TrigFunction::Tan) {
+        if (fast) {
+            DIFFUSIONX_IVDEP
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = trig_element<true, true>(x[i], 0);
+            }
+        } else {
+            DIFFUSIONX_IVDEP
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = trig_element<false, true>(x[i], 0);
+            }
+        }
+    } else if (fast) {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = trig_element<true, false>(x[i], shift);
+        }
+    } else {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = trig_element<false, false>(x[i], shift);
+        }
+    }
+}
+
+DIFFUSIONX_TARGET_CLONES
+void atan_loop(const double *x, double *out, size_t n, bool fast) {
+    if (fast) {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = atan_core(x[i], true);
+        }
+    } else {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = atan_core(x[i], false);
+        }
+    }
+}
+
+/// x^y for x > 0: exp of y log(x) with the logarithm in double-double
+DIFFUSIONX_INLINE auto pow_core(double x, double y) -> double {
+    double log_lo = 0.0;
+    double log_hi = log_double_double(x, log_lo);
+    double e = 0.0;
+    double p = dekker_product(y, log_hi, e);
+    return exp_core(p, e + y * log_lo);
+}
+
+/// y_stride 0 broadcasts y[0]
+DIFFUSIONX_TARGET_CLONES
+void pow_loop(const double *x, const double *y, size_t y_stride, double *out, size_t n,
+              bool fast) {
+    if (fast) {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = exp_fast(y[i * y_stride] * log_fast(x[i]));
+        }
+    } else {
+        DIFFUSIONX_IVDEP
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = pow_core(x[i], y[i * y_stride]);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public interface
+// ---------------------------------------------------------------------------
+
+auto check_spans(size_t input, size_t output) -> Result<int> {
+    if (input != output) {
+        return Err(Error::InvalidArgument("Input and output must have the same size"));
+    }
+    return Ok(0);
+}
+
+/**
+ * @brief Computes out[i] = exp(x[i])
+ * @param x The arguments
+ * @param out The results, same size as x (may be the same memory as x)
+ * @param accuracy The accuracy tier
+ * @return Result containing 0, or an Error if the sizes differ
+ */
+export auto vexp(std::span<const double> x, std::span<double> out,
+                 Accuracy accuracy = Accuracy::Ulp1) -> Result<int> {
+    if (auto r = check_spans(x.size(), out.size()); !r.has_value()) {
+        return r;
+    }
+    exp_loop(x.data(), out.data(), x.size(), accuracy == Accuracy::Fast);
+    return Ok(0);
+}
+
+/**
+ * @brief Computes out[i] = log(x[i])
+ * @param x The arguments
+ * @param out The results, same size as x (may be the same memory as x)
+ * @param accuracy The accuracy tier
+ * @return Result containing 0, or an Error if the sizes differ
+ */
+export auto vlog(std::span<const double> x, std::span<double> out,
+                 Accuracy accuracy = Accuracy::Ulp1) -> Result<int> {
+    if (auto r = check_spans(x.size(), out.size()); !r.has_value()) {
+        return r;
+    }
+    log_loop(x.data(), out.data(), x.size(), accuracy == Accuracy::Fast);
+    return Ok(0);
+}
+
+/// Evaluates f with the vector kernel, and huge or non-finite arguments with the C library
+auto trig_dispatch(std::span<const double> x, std::span<double> out, TrigFunction f,
+                   Accuracy accuracy) -> Result<int> {
+    if (auto r = check_spans(x.size(), out.size()); !r.has_value()) {
+        return r;
+    }
+    auto scalar = [f](double v) {
+        switch (f) {
+            case TrigFunction::Sin:
+                return std::sin(v);
+            case TrigFunction::Cos:
+                return std::cos(v);
+            default:
+                return std::tan(v);
+        }
+    };
+    if (f == TrigFunction::Tan && accuracy == Accuracy::Ulp1) {
+        for (size_t i = 0; i < x.size(); ++i) {
+            out[i] = scalar(x[i]);
+        }
+        return Ok(0);
+    }
+    bool fast = accuracy == Accuracy::Fast;
+    // Count irregular arguments before writing, since out may alias x
+    size_t irregular = 0;
+    for (double v: x) {
+        irregular += std::abs(v) <= trig_limit ? 0 : 1;
+    }
+    if (irregular == 0) {
+        trig_loop(x.data(), out.data(), x.size(), f, fast);
+        return Ok(0);
+    }
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (std::abs(x[i]) <= trig_limit) {
+            trig_loop(&x[i], &out[i], 1, f, fast);
+        } else {
+            out[i] = scalar(x[i]);
+        }
+    }
+    return Ok(0);
+}
+
+/**
+ * @brief Computes out[i] = sin(x[i])
+ * @param x The arguments
+ * @param out The results, same size as x (may be the same memory as x)
+ * @param accuracy The accuracy tier
+ * @return Result containing 0, or an Error if the sizes differ
+ */
+export auto vsin(std::span<const double> x, std::span<double> out,
+                 Accuracy accuracy = Accuracy::Ulp1) -> Result<int> {
+    return trig_dispatch(x, out, TrigFunction::Sin, accuracy);
+}
+
+/**
+ * @brief Computes out[i] = cos(x[i])
+ * @param x The arguments
+ * @param out The results, same size as x (may be the same memory as x)
+ * @param accuracy The accuracy tier
+ * @return Result containing 0, or an Error if the sizes differ
+ */
+export auto vcos(std::span<const double> x, std::span<double> out,
+                 Accuracy accuracy = Accuracy::Ulp1) -> Result<int> {
+    return trig_dispatch(x, out, TrigFunction::Cos, accuracy);
+}
+
+/**
+ * @brief Computes out[i] = tan(x[i])
+ * @param x The arguments
+ * @param out The results, same size as x (may be the same memory as x)
+ * @param accuracy The accuracy tier; `Ulp1` uses the scalar C library
+ * @return Result containing 0, or an Error if the sizes differ
+ */
+export auto vtan(std::span<const double> x, std::span<double> out,
+                 Accuracy accuracy = Accuracy::Ulp1) -> Result<int> {
+    return trig_dispatch(x, out, TrigFunction::Tan, accuracy);
+}
+
+/**
+ * @brief Computes out[i] = atan(x[i])
+ * @param x The arguments
+ * @param out The results, same size as x (may be the same memory as x)
+ * @param accuracy The accuracy tier
+ * @return Result containing 0, or an Error if the sizes differ
+ */
+export auto vatan(std::span<const double> x, std::span<double> out,
+                  Accuracy accuracy = Accuracy::Ulp1) -> Result<int> {
+    if (auto r = check_spans(x.size(), out.size()); !r.has_value()) {
+        return r;
+    }
+    atan_loop(x.data(), out.data(), x.size(), accuracy == Accuracy::Fast);
+    return Ok(0);
+}
+
+/// Evaluates pow with the vector kernel for x > 0 and finite y, otherwise with the C library
+auto pow_dispatch(std::span<const double> x, const double *y, size_t y_stride,
+                  std::span<double> out, Accuracy accuracy) -> Result<int> {
+    if (accuracy == Accuracy::Ulp1) {
+        for (size_t i = 0; i < x.size(); ++i) {
+            out[i] = std::pow(x[i], y[i * y_stride]);
+        }
+        return Ok(0);
+    }
+    auto regular = [&](size_t i) {
+        return x[i] > 0 && x[i] < inf && std::abs(y[i * y_stride]) < inf;
+    };
+    bool fast = accuracy == Accuracy::Fast;
+    size_t irregular = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        irregular += regular(i) ? 0 : 1;
+    }
+    if (irregular == 0) {
+        pow_loop(x.data(), y, y_stride, out.data(), x.size(), fast);
+        return Ok(0);
+    }
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (regular(i)) {
+            pow_loop(&x[i], y + i * y_stride, y_stride, &out[i], 1, fast);
+        } else {
+            out[i] = std::pow(x[i], y[i * y_stride]);
+        }
+    }
+    return Ok(0);
+}
+
+/**
+ * @brief Computes out[i] = pow(x[i], y[i])
+ * @param x The bases
+ * @param y The exponents, same size as x
+ * @param out The results, same size as x (may be the same memory as x or y)
+ * @param accuracy The accuracy tier; `Ulp1` uses the scalar C library
+ * @return Result containing 0, or an Error if the sizes differ
+ */
+export auto vpow(std::span<const double> x, std::span<const double> y, std::span<double> out,
+                 Accuracy accuracy = Accuracy::Ulp1) -> Result<int> {
+    if (auto r = check_spans(x.size(), out.size()); !r.has_value()) {
+        return r;
+    }
+    if (auto r = check_spans(x.size(), y.size()); !r.has_value()) {
+        return r;
+    }
+    return pow_dispatch(x, y.data(), 1, out, accuracy);
+}
+
+/**
+ * @brief Computes out[i] = pow(x[i], y)
+ * @param x The bases
+ * @param y The exponent
+ * @param out The results, same size as x (may be the same memory as x)
+ * @param accuracy The accuracy tier; `Ulp1` uses the scalar C library
+ * @return Result containing 0, or an Error if the sizes differ
+ */
+export auto vpow(std::span<const double> x, double y, std::span<double> out,
+                 Accuracy accuracy = Accuracy::Ulp1) -> Result<int> {
+    if (auto r = check_spans(x.size(), out.size()); !r.has_value()) {
+        return r;
+    }
+    return pow_dispatch(x, &y, 0, out, accuracy);
+}
@@ -13,5 +13,17 @@ export import diffusionx.simulation.basic.utils;
 export import diffusionx.simulation.basic.tamsd;
 export import diffusionx.simulation.basic.moment;
 export import diffusionx.simulation.basic.functional;
+export import diffusionx.simulation.basic.stepper;
 export import diffusionx.simulation.basic.csv;
+export import diffusionx.simulation.basic.codec;
+export import diffusionx.simulation.basic.arrow;
+export import diffusionx.simulation.basic.cache;
+export import diffusionx.simulation.basic.downsample;
+export import diffusionx.simulation.basic.observable;
+export import diffusionx.simulation.basic.extremes;
+export import diffusionx.simulation.basic.path_integral;
 export import diffusionx.simulation.basic.circulant_embedding;
+export import diffusionx.simulation.basic.fft;
+export import diffusionx.simulation.basic.bootstrap;
+export import diffusionx.simulation.basic.blocking;
+export import diffusionx.simulation.basic.shared_ensemble;
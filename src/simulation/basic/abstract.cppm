@@ -4,6 +4,7 @@ module;
 #include <cmath>
 #include <concepts>
 #include <format>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,6 +14,7 @@ import diffusionx.error;
 import diffusionx.simulation.basic.utils;
 import diffusionx.simulation.basic.moment;
 import diffusionx.simulation.basic.functional;
+import diffusionx.simulation.basic.stepper;
 
 using std::vector;
 
@@ -93,6 +95,14 @@ export struct ContinuousProcess {
                                           size_t particles = 10000,
                                           double time_step = 0.01);
 
+    /**
+     * @brief Creates a stepper that generates a path of the process block by block
+     * @param time_step The time step for discretization (default: 0.01)
+     * @return Result containing the stepper, or an Error if the process does
+     *         not support incremental generation
+     */
+    virtual Result<std::unique_ptr<Stepper> > stepper(double time_step = 0.01);
+
     // /**
     //  * @brief Computes the first passage time (FPT) for a given domain
     //  * @param domain The domain boundaries as a pair (lower, upper)
@@ -265,6 +275,12 @@ auto ContinuousProcess::central_moment(double duration, int order,
     return moment.central_moment(particles, time_step);
 }
 
+auto ContinuousProcess::stepper(double time_step)
+    -> Result<std::unique_ptr<Stepper> > {
+    return Err(Error::NotImplemented(
+        "stepper is not implemented for this process"));
+}
+
 // Result<Option<double>> ContinuousProcess::fpt(double_pair domain,
 //                                                double max_duration,
 //                                                double time_step) {
@@ -0,0 +1,710 @@
+/**
+ * @file arrow.cppm
+ * @brief Apache Arrow IPC (Feather v2) output for trajectories and tables
+ *
+ * This module writes Arrow IPC files and streams without depending on the
+ * Arrow C++ library. The FlatBuffers metadata (schema, record batch and
+ * dictionary batch messages, file footer) is assembled by a small builder and
+ * the column buffers are written straight from the trajectory vectors, so
+ * Arrow-native tools such as Polars or DuckDB can memory-map the output
+ * instead of parsing CSV.
+ *
+ * Trajectory tables have the schema
+ * `trajectory_id: dictionary<int32, utf8>, time: float64, position: float64`
+ * and are split into record batches of at most `ArrowOptions::batch_rows`
+ * rows.
+ */
+
+module;
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+export module diffusionx.simulation.basic.arrow;
+
+import diffusionx.error;
+import diffusionx.simulation.basic.utils;
+
+using std::string;
+using std::vector;
+
+/**
+ * @brief Arrow IPC container flavour
+ */
+export enum class ArrowFormat {
+    File, ///< Random-access file format (Feather v2), memory-mappable
+    Stream, ///< Streaming format, suitable for pipes and sockets
+};
+
+/**
+ * @brief Options controlling Arrow IPC output
+ */
+export struct ArrowOptions {
+    ArrowFormat format = ArrowFormat::File; ///< Container flavour
+    size_t batch_rows = 65536; ///< Maximum number of rows per record batch
+};
+
+// ---------------------------------------------------------------------------
+// Minimal FlatBuffers builder
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Forward-growing FlatBuffers builder
+ *
+ * Objects are laid out top-down: a table is written first with placeholder
+ * offsets and its children are appended afterwards, so every uoffset points
+ * forward as the format requires. Each vtable is emitted right before its
+ * table. Scalars are aligned relative to the buffer start, which callers keep
+ * 8-byte aligned in the output file.
+ */
+class FlatBuilder {
+    vector<uint8_t> m_buf;
+
+public:
+    /**
+     * @brief A table field: an inline scalar/struct or a deferred child
+     */
+    struct Field {
+        uint16_t id = 0; ///< Field id in the schema (vtable slot)
+        uint8_t size = 0; ///< Inline size in bytes
+        uint8_t align = 1; ///< Inline alignment in bytes
+        uint64_t scalar = 0; ///< Scalar value (little-endian truncated)
+        std::function<size_t(FlatBuilder &)> child; ///< Child writer, if any
+    };
+
+    static auto scalar(uint16_t id, uint8_t size, uint64_t value) -> Field {
+        return Field{id, size, size, value, nullptr};
+    }
+
+    static auto offset(uint16_t id, std::function<size_t(FlatBuilder &)> fn)
+        -> Field {
+        return Field{id, 4, 4, 0, std::move(fn)};
+    }
+
+    FlatBuilder() : m_buf(4, 0) {
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return m_buf.size(); }
+
+    void pad_to(size_t alignment) {
+        while (m_buf.size() % alignment != 0) {
+            m_buf.push_back(0);
+        }
+    }
+
+    void put(uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            m_buf.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void patch(size_t pos, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            m_buf[pos + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    auto table(const vector<Field> &fields) -> size_t {
+        uint16_t slots = 0;
+        size_t inline_size = 4;
+        vector<size_t> positions(fields.size());
+        for (size_t i = 0; i < fields.size(); ++i) {
+            slots = std::max<uint16_t>(slots, fields[i].id + 1);
+            inline_size = (inline_size + fields[i].align - 1) /
+                          fields[i].align * fields[i].align;
+            positions[i] = inline_size;
+            inline_size += fields[i].size;
+        }
+
+        pad_to(2);
+        size_t vtable = m_buf.size();
+        put(4 + (2 * slots), 2);
+        put(inline_size, 2);
+        for (uint16_t slot = 0; slot < slots; ++slot) {
+            size_t at = 0;
+            for (size_t i = 0; i < fields.size(); ++i) {
+                if (fields[i].id == slot) {
+                    at = positions[i];
+                }
+            }
+            put(at, 2);
+        }
+
+        pad_to(8);
+        size_t start = m_buf.size();
+        put(static_cast<uint32_t>(start - vtable), 4);
+        m_buf.resize(start + inline_size, 0);
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (!fields[i].child) {
+                patch(start + positions[i], fields[i].scalar, fields[i].size);
+            }
+        }
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i].child) {
+                size_t at = start + positions[i];
+                size_t child = fields[i].child(*this);
+                patch(at, child - at, 4);
+            }
+        }
+        return start;
+    }
+
+    auto tables(size_t count, const std::function<size_t(FlatBuilder &, size_t)> &fn)
+        -> size_t {
+        pad_to(4);
+        size_t start = m_buf.size();
+        put(count, 4);
+        m_buf.resize(start + 4 + (4 * count), 0);
+        for (size_t i = 0; i < count; ++i) {
+            size_t at = start + 4 + (4 * i);
+            size_t child = fn(*this, i);
+            patch(at, child - at, 4);
+        }
+        return start;
+    }
+
+    auto structs(const vector<uint64_t> &words, size_t count) -> size_t {
+        while ((m_buf.size() + 4) % 8 != 0) {
+            m_buf.push_back(0);
+        }
+        size_t start = m_buf.size();
+        put(count, 4);
+        for (auto word: words) {
+            put(word, 8);
+        }
+        return start;
+    }
+
+    auto str(const string &s) -> size_t {
+        pad_to(4);
+        size_t start = m_buf.size();
+        put(s.size(), 4);
+        m_buf.insert(m_buf.end(), s.begin(), s.end());
+        m_buf.push_back(0);
+        return start;
+    }
+
+    auto finish(const vector<Field> &root) -> vector<uint8_t> {
+        size_t pos = table(root);
+        patch(0, pos, 4);
+        pad_to(8);
+        return std::move(m_buf);
+    }
+};
+
+// Arrow enum values (format/Schema.fbs, format/Message.fbs)
+constexpr uint64_t metadata_version_v5 = 4;
+constexpr uint64_t type_floating_point = 3;
+constexpr uint64_t type_utf8 = 5;
+constexpr uint64_t precision_double = 2;
+constexpr uint64_t header_schema = 1;
+constexpr uint64_t header_dictionary_batch = 2;
+constexpr uint64_t header_record_batch = 3;
+
+/**
+ * @brief Column description used to build the schema
+ */
+struct ArrowColumn {
+    string name; ///< Column name
+    bool dictionary = false; ///< int32 indices into a utf8 dictionary (id 0)
+};
+
+auto write_int_type(FlatBuilder &b, uint64_t bit_width, bool is_signed)
+    -> size_t {
+    return b.table({FlatBuilder::scalar(0, 4, bit_width),
+                    FlatBuilder::scalar(1, 1, is_signed ? 1 : 0)});
+}
+
+auto write_field(FlatBuilder &b, const ArrowColumn &column) -> size_t {
+    vector<FlatBuilder::Field> fields{
+        FlatBuilder::offset(0, [&column](FlatBuilder &fb) {
+            return fb.str(column.name);
+        }),
+        FlatBuilder::scalar(1, 1, 0),
+        FlatBuilder::scalar(2, 1,
+                            column.dictionary ? type_utf8 : type_floating_point),
+        FlatBuilder::offset(3, [&column](FlatBuilder &fb) {
+            if (column.dictionary) {
+                return fb.table({});
+            }
+            return fb.table({FlatBuilder::scalar(0, 2, precision_double)});
+        }),
+        FlatBuilder::offset(5, [](FlatBuilder &fb) {
+            return fb.tables(0, nullptr);
+        }),
+    };
+    if (column.dictionary) {
+        fields.push_back(FlatBuilder::offset(4, [](FlatBuilder &fb) {
+            return fb.table({
+                FlatBuilder::scalar(0, 8, 0),
+                FlatBuilder::offset(1, [](FlatBuilder &ib) {
+                    return write_int_type(ib, 32, true);
+                }),
+                FlatBuilder::scalar(2, 1, 0),
+            });
+        }));
+    }
+    return b.table(fields);
+}
+
+auto write_schema(FlatBuilder &b, const vector<ArrowColumn> &columns)
+    -> size_t {
+    return b.table({
+        FlatBuilder::scalar(0, 2, 0),
+        FlatBuilder::offset(1, [&columns](FlatBuilder &fb) {
+            return fb.tables(columns.size(), [&columns](FlatBuilder &cb, size_t i) {
+                return write_field(cb, columns[i]);
+            });
+        }),
+    });
+}
+
+/**
+ * @brief One buffer of a message body, gathered from contiguous segments
+ */
+struct BodyBuffer {
+    vector<std::span<const uint8_t> > segments; ///< Data written in order
+
+    [[nodiscard]] auto length() const -> size_t {
+        size_t n = 0;
+        for (const auto &s: segments) {
+            n += s.size();
+        }
+        return n;
+    }
+};
+
+template<typename T>
+auto as_bytes_span(std::span<const T> values) -> std::span<const uint8_t> {
+    return {reinterpret_cast<const uint8_t *>(values.data()),
+            values.size_bytes()};
+}
+
+auto padded8(size_t n) -> size_t { return (n + 7) / 8 * 8; }
+
+auto write_record_batch(FlatBuilder &b, uint64_t rows, size_t num_fields,
+                        const vector<BodyBuffer> &buffers) -> size_t {
+    vector<uint64_t> nodes;
+    for (size_t i = 0; i < num_fields; ++i) {
+        nodes.push_back(rows);
+        nodes.push_back(0);
+    }
+    vector<uint64_t> spans;
+    uint64_t offset = 0;
+    for (const auto &buffer: buffers) {
+        spans.push_back(offset);
+        spans.push_back(buffer.length());
+        offset += padded8(buffer.length());
+    }
+    return b.table({
+        FlatBuilder::scalar(0, 8, rows),
+        FlatBuilder::offset(1, [nodes, num_fields](FlatBuilder &fb) {
+            return fb.structs(nodes, num_fields);
+        }),
+        FlatBuilder::offset(2, [spans, n = buffers.size()](FlatBuilder &fb) {
+            return fb.structs(spans, n);
+        }),
+    });
+}
+
+auto body_length(const vector<BodyBuffer> &buffers) -> uint64_t {
+    uint64_t n = 0;
+    for (const auto &buffer: buffers) {
+        n += padded8(buffer.length());
+    }
+    return n;
+}
+
+/**
+ * @brief Block entry of the file footer
+ */
+struct ArrowBlock {
+    uint64_t offset; ///< Offset of the message in the file
+    uint64_t metadata_length; ///< Prefix plus padded metadata length
+    uint64_t body_length; ///< Body length in bytes
+};
+
+/**
+ * @brief Writes encapsulated IPC messages and the optional file footer
+ */
+class IpcWriter {
+    std::ofstream m_file;
+    ArrowFormat m_format;
+    uint64_t m_pos = 0;
+    vector<ArrowColumn> m_columns;
+    vector<ArrowBlock> m_dictionaries;
+    vector<ArrowBlock> m_batches;
+
+    void write_bytes(const void *data, size_t n) {
+        m_file.write(static_cast<const char *>(data),
+                     static_cast<std::streamsize>(n));
+        m_pos += n;
+    }
+
+    void write_padding(size_t n) {
+        static constexpr uint8_t zeros[8] = {};
+        write_bytes(zeros, n);
+    }
+
+    void write_u32(uint32_t v) {
+        uint8_t bytes[4];
+        for (int i = 0; i < 4; ++i) {
+            bytes[i] = static_cast<uint8_t>(v >> (8 * i));
+        }
+        write_bytes(bytes, 4);
+    }
+
+    auto write_message(uint64_t header_type,
+                       const std::function<size_t(FlatBuilder &)> &header,
+                       const vector<BodyBuffer> &body) -> ArrowBlock {
+        uint64_t body_bytes = body_length(body);
+        FlatBuilder b;
+        auto metadata = b.finish({
+            FlatBuilder::scalar(0, 2, metadata_version_v5),
+            FlatBuilder::scalar(1, 1, header_type),
+            FlatBuilder::offset(2, header),
+            FlatBuilder::scalar(3, 8, body_bytes),
+        });
+        ArrowBlock block{m_pos, 8 + metadata.size(), body_bytes};
+        write_u32(0xFFFFFFFFu);
+        write_u32(static_cast<uint32_t>(metadata.size()));
+        write_bytes(metadata.data(), metadata.size());
+        for (const auto &buffer: body) {
+            for (const auto &segment: buffer.segments) {
+                write_bytes(segment.data(), segment.size());
+            }
+            write_padding(padded8(buffer.length()) - buffer.length());
+        }
+        return block;
+    }
+
+public:
+    IpcWriter(const string &filename, ArrowFormat format,
+              vector<ArrowColumn> columns)
+        : m_file(filename, std::ios::binary), m_format(format),
+          m_columns(std::move(columns)) {
+    }
+
+    [[nodiscard]] auto is_open() const -> bool { return m_file.is_open(); }
+
+    [[nodiscard]] auto good() const -> bool { return m_file.good(); }
+
+    void begin() {
+        if (m_format == ArrowFormat::File) {
+            write_bytes("ARROW1\0\0", 8);
+        }
+        write_message(header_schema, [this](FlatBuilder &b) {
+            return write_schema(b, m_columns);
+        }, {});
+    }
+
+    void dictionary(const vector<string> &values) {
+        vector<int32_t> offsets{0};
+        string data;
+        for (const auto &value: values) {
+            data += value;
+            offsets.push_back(static_cast<int32_t>(data.size()));
+        }
+        vector<BodyBuffer> body{
+            BodyBuffer{},
+            BodyBuffer{{as_bytes_span(std::span<const int32_t>(offsets))}},
+            BodyBuffer{{as_bytes_span(std::span<const char>(data))}},
+        };
+        uint64_t rows = values.size();
+        m_dictionaries.push_back(write_message(
+            header_dictionary_batch, [rows, &body](FlatBuilder &b) {
+                return b.table({
+                    FlatBuilder::scalar(0, 8, 0),
+                    FlatBuilder::offset(1, [rows, &body](FlatBuilder &fb) {
+                        return write_record_batch(fb, rows, 1, body);
+                    }),
+                    FlatBuilder::scalar(2, 1, 0),
+                });
+            }, body));
+    }
+
+    void record_batch(uint64_t rows, const vector<BodyBuffer> &body) {
+        size_t num_fields = m_columns.size();
+        m_batches.push_back(write_message(
+            header_record_batch, [rows, num_fields, &body](FlatBuilder &b) {
+                return write_record_batch(b, rows, num_fields, body);
+            }, body));
+    }
+
+    void finish() {
+        write_u32(0xFFFFFFFFu);
+        write_u32(0);
+        if (m_format == ArrowFormat::Stream) {
+            return;
+        }
+        auto blocks = [](const vector<ArrowBlock> &list) {
+            vector<uint64_t> words;
+            for (const auto &block: list) {
+                words.push_back(block.offset);
+                words.push_back(block.metadata_length);
+                words.push_back(block.body_length);
+            }
+            return words;
+        };
+        FlatBuilder b;
+        auto footer = b.finish({
+            FlatBuilder::scalar(0, 2, metadata_version_v5),
+            FlatBuilder::offset(1, [this](FlatBuilder &fb) {
+                return write_schema(fb, m_columns);
+            }),
+            FlatBuilder::offset(2, [&](FlatBuilder &fb) {
+                return fb.structs(blocks(m_dictionaries), m_dictionaries.size());
+            }),
+            FlatBuilder::offset(3, [&](FlatBuilder &fb) {
+                return fb.structs(blocks(m_batches), m_batches.size());
+            }),
+        });
+        write_bytes(footer.data(), footer.size());
+        write_u32(static_cast<uint32_t>(footer.size()));
+        write_bytes("ARROW1", 6);
+    }
+};
+
+/**
+ * @brief Source of the time column of one trajectory
+ *
+ * Either an explicit vector or an implicit uniform grid that is only
+ * materialized batch by batch.
+ */
+struct TimeColumn {
+    const vector<double> *explicit_times = nullptr; ///< Stored time points
+    double start_time = 0.0; ///< First time point of an implicit grid
+    double time_step = 0.0; ///< Spacing of an implicit grid
+};
+
+auto write_trajectory_table(const string &filename,
+                            const vector<TimeColumn> &times,
+                            const vector<const vector<double> *> &positions,
+                            const vector<string> &ids,
+                            const ArrowOptions &options) -> Result<int> {
+    if (options.batch_rows == 0) {
+        return Err(Error::InvalidArgument("batch_rows must be positive"));
+    }
+    if (!ids.empty() && ids.size() != positions.size()) {
+        return Err(Error::InvalidArgument(
+            "The number of trajectory ids must match the number of trajectories"));
+    }
+    vector<string> labels = ids;
+    if (labels.empty()) {
+        for (size_t i = 0; i < positions.size(); ++i) {
+            labels.push_back(std::to_string(i));
+        }
+    }
+
+    IpcWriter writer(filename, options.format,
+                     {{"trajectory_id", true}, {"time", false}, {"position", false}});
+    if (!writer.is_open()) {
+        return Err(Error::IoError("Failed to open file for writing: " + filename));
+    }
+    writer.begin();
+    writer.dictionary(labels);
+
+    vector<int32_t> id_scratch;
+    vector<double> time_scratch;
+    size_t traj = 0;
+    size_t row_in_traj = 0;
+    while (traj < positions.size()) {
+        BodyBuffer id_buffer;
+        BodyBuffer time_buffer;
+        BodyBuffer position_buffer;
+        id_scratch.clear();
+        time_scratch.clear();
+        size_t rows = 0;
+
+        // First pass: collect the row ranges of this batch.
+        struct Range {
+            size_t traj;
+            size_t begin;
+            size_t end;
+        };
+        vector<Range> ranges;
+        while (traj < positions.size() && rows < options.batch_rows) {
+            size_t length = positions[traj]->size();
+            size_t take = std::min(length - row_in_traj, options.batch_rows - rows);
+            if (take > 0) {
+                ranges.push_back({traj, row_in_traj, row_in_traj + take});
+            }
+            rows += take;
+            row_in_traj += take;
+            if (row_in_traj == length) {
+                ++traj;
+                row_in_traj = 0;
+            }
+        }
+        if (rows == 0) {
+            break;
+        }
+
+        // Materialize ids and implicit times, then reference stored data.
+        id_scratch.reserve(rows);
+        for (const auto &[k, begin, end]: ranges) {
+            id_scratch.insert(id_scratch.end(), end - begin, static_cast<int32_t>(k));
+            if (times[k].explicit_times == nullptr) {
+                for (size_t i = begin; i < end; ++i) {
+                    time_scratch.push_back(times[k].start_time +
+                                           (static_cast<double>(i) * times[k].time_step));
+                }
+            }
+        }
+        size_t implicit_cursor = 0;
+        for (const auto &[k, begin, end]: ranges) {
+            if (const auto *t = times[k].explicit_times; t != nullptr) {
+                time_buffer.segments.push_back(as_bytes_span(
+                    std::span<const double>(*t).subspan(begin, end - begin)));
+            } else {
+                time_buffer.segments.push_back(as_bytes_span(
+                    std::span<const double>(time_scratch).subspan(implicit_cursor, end - begin)));
+                implicit_cursor += end - begin;
+            }
+            position_buffer.segments.push_back(as_bytes_span(
+                std::span<const double>(*positions[k]).subspan(begin, end - begin)));
+        }
+        id_buffer.segments.push_back(as_bytes_span(std::span<const int32_t>(id_scratch)));
+
+        writer.record_batch(rows, {BodyBuffer{}, id_buffer, BodyBuffer{}, time_buffer,
+                                   BodyBuffer{}, position_buffer});
+    }
+    writer.finish();
+    if (!writer.good()) {
+        return Err(Error::IoError("Failed to write file: " + filename));
+    }
+    return Ok(0);
+}
+
+/**
+ * @brief Writes multiple trajectories to an Arrow IPC file or stream
+ * @param filename The output filename
+ * @param trajectories Vector of trajectory pairs (times, positions)
+ * @param ids Optional trajectory labels (defaults to "0", "1", ...)
+ * @param options Container flavour and record batch size
+ * @return Result indicating success or an Error
+ *
+ * The output has the same rows as `write_multiple_trajectories_csv`, with the
+ * trajectory id dictionary-encoded.
+ */
+export Result<int> write_trajectories_arrow(
+    const string &filename,
+    const vector<vec_pair> &trajectories,
+    const vector<string> &ids = {},
+    const ArrowOptions &options = {}
+) {
+    if (trajectories.empty()) {
+        return Err(Error::InvalidArgument("Trajectories vector cannot be empty"));
+    }
+    vector<TimeColumn> times;
+    vector<const vector<double> *> positions;
+    for (size_t i = 0; i < trajectories.size(); ++i) {
+        const auto &[t, x] = trajectories[i];
+        if (t.size() != x.size()) {
+            return Err(Error::InvalidArgument(
+                "Times and positions vectors must have the same size for trajectory " +
+                std::to_string(i)));
+        }
+        times.push_back({&t});
+        positions.push_back(&x);
+    }
+    return write_trajectory_table(filename, times, positions, ids, options);
+}
+
+/**
+ * @brief Writes trajectories sampled on a uniform grid to an Arrow IPC file
+ * @param filename The output filename
+ * @param positions Positions of each trajectory, sampled at start_time + i * time_step
+ * @param time_step The spacing of the time grid (must be positive)
+ * @param start_time The first time point
+ * @param ids Optional trajectory labels (defaults to "0", "1", ...)
+ * @param options Container flavour and record batch size
+ * @return Result indicating success or an Error
+ *
+ * The time column is never stored in memory as a whole; it is materialized
+ * per record batch while writing.
+ */
+export Result<int> write_uniform_trajectories_arrow(
+    const string &filename,
+    const vector<vector<double> > &positions,
+    double time_step,
+    double start_time = 0.0,
+    const vector<string> &ids = {},
+    const ArrowOptions &options = {}
+) {
+    if (positions.empty()) {
+        return Err(Error::InvalidArgument("Trajectories vector cannot be empty"));
+    }
+    if (time_step <= 0) {
+        return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    vector<TimeColumn> times(positions.size(), TimeColumn{nullptr, start_time, time_step});
+    vector<const vector<double> *> columns;
+    for (const auto &x: positions) {
+        columns.push_back(&x);
+    }
+    return write_trajectory_table(filename, times, columns, ids, options);
+}
+
+/**
+ * @brief Writes an analysis table of float64 columns to an Arrow IPC file
+ * @param filename The output filename
+ * @param names Column names
+ * @param columns Column data, all of the same length
+ * @param options Container flavour and record batch size
+ * @return Result indicating success or an Error
+ *
+ * Typical uses are lag time / TAMSD or time / MSD tables.
+ */
+export Result<int> write_table_arrow(
+    const string &filename,
+    const vector<string> &names,
+    const vector<vector<double> > &columns,
+    const ArrowOptions &options = {}
+) {
+    if (columns.empty() || names.size() != columns.size()) {
+        return Err(Error::InvalidArgument(
+            "Each column must have exactly one name and at least one column is required"));
+    }
+    if (options.batch_rows == 0) {
+        return Err(Error::InvalidArgument("batch_rows must be positive"));
+    }
+    size_t rows = columns[0].size();
+    for (const auto &column: columns) {
+        if (column.size() != rows) {
+            return Err(Error::InvalidArgument("All columns must have the same size"));
+        }
+    }
+
+    vector<ArrowColumn> schema;
+    for (const auto &name: names) {
+        schema.push_back({name, false});
+    }
+    IpcWriter writer(filename, options.format, schema);
+    if (!writer.is_open()) {
+        return Err(Error::IoError("Failed to open file for writing: " + filename));
+    }
+    writer.begin();
+    size_t begin = 0;
+    do {
+        size_t count = std::min(options.batch_rows, rows - begin);
+        vector<BodyBuffer> body;
+        for (const auto &column: columns) {
+            body.push_back(BodyBuffer{});
+            body.push_back(BodyBuffer{{as_bytes_span(
+                std::span<const double>(column).subspan(begin, count))}});
+        }
+        writer.record_batch(count, body);
+        begin += count;
+    } while (begin < rows);
+    writer.finish();
+    if (!writer.good()) {
+        return Err(Error::IoError("Failed to write file: " + filename));
+    }
+    return Ok(0);
+}
@@ -0,0 +1,290 @@
+/**
+ * @file blocking.cppm
+ * @brief Flyvbjerg-Petersen blocking analysis of correlated time series
+ *
+ * The time average of an observable along one long trajectory is
+ * autocorrelated, so the naive standard error σ/√N underestimates the
+ * error by the factor √(2τ), τ the integrated autocorrelation time in
+ * samples. Blocking repeatedly averages neighbouring pairs of values; once
+ * the blocks are longer than the correlation time the block means are
+ * independent and their standard error is the true one. Each level only
+ * needs its running moments and at most one unpaired value, so the
+ * analysis streams in O(log N) memory.
+ */
+
+module;
+
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+export module diffusionx.simulation.basic.blocking;
+
+import diffusionx.error;
+import diffusionx.memory;
+import diffusionx.simulation.basic.observable;
+import diffusionx.simulation.basic.stepper;
+
+using std::vector;
+
+/**
+ * @brief Statistics of one blocking level
+ */
+export struct BlockingLevel {
+    size_t block_size = 1; ///< Samples per block, 2^level
+    size_t blocks = 0; ///< Number of complete blocks
+    double standard_error = 0.0; ///< Standard error of the mean from the blocks
+    double error_of_error = 0.0; ///< Statistical error of standard_error
+};
+
+/**
+ * @brief Error estimate of a time average from blocking
+ */
+export struct BlockingEstimate {
+    size_t samples = 0; ///< Number of samples N
+    double mean = 0.0; ///< Time average of the samples
+    double naive_error = 0.0; ///< σ/√N, ignoring correlations
+    double standard_error = 0.0; ///< Standard error at the chosen level
+    double error_of_error = 0.0; ///< Statistical error of standard_error
+    double integrated_autocorrelation_time = 0.0; ///< τ, in units of sample_interval
+    double sample_interval = 1.0; ///< Time between samples
+    size_t block_size = 1; ///< Block size of the chosen level
+    bool converged = false; ///< Whether a level satisfied the plateau criterion
+};
+
+/**
+ * @brief Streaming Flyvbjerg-Petersen blocking accumulator
+ *
+ * The reported level is the smallest block size B with B³ > 2N g_B², where
+ * g_B = (SE_B / SE_1)² is the statistical inefficiency seen at that level
+ * (Lee, Needs and Drummond). Below it the blocks are still correlated;
+ * above it the error estimate only gets noisier. τ is reported in the
+ * convention where uncorrelated samples have τ = 1/2, so that the true
+ * error is √(2τ) times the naive one.
+ */
+export class BlockingAccumulator {
+    vector<RunningStats> m_levels; ///< Block means of each level
+    vector<double> m_pending; ///< Unpaired value of each level
+    vector<char> m_has_pending; ///< Whether a level holds an unpaired value
+    double m_sample_interval; ///< Time between samples
+
+public:
+    /**
+     * @brief Constructor
+     * @param sample_interval Time between samples, to report τ in time units
+     */
+    explicit BlockingAccumulator(double sample_interval = 1.0)
+        : m_sample_interval(sample_interval) {
+    }
+
+    /**
+     * @brief Adds a sample
+     * @param x The value of the observable
+     */
+    void push(double x) {
+        for (size_t k = 0;; ++k) {
+            if (k == m_levels.size()) {
+                m_levels.emplace_back();
+                m_pending.push_back(0.0);
+                m_has_pending.push_back(0);
+            }
+            m_levels[k].push(x);
+            if (m_has_pending[k] == 0) {
+                m_pending[k] = x;
+                m_has_pending[k] = 1;
+                return;
+            }
+            x = 0.5 * (m_pending[k] + x);
+            m_has_pending[k] = 0;
+        }
+    }
+
+    /**
+     * @brief Adds consecutive samples
+     * @param xs The values, in time order
+     */
+    void push(std::span<const double> xs) {
+        for (double x: xs) {
+            push(x);
+        }
+    }
+
+    /**
+     * @brief Gets the number of samples
+     * @return N
+     */
+    [[nodiscard]] auto count() const -> size_t {
+        return m_levels.empty() ? 0 : m_levels[0].count();
+    }
+
+    /**
+     * @brief Gets the statistics of every level with at least two blocks
+     * @return The levels, by increasing block size
+     */
+    [[nodiscard]] auto levels() const -> vector<BlockingLevel> {
+        vector<BlockingLevel> result;
+        for (size_t k = 0; k < m_levels.size() && m_levels[k].count() >= 2; ++k) {
+            BlockingLevel level;
+            level.block_size = size_t{1} << k;
+            level.blocks = m_levels[k].count();
+            level.standard_error = m_levels[k].standard_error();
+            level.error_of_error =
+                level.standard_error / std::sqrt(2.0 * static_cast<double>(level.blocks - 1));
+            result.push_back(level);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Computes the error estimate
+     * @return Result containing the estimate, or an Error if there are fewer
+     * than two samples or they are all equal
+     *
+     * If no level satisfies the plateau criterion yet, the largest level
+     * with at least four blocks is reported with `converged` false; its
+     * error is then a lower bound.
+     */
+    [[nodiscard]] auto estimate() const -> Result<BlockingEstimate> {
+        auto all = levels();
+        if (all.empty()) {
+            return Err(Error::InvalidArgument("At least two samples are required"));
+        }
+        BlockingEstimate result;
+        result.samples = count();
+        result.mean = m_levels[0].mean();
+        result.naive_error = all[0].standard_error;
+        result.sample_interval = m_sample_interval;
+        if (result.naive_error == 0.0) {
+            return Err(Error::InvalidArgument("The samples have zero variance"));
+        }
+        auto n = static_cast<double>(result.samples);
+        Option<size_t> chosen;
+        Option<size_t> fallback;
+        for (size_t k = 0; k < all.size(); ++k) {
+            if (all[k].blocks < 4) {
+                break;
+            }
+            fallback = k;
+            double ratio = all[k].standard_error / result.naive_error;
+            double inefficiency = ratio * ratio;
+            auto b = static_cast<double>(all[k].block_size);
+            if (b * b * b > 2.0 * n * inefficiency * inefficiency) {
+                chosen = k;
+                break;
+            }
+        }
+        size_t k = chosen.value_or(fallback.value_or(0));
+        result.converged = chosen.has_value();
+        result.block_size = all[k].block_size;
+        result.standard_error = all[k].standard_error;
+        result.error_of_error = all[k].error_of_error;
+        double ratio = result.standard_error / result.naive_error;
+        result.integrated_autocorrelation_time = 0.5 * ratio * ratio * m_sample_interval;
+        return Ok(result);
+    }
+};
+
+/**
+ * @brief Series of squared lag increments, whose time average is the TAMSD
+ *
+ * Called with consecutive points of a path, returns (x(t) - x(t - Δ))² with
+ * Δ = lag_steps grid steps, or None for the first lag_steps points.
+ */
+export class TamsdSeries {
+    vector<double> m_history; ///< Last lag_steps positions, ring buffer
+    size_t m_head = 0; ///< Oldest position in the ring buffer
+    size_t m_seen = 0; ///< Number of points seen
+
+public:
+    /**
+     * @brief Constructor
+     * @param lag_steps The lag Δ in grid steps (must be positive)
+     * @throws std::invalid_argument if lag_steps is zero
+     */
+    explicit TamsdSeries(size_t lag_steps) : m_history(lag_steps) {
+        if (lag_steps == 0) {
+            throw std::invalid_argument("Lag must be positive");
+        }
+    }
+
+    auto operator()(double /*time*/, double position) -> Option<double> {
+        double old = m_history[m_head];
+        m_history[m_head] = position;
+        m_head = m_head + 1 == m_history.size() ? 0 : m_head + 1;
+        if (m_seen++ < m_history.size()) {
+            return std::nullopt;
+        }
+        double d = position - old;
+        return d * d;
+    }
+};
+
+/**
+ * @brief Runs a stepper until a time average reaches a target precision
+ * @tparam F Callable (double t, double x) returning the observable as double,
+ * or as Option<double> to skip points
+ * @param stepper The stepper generating the trajectory
+ * @param series Maps each point of the path to the observable, e.g.
+ * `[](double, double x) { return x; }` for the mean position,
+ * `[](double, double x) { return x > 0 ? 1.0 : 0.0; }` for an occupation
+ * fraction, or a `TamsdSeries`
+ * @param target_error Stop once the converged standard error is at most this
+ * @param max_duration Stop after this much simulated time in any case
+ * @param block_size Points generated per block; precision is checked after
+ * each block
+ * @return Result containing the estimate at the stopping time, or an Error
+ *
+ * The current point of the stepper is the first sample. If max_duration is
+ * reached first, the estimate at that time is returned; its standard error
+ * is then above the target or not yet `converged`.
+ */
+export template<typename F>
+auto run_blocking(Stepper &stepper, F &&series, double target_error, double max_duration,
+                  size_t block_size = stepper_block_size) -> Result<BlockingEstimate> {
+    if (!(target_error > 0)) {
+        return Err(Error::InvalidArgument(
+            std::format("The target error must be positive, but got {}", target_error)));
+    }
+    if (max_duration <= 0) {
+        return Err(Error::InvalidArgument("Maximum duration must be positive"));
+    }
+    if (block_size == 0) {
+        return Err(Error::InvalidArgument("Block size must be positive"));
+    }
+    BlockingAccumulator acc(stepper.get_time_step());
+    auto feed = [&](double t, double x) {
+        if constexpr (std::is_convertible_v<std::invoke_result_t<F &, double, double>, double>) {
+            acc.push(static_cast<double>(series(t, x)));
+        } else if (auto value = series(t, x)) {
+            acc.push(*value);
+        }
+    };
+    feed(stepper.get_time(), stepper.get_position());
+    auto num_steps = static_cast<size_t>(std::ceil(max_duration / stepper.get_time_step()));
+    buffer<double> times(std::min(block_size, num_steps));
+    buffer<double> positions(times.size());
+    for (size_t done = 0; done < num_steps;) {
+        size_t count = std::min(times.size(), num_steps - done);
+        auto t = std::span(times).first(count);
+        auto x = std::span(positions).first(count);
+        stepper.advance(t, x);
+        for (size_t i = 0; i < count; ++i) {
+            feed(t[i], x[i]);
+        }
+        done += count;
+        if (acc.count() >= 2) {
+            auto current = acc.estimate();
+            if (current && current->converged && current->standard_error <= target_error) {
+                return current;
+            }
+        }
+    }
+    return acc.estimate();
+}
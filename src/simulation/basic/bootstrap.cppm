@@ -0,0 +1,663 @@
+/**
+ * @file bootstrap.cppm
+ * @brief Streaming Poisson bootstrap confidence intervals
+ *
+ * The ordinary bootstrap resamples the whole ensemble B times. The Poisson
+ * bootstrap instead gives observation i the weight w_ib ~ Poisson(1) in
+ * replicate b, which has the same large-sample behaviour and can be
+ * accumulated in one pass: every observation adds w_ib f_i to B running
+ * sums of its features f_i, and the replicate statistic is evaluated on the
+ * weighted means at the end. The weights are a pure function of
+ * (seed, i, b), so nothing is copied or stored per observation and the
+ * result does not depend on how the ensemble is split over threads.
+ *
+ * Intervals are either the percentile interval of the replicates or the
+ * bias-corrected and accelerated (BCa) interval, whose acceleration comes
+ * from a grouped jackknife kept alongside the replicates.
+ */
+
+module;
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.simulation.basic.bootstrap;
+
+import diffusionx.error;
+import diffusionx.random.utils;
+import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.tamsd;
+
+using std::vector;
+
+/**
+ * @brief Counter-based hash of a seed, an observation and a replicate pair
+ * @param seed The bootstrap seed
+ * @param index The observation index
+ * @param pair The index of a pair of replicates
+ * @return 64 well-mixed bits
+ */
+auto bootstrap_hash(uint64_t seed, uint64_t index, uint64_t pair) -> uint64_t {
+    uint64_t z = seed ^ (index * 0x9e3779b97f4a7c15ULL) ^ (pair * 0xd1b54a32d192ed03ULL);
+    for (int round = 0; round < 2; ++round) {
+        z += 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+    }
+    return z;
+}
+
+/**
+ * @brief Largest Poisson(1) weight that is generated, P(w > 12) < 2^-32
+ */
+constexpr size_t bootstrap_max_weight = 12;
+
+/**
+ * @brief 2^32 P(Poisson(1) <= k) for k = 0..11, rounded
+ */
+constexpr auto poisson_one_thresholds() -> std::array<uint64_t, bootstrap_max_weight> {
+    std::array<uint64_t, bootstrap_max_weight> thresholds{};
+    // e^-1 / k!, accumulated in long double at compile time
+    long double term = 0.36787944117144232159552377016146087L;
+    long double cdf = 0.0L;
+    for (size_t k = 0; k < bootstrap_max_weight; ++k) {
+        cdf += term;
+        term /= static_cast<long double>(k + 1);
+        thresholds[k] = static_cast<uint64_t>((cdf * 4294967296.0L) + 0.5L);
+    }
+    return thresholds;
+}
+
+constexpr auto bootstrap_thresholds = poisson_one_thresholds();
+
+/**
+ * @brief Maps 32 random bits to a Poisson(1) weight by inversion
+ * @param u Uniform 32-bit integer
+ * @return The number of thresholds not exceeding u
+ */
+auto poisson_one_weight(uint64_t u) -> uint32_t {
+    uint32_t w = 0;
+    for (uint64_t threshold: bootstrap_thresholds) {
+        w += u >= threshold ? 1 : 0;
+    }
+    return w;
+}
+
+/**
+ * @brief Standard normal distribution function Φ(x)
+ */
+auto standard_normal_cdf(double x) -> double {
+    return 0.5 * std::erfc(-x / std::numbers::sqrt2);
+}
+
+/**
+ * @brief Standard normal quantile function Φ⁻¹(p) for p in (0, 1)
+ *
+ * Acklam's rational approximation (relative error 1e-9) refined by one
+ * Halley step.
+ */
+auto standard_normal_quantile(double p) -> double {
+    constexpr std::array<double, 6> a{-3.969683028665376e+01, 2.209460984245205e+02,
+                                      -2.759285104469687e+02, 1.383577518672690e+02,
+                                      -3.066479806614716e+01, 2.506628277459239e+00};
+    constexpr std::array<double, 5> b{-5.447609879822406e+01, 1.615858368580409e+02,
+                                      -1.556989798598866e+02, 6.680131188771972e+01,
+                                      -1.328068155288572e+01};
+    constexpr std::array<double, 6> c{-7.784894002430293e-03, -3.223964580411365e-01,
+                                      -2.400758277161838e+00, -2.549732539343734e+00,
+                                      4.374664141464968e+00, 2.938163982698783e+00};
+    constexpr std::array<double, 4> d{7.784695709041462e-03, 3.224671290700398e-01,
+                                      2.445134137142996e+00, 3.754408661907416e+00};
+    constexpr double low = 0.02425;
+    double x = 0.0;
+    if (p < low || p > 1.0 - low) {
+        double q = std::sqrt(-2.0 * std::log(p < low ? p : 1.0 - p));
+        x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        x = p < low ? x : -x;
+    } else {
+        double q = p - 0.5;
+        double r = q * q;
+        x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    }
+    double e = standard_normal_cdf(x) - p;
+    double u = e * std::sqrt(2.0 * std::numbers::pi) * std::exp(0.5 * x * x);
+    return x - (u / (1.0 + (0.5 * x * u)));
+}
+
+/**
+ * @brief Type-7 quantile of sorted values
+ */
+auto sorted_quantile(const vector<double> &sorted, double p) -> double {
+    double h = p * static_cast<double>(sorted.size() - 1);
+    auto lo = static_cast<size_t>(std::floor(h));
+    size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + ((h - static_cast<double>(lo)) * (sorted[hi] - sorted[lo]));
+}
+
+/**
+ * @brief Kind of bootstrap confidence interval
+ */
+export enum class BootstrapMethod {
+    Percentile, ///< Quantiles of the replicates
+    BCa, ///< Bias-corrected and accelerated quantiles
+};
+
+/**
+ * @brief A bootstrap confidence interval
+ */
+export struct ConfidenceInterval {
+    double estimate = 0.0; ///< The statistic on the full sample
+    double lower = 0.0; ///< Lower end of the interval
+    double upper = 0.0; ///< Upper end of the interval
+    double standard_error = 0.0; ///< Standard deviation of the replicates
+    double bias = 0.0; ///< Mean of the replicates minus the estimate
+    size_t replicates = 0; ///< Number of replicates used
+};
+
+/**
+ * @brief Streaming Poisson bootstrap of a smooth function of feature means
+ *
+ * Each observation contributes a fixed number of features, e.g. δ² and δ⁴
+ * of one trajectory for the ergodicity breaking parameter; the statistic is
+ * any function of the means of the features. An accumulator holds B
+ * replicate sums and G jackknife group sums, O((B + G) F) memory
+ * independent of the number of observations, and accumulators filled by
+ * different threads are merged by addition.
+ */
+export class PoissonBootstrap {
+    size_t m_features; ///< Features per observation F
+    size_t m_replicates; ///< Number of replicates B
+    size_t m_groups; ///< Number of jackknife groups G
+    uint64_t m_seed; ///< Seed of the replicate weights
+    size_t m_count = 0; ///< Number of observations
+    vector<double> m_total; ///< Sums of the features over all observations
+    vector<double> m_weights; ///< Total weight of each replicate
+    vector<double> m_sums; ///< Weighted feature sums, replicate-major
+    vector<double> m_group_sums; ///< Feature sums of each jackknife group
+    vector<size_t> m_group_counts; ///< Observations in each jackknife group
+
+    template<typename F>
+    [[nodiscard]] auto evaluate(F &statistic, std::span<const double> sums, double weight,
+                                vector<double> &means) const -> double {
+        for (size_t j = 0; j < m_features; ++j) {
+            means[j] = sums[j] / weight;
+        }
+        return statistic(std::span<const double>(means));
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param features Number of features per observation (must be positive)
+     * @param replicates Number of bootstrap replicates B (at least 2)
+     * @param seed Seed of the replicate weights; accumulators to be merged
+     * must share it
+     * @param groups Number of jackknife groups used for the BCa acceleration
+     * @throws std::invalid_argument if a size is invalid
+     */
+    PoissonBootstrap(size_t features, size_t replicates, uint64_t seed, size_t groups = 100)
+        : m_features(features), m_replicates(replicates), m_groups(groups), m_seed(seed),
+          m_total(features, 0.0), m_weights(replicates, 0.0),
+          m_sums(replicates * features, 0.0), m_group_sums(groups * features, 0.0),
+          m_group_counts(groups, 0) {
+        if (features == 0) {
+            throw std::invalid_argument("The number of features must be positive");
+        }
+        if (replicates < 2) {
+            throw std::invalid_argument("At least 2 bootstrap replicates are required");
+        }
+        if (groups < 2) {
+            throw std::invalid_argument("At least 2 jackknife groups are required");
+        }
+    }
+
+    /**
+     * @brief Adds one observation
+     * @param index Index of the observation in the ensemble, which fixes its
+     * replicate weights; every index must be pushed at most once
+     * @param features The features of the observation (size F)
+     */
+    void push(uint64_t index, std::span<const double> features) {
+        const double *f = features.data();
+        for (size_t j = 0; j < m_features; ++j) {
+            m_total[j] += f[j];
+        }
+        double *group = &m_group_sums[(index % m_groups) * m_features];
+        for (size_t j = 0; j < m_features; ++j) {
+            group[j] += f[j];
+        }
+        ++m_group_counts[index % m_groups];
+        ++m_count;
+        // Two 32-bit weights per hash
+        for (size_t b = 0; b < m_replicates; b += 2) {
+            uint64_t bits = bootstrap_hash(m_seed, index, b / 2);
+            std::array<uint32_t, 2> w{poisson_one_weight(bits & 0xffffffffULL),
+                                      poisson_one_weight(bits >> 32)};
+            size_t pair = std::min<size_t>(2, m_replicates - b);
+            for (size_t k = 0; k < pair; ++k) {
+                if (w[k] == 0) {
+                    continue;
+                }
+                auto weight = static_cast<double>(w[k]);
+                m_weights[b + k] += weight;
+                double *sums = &m_sums[(b + k) * m_features];
+                for (size_t j = 0; j < m_features; ++j) {
+                    sums[j] += weight * f[j];
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Adds the observations of another accumulator
+     * @param other An accumulator with the same sizes and seed
+     * @return Result indicating success, or an Error if they differ
+     */
+    auto merge(const PoissonBootstrap &other) -> Result<int> {
+        if (other.m_features != m_features || other.m_replicates != m_replicates ||
+            other.m_groups != m_groups || other.m_seed != m_seed) {
+            return Err(Error::InvalidArgument(
+                "Bootstrap accumulators must have the same sizes and seed to be merged"));
+        }
+        m_count += other.m_count;
+        for (size_t j = 0; j < m_features; ++j) {
+            m_total[j] += other.m_total[j];
+        }
+        for (size_t b = 0; b < m_replicates; ++b) {
+            m_weights[b] += other.m_weights[b];
+        }
+        for (size_t k = 0; k < m_sums.size(); ++k) {
+            m_sums[k] += other.m_sums[k];
+        }
+        for (size_t k = 0; k < m_group_sums.size(); ++k) {
+            m_group_sums[k] += other.m_group_sums[k];
+        }
+        for (size_t g = 0; g < m_groups; ++g) {
+            m_group_counts[g] += other.m_group_counts[g];
+        }
+        return Ok(0);
+    }
+
+    /**
+     * @brief Gets the number of observations
+     * @return The number of pushed observations
+     */
+    [[nodiscard]] auto count() const -> size_t {
+        return m_count;
+    }
+
+    /**
+     * @brief Gets the number of replicates
+     * @return B
+     */
+    [[nodiscard]] auto get_replicates() const -> size_t {
+        return m_replicates;
+    }
+
+    /**
+     * @brief Evaluates the statistic on every replicate
+     * @tparam F Callable taking the feature means as span<const double>
+     * @param statistic The statistic
+     * @return The replicate values; NaN for a replicate with zero total weight
+     */
+    template<typename F>
+    [[nodiscard]] auto replicate_values(F statistic) const -> vector<double> {
+        vector<double> values(m_replicates);
+        vector<double> means(m_features);
+        for (size_t b = 0; b < m_replicates; ++b) {
+            values[b] = m_weights[b] > 0
+                            ? evaluate(statistic,
+                                       std::span(m_sums).subspan(b * m_features, m_features),
+                                       m_weights[b], means)
+                            : std::numeric_limits<double>::quiet_NaN();
+        }
+        return values;
+    }
+
+    /**
+     * @brief Computes a confidence interval for the statistic
+     * @tparam F Callable taking the feature means as span<const double>
+     * @param statistic The statistic
+     * @param level The confidence level, in (0, 1)
+     * @param method Percentile or BCa interval
+     * @return Result containing the interval, or an Error
+     *
+     * BCa uses the bias correction z0 = Φ⁻¹(#{θ*_b < θ̂} / B) and the
+     * acceleration a = Σ d_g³ / (6 (Σ d_g²)^(3/2)) with d_g the deviations
+     * of the leave-one-group-out estimates from their mean. With fewer
+     * observations than groups this is the ordinary jackknife.
+     */
+    template<typename F>
+    [[nodiscard]] auto interval(F statistic, double level = 0.95,
+                                BootstrapMethod method = BootstrapMethod::BCa) const
+        -> Result<ConfidenceInterval> {
+        if (!(level > 0 && level < 1)) {
+            return Err(Error::InvalidArgument(
+                std::format("The confidence level must be in (0, 1), but got {}", level)));
+        }
+        if (m_count < 2) {
+            return Err(Error::InvalidArgument("At least 2 observations are required"));
+        }
+        vector<double> means(m_features);
+        ConfidenceInterval result;
+        result.estimate = evaluate(statistic, m_total, static_cast<double>(m_count), means);
+        vector<double> values;
+        values.reserve(m_replicates);
+        for (double v: replicate_values(statistic)) {
+            if (std::isfinite(v)) {
+                values.push_back(v);
+            }
+        }
+        if (values.size() < 2) {
+            return Err(Error::SimulationFailed("Fewer than 2 finite bootstrap replicates"));
+        }
+        std::ranges::sort(values);
+        auto n = static_cast<double>(values.size());
+        double mean = 0.0;
+        for (double v: values) {
+            mean += v;
+        }
+        mean /= n;
+        double ss = 0.0;
+        for (double v: values) {
+            ss += (v - mean) * (v - mean);
+        }
+        result.standard_error = std::sqrt(ss / (n - 1.0));
+        result.bias = mean - result.estimate;
+        result.replicates = values.size();
+
+        double alpha = 0.5 * (1.0 - level);
+        double p_lower = alpha;
+        double p_upper = 1.0 - alpha;
+        if (method == BootstrapMethod::BCa) {
+            auto below = static_cast<double>(std::ranges::lower_bound(values, result.estimate) -
+                                             values.begin());
+            auto ties = static_cast<double>(std::ranges::upper_bound(values, result.estimate) -
+                                            values.begin()) - below;
+            double share = std::clamp((below + (0.5 * ties)) / n, 0.5 / n, 1.0 - (0.5 / n));
+            double z0 = standard_normal_quantile(share);
+
+            vector<double> jack;
+            jack.reserve(m_groups);
+            vector<double> rest(m_features);
+            for (size_t g = 0; g < m_groups; ++g) {
+                size_t left = m_count - m_group_counts[g];
+                if (m_group_counts[g] == 0 || left == 0) {
+                    continue;
+                }
+                for (size_t j = 0; j < m_features; ++j) {
+                    rest[j] = m_total[j] - m_group_sums[(g * m_features) + j];
+                }
+                double v = evaluate(statistic, rest, static_cast<double>(left), means);
+                if (std::isfinite(v)) {
+                    jack.push_back(v);
+                }
+            }
+            double acceleration = 0.0;
+            if (jack.size() >= 2) {
+                double jack_mean = 0.0;
+                for (double v: jack) {
+                    jack_mean += v;
+                }
+                jack_mean /= static_cast<double>(jack.size());
+                double s2 = 0.0;
+                double s3 = 0.0;
+                for (double v: jack) {
+                    double d = jack_mean - v;
+                    s2 += d * d;
+                    s3 += d * d * d;
+                }
+                acceleration = s2 > 0 ? s3 / (6.0 * std::pow(s2, 1.5)) : 0.0;
+            }
+            auto adjust = [z0, acceleration](double p) {
+                double z = z0 + standard_normal_quantile(p);
+                return standard_normal_cdf(z0 + (z / (1.0 - (acceleration * z))));
+            };
+            p_lower = adjust(alpha);
+            p_upper = adjust(1.0 - alpha);
+        }
+        result.lower = sorted_quantile(values, p_lower);
+        result.upper = sorted_quantile(values, p_upper);
+        return Ok(result);
+    }
+};
+
+/**
+ * @brief Fills bootstrap accumulators over an index range in parallel
+ * @tparam F Callable (size_t index, span<double> features) -> bool, returning
+ * false to skip the observation
+ * @param n Number of observations
+ * @param features Features per observation
+ * @param replicates Number of replicates
+ * @param seed Seed of the replicate weights
+ * @param fill Computes the features of one observation
+ * @return The merged accumulator
+ *
+ * Each placed worker owns one accumulator over a contiguous range of
+ * indices; the accumulators are merged at the end.
+ */
+template<typename F>
+auto bootstrap_accumulate(size_t n, size_t features, size_t replicates, uint64_t seed,
+                          F &&fill) -> PoissonBootstrap {
+    size_t workers = std::max<size_t>(1, std::min(default_workers(), n));
+    vector<PoissonBootstrap> partial(workers, PoissonBootstrap(features, replicates, seed));
+    run_placed(workers, workers, [&](size_t begin, size_t end) {
+        vector<double> f(features);
+        for (size_t w = begin; w < end; ++w) {
+            size_t first = (w * (n / workers)) + std::min(w, n % workers);
+            size_t share = (n / workers) + (w < n % workers ? 1 : 0);
+            for (size_t i = first; i < first + share; ++i) {
+                if (fill(i, std::span(f))) {
+                    partial[w].push(i, f);
+                }
+            }
+        }
+    });
+    for (size_t w = 1; w < workers; ++w) {
+        (void) partial[0].merge(partial[w]);
+    }
+    return std::move(partial[0]);
+}
+
+/**
+ * @brief Draws a random bootstrap seed
+ */
+auto bootstrap_seed() -> uint64_t {
+    auto gen = generator();
+    return (static_cast<uint64_t>(gen()) << 32) | gen();
+}
+
+/**
+ * @brief Bootstrap confidence interval of the ergodicity breaking parameter
+ * @param trajectories Vector of trajectory data
+ * @param lag_time The lag time for computing the TAMSD
+ * @param replicates Number of bootstrap replicates
+ * @param level The confidence level
+ * @param method Percentile or BCa interval
+ * @return Result containing the interval around the value of
+ * `ergodicity_breaking_parameter`, or an Error
+ *
+ * Trajectories whose TAMSD is not defined at the lag are skipped, as in
+ * `tamsd_distribution`.
+ */
+export auto bootstrap_ergodicity_breaking(const vector<vector<double> > &trajectories,
+                                          size_t lag_time, size_t replicates = 1000,
+                                          double level = 0.95,
+                                          BootstrapMethod method = BootstrapMethod::BCa)
+    -> Result<ConfidenceInterval> {
+    if (trajectories.empty()) {
+        return Err(Error::InvalidArgument("Trajectories vector cannot be empty"));
+    }
+    if (replicates < 2) {
+        return Err(Error::InvalidArgument("At least 2 bootstrap replicates are required"));
+    }
+    auto boot = bootstrap_accumulate(
+        trajectories.size(), 2, replicates, bootstrap_seed(),
+        [&](size_t i, std::span<double> f) {
+            auto delta = tamsd(trajectories[i], lag_time);
+            if (!delta) {
+                return false;
+            }
+            f[0] = delta.value();
+            f[1] = delta.value() * delta.value();
+            return true;
+        });
+    return boot.interval(
+        [](std::span<const double> m) { return ((m[0] * m[0]) / m[1]) - 1.0; }, level, method);
+}
+
+/**
+ * @brief Bootstrap confidence interval of the ensemble-averaged TAMSD
+ * @param trajectories Vector of trajectory data
+ * @param lag_time The lag time for computing the TAMSD
+ * @param replicates Number of bootstrap replicates
+ * @param level The confidence level
+ * @param method Percentile or BCa interval
+ * @return Result containing the interval around the value of
+ * `ensemble_tamsd`, or an Error
+ */
+export auto bootstrap_ensemble_tamsd(const vector<vector<double> > &trajectories,
+                                     size_t lag_time, size_t replicates = 1000,
+                                     double level = 0.95,
+                                     BootstrapMethod method = BootstrapMethod::BCa)
+    -> Result<ConfidenceInterval> {
+    if (trajectories.empty()) {
+        return Err(Error::InvalidArgument("Trajectories vector cannot be empty"));
+    }
+    if (replicates < 2) {
+        return Err(Error::InvalidArgument("At least 2 bootstrap replicates are required"));
+    }
+    auto boot = bootstrap_accumulate(
+        trajectories.size(), 1, replicates, bootstrap_seed(),
+        [&](size_t i, std::span<double> f) {
+            auto delta = tamsd(trajectories[i], lag_time);
+            if (!delta) {
+                return false;
+            }
+            f[0] = delta.value();
+            return true;
+        });
+    return boot.interval([](std::span<const double> m) { return m[0]; }, level, method);
+}
+
+/**
+ * @brief Computes a raw or central moment from the raw moments m_1..m_order
+ */
+auto moment_from_raw(std::span<const double> raw, int order, bool central) -> double {
+    if (!central) {
+        return raw[order - 1];
+    }
+    // E[(X - μ)^n] = Σ_k C(n, k) m_k (-μ)^(n - k), m_0 = 1
+    double mu = raw[0];
+    double sum = 0.0;
+    double binomial = 1.0;
+    for (int k = 0; k <= order; ++k) {
+        double mk = k == 0 ? 1.0 : raw[k - 1];
+        sum += binomial * mk * std::pow(-mu, order - k);
+        binomial = binomial * static_cast<double>(order - k) / static_cast<double>(k + 1);
+    }
+    return sum;
+}
+
+/**
+ * @brief Bootstrap confidence interval of a moment of a sample
+ * @param samples The sample, e.g. endpoints of an ensemble
+ * @param order The order of the moment (1 to 8)
+ * @param central Whether to compute the central moment
+ * @param replicates Number of bootstrap replicates
+ * @param level The confidence level
+ * @param method Percentile or BCa interval
+ * @return Result containing the interval, or an Error
+ *
+ * The features are the powers x, x², ..., x^order; a central moment is
+ * recovered from the weighted raw moments of each replicate.
+ */
+export auto bootstrap_moment(std::span<const double> samples, int order, bool central = false,
+                             size_t replicates = 1000, double level = 0.95,
+                             BootstrapMethod method = BootstrapMethod::BCa)
+    -> Result<ConfidenceInterval> {
+    if (order < 1 || order > 8) {
+        return Err(Error::InvalidArgument(
+            std::format("The order must be in [1, 8], but got {}", order)));
+    }
+    if (replicates < 2) {
+        return Err(Error::InvalidArgument("At least 2 bootstrap replicates are required"));
+    }
+    auto boot = bootstrap_accumulate(samples.size(), static_cast<size_t>(order), replicates,
+                                     bootstrap_seed(), [&](size_t i, std::span<double> f) {
+                                         double power = 1.0;
+                                         for (double &fk: f) {
+                                             power *= samples[i];
+                                             fk = power;
+                                         }
+                                         return true;
+                                     });
+    return boot.interval(
+        [order, central](std::span<const double> m) { return moment_from_raw(m, order, central); },
+        level, method);
+}
+
+/**
+ * @brief Bootstrap confidence interval of a moment of a process at a time
+ * @param process The continuous process
+ * @param duration The time at which to compute the moment
+ * @param order The order of the moment (1 to 8)
+ * @param central Whether to compute the central moment
+ * @param particles The number of Monte Carlo samples
+ * @param time_step The time step for discretization
+ * @param replicates Number of bootstrap replicates
+ * @param level The confidence level
+ * @param method Percentile or BCa interval
+ * @return Result containing the interval, or an Error
+ *
+ * The endpoints are pushed into the accumulators as they are simulated and
+ * never stored, like the point estimates of `ContinuousProcess`; particles
+ * whose simulation fails are skipped.
+ */
+export auto bootstrap_moment(ContinuousProcess &process, double duration, int order,
+                             bool central = false, size_t particles = 10000,
+                             double time_step = 0.01, size_t replicates = 1000,
+                             double level = 0.95,
+                             BootstrapMethod method = BootstrapMethod::BCa)
+    -> Result<ConfidenceInterval> {
+    if (order < 1 || order > 8) {
+        return Err(Error::InvalidArgument(
+            std::format("The order must be in [1, 8], but got {}", order)));
+    }
+    if (duration <= 0 || time_step <= 0) {
+        return Err(Error::InvalidArgument("Duration and time step must be positive"));
+    }
+    if (particles == 0) {
+        return Err(Error::InvalidArgument("The number of particles must be greater than 0"));
+    }
+    if (replicates < 2) {
+        return Err(Error::InvalidArgument("At least 2 bootstrap replicates are required"));
+    }
+    auto boot = bootstrap_accumulate(particles, static_cast<size_t>(order), replicates,
+                                     bootstrap_seed(), [&](size_t, std::span<double> f) {
+                                         auto x = process.end(duration, time_step);
+                                         if (!x) {
+                                             return false;
+                                         }
+                                         double power = 1.0;
+                                         for (double &fk: f) {
+                                             power *= x.value();
+                                             fk = power;
+                                         }
+                                         return true;
+                                     });
+    return boot.interval(
+        [order, central](std::span<const double> m) { return moment_from_raw(m, order, central); },
+        level, method);
+}
@@ -0,0 +1,640 @@
+/**
+ * @file cache.cppm
+ * @brief Content-addressed on-disk cache for simulation results
+ *
+ * This module stores the results of expensive simulations (moment curves,
+ * histograms, scalar statistics or whole ensembles) in a cache directory,
+ * keyed by a hash of the full job description. The job description always
+ * includes the library version, so results produced by a different version
+ * are never reused. Each entry also stores the full description and is
+ * verified on lookup, so hash collisions degrade to cache misses.
+ *
+ * Entries are written to a temporary file and renamed into place, so that
+ * concurrent readers and writers never observe a partially written entry.
+ * Temporary files left behind by crashed writers are removed when a cache
+ * is opened.
+ * The directory is kept under a byte budget by evicting the least recently
+ * used entries (a cache hit refreshes the modification time of the entry).
+ */
+
+module;
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#ifndef DIFFUSIONX_VERSION
+#error "DIFFUSIONX_VERSION must be defined to the project version by the build"
+#endif
+
+export module diffusionx.simulation.basic.cache;
+
+import diffusionx.error;
+import diffusionx.simulation.basic.utils;
+import diffusionx.simulation.basic.codec;
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Library version recorded in every cache key
+ *
+ * Set from the project version in CMakeLists.txt.
+ */
+export constexpr string_view library_version = DIFFUSIONX_VERSION;
+
+/**
+ * @brief Age after which a leftover temporary file is considered stale
+ *
+ * Younger temporary files may still be written by another process.
+ */
+export constexpr std::chrono::hours stale_temporary_age{1};
+
+/**
+ * @brief Default byte budget of a cache directory (1 GiB)
+ */
+export constexpr uintmax_t default_cache_bytes = uintmax_t{1} << 30;
+
+/**
+ * @brief Kind of payload stored in a cache entry
+ */
+enum class EntryKind : uint8_t {
+    Values = 0, ///< A flat vector of doubles
+    Ensemble = 1, ///< Trajectories in the compressed binary format
+};
+
+constexpr char cache_magic[8] = {'D', 'F', 'X', 'C', 'A', 'C', 'H', '1'};
+constexpr string_view cache_extension = ".dxc";
+constexpr string_view temporary_suffix = ".tmp";
+
+void append_le64(string &out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+auto load_le64(const char *p) -> uint64_t {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    }
+    return v;
+}
+
+void append_hex(string &out, uint64_t v) {
+    constexpr char digits[] = "0123456789abcdef";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        out.push_back(digits[(v >> shift) & 0xF]);
+    }
+}
+
+/**
+ * @brief FNV-1a over the bytes followed by a splitmix64 finalizer
+ */
+auto fnv1a_mix(string_view bytes, uint64_t seed) -> uint64_t {
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for (char c: bytes) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+/**
+ * @brief Canonical description of a simulation job
+ *
+ * Fields are appended in call order as `name=value` lines. Floating-point
+ * values are recorded by their exact bit pattern and strings are length
+ * prefixed, so two keys are equal only if every field is bit-identical.
+ * The library version is always the first field.
+ *
+ * Example:
+ * @code
+ * auto key = JobKey("Bm.msd")
+ *                .add("start_position", 0.0)
+ *                .add("diffusion_coefficient", 1.0)
+ *                .add("duration", 10.0)
+ *                .add("time_step", 0.01)
+ *                .add("particles", 10000);
+ * @endcode
+ */
+export class JobKey {
+    string m_text; ///< Canonical text of the job description
+
+    void append(string_view name, string_view value) {
+        m_text.append(name);
+        m_text.push_back('=');
+        m_text.append(value);
+        m_text.push_back('\n');
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param job Name of the job, e.g. the process and the computed quantity
+     */
+    explicit JobKey(string_view job) {
+        add("diffusionx", library_version);
+        add("job", job);
+    }
+
+    /**
+     * @brief Adds a floating-point parameter
+     * @param name The parameter name
+     * @param value The parameter value
+     * @return Reference to this key
+     */
+    auto add(string_view name, double value) -> JobKey & {
+        string field = "f";
+        append_hex(field, std::bit_cast<uint64_t>(value));
+        append(name, field);
+        return *this;
+    }
+
+    /**
+     * @brief Adds an integer parameter (particle count, seed, ...)
+     * @param name The parameter name
+     * @param value The parameter value
+     * @return Reference to this key
+     */
+    template<std::integral T>
+    auto add(string_view name, T value) -> JobKey & {
+        append(name, (std::is_signed_v<T> ? "i" : "u") + std::to_string(value));
+        return *this;
+    }
+
+    /**
+     * @brief Adds a string parameter (sampler choice, method name, ...)
+     * @param name The parameter name
+     * @param value The parameter value
+     * @return Reference to this key
+     */
+    auto add(string_view name, string_view value) -> JobKey & {
+        string field = "s" + std::to_string(value.size()) + ":";
+        field.append(value);
+        append(name, field);
+        return *this;
+    }
+
+    /**
+     * @brief Adds a vector parameter (e.g. observation times)
+     * @param name The parameter name
+     * @param values The parameter values
+     * @return Reference to this key
+     */
+    auto add(string_view name, std::span<const double> values) -> JobKey & {
+        string field = "v" + std::to_string(values.size()) + ":";
+        for (double v: values) {
+            append_hex(field, std::bit_cast<uint64_t>(v));
+        }
+        append(name, field);
+        return *this;
+    }
+
+    /**
+     * @brief Gets the canonical text of the job description
+     * @return The canonical text
+     */
+    [[nodiscard]] auto text() const -> const string & {
+        return m_text;
+    }
+
+    /**
+     * @brief Gets the 128-bit content hash of the job description
+     * @return The hash as 32 lowercase hexadecimal digits
+     */
+    [[nodiscard]] auto digest() const -> string {
+        string out;
+        append_hex(out, fnv1a_mix(m_text, 0));
+        append_hex(out, fnv1a_mix(m_text, 0x9e3779b97f4a7c15ULL));
+        return out;
+    }
+};
+
+/**
+ * @brief On-disk, content-addressed cache of simulation results
+ *
+ * Example:
+ * @code
+ * ResultCache cache(".diffusionx-cache");
+ * auto msd = cache.get_or_compute_value(key, [&] {
+ *     return bm.msd(duration, particles, time_step);
+ * });
+ * @endcode
+ */
+export class ResultCache {
+    fs::path m_directory; ///< Cache directory
+    uintmax_t m_max_bytes; ///< Byte budget of the cache directory
+
+    [[nodiscard]] auto entry_path(const JobKey &key) const -> fs::path {
+        return m_directory / (key.digest() + string(cache_extension));
+    }
+
+    auto load(const JobKey &key, EntryKind kind) const -> Option<string> {
+        auto path = entry_path(key);
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return std::nullopt;
+        }
+        string bytes((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+        const auto &text = key.text();
+        size_t header = sizeof(cache_magic) + 1 + 8;
+        if (bytes.size() < header ||
+            !std::equal(std::begin(cache_magic), std::end(cache_magic),
+                        bytes.begin()) ||
+            static_cast<uint8_t>(bytes[sizeof(cache_magic)]) !=
+            static_cast<uint8_t>(kind)) {
+            return std::nullopt;
+        }
+        uint64_t key_size = load_le64(bytes.data() + header - 8);
+        if (key_size != text.size() ||
+            bytes.size() < header + key_size + 8 ||
+            string_view(bytes).substr(header, key_size) != text) {
+            return std::nullopt;
+        }
+        size_t payload_start = header + key_size + 8;
+        uint64_t payload_size = load_le64(bytes.data() + payload_start - 8);
+        if (bytes.size() - payload_start != payload_size) {
+            return std::nullopt;
+        }
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+        return bytes.substr(payload_start);
+    }
+
+    auto store(const JobKey &key, EntryKind kind, string_view payload)
+        -> Result<int> {
+        std::error_code ec;
+        fs::create_directories(m_directory, ec);
+        if (ec) {
+            return Err(Error::IoError("Failed to create cache directory: " +
+                                      m_directory.string()));
+        }
+        string bytes(std::begin(cache_magic), std::end(cache_magic));
+        bytes.push_back(static_cast<char>(kind));
+        append_le64(bytes, key.text().size());
+        bytes.append(key.text());
+        append_le64(bytes, payload.size());
+        bytes.append(payload);
+
+        auto path = entry_path(key);
+        string suffix(temporary_suffix);
+        append_hex(suffix, (static_cast<uint64_t>(std::random_device{}()) << 32) |
+                           std::random_device{}());
+        auto temp = path;
+        temp += suffix;
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return Err(Error::IoError("Failed to open cache entry for writing: " +
+                                          temp.string()));
+            }
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!file.flush()) {
+                file.close();
+                fs::remove(temp, ec);
+                return Err(Error::IoError("Failed to write cache entry: " +
+                                          temp.string()));
+            }
+        }
+        fs::rename(temp, path, ec);
+        if (ec) {
+            fs::remove(temp, ec);
+            return Err(Error::IoError("Failed to commit cache entry: " +
+                                      path.string()));
+        }
+        if (auto res = evict(); !res) {
+            return Err(res.error());
+        }
+        return Ok(0);
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param directory The cache directory, created on the first write
+     * @param max_bytes The byte budget of the cache directory
+     * @throws std::invalid_argument if directory is empty or max_bytes is zero
+     *
+     * Stale temporary files in the directory are removed.
+     */
+    explicit ResultCache(fs::path directory,
+                         uintmax_t max_bytes = default_cache_bytes)
+        : m_directory(std::move(directory)), m_max_bytes(max_bytes) {
+        if (m_directory.empty()) {
+            throw std::invalid_argument("directory must not be empty");
+        }
+        if (max_bytes == 0) {
+            throw std::invalid_argument("max_bytes must be positive");
+        }
+        // Best effort: a failed sweep only leaves the files for the next one
+        (void) remove_stale_temporaries();
+    }
+
+    /**
+     * @brief Gets the cache directory
+     * @return The cache directory
+     */
+    [[nodiscard]] auto get_directory() const -> const fs::path & {
+        return m_directory;
+    }
+
+    /**
+     * @brief Gets the byte budget of the cache directory
+     * @return The byte budget
+     */
+    [[nodiscard]] auto get_max_bytes() const -> uintmax_t {
+        return m_max_bytes;
+    }
+
+    /**
+     * @brief Looks up a vector of values
+     * @param key The job description
+     * @return The cached values, or None on a cache miss
+     */
+    auto get_values(const JobKey &key) const -> Option<vector<double> > {
+        auto payload = load(key, EntryKind::Values);
+        if (!payload.has_value() || payload->size() % sizeof(double) != 0) {
+            return std::nullopt;
+        }
+        vector<double> values(payload->size() / sizeof(double));
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = std::bit_cast<double>(
+                load_le64(payload->data() + (i * sizeof(double))));
+        }
+        return values;
+    }
+
+    /**
+     * @brief Stores a vector of values
+     * @param key The job description
+     * @param values The values to store
+     * @return Result indicating success or an Error
+     */
+    auto put_values(const JobKey &key, std::span<const double> values)
+        -> Result<int> {
+        string payload;
+        payload.reserve(values.size() * sizeof(double));
+        for (double v: values) {
+            append_le64(payload, std::bit_cast<uint64_t>(v));
+        }
+        return store(key, EntryKind::Values, payload);
+    }
+
+    /**
+     * @brief Looks up an ensemble of trajectories
+     * @param key The job description
+     * @return The cached trajectories, or None on a cache miss
+     */
+    auto get_ensemble(const JobKey &key) const -> Option<vector<vec_pair> > {
+        auto payload = load(key, EntryKind::Ensemble);
+        if (!payload.has_value()) {
+            return std::nullopt;
+        }
+        auto trajectories = decode_trajectories(std::span(
+            reinterpret_cast<const uint8_t *>(payload->data()), payload->size()));
+        if (!trajectories.has_value()) {
+            return std::nullopt;
+        }
+        return std::move(trajectories.value());
+    }
+
+    /**
+     * @brief Stores an ensemble of trajectories (losslessly compressed)
+     * @param key The job description
+     * @param trajectories The trajectories to store
+     * @return Result indicating success or an Error
+     */
+    auto put_ensemble(const JobKey &key, const vector<vec_pair> &trajectories)
+        -> Result<int> {
+        auto encoded = encode_trajectories(trajectories);
+        if (!encoded.has_value()) {
+            return Err(encoded.error());
+        }
+        return store(key, EntryKind::Ensemble,
+                     string_view(reinterpret_cast<const char *>(encoded->data()),
+                                 encoded->size()));
+    }
+
+    /**
+     * @brief Returns the cached values, computing and storing them on a miss
+     * @tparam F Callable returning Result<vector<double>>
+     * @param key The job description
+     * @param compute The computation to run on a cache miss
+     * @return Result containing the values, or an Error
+     */
+    template<typename F>
+    auto get_or_compute(const JobKey &key, F &&compute) -> Result<vector<double> > {
+        if (auto cached = get_values(key); cached.has_value()) {
+            return Ok(std::move(cached.value()));
+        }
+        Result<vector<double> > values = compute();
+        if (!values.has_value()) {
+            return Err(values.error());
+        }
+        if (auto res = put_values(key, values.value()); !res) {
+            return Err(res.error());
+        }
+        return values;
+    }
+
+    /**
+     * @brief Returns the cached scalar, computing and storing it on a miss
+     * @tparam F Callable returning Result<double>
+     * @param key The job description
+     * @param compute The computation to run on a cache miss
+     * @return Result containing the value, or an Error
+     */
+    template<typename F>
+    auto get_or_compute_value(const JobKey &key, F &&compute) -> Result<double> {
+        auto values = get_or_compute(key, [&]() -> Result<vector<double> > {
+            Result<double> value = compute();
+            if (!value.has_value()) {
+                return Err(value.error());
+            }
+            return Ok(vector<double>{value.value()});
+        });
+        if (!values.has_value()) {
+            return Err(values.error());
+        }
+        if (values->size() != 1) {
+            return Err(Error::IoError("Cached entry is not a scalar"));
+        }
+        return Ok(values->front());
+    }
+
+    /**
+     * @brief Returns the cached ensemble, computing and storing it on a miss
+     * @tparam F Callable returning Result<vector<vec_pair>>
+     * @param key The job description
+     * @param compute The computation to run on a cache miss
+     * @return Result containing the trajectories, or an Error
+     */
+    template<typename F>
+    auto get_or_compute_ensemble(const JobKey &key, F &&compute)
+        -> Result<vector<vec_pair> > {
+        if (auto cached = get_ensemble(key); cached.has_value()) {
+            return Ok(std::move(cached.value()));
+        }
+        Result<vector<vec_pair> > trajectories = compute();
+        if (!trajectories.has_value()) {
+            return Err(trajectories.error());
+        }
+        if (auto res = put_ensemble(key, trajectories.value()); !res) {
+            return Err(res.error());
+        }
+        return trajectories;
+    }
+
+    /**
+     * @brief Evicts least recently used entries until the budget is met
+     * @return Result containing the number of evicted entries, or an Error
+     *
+     * Entries removed concurrently by another process are skipped silently.
+     */
+    auto evict() const -> Result<size_t> {
+        struct Entry {
+            fs::path path;
+            uintmax_t size;
+            fs::file_time_type time;
+        };
+        std::error_code ec;
+        vector<Entry> entries;
+        uintmax_t total = 0;
+        for (fs::directory_iterator it(m_directory, ec), end; !ec && it != end;
+             it.increment(ec)) {
+            if (it->path().extension() != cache_extension) {
+                continue;
+            }
+            std::error_code entry_ec;
+            auto size = it->file_size(entry_ec);
+            auto time = it->last_write_time(entry_ec);
+            if (entry_ec) {
+                continue;
+            }
+            entries.push_back({it->path(), size, time});
+            total += size;
+        }
+        if (ec) {
+            return Err(Error::IoError("Failed to list cache directory: " +
+                                      m_directory.string()));
+        }
+        if (total <= m_max_bytes) {
+            return Ok(size_t{0});
+        }
+        std::ranges::sort(entries, {}, &Entry::time);
+        size_t evicted = 0;
+        for (const auto &entry: entries) {
+            if (total <= m_max_bytes) {
+                break;
+            }
+            if (fs::remove(entry.path, ec)) {
+                ++evicted;
+            }
+            total -= entry.size;
+        }
+        return Ok(evicted);
+    }
+
+    /**
+     * @brief Removes temporary files left behind by crashed writers
+     * @param age Minimum age of the temporary files to remove
+     * @return Result containing the number of removed files, or an Error
+     */
+    auto remove_stale_temporaries(std::chrono::seconds age = stale_temporary_age) const
+        -> Result<size_t> {
+        std::error_code ec;
+        auto cutoff = fs::file_time_type::clock::now() - age;
+        string marker = string(cache_extension) + string(temporary_suffix);
+        vector<fs::path> paths;
+        for (fs::directory_iterator it(m_directory, ec), end; !ec && it != end;
+             it.increment(ec)) {
+            if (it->path().filename().string().find(marker) == string::npos) {
+                continue;
+            }
+            std::error_code entry_ec;
+            auto time = it->last_write_time(entry_ec);
+            if (!entry_ec && time <= cutoff) {
+                paths.push_back(it->path());
+            }
+        }
+        if (ec && ec != std::errc::no_such_file_or_directory) {
+            return Err(Error::IoError("Failed to list cache directory: " +
+                                      m_directory.string()));
+        }
+        size_t removed = 0;
+        for (const auto &path: paths) {
+            if (fs::remove(path, ec)) {
+                ++removed;
+            }
+        }
+        return Ok(removed);
+    }
+
+    /**
+     * @brief Gets the total size of the cached entries
+     * @return Result containing the size in bytes, or an Error
+     */
+    auto size_bytes() const -> Result<uintmax_t> {
+        std::error_code ec;
+        uintmax_t total = 0;
+        for (fs::directory_iterator it(m_directory, ec), end; !ec && it != end;
+             it.increment(ec)) {
+            if (it->path().extension() == cache_extension) {
+                std::error_code entry_ec;
+                auto size = it->file_size(entry_ec);
+                total += entry_ec ? 0 : size;
+            }
+        }
+        if (ec && ec != std::errc::no_such_file_or_directory) {
+            return Err(Error::IoError("Failed to list cache directory: " +
+                                      m_directory.string()));
+        }
+        return Ok(total);
+    }
+
+    /**
+     * @brief Removes every entry from the cache directory
+     * @return Result indicating success or an Error
+     */
+    auto clear() const -> Result<int> {
+        std::error_code ec;
+        vector<fs::path> paths;
+        for (fs::directory_iterator it(m_directory, ec), end; !ec && it != end;
+             it.increment(ec)) {
+            if (it->path().extension() == cache_extension) {
+                paths.push_back(it->path());
+            }
+        }
+        if (ec && ec != std::errc::no_such_file_or_directory) {
+            return Err(Error::IoError("Failed to list cache directory: " +
+                                      m_directory.string()));
+        }
+        for (const auto &path: paths) {
+            fs::remove(path, ec);
+        }
+        return Ok(0);
+    }
+};
@@ -0,0 +1,1031 @@
+/**
+ * @file codec.cppm
+ * @brief Lossless compression codec for stored trajectories
+ *
+ * This module provides a chunked, lossless codec for trajectory columns and a
+ * compact binary file format for ensembles of trajectories. Each chunk is
+ * encoded independently so that a single trajectory (or a window of it) can
+ * be decoded without touching the rest of the archive.
+ *
+ * Floating-point chunks are transformed with XOR-with-previous (Gorilla
+ * style) or with a zigzag delta of the IEEE-754 bit patterns, whichever is
+ * smaller. The transformed words are byte-shuffled into eight byte planes and
+ * every plane is stored as all-zero, raw or zero-run coded. Integer-valued
+ * chunks (e.g. `SimpleRandomWalk` positions or Poisson counts) are stored as
+ * frame-of-reference bit-packed deltas.
+ */
+
+module;
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+export module diffusionx.simulation.basic.codec;
+
+import diffusionx.error;
+import diffusionx.simulation.basic.utils;
+
+using std::string;
+using std::vector;
+
+/**
+ * @brief Default number of values per independently decodable chunk
+ */
+export constexpr size_t codec_chunk_size = 4096;
+
+/**
+ * @brief Largest accepted number of values per chunk
+ *
+ * Decoding allocates scratch memory for one chunk, so columns read from a
+ * file with larger chunks are rejected as corrupt.
+ */
+export constexpr size_t codec_max_chunk_size = size_t{1} << 20;
+
+/**
+ * @brief Encoding applied to a single chunk
+ */
+export enum class ChunkEncoding : uint8_t {
+    FloatXor = 0, ///< XOR with the previous value, byte-shuffled planes
+    FloatDelta = 1, ///< Zigzag delta of the bit patterns, byte-shuffled planes
+    Integer = 2, ///< Frame-of-reference bit-packed integer deltas
+};
+
+/**
+ * @brief Storage kind of a single byte plane inside a floating-point chunk
+ */
+enum class PlaneKind : uint8_t {
+    Zero = 0, ///< Every byte of the plane is zero, nothing is stored
+    Raw = 1, ///< The plane is stored verbatim
+    ZeroRun = 2, ///< The plane is stored with the zero-run coder
+};
+
+/**
+ * @brief A compressed column of doubles split into independent chunks
+ *
+ * `offsets[k]` is the byte offset of chunk k inside `data`, and
+ * `offsets.back()` equals `data.size()`.
+ */
+export struct CompressedColumn {
+    size_t size = 0; ///< Number of encoded values
+    size_t chunk_size = codec_chunk_size; ///< Number of values per chunk
+    vector<uint64_t> offsets{0}; ///< Byte offsets of the chunks
+    vector<uint8_t> data; ///< Encoded chunk payloads
+
+    /**
+     * @brief Gets the number of chunks in the column
+     * @return The number of chunks
+     */
+    [[nodiscard]] auto num_chunks() const -> size_t {
+        return offsets.size() - 1;
+    }
+
+    /**
+     * @brief Gets the compressed size in bytes (payload and chunk index)
+     * @return The number of bytes used by the column
+     */
+    [[nodiscard]] auto compressed_bytes() const -> size_t {
+        return data.size() + (offsets.size() * sizeof(uint64_t));
+    }
+};
+
+/**
+ * @brief A trajectory whose time and position columns are compressed
+ */
+export struct CompressedTrajectory {
+    CompressedColumn times; ///< Compressed time points
+    CompressedColumn positions; ///< Compressed positions
+};
+
+// ---------------------------------------------------------------------------
+// Byte-level helpers
+// ---------------------------------------------------------------------------
+
+auto zigzag_encode(int64_t v) -> uint64_t {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+auto zigzag_decode(uint64_t v) -> int64_t {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+void put_u32(vector<uint8_t> &out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void put_u64(vector<uint8_t> &out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void put_varint(vector<uint8_t> &out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+/**
+ * @brief Bounds-checked little-endian reader over an encoded buffer
+ */
+class ByteReader {
+    std::span<const uint8_t> m_bytes;
+    size_t m_pos = 0;
+
+public:
+    explicit ByteReader(std::span<const uint8_t> bytes) : m_bytes(bytes) {
+    }
+
+    [[nodiscard]] auto remaining() const -> size_t {
+        return m_bytes.size() - m_pos;
+    }
+
+    auto u8(uint8_t &v) -> bool {
+        if (remaining() < 1) {
+            return false;
+        }
+        v = m_bytes[m_pos++];
+        return true;
+    }
+
+    auto u32(uint32_t &v) -> bool {
+        if (remaining() < 4) {
+            return false;
+        }
+        v = 0;
+        for (int i = 0; i < 4; ++i) {
+            v |= static_cast<uint32_t>(m_bytes[m_pos++]) << (8 * i);
+        }
+        return true;
+    }
+
+    auto u64(uint64_t &v) -> bool {
+        if (remaining() < 8) {
+            return false;
+        }
+        v = 0;
+        for (int i = 0; i < 8; ++i) {
+            v |= static_cast<uint64_t>(m_bytes[m_pos++]) << (8 * i);
+        }
+        return true;
+    }
+
+    auto varint(uint64_t &v) -> bool {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = 0;
+            if (!u8(byte)) {
+                return false;
+            }
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto take(size_t n, std::span<const uint8_t> &out) -> bool {
+        if (remaining() < n) {
+            return false;
+        }
+        out = m_bytes.subspan(m_pos, n);
+        m_pos += n;
+        return true;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Zero-run coder for byte planes
+// ---------------------------------------------------------------------------
+
+/**
+ * Control byte c < 0x80 introduces c + 1 literal bytes, c >= 0x80 stands for
+ * (c & 0x7F) + 1 zero bytes. Isolated zeros are kept inside literal runs.
+ */
+void zero_run_encode(std::span<const uint8_t> plane, vector<uint8_t> &out) {
+    size_t n = plane.size();
+    size_t i = 0;
+    while (i < n) {
+        if (plane[i] == 0 && i + 1 < n && plane[i + 1] == 0) {
+            size_t run = 0;
+            while (i < n && plane[i] == 0 && run < 128) {
+                ++i;
+                ++run;
+            }
+            out.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+            continue;
+        }
+        size_t start = i;
+        while (i < n && i - start < 128 &&
+               !(plane[i] == 0 && i + 1 < n && plane[i + 1] == 0)) {
+            ++i;
+        }
+        out.push_back(static_cast<uint8_t>(i - start - 1));
+        out.insert(out.end(), plane.begin() + static_cast<ptrdiff_t>(start),
+                   plane.begin() + static_cast<ptrdiff_t>(i));
+    }
+}
+
+auto zero_run_decode(std::span<const uint8_t> in, std::span<uint8_t> plane)
+    -> bool {
+    size_t o = 0;
+    size_t i = 0;
+    while (i < in.size()) {
+        uint8_t c = in[i++];
+        size_t len = (c & 0x7F) + 1;
+        if (o + len > plane.size()) {
+            return false;
+        }
+        if ((c & 0x80) != 0) {
+            std::fill_n(plane.begin() + static_cast<ptrdiff_t>(o), len, 0);
+        } else {
+            if (i + len > in.size()) {
+                return false;
+            }
+            std::copy_n(in.begin() + static_cast<ptrdiff_t>(i), len,
+                        plane.begin() + static_cast<ptrdiff_t>(o));
+            i += len;
+        }
+        o += len;
+    }
+    return o == plane.size();
+}
+
+// ---------------------------------------------------------------------------
+// Chunk encoders
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Checks whether every value is an exactly representable integer
+ *
+ * Negative zero is rejected so that the integer path stays bit-exact.
+ */
+auto is_integral_chunk(std::span<const double> values) -> bool {
+    constexpr double limit = 9007199254740992.0; // 2^53
+    return std::ranges::all_of(values, [](double x) {
+        return std::trunc(x) == x && std::abs(x) <= limit &&
+               !(x == 0.0 && std::signbit(x));
+    });
+}
+
+void encode_integer_chunk(std::span<const double> values,
+                          vector<uint8_t> &out) {
+    out.push_back(static_cast<uint8_t>(ChunkEncoding::Integer));
+    auto first = static_cast<int64_t>(values[0]);
+    put_varint(out, zigzag_encode(first));
+
+    size_t n = values.size();
+    int64_t min_delta = 0;
+    for (size_t i = 1; i < n; ++i) {
+        int64_t delta = static_cast<int64_t>(values[i]) -
+                        static_cast<int64_t>(values[i - 1]);
+        min_delta = (i == 1) ? delta : std::min(min_delta, delta);
+    }
+    uint64_t max_offset = 0;
+    for (size_t i = 1; i < n; ++i) {
+        int64_t delta = static_cast<int64_t>(values[i]) -
+                        static_cast<int64_t>(values[i - 1]);
+        max_offset = std::max(max_offset,
+                              static_cast<uint64_t>(delta - min_delta));
+    }
+    auto width = static_cast<uint8_t>(std::bit_width(max_offset));
+    put_varint(out, zigzag_encode(min_delta));
+    out.push_back(width);
+    if (width == 0) {
+        return;
+    }
+
+    uint64_t acc = 0;
+    unsigned int bits = 0;
+    for (size_t i = 1; i < n; ++i) {
+        int64_t delta = static_cast<int64_t>(values[i]) -
+                        static_cast<int64_t>(values[i - 1]);
+        acc |= static_cast<uint64_t>(delta - min_delta) << bits;
+        bits += width;
+        while (bits >= 8) {
+            out.push_back(static_cast<uint8_t>(acc));
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+    if (bits > 0) {
+        out.push_back(static_cast<uint8_t>(acc));
+    }
+}
+
+void encode_planes(std::span<const uint64_t> words, ChunkEncoding encoding,
+                   vector<uint8_t> &out) {
+    size_t n = words.size();
+    out.push_back(static_cast<uint8_t>(encoding));
+    vector<uint8_t> plane(n);
+    vector<uint8_t> coded;
+    for (int p = 0; p < 8; ++p) {
+        bool all_zero = true;
+        for (size_t i = 0; i < n; ++i) {
+            plane[i] = static_cast<uint8_t>(words[i] >> (8 * p));
+            all_zero = all_zero && plane[i] == 0;
+        }
+        if (all_zero) {
+            out.push_back(static_cast<uint8_t>(PlaneKind::Zero));
+            continue;
+        }
+        coded.clear();
+        zero_run_encode(plane, coded);
+        if (coded.size() + 4 < n) {
+            out.push_back(static_cast<uint8_t>(PlaneKind::ZeroRun));
+            put_u32(out, static_cast<uint32_t>(coded.size()));
+            out.insert(out.end(), coded.begin(), coded.end());
+        } else {
+            out.push_back(static_cast<uint8_t>(PlaneKind::Raw));
+            out.insert(out.end(), plane.begin(), plane.end());
+        }
+    }
+}
+
+void encode_float_chunk(std::span<const double> values, vector<uint8_t> &out) {
+    size_t n = values.size();
+    vector<uint64_t> xored(n);
+    vector<uint64_t> deltas(n);
+    uint64_t prev = 0;
+    for (size_t i = 0; i < n; ++i) {
+        auto bits = std::bit_cast<uint64_t>(values[i]);
+        xored[i] = bits ^ prev;
+        deltas[i] = zigzag_encode(static_cast<int64_t>(bits - prev));
+        prev = bits;
+    }
+
+    vector<uint8_t> xor_out;
+    vector<uint8_t> delta_out;
+    encode_planes(xored, ChunkEncoding::FloatXor, xor_out);
+    encode_planes(deltas, ChunkEncoding::FloatDelta, delta_out);
+    const auto &best = delta_out.size() < xor_out.size() ? delta_out : xor_out;
+    out.insert(out.end(), best.begin(), best.end());
+}
+
+// ---------------------------------------------------------------------------
+// Chunk decoders
+// ---------------------------------------------------------------------------
+
+auto decode_integer_chunk(ByteReader &reader, std::span<double> out)
+    -> Result<int> {
+    uint64_t first = 0;
+    uint64_t min_delta = 0;
+    uint8_t width = 0;
+    if (!reader.varint(first) || !reader.varint(min_delta) ||
+        !reader.u8(width) || width > 64) {
+        return Err(Error::IoError("Corrupted integer chunk header"));
+    }
+    size_t n = out.size();
+    int64_t value = zigzag_decode(first);
+    int64_t base = zigzag_decode(min_delta);
+    out[0] = static_cast<double>(value);
+    if (width == 0) {
+        for (size_t i = 1; i < n; ++i) {
+            value += base;
+            out[i] = static_cast<double>(value);
+        }
+        return Ok(0);
+    }
+
+    std::span<const uint8_t> packed;
+    if (!reader.take((((n - 1) * width) + 7) / 8, packed)) {
+        return Err(Error::IoError("Truncated integer chunk payload"));
+    }
+    uint64_t mask = width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+    vector<uint64_t> offsets(n);
+    if (width <= 57 && std::endian::native == std::endian::little) {
+        // One unaligned load per value (shift + width <= 64): independent and
+        // branch-free, so it vectorizes. The padding keeps the last loads in bounds.
+        vector<uint8_t> padded(packed.size() + sizeof(uint64_t), 0);
+        std::ranges::copy(packed, padded.begin());
+        for (size_t i = 1; i < n; ++i) {
+            size_t bit_pos = (i - 1) * width;
+            uint64_t word = 0;
+            std::memcpy(&word, padded.data() + (bit_pos >> 3), sizeof(word));
+            offsets[i] = (word >> (bit_pos & 7)) & mask;
+        }
+    } else {
+        size_t bit_pos = 0;
+        for (size_t i = 1; i < n; ++i) {
+            uint64_t offset = 0;
+            for (unsigned int got = 0; got < width;) {
+                size_t byte = bit_pos >> 3;
+                unsigned int shift = bit_pos & 7;
+                unsigned int take = std::min(8 - shift, width - got);
+                uint64_t chunk = (packed[byte] >> shift) & ((1u << take) - 1);
+                offset |= chunk << got;
+                got += take;
+                bit_pos += take;
+            }
+            offsets[i] = offset & mask;
+        }
+    }
+    // The running sum is a one-add dependency chain and stays scalar
+    for (size_t i = 1; i < n; ++i) {
+        value += base + static_cast<int64_t>(offsets[i]);
+        out[i] = static_cast<double>(value);
+    }
+    return Ok(0);
+}
+
+auto decode_float_chunk(ByteReader &reader, ChunkEncoding encoding,
+                        std::span<double> out) -> Result<int> {
+    // Every plane has a header byte; check before sizing the scratch planes
+    if (reader.remaining() < 8) {
+        return Err(Error::IoError("Truncated byte plane header"));
+    }
+    size_t n = out.size();
+    vector<uint64_t> words(n, 0);
+    vector<uint8_t> plane(n);
+    for (int p = 0; p < 8; ++p) {
+        uint8_t kind = 0;
+        if (!reader.u8(kind)) {
+            return Err(Error::IoError("Truncated byte plane header"));
+        }
+        switch (static_cast<PlaneKind>(kind)) {
+            case PlaneKind::Zero:
+                continue;
+            case PlaneKind::Raw: {
+                std::span<const uint8_t> raw;
+                if (!reader.take(n, raw)) {
+                    return Err(Error::IoError("Truncated raw byte plane"));
+                }
+                std::ranges::copy(raw, plane.begin());
+                break;
+            }
+            case PlaneKind::ZeroRun: {
+                uint32_t len = 0;
+                std::span<const uint8_t> coded;
+                if (!reader.u32(len) || !reader.take(len, coded) ||
+                    !zero_run_decode(coded, plane)) {
+                    return Err(Error::IoError("Corrupted zero-run byte plane"));
+                }
+                break;
+            }
+            default:
+                return Err(Error::IoError("Unknown byte plane kind"));
+        }
+        // Unshuffle: branch-free and contiguous, so it vectorizes.
+        int shift = 8 * p;
+        for (size_t i = 0; i < n; ++i) {
+            words[i] |= static_cast<uint64_t>(plane[i]) << shift;
+        }
+    }
+
+    uint64_t prev = 0;
+    if (encoding == ChunkEncoding::FloatXor) {
+        for (size_t i = 0; i < n; ++i) {
+            prev ^= words[i];
+            out[i] = std::bit_cast<double>(prev);
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            prev += static_cast<uint64_t>(zigzag_decode(words[i]));
+            out[i] = std::bit_cast<double>(prev);
+        }
+    }
+    return Ok(0);
+}
+
+// ---------------------------------------------------------------------------
+// Public column API
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Checks the chunk size and the chunk count of a column
+ */
+auto valid_layout(const CompressedColumn &column) -> bool {
+    return column.chunk_size != 0 && column.chunk_size <= codec_max_chunk_size &&
+           column.num_chunks() == (column.size + column.chunk_size - 1) / column.chunk_size;
+}
+
+/**
+ * @brief Compresses a column of doubles losslessly
+ * @param values The values to compress
+ * @param chunk_size The number of values per independently decodable chunk
+ * @return Result containing the compressed column, or an Error
+ *
+ * Each chunk picks the smallest of the XOR, bit-delta and (for integral
+ * values) bit-packed integer encodings.
+ */
+export auto compress(std::span<const double> values,
+                     size_t chunk_size = codec_chunk_size)
+    -> Result<CompressedColumn> {
+    if (chunk_size == 0 || chunk_size > codec_max_chunk_size) {
+        return Err(Error::InvalidArgument(
+            "Chunk size must be positive and at most codec_max_chunk_size"));
+    }
+    CompressedColumn column;
+    column.size = values.size();
+    column.chunk_size = chunk_size;
+    column.offsets.reserve((values.size() / chunk_size) + 2);
+    vector<uint8_t> integer;
+    vector<uint8_t> floating;
+    for (size_t start = 0; start < values.size(); start += chunk_size) {
+        auto chunk = values.subspan(
+            start, std::min(chunk_size, values.size() - start));
+        floating.clear();
+        encode_float_chunk(chunk, floating);
+        const auto *best = &floating;
+        if (is_integral_chunk(chunk)) {
+            integer.clear();
+            encode_integer_chunk(chunk, integer);
+            if (integer.size() <= floating.size()) {
+                best = &integer;
+            }
+        }
+        column.data.insert(column.data.end(), best->begin(), best->end());
+        column.offsets.push_back(column.data.size());
+    }
+    return Ok(std::move(column));
+}
+
+/**
+ * @brief Decodes a single chunk of a compressed column
+ * @param column The compressed column
+ * @param chunk The chunk index
+ * @param out Output span, must hold exactly the number of values in the chunk
+ * @return Result indicating success or an Error
+ */
+export auto decompress_chunk(const CompressedColumn &column, size_t chunk,
+                             std::span<double> out) -> Result<int> {
+    if (!valid_layout(column)) {
+        return Err(Error::IoError("Corrupted column layout"));
+    }
+    if (chunk >= column.num_chunks()) {
+        return Err(Error::InvalidArgument("Chunk index out of range"));
+    }
+    size_t start = chunk * column.chunk_size;
+    size_t count = std::min(column.chunk_size, column.size - start);
+    if (out.size() != count) {
+        return Err(Error::InvalidArgument(
+            "Output span does not match the chunk length"));
+    }
+    if (column.offsets[chunk + 1] > column.data.size() ||
+        column.offsets[chunk] > column.offsets[chunk + 1]) {
+        return Err(Error::IoError("Corrupted chunk index"));
+    }
+    ByteReader reader(std::span(column.data).subspan(
+        column.offsets[chunk],
+        column.offsets[chunk + 1] - column.offsets[chunk]));
+    uint8_t encoding = 0;
+    if (!reader.u8(encoding)) {
+        return Err(Error::IoError("Empty chunk"));
+    }
+    switch (static_cast<ChunkEncoding>(encoding)) {
+        case ChunkEncoding::Integer:
+            return decode_integer_chunk(reader, out);
+        case ChunkEncoding::FloatXor:
+        case ChunkEncoding::FloatDelta:
+            return decode_float_chunk(
+                reader, static_cast<ChunkEncoding>(encoding), out);
+        default:
+            return Err(Error::IoError("Unknown chunk encoding"));
+    }
+}
+
+/**
+ * @brief Decodes the values in [begin, end) of a compressed column
+ * @param column The compressed column
+ * @param begin Index of the first value to decode
+ * @param end One past the index of the last value to decode
+ * @return Result containing the decoded values, or an Error
+ *
+ * Only the chunks overlapping the requested range are decoded. Memory is
+ * reserved for at most 64 values per encoded byte; denser columns grow as
+ * they decode, so a corrupt column fails before memory is allocated for
+ * values it does not contain.
+ */
+export auto decompress_range(const CompressedColumn &column, size_t begin,
+                             size_t end) -> Result<vector<double> > {
+    if (begin > end || end > column.size) {
+        return Err(Error::InvalidArgument("Invalid decode range"));
+    }
+    vector<double> result;
+    if (begin == end) {
+        return Ok(std::move(result));
+    }
+    if (!valid_layout(column)) {
+        return Err(Error::IoError("Corrupted column layout"));
+    }
+    size_t first_chunk = begin / column.chunk_size;
+    size_t last_chunk = (end - 1) / column.chunk_size;
+    uint64_t encoded = column.offsets[last_chunk + 1] > column.offsets[first_chunk]
+                           ? column.offsets[last_chunk + 1] - column.offsets[first_chunk]
+                           : 0;
+    encoded = std::min<uint64_t>(encoded, column.data.size());
+    result.reserve(std::min<uint64_t>(end - begin, encoded * 64));
+    vector<double> scratch(std::min(column.chunk_size, column.size));
+    for (size_t k = first_chunk; k <= last_chunk; ++k) {
+        size_t chunk_start = k * column.chunk_size;
+        size_t count = std::min(column.chunk_size, column.size - chunk_start);
+        auto decoded = std::span(scratch).first(count);
+        if (auto res = decompress_chunk(column, k, decoded); !res) {
+            return Err(res.error());
+        }
+        size_t lo = std::max(begin, chunk_start);
+        size_t hi = std::min(end, chunk_start + count);
+        result.insert(result.end(),
+                      decoded.begin() + static_cast<ptrdiff_t>(lo - chunk_start),
+                      decoded.begin() + static_cast<ptrdiff_t>(hi - chunk_start));
+    }
+    return Ok(std::move(result));
+}
+
+/**
+ * @brief Decodes a whole compressed column
+ * @param column The compressed column
+ * @return Result containing the decoded values, or an Error
+ */
+export auto decompress(const CompressedColumn &column)
+    -> Result<vector<double> > {
+    return decompress_range(column, 0, column.size);
+}
+
+/**
+ * @brief Compresses a trajectory (time and position columns)
+ * @param trajectory The trajectory data (times, positions)
+ * @param chunk_size The number of values per chunk
+ * @return Result containing the compressed trajectory, or an Error
+ */
+export auto compress_trajectory(const vec_pair &trajectory,
+                                size_t chunk_size = codec_chunk_size)
+    -> Result<CompressedTrajectory> {
+    const auto &[times, positions] = trajectory;
+    if (times.size() != positions.size()) {
+        return Err(Error::InvalidArgument(
+            "Times and positions vectors must have the same size"));
+    }
+    auto t = compress(times, chunk_size);
+    if (!t.has_value()) {
+        return Err(t.error());
+    }
+    auto x = compress(positions, chunk_size);
+    if (!x.has_value()) {
+        return Err(x.error());
+    }
+    return Ok(CompressedTrajectory{std::move(t.value()), std::move(x.value())});
+}
+
+/**
+ * @brief Decodes a compressed trajectory
+ * @param trajectory The compressed trajectory
+ * @return Result containing the trajectory data (times, positions), or an Error
+ */
+export auto decompress_trajectory(const CompressedTrajectory &trajectory)
+    -> Result<vec_pair> {
+    auto t = decompress(trajectory.times);
+    if (!t.has_value()) {
+        return Err(t.error());
+    }
+    auto x = decompress(trajectory.positions);
+    if (!x.has_value()) {
+        return Err(x.error());
+    }
+    return Ok(std::make_pair(std::move(t.value()), std::move(x.value())));
+}
+
+// ---------------------------------------------------------------------------
+// Binary ensemble files
+// ---------------------------------------------------------------------------
+
+constexpr char binary_magic[8] = {'D', 'F', 'X', 'T', 'R', 'J', '0', '1'};
+
+void serialize_column(const CompressedColumn &column, vector<uint8_t> &out) {
+    put_u64(out, column.size);
+    put_u64(out, column.chunk_size);
+    put_u64(out, column.num_chunks());
+    for (auto offset: column.offsets) {
+        put_u64(out, offset);
+    }
+    out.insert(out.end(), column.data.begin(), column.data.end());
+}
+
+auto read_u64(std::istream &in, uint64_t &v) -> bool {
+    uint8_t buf[8];
+    if (!in.read(reinterpret_cast<char *>(buf), 8)) {
+        return false;
+    }
+    v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v |= static_cast<uint64_t>(buf[i]) << (8 * i);
+    }
+    return true;
+}
+
+/**
+ * @brief Number of bytes between the read position and the end of a stream
+ *
+ * Sizes read from a file are checked against it before anything is
+ * allocated, so a corrupt or truncated file fails with an IoError.
+ */
+auto stream_remaining(std::istream &in) -> uint64_t {
+    auto here = in.tellg();
+    if (here < 0 || !in.seekg(0, std::ios::end)) {
+        return 0;
+    }
+    auto end = in.tellg();
+    in.seekg(here);
+    return end > here ? static_cast<uint64_t>(end - here) : 0;
+}
+
+auto deserialize_column(std::istream &in) -> Result<CompressedColumn> {
+    CompressedColumn column;
+    uint64_t size = 0;
+    uint64_t chunk_size = 0;
+    uint64_t chunks = 0;
+    if (!read_u64(in, size) || !read_u64(in, chunk_size) ||
+        !read_u64(in, chunks)) {
+        return Err(Error::IoError("Truncated column header"));
+    }
+    if (chunk_size == 0 || chunk_size > codec_max_chunk_size ||
+        chunks != (size + chunk_size - 1) / chunk_size ||
+        chunks >= stream_remaining(in) / sizeof(uint64_t)) {
+        return Err(Error::IoError("Corrupted column header"));
+    }
+    column.size = size;
+    column.chunk_size = chunk_size;
+    column.offsets.resize(chunks + 1);
+    for (auto &offset: column.offsets) {
+        if (!read_u64(in, offset)) {
+            return Err(Error::IoError("Truncated chunk index"));
+        }
+    }
+    if (column.offsets.back() > stream_remaining(in)) {
+        return Err(Error::IoError("Truncated column payload"));
+    }
+    column.data.resize(column.offsets.back());
+    if (!in.read(reinterpret_cast<char *>(column.data.data()),
+                 static_cast<std::streamsize>(column.data.size()))) {
+        return Err(Error::IoError("Truncated column payload"));
+    }
+    return Ok(std::move(column));
+}
+
+auto deserialize_column(ByteReader &reader) -> Result<CompressedColumn> {
+    CompressedColumn column;
+    uint64_t size = 0;
+    uint64_t chunk_size = 0;
+    uint64_t chunks = 0;
+    if (!reader.u64(size) || !reader.u64(chunk_size) || !reader.u64(chunks)) {
+        return Err(Error::IoError("Truncated column header"));
+    }
+    if (chunk_size == 0 || chunk_size > codec_max_chunk_size ||
+        chunks != (size + chunk_size - 1) / chunk_size ||
+        chunks >= reader.remaining() / sizeof(uint64_t)) {
+        return Err(Error::IoError("Corrupted column header"));
+    }
+    column.size = size;
+    column.chunk_size = chunk_size;
+    column.offsets.resize(chunks + 1);
+    for (auto &offset: column.offsets) {
+        if (!reader.u64(offset)) {
+            return Err(Error::IoError("Truncated chunk index"));
+        }
+    }
+    std::span<const uint8_t> payload;
+    if (!reader.take(column.offsets.back(), payload)) {
+        return Err(Error::IoError("Truncated column payload"));
+    }
+    column.data.assign(payload.begin(), payload.end());
+    return Ok(std::move(column));
+}
+
+/**
+ * @brief Encodes multiple trajectories into the compressed binary format
+ * @param trajectories Vector of trajectory pairs (times, positions)
+ * @param chunk_size The number of values per chunk
+ * @return Result containing the encoded bytes, or an Error
+ *
+ * Layout: magic, trajectory count, compressed trajectories, then an index of
+ * trajectory offsets followed by the index offset and the magic again, so
+ * that single trajectories can be located without scanning the file.
+ */
+export auto encode_trajectories(const vector<vec_pair> &trajectories,
+                                size_t chunk_size = codec_chunk_size)
+    -> Result<vector<uint8_t> > {
+    if (trajectories.empty()) {
+        return Err(Error::InvalidArgument("Trajectories vector cannot be empty"));
+    }
+
+    vector<uint8_t> buffer(std::begin(binary_magic), std::end(binary_magic));
+    put_u64(buffer, trajectories.size());
+    vector<uint64_t> index;
+    index.reserve(trajectories.size());
+    for (const auto &trajectory: trajectories) {
+        auto compressed = compress_trajectory(trajectory, chunk_size);
+        if (!compressed.has_value()) {
+            return Err(compressed.error());
+        }
+        index.push_back(buffer.size());
+        serialize_column(compressed->times, buffer);
+        serialize_column(compressed->positions, buffer);
+    }
+    uint64_t index_offset = buffer.size();
+    for (auto offset: index) {
+        put_u64(buffer, offset);
+    }
+    put_u64(buffer, index_offset);
+    buffer.insert(buffer.end(), std::begin(binary_magic), std::end(binary_magic));
+    return Ok(std::move(buffer));
+}
+
+/**
+ * @brief Decodes trajectories from an in-memory buffer in the binary format
+ * @param bytes The encoded bytes, as produced by `encode_trajectories`
+ * @return Result containing the trajectories (times, positions), or an Error
+ */
+export auto decode_trajectories(std::span<const uint8_t> bytes)
+    -> Result<vector<vec_pair> > {
+    constexpr size_t header = sizeof(binary_magic) + sizeof(uint64_t);
+    if (bytes.size() < 2 * header ||
+        !std::equal(std::begin(binary_magic), std::end(binary_magic),
+                    bytes.begin()) ||
+        !std::equal(std::begin(binary_magic), std::end(binary_magic),
+                    bytes.end() - sizeof(binary_magic))) {
+        return Err(Error::IoError("Not a diffusionx trajectory buffer"));
+    }
+    uint64_t count = 0;
+    uint64_t index_offset = 0;
+    ByteReader head(bytes.subspan(sizeof(binary_magic), sizeof(uint64_t)));
+    ByteReader foot(bytes.subspan(bytes.size() - header, sizeof(uint64_t)));
+    head.u64(count);
+    foot.u64(index_offset);
+    if (index_offset > bytes.size() - header ||
+        count != (bytes.size() - header - index_offset) / sizeof(uint64_t)) {
+        return Err(Error::IoError("Corrupted trajectory index"));
+    }
+    ByteReader index(bytes.subspan(index_offset, count * sizeof(uint64_t)));
+    vector<vec_pair> trajectories;
+    trajectories.reserve(count);
+    for (uint64_t k = 0; k < count; ++k) {
+        uint64_t offset = 0;
+        index.u64(offset);
+        if (offset >= index_offset) {
+            return Err(Error::IoError("Corrupted trajectory index"));
+        }
+        ByteReader reader(bytes.subspan(offset, index_offset - offset));
+        auto t = deserialize_column(reader);
+        if (!t.has_value()) {
+            return Err(t.error());
+        }
+        auto x = deserialize_column(reader);
+        if (!x.has_value()) {
+            return Err(x.error());
+        }
+        auto trajectory = decompress_trajectory(
+            CompressedTrajectory{std::move(t.value()), std::move(x.value())});
+        if (!trajectory.has_value()) {
+            return Err(trajectory.error());
+        }
+        trajectories.push_back(std::move(trajectory.value()));
+    }
+    return Ok(std::move(trajectories));
+}
+
+/**
+ * @brief Writes multiple trajectories to a compressed binary file
+ * @param filename The output filename
+ * @param trajectories Vector of trajectory pairs (times, positions)
+ * @param chunk_size The number of values per chunk
+ * @return Result indicating success or an Error
+ *
+ * See `encode_trajectories` for the layout.
+ */
+export Result<int> write_trajectories_binary(
+    const string &filename,
+    const vector<vec_pair> &trajectories,
+    size_t chunk_size = codec_chunk_size
+) {
+    auto buffer = encode_trajectories(trajectories, chunk_size);
+    if (!buffer.has_value()) {
+        return Err(buffer.error());
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return Err(Error::IoError("Failed to open file for writing: " + filename));
+    }
+    file.write(reinterpret_cast<const char *>(buffer->data()),
+               static_cast<std::streamsize>(buffer->size()));
+    if (!file) {
+        return Err(Error::IoError("Failed to write file: " + filename));
+    }
+    file.close();
+    return Ok(0);
+}
+
+/**
+ * @brief Opens a compressed binary file and reads its trajectory index
+ */
+auto open_binary_index(const string &filename, std::ifstream &file)
+    -> Result<vector<uint64_t> > {
+    file.open(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return Err(Error::IoError("Failed to open file for reading: " + filename));
+    }
+    char magic[8];
+    if (!file.read(magic, 8) || !std::equal(magic, magic + 8, binary_magic)) {
+        return Err(Error::IoError("Not a diffusionx trajectory file: " + filename));
+    }
+    uint64_t count = 0;
+    if (!read_u64(file, count)) {
+        return Err(Error::IoError("Truncated file header"));
+    }
+    uint64_t file_size = 16 + stream_remaining(file);
+    file.seekg(-16, std::ios::end);
+    uint64_t index_offset = 0;
+    if (!read_u64(file, index_offset) || !file.read(magic, 8) ||
+        !std::equal(magic, magic + 8, binary_magic)) {
+        return Err(Error::IoError("Corrupted file footer: " + filename));
+    }
+    // Layout: ... index (count offsets), index offset, magic
+    if (file_size < 32 || index_offset > file_size - 16 ||
+        count != (file_size - 16 - index_offset) / sizeof(uint64_t)) {
+        return Err(Error::IoError("Corrupted trajectory index: " + filename));
+    }
+    file.seekg(static_cast<std::streamoff>(index_offset));
+    vector<uint64_t> index(count);
+    for (auto &offset: index) {
+        if (!read_u64(file, offset)) {
+            return Err(Error::IoError("Truncated trajectory index"));
+        }
+    }
+    return Ok(std::move(index));
+}
+
+auto read_compressed_at(std::ifstream &file, uint64_t offset)
+    -> Result<CompressedTrajectory> {
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+    auto t = deserialize_column(file);
+    if (!t.has_value()) {
+        return Err(t.error());
+    }
+    auto x = deserialize_column(file);
+    if (!x.has_value()) {
+        return Err(x.error());
+    }
+    return Ok(CompressedTrajectory{std::move(t.value()), std::move(x.value())});
+}
+
+/**
+ * @brief Reads a single trajectory from a compressed binary file
+ * @param filename The input filename
+ * @param trajectory_index Index of the trajectory to read
+ * @return Result containing the compressed trajectory, or an Error
+ *
+ * The trajectory stays compressed so that callers can decode only the
+ * chunks they need with `decompress_range`.
+ */
+export Result<CompressedTrajectory> read_compressed_trajectory(
+    const string &filename, size_t trajectory_index) {
+    std::ifstream file;
+    auto index = open_binary_index(filename, file);
+    if (!index.has_value()) {
+        return Err(index.error());
+    }
+    if (trajectory_index >= index->size()) {
+        return Err(Error::InvalidArgument("Trajectory index out of range"));
+    }
+    return read_compressed_at(file, (*index)[trajectory_index]);
+}
+
+/**
+ * @brief Reads all trajectories from a compressed binary file
+ * @param filename The input filename
+ * @return Result containing the trajectories (times, positions), or an Error
+ */
+export Result<vector<vec_pair> > read_trajectories_binary(
+    const string &filename) {
+    std::ifstream file;
+    auto index = open_binary_index(filename, file);
+    if (!index.has_value()) {
+        return Err(index.error());
+    }
+    vector<vec_pair> trajectories;
+    trajectories.reserve(index->size());
+    for (auto offset: index.value()) {
+        auto compressed = read_compressed_at(file, offset);
+        if (!compressed.has_value()) {
+            return Err(compressed.error());
+        }
+        auto trajectory = decompress_trajectory(compressed.value());
+        if (!trajectory.has_value()) {
+            return Err(trajectory.error());
+        }
+        trajectories.push_back(std::move(trajectory.value()));
+    }
+    return Ok(std::move(trajectories));
+}
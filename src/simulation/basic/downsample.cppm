@@ -0,0 +1,445 @@
+/**
+ * @file downsample.cppm
+ * @brief Streaming visual downsampling of long trajectories
+ *
+ * This module reduces very long trajectories to a number of points suitable
+ * for plotting while they are being generated. Points are pushed one by one
+ * or in blocks (e.g. from `stream_path`) and only O(buckets) state is kept,
+ * so a path of 10⁸ steps never has to be stored.
+ *
+ * Two reductions are provided:
+ * - `MinMaxDownsampler`: per time bucket, the first, minimum, maximum and
+ *   last points (M4 aggregation). Line plots drawn with one bucket per pixel
+ *   column are pixel-identical to plots of the full path, and every extreme
+ *   jump is kept.
+ * - `LttbDownsampler`: Largest-Triangle-Three-Buckets, one point per bucket.
+ *   The candidate maximizing the triangle area is always a vertex of the
+ *   convex hull of its bucket, so only the hull is kept (built incrementally
+ *   with the monotone chain, as points arrive sorted by time).
+ */
+
+module;
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+export module diffusionx.simulation.basic.downsample;
+
+import diffusionx.error;
+import diffusionx.simulation.basic.utils;
+import diffusionx.simulation.basic.stepper;
+import diffusionx.simulation.basic.abstract;
+
+using std::vector;
+
+/**
+ * @brief A point of a trajectory
+ */
+struct PathPoint {
+    double t; ///< Time
+    double x; ///< Position
+};
+
+/**
+ * @brief Maps times in [start, end] to bucket indices
+ */
+class BucketGrid {
+    double m_start;
+    double m_scale;
+    size_t m_buckets;
+
+public:
+    BucketGrid(double start, double end, size_t buckets)
+        : m_start(start), m_scale(static_cast<double>(buckets) / (end - start)),
+          m_buckets(buckets) {
+        if (!(end > start)) {
+            throw std::invalid_argument("End time must be greater than start time");
+        }
+        if (buckets == 0) {
+            throw std::invalid_argument("Number of buckets must be positive");
+        }
+    }
+
+    [[nodiscard]] auto index(double t) const -> size_t {
+        double b = std::floor((t - m_start) * m_scale);
+        if (!(b > 0)) {
+            return 0;
+        }
+        return std::min(static_cast<size_t>(b), m_buckets - 1);
+    }
+};
+
+/**
+ * @brief Streaming min/max envelope (M4) downsampler
+ *
+ * For each of `buckets` equal time intervals of [start, end] the first,
+ * minimum, maximum and last points are kept, in time order and without
+ * duplicates, so the output has at most 4 * buckets points. Times outside
+ * the interval are clamped to the first or last bucket.
+ */
+export class MinMaxDownsampler {
+    BucketGrid m_grid; ///< Time-to-bucket mapping
+    vector<double> m_times; ///< Emitted time points
+    vector<double> m_positions; ///< Emitted positions
+    size_t m_bucket = 0; ///< Index of the open bucket
+    size_t m_count = 0; ///< Number of points in the open bucket
+    size_t m_seen = 0; ///< Number of points pushed so far
+    PathPoint m_first{}, m_min{}, m_max{}, m_last{}; ///< Open bucket summary
+    size_t m_min_at = 0, m_max_at = 0; ///< Sequence numbers of the extremes
+
+    void flush() {
+        if (m_count == 0) {
+            return;
+        }
+        size_t first_at = m_seen - m_count;
+        size_t last_at = m_seen - 1;
+        std::pair<size_t, PathPoint> points[4] = {
+            {first_at, m_first}, {m_min_at, m_min}, {m_max_at, m_max}, {last_at, m_last}};
+        std::sort(std::begin(points), std::end(points),
+                  [](const auto &a, const auto &b) { return a.first < b.first; });
+        for (size_t i = 0; i < 4; ++i) {
+            if (i > 0 && points[i].first == points[i - 1].first) {
+                continue;
+            }
+            m_times.push_back(points[i].second.t);
+            m_positions.push_back(points[i].second.x);
+        }
+        m_count = 0;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param start Start of the time range
+     * @param end End of the time range
+     * @param buckets Number of time buckets (e.g. the plot width in pixels)
+     * @throws std::invalid_argument if end <= start or buckets is zero
+     */
+    MinMaxDownsampler(double start, double end, size_t buckets)
+        : m_grid(start, end, buckets) {
+        m_times.reserve(4 * buckets);
+        m_positions.reserve(4 * buckets);
+    }
+
+    /**
+     * @brief Consumes one point
+     * @param t Time, not smaller than the previous time
+     * @param x Position
+     */
+    void push(double t, double x) {
+        size_t bucket = std::max(m_grid.index(t), m_bucket);
+        if (bucket != m_bucket) {
+            flush();
+            m_bucket = bucket;
+        }
+        PathPoint p{t, x};
+        if (m_count == 0) {
+            m_first = m_min = m_max = p;
+            m_min_at = m_max_at = m_seen;
+        } else if (x < m_min.x) {
+            m_min = p;
+            m_min_at = m_seen;
+        } else if (x > m_max.x) {
+            m_max = p;
+            m_max_at = m_seen;
+        }
+        m_last = p;
+        ++m_count;
+        ++m_seen;
+    }
+
+    /**
+     * @brief Consumes a block of points
+     * @param times Time points in non-decreasing order
+     * @param positions Positions, same size as times
+     */
+    void push(std::span<const double> times, std::span<const double> positions) {
+        size_t n = std::min(times.size(), positions.size());
+        for (size_t i = 0; i < n; ++i) {
+            push(times[i], positions[i]);
+        }
+    }
+
+    /**
+     * @brief Consumes a block of points (sink interface of `stream_path`)
+     */
+    void operator()(std::span<const double> times,
+                    std::span<const double> positions) {
+        push(times, positions);
+    }
+
+    /**
+     * @brief Closes the last bucket and returns the downsampled trajectory
+     * @return The downsampled times and positions
+     */
+    auto finish() -> vec_pair {
+        flush();
+        return std::make_pair(std::move(m_times), std::move(m_positions));
+    }
+};
+
+/**
+ * @brief Incremental convex hull of points with non-decreasing times
+ */
+class MonotoneHull {
+    vector<PathPoint> m_upper;
+    vector<PathPoint> m_lower;
+
+    static auto cross(const PathPoint &o, const PathPoint &a, const PathPoint &b)
+        -> double {
+        return ((a.t - o.t) * (b.x - o.x)) - ((a.x - o.x) * (b.t - o.t));
+    }
+
+public:
+    void add(const PathPoint &p) {
+        while (m_upper.size() >= 2 &&
+               cross(m_upper[m_upper.size() - 2], m_upper.back(), p) >= 0) {
+            m_upper.pop_back();
+        }
+        m_upper.push_back(p);
+        while (m_lower.size() >= 2 &&
+               cross(m_lower[m_lower.size() - 2], m_lower.back(), p) <= 0) {
+            m_lower.pop_back();
+        }
+        m_lower.push_back(p);
+    }
+
+    [[nodiscard]] auto empty() const -> bool {
+        return m_upper.empty();
+    }
+
+    void clear() {
+        m_upper.clear();
+        m_lower.clear();
+    }
+
+    /**
+     * @brief Finds the hull vertex maximizing the area of triangle (a, p, c)
+     */
+    [[nodiscard]] auto farthest(const PathPoint &a, const PathPoint &c) const
+        -> PathPoint {
+        PathPoint best = m_upper.front();
+        double best_area = -1.0;
+        for (const auto *chain: {&m_upper, &m_lower}) {
+            for (const auto &p: *chain) {
+                double area = std::abs(cross(a, p, c));
+                if (area > best_area) {
+                    best_area = area;
+                    best = p;
+                }
+            }
+        }
+        return best;
+    }
+
+    void swap(MonotoneHull &other) noexcept {
+        m_upper.swap(other.m_upper);
+        m_lower.swap(other.m_lower);
+    }
+};
+
+/**
+ * @brief Streaming Largest-Triangle-Three-Buckets downsampler
+ *
+ * The first and last points are always kept; the points in between are
+ * split into `buckets` equal time intervals of [start, end] and one point
+ * is selected per non-empty bucket. Runs in O(N) time, and besides the
+ * output only the convex hulls of two buckets are stored.
+ */
+export class LttbDownsampler {
+    BucketGrid m_grid; ///< Time-to-bucket mapping
+    vector<double> m_times; ///< Emitted time points
+    vector<double> m_positions; ///< Emitted positions
+    PathPoint m_anchor{}; ///< Last emitted point
+    Option<PathPoint> m_pending; ///< Last pushed point, not yet bucketed
+    MonotoneHull m_previous; ///< Hull of the bucket awaiting selection
+    MonotoneHull m_current; ///< Hull of the open bucket
+    size_t m_bucket = 0; ///< Index of the open bucket
+    double m_sum_t = 0.0, m_sum_x = 0.0; ///< Coordinate sums of the open bucket
+    size_t m_count = 0; ///< Number of points in the open bucket
+    bool m_started = false; ///< Whether the first point has been emitted
+
+    void emit(const PathPoint &p) {
+        m_times.push_back(p.t);
+        m_positions.push_back(p.x);
+        m_anchor = p;
+    }
+
+    void select_previous(const PathPoint &next) {
+        if (!m_previous.empty()) {
+            emit(m_previous.farthest(m_anchor, next));
+            m_previous.clear();
+        }
+    }
+
+    void bucket_point(const PathPoint &p) {
+        size_t bucket = std::max(m_grid.index(p.t), m_bucket);
+        if (bucket != m_bucket && m_count > 0) {
+            auto n = static_cast<double>(m_count);
+            select_previous({m_sum_t / n, m_sum_x / n});
+            m_previous.swap(m_current);
+            m_sum_t = m_sum_x = 0.0;
+            m_count = 0;
+        }
+        m_bucket = bucket;
+        m_current.add(p);
+        m_sum_t += p.t;
+        m_sum_x += p.x;
+        ++m_count;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param start Start of the time range
+     * @param end End of the time range
+     * @param buckets Number of buckets (output has at most buckets + 2 points)
+     * @throws std::invalid_argument if end <= start or buckets is zero
+     */
+    LttbDownsampler(double start, double end, size_t buckets)
+        : m_grid(start, end, buckets) {
+        m_times.reserve(buckets + 2);
+        m_positions.reserve(buckets + 2);
+    }
+
+    /**
+     * @brief Consumes one point
+     * @param t Time, not smaller than the previous time
+     * @param x Position
+     */
+    void push(double t, double x) {
+        PathPoint p{t, x};
+        if (!m_started) {
+            emit(p);
+            m_started = true;
+            return;
+        }
+        if (m_pending.has_value()) {
+            bucket_point(m_pending.value());
+        }
+        m_pending = p;
+    }
+
+    /**
+     * @brief Consumes a block of points
+     * @param times Time points in non-decreasing order
+     * @param positions Positions, same size as times
+     */
+    void push(std::span<const double> times, std::span<const double> positions) {
+        size_t n = std::min(times.size(), positions.size());
+        for (size_t i = 0; i < n; ++i) {
+            push(times[i], positions[i]);
+        }
+    }
+
+    /**
+     * @brief Consumes a block of points (sink interface of `stream_path`)
+     */
+    void operator()(std::span<const double> times,
+                    std::span<const double> positions) {
+        push(times, positions);
+    }
+
+    /**
+     * @brief Selects the remaining points and returns the downsampled trajectory
+     * @return The downsampled times and positions
+     */
+    auto finish() -> vec_pair {
+        if (m_pending.has_value()) {
+            const auto &last = m_pending.value();
+            if (m_count > 0) {
+                auto n = static_cast<double>(m_count);
+                select_previous({m_sum_t / n, m_sum_x / n});
+                m_previous.swap(m_current);
+            }
+            select_previous(last);
+            emit(last);
+        }
+        return std::make_pair(std::move(m_times), std::move(m_positions));
+    }
+};
+
+/**
+ * @brief Downsampling method
+ */
+export enum class DownsampleMethod {
+    MinMax, ///< Min/max envelope per bucket (`MinMaxDownsampler`)
+    Lttb, ///< Largest-Triangle-Three-Buckets (`LttbDownsampler`)
+};
+
+/**
+ * @brief Downsamples a stored trajectory
+ * @param trajectory The trajectory data (times, positions), sorted by time
+ * @param buckets The number of buckets
+ * @param method The downsampling method
+ * @return Result containing the downsampled trajectory, or an Error
+ */
+export auto downsample(const vec_pair &trajectory, size_t buckets,
+                       DownsampleMethod method = DownsampleMethod::MinMax)
+    -> Result<vec_pair> {
+    const auto &[times, positions] = trajectory;
+    if (times.size() != positions.size()) {
+        return Err(Error::InvalidArgument(
+            "Times and positions vectors must have the same size"));
+    }
+    if (buckets == 0) {
+        return Err(Error::InvalidArgument("Number of buckets must be positive"));
+    }
+    if (times.size() < 2 || !(times.back() > times.front())) {
+        return Ok(vec_pair(trajectory));
+    }
+    if (method == DownsampleMethod::Lttb) {
+        LttbDownsampler sampler(times.front(), times.back(), buckets);
+        sampler.push(times, positions);
+        return Ok(sampler.finish());
+    }
+    MinMaxDownsampler sampler(times.front(), times.back(), buckets);
+    sampler.push(times, positions);
+    return Ok(sampler.finish());
+}
+
+/**
+ * @brief Simulates a path and downsamples it while it is being generated
+ * @param process The process, must support `stepper`
+ * @param duration The total simulation time
+ * @param buckets The number of buckets
+ * @param method The downsampling method
+ * @param time_step The time step for discretization
+ * @return Result containing the downsampled trajectory, or an Error
+ *
+ * Memory use is O(buckets) regardless of the number of steps.
+ */
+export auto simulate_downsampled(ContinuousProcess &process, double duration,
+                                 size_t buckets,
+                                 DownsampleMethod method = DownsampleMethod::MinMax,
+                                 double time_step = 0.01) -> Result<vec_pair> {
+    if (duration <= 0) {
+        return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    if (buckets == 0) {
+        return Err(Error::InvalidArgument("Number of buckets must be positive"));
+    }
+    auto stepper = process.stepper(time_step);
+    if (!stepper.has_value()) {
+        return Err(stepper.error());
+    }
+    auto &path = *stepper.value();
+    double start = path.get_time();
+    double end = start + duration;
+    if (method == DownsampleMethod::Lttb) {
+        LttbDownsampler sampler(start, end, buckets);
+        if (auto res = stream_path(path, duration, sampler); !res) {
+            return Err(res.error());
+        }
+        return Ok(sampler.finish());
+    }
+    MinMaxDownsampler sampler(start, end, buckets);
+    if (auto res = stream_path(path, duration, sampler); !res) {
+        return Err(res.error());
+    }
+    return Ok(sampler.finish());
+}
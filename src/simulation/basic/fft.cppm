@@ -0,0 +1,104 @@
+/**
+ * @file fft.cppm
+ * @brief Process-wide cache of FFTW plans
+ *
+ * The FFTW planner is not thread-safe, while executing an existing plan on
+ * new arrays with `fftw_execute_dft` is. Every module that transforms data
+ * with FFTW gets its plans here, so planning is serialized by one mutex and
+ * each transform size is planned once per process.
+ */
+
+module;
+
+#include <fftw3.h>
+#include <mutex>
+#include <vector>
+
+export module diffusionx.simulation.basic.fft;
+
+using std::vector;
+
+/**
+ * @brief Out-of-place complex FFTW plans, keyed by size and direction
+ */
+class FftPlanCache {
+    struct Plan {
+        size_t size; ///< Transform size
+        int sign; ///< FFTW_FORWARD or FFTW_BACKWARD
+        fftw_plan plan; ///< Out-of-place plan on fftw_alloc'd arrays
+    };
+
+    std::mutex m_mutex; ///< Protects the plans and the FFTW planner
+    vector<Plan> m_plans; ///< Cached plans, never evicted
+
+public:
+    FftPlanCache() = default;
+    FftPlanCache(const FftPlanCache &) = delete;
+    auto operator=(const FftPlanCache &) -> FftPlanCache & = delete;
+
+    ~FftPlanCache() { clear(); }
+
+    auto plan(size_t size, int sign) -> fftw_plan {
+        std::lock_guard lock(m_mutex);
+        for (const auto &p: m_plans) {
+            if (p.size == size && p.sign == sign) {
+                return p.plan;
+            }
+        }
+        fftw_complex *in = fftw_alloc_complex(size);
+        fftw_complex *out = fftw_alloc_complex(size);
+        fftw_plan plan =
+            fftw_plan_dft_1d(static_cast<int>(size), in, out, sign, FFTW_ESTIMATE);
+        fftw_free(in);
+        fftw_free(out);
+        m_plans.push_back({size, sign, plan});
+        return plan;
+    }
+
+    auto size() -> size_t {
+        std::lock_guard lock(m_mutex);
+        return m_plans.size();
+    }
+
+    void clear() {
+        std::lock_guard lock(m_mutex);
+        for (const auto &p: m_plans) {
+            fftw_destroy_plan(p.plan);
+        }
+        m_plans.clear();
+    }
+};
+
+auto fft_plan_cache() -> FftPlanCache & {
+    static FftPlanCache cache;
+    return cache;
+}
+
+/**
+ * @brief Gets a shared plan for out-of-place complex transforms
+ * @param size The transform size
+ * @param sign FFTW_FORWARD or FFTW_BACKWARD
+ * @return The plan, to be run with `fftw_execute_dft` on fftw_alloc'd arrays
+ *
+ * The plan is owned by the cache and must not be destroyed by the caller.
+ */
+export auto fft_plan(size_t size, int sign) -> fftw_plan {
+    return fft_plan_cache().plan(size, sign);
+}
+
+/**
+ * @brief Gets the number of cached FFTW plans
+ * @return The number of plans
+ */
+export auto fft_plan_entries() -> size_t {
+    return fft_plan_cache().size();
+}
+
+/**
+ * @brief Destroys all cached FFTW plans
+ *
+ * Must not be called while a transform is running.
+ */
+export void clear_fft_plans() {
+    fft_plan_cache().clear();
+}
@@ -0,0 +1,793 @@
+/**
+ * @file observable.cppm
+ * @brief Fused evaluation of many path functionals over one ensemble
+ *
+ * Every Monte Carlo method of a process (`mean`, `msd`, `raw_moment`, ...)
+ * draws its own ensemble, so asking for five quantities costs five
+ * ensembles. An `ObservableSweep` instead holds any number of registered
+ * observables, generates each path once, block by block through the
+ * process stepper, and feeds every block to all observables while it is
+ * still in cache. Each worker thread owns empty clones of the observables
+ * and the clones are merged after the join, so no state is shared while
+ * paths are generated.
+ *
+ * Provided observables:
+ * - `ExtremeObservable`: running maximum and minimum of each path
+ * - `TimeAverageObservable`: time average (1/T)∫X(t)dt of each path
+ * - `OccupationObservable`: time spent in an interval (a, b)
+ * - `ExitObservable`: whether and when the path first leaves (a, b)
+ * - `GridMomentObservable`: raw and central moments at fixed times
+ *
+ * Time integrals use the left-point rule on the stepper grid, as
+ * ∫f(X)dt ≈ Σ f(X(t_k))(t_{k+1} - t_k).
+ */
+
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <concepts>
+#include <format>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+export module diffusionx.simulation.basic.observable;
+
+import diffusionx.error;
+import diffusionx.memory;
+import diffusionx.random.utils;
+import diffusionx.simulation.basic.utils;
+import diffusionx.simulation.basic.stepper;
+import diffusionx.simulation.basic.abstract;
+
+using std::vector;
+
+/**
+ * @brief Default number of points per block of an `ObservableSweep`
+ *
+ * Times and positions of a block take 16 KiB, so a block stays in L1 while
+ * all observables read it.
+ */
+export constexpr size_t observable_block_size = 1024;
+
+/**
+ * @brief Mergeable running mean and variance (Welford, Chan et al. merge)
+ */
+export class RunningStats {
+    size_t m_count = 0; ///< Number of values
+    double m_mean = 0.0; ///< Mean of the values
+    double m_m2 = 0.0; ///< Sum of squared deviations from the mean
+
+public:
+    /**
+     * @brief Adds a value
+     * @param x The value
+     */
+    void push(double x) {
+        ++m_count;
+        double delta = x - m_mean;
+        m_mean += delta / static_cast<double>(m_count);
+        m_m2 += delta * (x - m_mean);
+    }
+
+    /**
+     * @brief Adds all values of another accumulator
+     * @param other The other accumulator
+     */
+    void merge(const RunningStats &other) {
+        if (other.m_count == 0) {
+            return;
+        }
+        if (m_count == 0) {
+            *this = other;
+            return;
+        }
+        auto n = static_cast<double>(m_count);
+        auto m = static_cast<double>(other.m_count);
+        double delta = other.m_mean - m_mean;
+        m_mean += delta * m / (n + m);
+        m_m2 += other.m_m2 + (delta * delta * n * m / (n + m));
+        m_count += other.m_count;
+    }
+
+    /**
+     * @brief Gets the number of values
+     * @return The count
+     */
+    [[nodiscard]] auto count() const -> size_t {
+        return m_count;
+    }
+
+    /**
+     * @brief Gets the mean of the values
+     * @return The mean, or 0 if there are none
+     */
+    [[nodiscard]] auto mean() const -> double {
+        return m_mean;
+    }
+
+    /**
+     * @brief Gets the unbiased sample variance of the values
+     * @return The variance, or 0 if there are fewer than two values
+     */
+    [[nodiscard]] auto variance() const -> double {
+        return m_count > 1 ? m_m2 / static_cast<double>(m_count - 1) : 0.0;
+    }
+
+    /**
+     * @brief Gets the standard error of the mean
+     * @return sqrt(variance / count), or 0 if there are fewer than two values
+     */
+    [[nodiscard]] auto standard_error() const -> double {
+        return m_count > 1 ? std::sqrt(variance() / static_cast<double>(m_count)) : 0.0;
+    }
+};
+
+/**
+ * @brief Abstract base class for path functionals evaluated by a sweep
+ *
+ * For every path the sweep calls `begin_path` with the starting point, then
+ * `consume` with consecutive blocks of the following points, then
+ * `end_path`. Ensemble results are accumulated across paths. A derived
+ * class must be able to merge the accumulated state of another instance of
+ * the same class created by `clone_empty`.
+ */
+export class Observable {
+public:
+    virtual ~Observable() = default;
+
+    /**
+     * @brief Creates an instance with the same parameters and no paths
+     * @return The empty clone
+     */
+    [[nodiscard]] virtual auto clone_empty() const -> std::unique_ptr<Observable> = 0;
+
+    /**
+     * @brief Starts a new path
+     * @param time The starting time
+     * @param position The starting position
+     */
+    virtual void begin_path(double time, double position) = 0;
+
+    /**
+     * @brief Consumes the next points of the current path
+     * @param times The time points, increasing
+     * @param positions The positions, same size as times
+     */
+    virtual void consume(std::span<const double> times,
+                         std::span<const double> positions) = 0;
+
+    /**
+     * @brief Finishes the current path and adds it to the ensemble results
+     */
+    virtual void end_path() = 0;
+
+    /**
+     * @brief Adds the ensemble results of another instance
+     * @param other An instance created by `clone_empty` of this one
+     * @throws std::bad_cast if other has a different type
+     */
+    virtual void merge(const Observable &other) = 0;
+};
+
+/**
+ * @brief Running maximum and minimum of each path
+ *
+ * max_t X(t) and min_t X(t) are taken over the grid points of [0, T].
+ */
+export class ExtremeObservable final : public Observable {
+    double m_max = 0.0; ///< Maximum of the current path
+    double m_min = 0.0; ///< Minimum of the current path
+    RunningStats m_maxima; ///< Ensemble of path maxima
+    RunningStats m_minima; ///< Ensemble of path minima
+    RunningStats m_ranges; ///< Ensemble of path ranges max - min
+
+public:
+    [[nodiscard]] auto clone_empty() const -> std::unique_ptr<Observable> override {
+        return std::make_unique<ExtremeObservable>();
+    }
+
+    void begin_path(double time, double position) override {
+        m_max = position;
+        m_min = position;
+    }
+
+    void consume(std::span<const double> times,
+                 std::span<const double> positions) override {
+        double hi = m_max;
+        double lo = m_min;
+        for (double x: positions) {
+            hi = std::max(hi, x);
+            lo = std::min(lo, x);
+        }
+        m_max = hi;
+        m_min = lo;
+    }
+
+    void end_path() override {
+        m_maxima.push(m_max);
+        m_minima.push(m_min);
+        m_ranges.push(m_max - m_min);
+    }
+
+    void merge(const Observable &other) override {
+        const auto &o = dynamic_cast<const ExtremeObservable &>(other);
+        m_maxima.merge(o.m_maxima);
+        m_minima.merge(o.m_minima);
+        m_ranges.merge(o.m_ranges);
+    }
+
+    /**
+     * @brief Gets the ensemble of path maxima
+     * @return The statistics of max_t X(t)
+     */
+    [[nodiscard]] auto get_maxima() const -> const RunningStats & {
+        return m_maxima;
+    }
+
+    /**
+     * @brief Gets the ensemble of path minima
+     * @return The statistics of min_t X(t)
+     */
+    [[nodiscard]] auto get_minima() const -> const RunningStats & {
+        return m_minima;
+    }
+
+    /**
+     * @brief Gets the ensemble of path ranges
+     * @return The statistics of max_t X(t) - min_t X(t)
+     */
+    [[nodiscard]] auto get_ranges() const -> const RunningStats & {
+        return m_ranges;
+    }
+};
+
+/**
+ * @brief Time average of each path
+ *
+ * The functional is (1/T)∫₀ᵀ X(t)dt, whose ensemble variance measures how
+ * far single paths are from ergodic behavior.
+ */
+export class TimeAverageObservable final : public Observable {
+    double m_start = 0.0; ///< Starting time of the current path
+    double m_last_t = 0.0; ///< Time of the previous point
+    double m_last_x = 0.0; ///< Position of the previous point
+    double m_integral = 0.0; ///< Integral of X over the current path
+    RunningStats m_averages; ///< Ensemble of time averages
+
+public:
+    [[nodiscard]] auto clone_empty() const -> std::unique_ptr<Observable> override {
+        return std::make_unique<TimeAverageObservable>();
+    }
+
+    void begin_path(double time, double position) override {
+        m_start = time;
+        m_last_t = time;
+        m_last_x = position;
+        m_integral = 0.0;
+    }
+
+    void consume(std::span<const double> times,
+                 std::span<const double> positions) override {
+        double t_prev = m_last_t;
+        double x_prev = m_last_x;
+        double sum = 0.0;
+        for (size_t i = 0; i < times.size(); ++i) {
+            sum += x_prev * (times[i] - t_prev);
+            t_prev = times[i];
+            x_prev = positions[i];
+        }
+        m_integral += sum;
+        m_last_t = t_prev;
+        m_last_x = x_prev;
+    }
+
+    void end_path() override {
+        double duration = m_last_t - m_start;
+        m_averages.push(duration > 0 ? m_integral / duration : m_last_x);
+    }
+
+    void merge(const Observable &other) override {
+        m_averages.merge(dynamic_cast<const TimeAverageObservable &>(other).m_averages);
+    }
+
+    /**
+     * @brief Gets the ensemble of time averages
+     * @return The statistics of (1/T)∫X(t)dt
+     */
+    [[nodiscard]] auto get_averages() const -> const RunningStats & {
+        return m_averages;
+    }
+};
+
+/**
+ * @brief Occupation time of an interval
+ *
+ * The functional is L_T = ∫₀ᵀ 𝟙_{(a,b)}(X(t)) dt, as in `OccupationTime`.
+ */
+export class OccupationObservable final : public Observable {
+    double_pair m_domain; ///< The interval (a, b)
+    double m_last_t = 0.0; ///< Time of the previous point
+    double m_last_x = 0.0; ///< Position of the previous point
+    double m_time = 0.0; ///< Occupation time of the current path
+    double m_duration = 0.0; ///< Duration of the current path
+    RunningStats m_times; ///< Ensemble of occupation times
+    RunningStats m_fractions; ///< Ensemble of occupation fractions L_T / T
+
+public:
+    /**
+     * @brief Constructor
+     * @param domain The interval (a, b)
+     * @throws std::invalid_argument if a >= b
+     */
+    explicit OccupationObservable(double_pair domain) : m_domain(domain) {
+        auto [a, b] = domain;
+        if (a >= b) {
+            throw std::invalid_argument(std::format(
+                "The domain (a, b) must be a valid interval, but got ({}, {})", a, b));
+        }
+    }
+
+    [[nodiscard]] auto clone_empty() const -> std::unique_ptr<Observable> override {
+        return std::make_unique<OccupationObservable>(m_domain);
+    }
+
+    void begin_path(double time, double position) override {
+        m_last_t = time;
+        m_last_x = position;
+        m_time = 0.0;
+        m_duration = 0.0;
+    }
+
+    void consume(std::span<const double> times,
+                 std::span<const double> positions) override {
+        auto [a, b] = m_domain;
+        double t_prev = m_last_t;
+        double x_prev = m_last_x;
+        double inside = 0.0;
+        for (size_t i = 0; i < times.size(); ++i) {
+            double dt = times[i] - t_prev;
+            inside += (x_prev > a && x_prev < b) ? dt : 0.0;
+            t_prev = times[i];
+            x_prev = positions[i];
+        }
+        m_time += inside;
+        m_duration += t_prev - m_last_t;
+        m_last_t = t_prev;
+        m_last_x = x_prev;
+    }
+
+    void end_path() override {
+        m_times.push(m_time);
+        m_fractions.push(m_duration > 0 ? m_time / m_duration : 0.0);
+    }
+
+    void merge(const Observable &other) override {
+        const auto &o = dynamic_cast<const OccupationObservable &>(other);
+        m_times.merge(o.m_times);
+        m_fractions.merge(o.m_fractions);
+    }
+
+    /**
+     * @brief Gets the interval
+     * @return The interval (a, b)
+     */
+    [[nodiscard]] auto get_domain() const -> double_pair {
+        return m_domain;
+    }
+
+    /**
+     * @brief Gets the ensemble of occupation times
+     * @return The statistics of L_T
+     */
+    [[nodiscard]] auto get_times() const -> const RunningStats & {
+        return m_times;
+    }
+
+    /**
+     * @brief Gets the ensemble of occupation fractions
+     * @return The statistics of L_T / T
+     */
+    [[nodiscard]] auto get_fractions() const -> const RunningStats & {
+        return m_fractions;
+    }
+};
+
+/**
+ * @brief First exit from an interval (hitting flag)
+ *
+ * Records whether the path leaves (a, b) before the end of the sweep and,
+ * if it does, the first passage time τ = inf{t : X(t) ∉ (a, b)} as in
+ * `FirstPassageTime`. Blocks after the exit are skipped.
+ */
+export class ExitObservable final : public Observable {
+    double_pair m_domain; ///< The interval (a, b)
+    double m_start = 0.0; ///< Starting time of the current path
+    bool m_exited = false; ///< Whether the current path has left (a, b)
+    double m_exit_time = 0.0; ///< Exit time of the current path
+    size_t m_paths = 0; ///< Number of finished paths
+    RunningStats m_passage_times; ///< Ensemble of exit times of the paths that exited
+
+public:
+    /**
+     * @brief Constructor
+     * @param domain The interval (a, b)
+     * @throws std::invalid_argument if a >= b
+     */
+    explicit ExitObservable(double_pair domain) : m_domain(domain) {
+        auto [a, b] = domain;
+        if (a >= b) {
+            throw std::invalid_argument(std::format(
+                "The domain (a, b) must be a valid interval, but got ({}, {})", a, b));
+        }
+    }
+
+    [[nodiscard]] auto clone_empty() const -> std::unique_ptr<Observable> override {
+        return std::make_unique<ExitObservable>(m_domain);
+    }
+
+    void begin_path(double time, double position) override {
+        auto [a, b] = m_domain;
+        m_start = time;
+        m_exited = !(position > a && position < b);
+        m_exit_time = time;
+    }
+
+    void consume(std::span<const double> times,
+                 std::span<const double> positions) override {
+        if (m_exited) {
+            return;
+        }
+        auto [a, b] = m_domain;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            if (!(positions[i] > a && positions[i] < b)) {
+                m_exited = true;
+                m_exit_time = times[i];
+                return;
+            }
+        }
+    }
+
+    void end_path() override {
+        ++m_paths;
+        if (m_exited) {
+            m_passage_times.push(m_exit_time - m_start);
+        }
+    }
+
+    void merge(const Observable &other) override {
+        const auto &o = dynamic_cast<const ExitObservable &>(other);
+        m_paths += o.m_paths;
+        m_passage_times.merge(o.m_passage_times);
+    }
+
+    /**
+     * @brief Gets the interval
+     * @return The interval (a, b)
+     */
+    [[nodiscard]] auto get_domain() const -> double_pair {
+        return m_domain;
+    }
+
+    /**
+     * @brief Gets the fraction of paths that left the interval
+     * @return The exit probability within the sweep duration
+     */
+    [[nodiscard]] auto exit_probability() const -> double {
+        return m_paths > 0
+                   ? static_cast<double>(m_passage_times.count()) / static_cast<double>(m_paths)
+                   : 0.0;
+    }
+
+    /**
+     * @brief Gets the ensemble of exit times of the paths that left
+     * @return The statistics of τ conditioned on τ <= T
+     */
+    [[nodiscard]] auto get_passage_times() const -> const RunningStats & {
+        return m_passage_times;
+    }
+};
+
+/**
+ * @brief Raw and central moments of X(t) at fixed times
+ *
+ * For each requested time t_j the position at the first grid point with
+ * time >= t_j is recorded, so times should be multiples of the time step.
+ * Times beyond the end of the sweep are never reached and have no moments.
+ * Power sums of order 1..max_order are accumulated per time; central
+ * moments are expanded from them, which is accurate for the small orders
+ * this is meant for.
+ */
+export class GridMomentObservable final : public Observable {
+    vector<double> m_times; ///< Sorted sampling times
+    int m_max_order; ///< Highest accumulated order
+    bool m_displacement; ///< Whether X(t) - X(0) is measured instead of X(t)
+    double m_origin = 0.0; ///< Subtracted position of the current path
+    size_t m_next = 0; ///< Index of the next sampling time of the current path
+    vector<size_t> m_counts; ///< Number of paths that reached each time
+    vector<double> m_sums; ///< Power sums, max_order per time, row-major
+
+    void record(size_t j, double x) {
+        ++m_counts[j];
+        double *row = m_sums.data() + (j * static_cast<size_t>(m_max_order));
+        double power = 1.0;
+        for (int p = 0; p < m_max_order; ++p) {
+            power *= x;
+            row[p] += power;
+        }
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param times The sampling times, finite and distinct
+     * @param max_order The highest moment order (at least 1)
+     * @param displacement Whether to measure X(t) - X(0) instead of X(t)
+     * @throws std::invalid_argument if times is empty or max_order < 1
+     */
+    GridMomentObservable(vector<double> times, int max_order = 2, bool displacement = false)
+        : m_times(std::move(times)), m_max_order(max_order), m_displacement(displacement) {
+        if (m_times.empty()) {
+            throw std::invalid_argument("At least one sampling time is required");
+        }
+        if (max_order < 1) {
+            throw std::invalid_argument(
+                std::format("The maximum order must be at least 1, but got {}", max_order));
+        }
+        std::sort(m_times.begin(), m_times.end());
+        m_counts.assign(m_times.size(), 0);
+        m_sums.assign(m_times.size() * static_cast<size_t>(m_max_order), 0.0);
+    }
+
+    [[nodiscard]] auto clone_empty() const -> std::unique_ptr<Observable> override {
+        return std::make_unique<GridMomentObservable>(m_times, m_max_order, m_displacement);
+    }
+
+    void begin_path(double time, double position) override {
+        m_origin = m_displacement ? position : 0.0;
+        m_next = 0;
+        while (m_next < m_times.size() && m_times[m_next] <= time) {
+            record(m_next++, position - m_origin);
+        }
+    }
+
+    void consume(std::span<const double> times,
+                 std::span<const double> positions) override {
+        // Tolerate rounding of times that are multiples of the time step
+        while (m_next < m_times.size() && !times.empty()) {
+            double target = m_times[m_next] * (1.0 - 1e-12);
+            if (times.back() < target) {
+                return;
+            }
+            auto it = std::lower_bound(times.begin(), times.end(), target);
+            auto i = static_cast<size_t>(it - times.begin());
+            record(m_next++, positions[i] - m_origin);
+        }
+    }
+
+    void end_path() override {
+        m_next = m_times.size();
+    }
+
+    void merge(const Observable &other) override {
+        const auto &o = dynamic_cast<const GridMomentObservable &>(other);
+        if (o.m_sums.size() != m_sums.size()) {
+            throw std::invalid_argument("Cannot merge moments on different grids");
+        }
+        for (size_t j = 0; j < m_counts.size(); ++j) {
+            m_counts[j] += o.m_counts[j];
+        }
+        for (size_t k = 0; k < m_sums.size(); ++k) {
+            m_sums[k] += o.m_sums[k];
+        }
+    }
+
+    /**
+     * @brief Gets the sampling times
+     * @return The sorted sampling times
+     */
+    [[nodiscard]] auto get_times() const -> const vector<double> & {
+        return m_times;
+    }
+
+    /**
+     * @brief Gets a raw moment
+     * @param j The index of the sampling time
+     * @param order The order, in [0, max_order]
+     * @return Result containing E[X(t_j)^order], or an Error
+     */
+    [[nodiscard]] auto raw_moment(size_t j, int order) const -> Result<double> {
+        if (j >= m_times.size()) {
+            return Err(Error::InvalidArgument(
+                std::format("Time index {} out of range for {} times", j, m_times.size())));
+        }
+        if (order < 0 || order > m_max_order) {
+            return Err(Error::InvalidArgument(
+                std::format("The order must be in [0, {}], but got {}", m_max_order, order)));
+        }
+        if (m_counts[j] == 0) {
+            return Err(Error::SimulationFailed(
+                std::format("No path has reached time {}", m_times[j])));
+        }
+        if (order == 0) {
+            return Ok(1.0);
+        }
+        return Ok(m_sums[(j * static_cast<size_t>(m_max_order)) + static_cast<size_t>(order - 1)] /
+                  static_cast<double>(m_counts[j]));
+    }
+
+    /**
+     * @brief Gets a central moment
+     * @param j The index of the sampling time
+     * @param order The order, in [0, max_order]
+     * @return Result containing E[(X(t_j) - E[X(t_j)])^order], or an Error
+     */
+    [[nodiscard]] auto central_moment(size_t j, int order) const -> Result<double> {
+        auto mean = raw_moment(j, std::min(order, 1));
+        if (!mean) {
+            return Err(mean.error());
+        }
+        if (order > m_max_order) {
+            return Err(Error::InvalidArgument(
+                std::format("The order must be in [0, {}], but got {}", m_max_order, order)));
+        }
+        double mu = order == 0 ? 0.0 : mean.value();
+        // E[(X - mu)^n] = sum_k C(n, k) E[X^k] (-mu)^(n-k)
+        double result = 0.0;
+        double binomial = 1.0;
+        for (int k = 0; k <= order; ++k) {
+            result += binomial * raw_moment(j, k).value() * std::pow(-mu, order - k);
+            binomial = binomial * (order - k) / (k + 1);
+        }
+        return Ok(result);
+    }
+};
+
+/**
+ * @brief Registry of observables evaluated over one shared ensemble
+ *
+ * @example
+ * ```cpp
+ * Bm bm;
+ * ObservableSweep sweep;
+ * auto &extremes = sweep.add<ExtremeObservable>();
+ * auto &moments = sweep.add<GridMomentObservable>(vector<double>{1.0, 10.0});
+ * auto &exit = sweep.add<ExitObservable>(double_pair{-1.0, 1.0});
+ * sweep.run(bm, 10.0, 100000);
+ * double m = extremes.get_maxima().mean();
+ * ```
+ *
+ * References returned by `add` stay valid for the lifetime of the sweep.
+ * Results accumulate across calls to `run`, so an ensemble can be extended
+ * later.
+ */
+export class ObservableSweep {
+    vector<std::unique_ptr<Observable> > m_observables; ///< Registered observables
+    size_t m_paths = 0; ///< Number of paths simulated so far
+
+public:
+    /**
+     * @brief Registers a new observable
+     * @tparam T The observable type
+     * @param args The constructor arguments of T
+     * @return Reference to the registered observable, which holds the results
+     */
+    template<std::derived_from<Observable> T, typename... Args>
+    auto add(Args &&... args) -> T & {
+        auto observable = std::make_unique<T>(std::forward<Args>(args)...);
+        T &ref = *observable;
+        m_observables.push_back(std::move(observable));
+        return ref;
+    }
+
+    /**
+     * @brief Gets the number of registered observables
+     * @return The number of observables
+     */
+    [[nodiscard]] auto size() const -> size_t {
+        return m_observables.size();
+    }
+
+    /**
+     * @brief Gets the number of paths simulated so far
+     * @return The number of paths
+     */
+    [[nodiscard]] auto get_paths() const -> size_t {
+        return m_paths;
+    }
+
+    /**
+     * @brief Simulates an ensemble and feeds every path to all observables
+     * @param process The process, must support `stepper`
+     * @param duration The duration of each path
+     * @param particles The number of paths
+     * @param time_step The time step for discretization
+     * @param num_workers The number of worker threads
+     * @param block_size The number of points per block
+     * @return Result containing the total number of paths simulated so far, or an Error
+     *
+     * Memory use is O(num_workers * (block_size + observable state)).
+     */
+    auto run(ContinuousProcess &process, double duration, size_t particles,
+             double time_step = 0.01, size_t num_workers = default_workers(),
+             size_t block_size = observable_block_size) -> Result<size_t> {
+        if (duration <= 0) {
+            return Err(Error::InvalidArgument("Duration must be positive"));
+        }
+        if (particles == 0) {
+            return Err(Error::InvalidArgument("The number of particles must be greater than 0"));
+        }
+        if (block_size == 0) {
+            return Err(Error::InvalidArgument("Block size must be positive"));
+        }
+        // Fail early if the process has no stepper
+        if (auto probe = process.stepper(time_step); !probe) {
+            return Err(probe.error());
+        }
+
+        num_workers = std::clamp<size_t>(num_workers, 1, particles);
+        auto num_steps = count_steps(duration, time_step);
+        vector<vector<std::unique_ptr<Observable> > > locals(num_workers);
+        for (auto &local: locals) {
+            local.reserve(m_observables.size());
+            for (const auto &observable: m_observables) {
+                local.push_back(observable->clone_empty());
+            }
+        }
+        std::atomic<bool> failed{false};
+
+        run_placed(num_workers, num_workers, [&](size_t begin, size_t end) {
+            for (size_t w = begin; w < end; ++w) {
+                auto &local = locals[w];
+                size_t first = particles * w / num_workers;
+                size_t last = particles * (w + 1) / num_workers;
+                buffer<double> times(std::min(block_size, num_steps));
+                buffer<double> positions(times.size());
+                for (size_t p = first; p < last; ++p) {
+                    auto stepper = process.stepper(time_step);
+                    if (!stepper) {
+                        failed.store(true, std::memory_order_relaxed);
+                        return;
+                    }
+                    auto &path = *stepper.value();
+                    double end_time = path.get_time() + duration;
+                    for (auto &observable: local) {
+                        observable->begin_path(path.get_time(), path.get_position());
+                    }
+                    for (size_t done = 0; done < num_steps;) {
+                        size_t count = std::min(times.size(), num_steps - done);
+                        auto t = std::span(times).first(count);
+                        auto x = std::span(positions).first(count);
+                        if (done + count == num_steps) {
+                            path.finish(t, x, end_time);
+                        } else {
+                            path.advance(t, x);
+                        }
+                        for (auto &observable: local) {
+                            observable->consume(t, x);
+                        }
+                        done += count;
+                    }
+                    for (auto &observable: local) {
+                        observable->end_path();
+                    }
+                }
+            }
+        });
+
+        if (failed.load()) {
+            return Err(Error::SimulationFailed("Failed to create a stepper for a path"));
+        }
+        for (auto &local: locals) {
+            for (size_t k = 0; k < local.size(); ++k) {
+                m_observables[k]->merge(*local[k]);
+            }
+        }
+        m_paths += particles;
+        return Ok(m_paths);
+    }
+};
@@ -0,0 +1,395 @@
+/**
+ * @file path_integral.cppm
+ * @brief Local time, time integrals and Feynman-Kac weights as streaming functionals
+ *
+ * The observables of this module are evaluated by an `ObservableSweep`
+ * while paths are generated, so their ensemble distributions are obtained
+ * without storing a single path. Each of them keeps one value per path.
+ *
+ * - `PathIntegralObservable`: ∫X dt and ∫X² dt
+ * - `LocalTimeObservable`: occupation density (local time) at a level
+ * - `FeynmanKacObservable`: weights exp(-∫V(X)dt) and end points
+ *
+ * Integrals use the trapezoid rule on the stepper grid. When the variance
+ * rate σ² of the driving noise is given, the integrals are instead taken
+ * over the Brownian bridge between grid points: ∫X dt is then sampled
+ * exactly, and ∫X² dt and the local time are replaced by their conditional
+ * expectations given the grid, which are unbiased for Brownian motion.
+ */
+
+module;
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <format>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+export module diffusionx.simulation.basic.path_integral;
+
+import diffusionx.error;
+import diffusionx.memory;
+import diffusionx.random.utils;
+import diffusionx.simulation.basic.observable;
+
+using std::vector;
+
+/**
+ * @brief Computes exp(z²) erfc(z) for z >= 0 without overflow
+ * @param z The argument
+ * @return The scaled complementary error function
+ */
+auto scaled_erfc(double z) -> double {
+    if (z < 5.0) {
+        return std::exp(z * z) * std::erfc(z);
+    }
+    // Asymptotic series, relative error below 1e-7 for z >= 5
+    double r = 1.0 / (2.0 * z * z);
+    return (1.0 - r * (1.0 - 3.0 * r * (1.0 - 5.0 * r))) / (z * std::sqrt(std::numbers::pi));
+}
+
+/**
+ * @brief Checks an optional variance rate of a bridge
+ * @param variance_rate The variance per unit time, 0 to disable bridges
+ * @throws std::invalid_argument if variance_rate is negative or not finite
+ */
+void check_variance_rate(double variance_rate) {
+    if (!std::isfinite(variance_rate) || variance_rate < 0) {
+        throw std::invalid_argument(std::format(
+            "The variance rate must be non-negative and finite, but got {}", variance_rate));
+    }
+}
+
+/**
+ * @brief Time integrals ∫X dt and ∫X² dt of each path
+ *
+ * With a variance rate σ², the integral of the bridge between points x, y
+ * a time h apart is h(x + y)/2 + N(0, σ²h³/12), sampled exactly, and the
+ * integral of its square has conditional mean h(x² + xy + y²)/3 + σ²h²/6.
+ */
+export class PathIntegralObservable final : public Observable {
+    double m_variance_rate; ///< Variance rate σ² of the bridge, 0 for the trapezoid rule
+    std::mt19937 m_gen = generator(); ///< Random number generator of the bridges
+    std::normal_distribution<double> m_normal{0.0, 1.0}; ///< Standard normal
+    double m_last_t = 0.0; ///< Time of the previous point
+    double m_last_x = 0.0; ///< Previous position
+    double m_integral = 0.0; ///< ∫X dt of the current path
+    double m_square_integral = 0.0; ///< ∫X² dt of the current path
+    vector<double> m_integrals; ///< ∫X dt of every path
+    vector<double> m_square_integrals; ///< ∫X² dt of every path
+
+public:
+    /**
+     * @brief Constructor
+     * @param variance_rate The variance rate σ² of the noise, 0 for the trapezoid rule
+     * @throws std::invalid_argument if variance_rate is negative or not finite
+     */
+    explicit PathIntegralObservable(double variance_rate = 0.0)
+        : m_variance_rate(variance_rate) {
+        check_variance_rate(variance_rate);
+    }
+
+    [[nodiscard]] auto clone_empty() const -> std::unique_ptr<Observable> override {
+        return std::make_unique<PathIntegralObservable>(m_variance_rate);
+    }
+
+    void begin_path(double time, double position) override {
+        m_last_t = time;
+        m_last_x = position;
+        m_integral = 0.0;
+        m_square_integral = 0.0;
+    }
+
+    void consume(std::span<const double> times,
+                 std::span<const double> positions) override {
+        double t_prev = m_last_t;
+        double x_prev = m_last_x;
+        double first = 0.0;
+        double trapezoid = 0.0;
+        double bridge = 0.0;
+        double squares = 0.0;
+        double cubes = 0.0;
+        for (size_t i = 0; i < times.size(); ++i) {
+            double h = times[i] - t_prev;
+            double x = positions[i];
+            first += h * (x_prev + x);
+            trapezoid += h * ((x_prev * x_prev) + (x * x));
+            bridge += h * ((x_prev * x_prev) + (x_prev * x) + (x * x));
+            squares += h * h;
+            cubes += h * h * h;
+            t_prev = times[i];
+            x_prev = x;
+        }
+        m_integral += 0.5 * first;
+        if (m_variance_rate > 0) {
+            // The bridge pieces are independent given the grid
+            m_integral += std::sqrt(m_variance_rate * cubes / 12.0) * m_normal(m_gen);
+            m_square_integral += (bridge / 3.0) + (m_variance_rate * squares / 6.0);
+        } else {
+            m_square_integral += 0.5 * trapezoid;
+        }
+        m_last_t = t_prev;
+        m_last_x = x_prev;
+    }
+
+    void end_path() override {
+        m_integrals.push_back(m_integral);
+        m_square_integrals.push_back(m_square_integral);
+    }
+
+    void merge(const Observable &other) override {
+        const auto &o = dynamic_cast<const PathIntegralObservable &>(other);
+        m_integrals.insert(m_integrals.end(), o.m_integrals.begin(), o.m_integrals.end());
+        m_square_integrals.insert(m_square_integrals.end(), o.m_square_integrals.begin(),
+                                  o.m_square_integrals.end());
+    }
+
+    /**
+     * @brief Gets ∫X dt of every path
+     * @return The ensemble of time integrals
+     */
+    [[nodiscard]] auto get_integrals() const -> const vector<double> & {
+        return m_integrals;
+    }
+
+    /**
+     * @brief Gets ∫X² dt of every path
+     * @return The ensemble of integrals of the square
+     */
+    [[nodiscard]] auto get_square_integrals() const -> const vector<double> & {
+        return m_square_integrals;
+    }
+};
+
+/**
+ * @brief Local time (occupation density) at a level
+ *
+ * The local time ℓ_T(a) satisfies ∫₀ᵀ f(X)dt = ∫ f(a) ℓ_T(a) da; the
+ * semimartingale local time of a diffusion with variance rate σ² is σ² ℓ.
+ * Each step contributes the expected local time of the Brownian bridge
+ * between its end points x, y, a time h apart,
+ *
+ * E[ℓ] = √(πh/2)/σ · exp(w² - z²) · exp(z²) erfc(z),
+ *
+ * with z = (|x - a| + |y - a|)/(σ√(2h)) and w = |y - x|/(σ√(2h)), which is
+ * exact in expectation for Brownian motion at any time step. For processes
+ * with state-dependent noise, such as `Langevin`, use the variance rate at
+ * the level.
+ */
+export class LocalTimeObservable final : public Observable {
+    double m_level; ///< The level a
+    double m_variance_rate; ///< Variance rate σ² of the bridge
+    double m_last_t = 0.0; ///< Time of the previous point
+    double m_last_x = 0.0; ///< Previous position
+    double m_local_time = 0.0; ///< Local time of the current path
+    vector<double> m_local_times; ///< Local time of every path
+    RunningStats m_stats; ///< Statistics of the local times
+
+public:
+    /**
+     * @brief Constructor
+     * @param level The level a
+     * @param variance_rate The variance rate σ² of the noise near the level
+     * @throws std::invalid_argument if variance_rate is not positive and finite
+     */
+    LocalTimeObservable(double level, double variance_rate)
+        : m_level(level), m_variance_rate(variance_rate) {
+        check_variance_rate(variance_rate);
+        if (variance_rate == 0) {
+            throw std::invalid_argument("The variance rate must be positive");
+        }
+    }
+
+    [[nodiscard]] auto clone_empty() const -> std::unique_ptr<Observable> override {
+        return std::make_unique<LocalTimeObservable>(m_level, m_variance_rate);
+    }
+
+    void begin_path(double time, double position) override {
+        m_last_t = time;
+        m_last_x = position;
+        m_local_time = 0.0;
+    }
+
+    void consume(std::span<const double> times,
+                 std::span<const double> positions) override {
+        double sigma = std::sqrt(m_variance_rate);
+        double t_prev = m_last_t;
+        double x_prev = m_last_x;
+        double sum = 0.0;
+        for (size_t i = 0; i < times.size(); ++i) {
+            double h = times[i] - t_prev;
+            double x = positions[i];
+            double scale = 1.0 / (sigma * std::sqrt(2.0 * h));
+            double z = (std::abs(x_prev - m_level) + std::abs(x - m_level)) * scale;
+            double w = std::abs(x - x_prev) * scale;
+            double exponent = (w * w) - (z * z);
+            // Steps far from the level contribute below 1e-300
+            if (exponent > -690.0) {
+                sum += std::sqrt(std::numbers::pi * h / 2.0) / sigma * std::exp(exponent) *
+                        scaled_erfc(z);
+            }
+            t_prev = times[i];
+            x_prev = x;
+        }
+        m_local_time += sum;
+        m_last_t = t_prev;
+        m_last_x = x_prev;
+    }
+
+    void end_path() override {
+        m_local_times.push_back(m_local_time);
+        m_stats.push(m_local_time);
+    }
+
+    void merge(const Observable &other) override {
+        const auto &o = dynamic_cast<const LocalTimeObservable &>(other);
+        m_local_times.insert(m_local_times.end(), o.m_local_times.begin(), o.m_local_times.end());
+        m_stats.merge(o.m_stats);
+    }
+
+    /**
+     * @brief Gets the level
+     * @return The level a
+     */
+    [[nodiscard]] auto get_level() const -> double {
+        return m_level;
+    }
+
+    /**
+     * @brief Gets the local time of every path
+     * @return The ensemble of local times
+     */
+    [[nodiscard]] auto get_local_times() const -> const vector<double> & {
+        return m_local_times;
+    }
+
+    /**
+     * @brief Gets the statistics of the local times
+     * @return The mean and variance of ℓ_T(a)
+     */
+    [[nodiscard]] auto get_stats() const -> const RunningStats & {
+        return m_stats;
+    }
+};
+
+/**
+ * @brief Feynman-Kac weights exp(-∫₀ᵀ V(X)dt) of each path
+ * @tparam Potential Callable taking a position and returning V(x)
+ *
+ * Together with the end points the weights give the Feynman-Kac solution
+ * u(x0, T) = E[f(X_T) exp(-∫V(X)dt)] for any f through `expectation`. The
+ * potential is evaluated over a whole block first, so a potential that can
+ * be inlined vectorizes, and then integrated with the trapezoid rule.
+ *
+ * @example
+ * ```cpp
+ * auto harmonic = [](double x) { return 0.5 * x * x; };
+ * auto &fk = sweep.add<FeynmanKacObservable<decltype(harmonic)> >(harmonic);
+ * ```
+ */
+export template<typename Potential>
+    requires std::copy_constructible<Potential> &&
+             std::is_invocable_r_v<double, const Potential &, double>
+class FeynmanKacObservable final : public Observable {
+    Potential m_potential; ///< The potential V
+    buffer<double> m_values; ///< Potential along the current block
+    double m_last_t = 0.0; ///< Time of the previous point
+    double m_last_v = 0.0; ///< Potential at the previous point
+    double m_last_x = 0.0; ///< Previous position
+    double m_action = 0.0; ///< ∫V(X)dt of the current path
+    vector<double> m_weights; ///< Weight of every path
+    vector<double> m_endpoints; ///< End point of every path
+
+public:
+    /**
+     * @brief Constructor
+     * @param potential The potential V
+     */
+    explicit FeynmanKacObservable(Potential potential) : m_potential(std::move(potential)) {
+    }
+
+    [[nodiscard]] auto clone_empty() const -> std::unique_ptr<Observable> override {
+        return std::make_unique<FeynmanKacObservable>(m_potential);
+    }
+
+    void begin_path(double time, double position) override {
+        m_last_t = time;
+        m_last_x = position;
+        m_last_v = m_potential(position);
+        m_action = 0.0;
+    }
+
+    void consume(std::span<const double> times,
+                 std::span<const double> positions) override {
+        size_t n = times.size();
+        if (n == 0) {
+            return;
+        }
+        m_values.resize(n);
+        double *v = m_values.data();
+        for (size_t i = 0; i < n; ++i) {
+            v[i] = m_potential(positions[i]);
+        }
+        double sum = (times[0] - m_last_t) * (m_last_v + v[0]);
+        for (size_t i = 1; i < n; ++i) {
+            sum += (times[i] - times[i - 1]) * (v[i - 1] + v[i]);
+        }
+        m_action += 0.5 * sum;
+        m_last_t = times[n - 1];
+        m_last_v = v[n - 1];
+        m_last_x = positions[n - 1];
+    }
+
+    void end_path() override {
+        m_weights.push_back(std::exp(-m_action));
+        m_endpoints.push_back(m_last_x);
+    }
+
+    void merge(const Observable &other) override {
+        const auto &o = dynamic_cast<const FeynmanKacObservable &>(other);
+        m_weights.insert(m_weights.end(), o.m_weights.begin(), o.m_weights.end());
+        m_endpoints.insert(m_endpoints.end(), o.m_endpoints.begin(), o.m_endpoints.end());
+    }
+
+    /**
+     * @brief Gets the weight of every path
+     * @return The ensemble of exp(-∫V(X)dt)
+     */
+    [[nodiscard]] auto get_weights() const -> const vector<double> & {
+        return m_weights;
+    }
+
+    /**
+     * @brief Gets the end point of every path, in the order of the weights
+     * @return The ensemble of X_T
+     */
+    [[nodiscard]] auto get_endpoints() const -> const vector<double> & {
+        return m_endpoints;
+    }
+
+    /**
+     * @brief Computes a Feynman-Kac expectation
+     * @tparam F Callable taking the end point
+     * @param f The terminal function
+     * @return Result containing E[f(X_T) exp(-∫V(X)dt)], or an Error
+     */
+    template<typename F>
+        requires std::is_invocable_r_v<double, F &, double>
+    [[nodiscard]] auto expectation(F &&f) const -> Result<double> {
+        if (m_weights.empty()) {
+            return Err(Error::SimulationFailed("No paths have been simulated"));
+        }
+        double sum = 0.0;
+        for (size_t k = 0; k < m_weights.size(); ++k) {
+            sum += m_weights[k] * f(m_endpoints[k]);
+        }
+        return Ok(sum / static_cast<double>(m_weights.size()));
+    }
+};
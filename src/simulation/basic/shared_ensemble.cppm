@@ -0,0 +1,612 @@
+/**
+ * @file shared_ensemble.cppm
+ * @brief Ensemble buffers in named POSIX shared memory
+ *
+ * A producer publishes an ensemble chunk by chunk into a named shared
+ * memory segment, and analysis or visualization processes on the same node
+ * map the segment and read the chunks in place as they complete, without
+ * files, serialization or copies.
+ *
+ * The segment holds a header and a ring of slots. Chunk k goes to slot
+ * k mod S, and each slot carries an atomic sequence number: 2k + 1 while
+ * chunk k is written and 2k + 2 once it is complete. A reader checks the
+ * sequence before and after using the values in place, so a chunk that the
+ * producer overwrote in the meantime is detected instead of read torn. If
+ * the producer is created with `wait_for_readers`, it does not overwrite
+ * chunks that readers have not acknowledged, and fails with
+ * `Error::IoError` if no acknowledgement arrives within `reader_timeout`.
+ *
+ * Supported on POSIX systems (Linux, macOS); elsewhere creating or opening
+ * a segment returns `Error::NotImplemented`.
+ */
+
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DIFFUSIONX_HAS_SHM 1
+#endif
+
+export module diffusionx.simulation.basic.shared_ensemble;
+
+import diffusionx.error;
+import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
+
+using std::string;
+using std::vector;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared ensemble buffers need address-free 64-bit atomics");
+
+/**
+ * @brief Identifies a shared ensemble segment ("DXSHMENS")
+ */
+constexpr uint64_t shared_ensemble_magic = 0x534e454d48535844ULL;
+
+/**
+ * @brief Version of the segment layout
+ */
+constexpr uint64_t shared_ensemble_version = 1;
+
+/**
+ * @brief Header at the start of a segment
+ */
+struct alignas(64) SharedEnsembleHeader {
+    uint64_t magic; ///< shared_ensemble_magic once the segment is initialized
+    uint64_t version; ///< shared_ensemble_version
+    uint64_t slots; ///< Number of slots S
+    uint64_t rows; ///< Rows per chunk
+    uint64_t columns; ///< Columns per chunk
+    uint64_t slot_bytes; ///< Stride between slots
+    alignas(64) std::atomic<uint64_t> published; ///< Number of published chunks
+    std::atomic<uint64_t> acknowledged; ///< Chunks readers are done with
+    std::atomic<uint64_t> closed; ///< Non-zero once the producer is done
+};
+
+/**
+ * @brief Header of a slot, followed by rows × columns doubles
+ */
+struct alignas(64) SharedSlotHeader {
+    std::atomic<uint64_t> sequence; ///< 2k + 1 while chunk k is written, 2k + 2 after
+    uint64_t rows; ///< Rows used by the chunk
+    uint64_t tag; ///< Producer-defined tag, e.g. the index of the first step
+};
+
+/**
+ * @brief Shape of a shared ensemble
+ */
+export struct SharedEnsembleLayout {
+    size_t slots = 8; ///< Chunks held in the ring
+    size_t rows = 1024; ///< Rows per chunk, e.g. time steps
+    size_t columns = 1; ///< Columns per chunk, e.g. particles
+};
+
+/**
+ * @brief Options of a shared ensemble producer
+ */
+export struct SharedEnsembleOptions {
+    bool wait_for_readers = false; ///< Block instead of overwriting unacknowledged chunks
+    bool unlink_on_close = true; ///< Remove the name when the producer is destroyed
+    std::chrono::milliseconds reader_timeout{10000}; ///< Longest wait for an acknowledgement
+};
+
+/**
+ * @brief A published chunk, viewed in place in the shared segment
+ */
+export struct SharedChunk {
+    uint64_t index = 0; ///< Chunk number k
+    uint64_t tag = 0; ///< Producer-defined tag
+    size_t rows = 0; ///< Rows in the chunk
+    size_t columns = 0; ///< Columns per row
+    std::span<const double> values; ///< rows × columns values, row-major
+};
+
+/**
+ * @brief A mapping of a shared memory segment, unmapped on destruction
+ */
+class SharedMapping {
+    void *m_base = nullptr; ///< Start of the mapping
+    size_t m_bytes = 0; ///< Length of the mapping
+
+public:
+    SharedMapping() = default;
+
+    SharedMapping(void *base, size_t bytes) : m_base(base), m_bytes(bytes) {
+    }
+
+    SharedMapping(const SharedMapping &) = delete;
+    auto operator=(const SharedMapping &) -> SharedMapping & = delete;
+
+    SharedMapping(SharedMapping &&other) noexcept
+        : m_base(std::exchange(other.m_base, nullptr)), m_bytes(std::exchange(other.m_bytes, 0)) {
+    }
+
+    auto operator=(SharedMapping &&other) noexcept -> SharedMapping & {
+        if (this != &other) {
+            reset();
+            m_base = std::exchange(other.m_base, nullptr);
+            m_bytes = std::exchange(other.m_bytes, 0);
+        }
+        return *this;
+    }
+
+    ~SharedMapping() {
+        reset();
+    }
+
+    void reset() {
+#if defined(DIFFUSIONX_HAS_SHM)
+        if (m_base != nullptr) {
+            munmap(m_base, m_bytes);
+        }
+#endif
+        m_base = nullptr;
+        m_bytes = 0;
+    }
+
+    [[nodiscard]] auto header() const -> SharedEnsembleHeader * {
+        return static_cast<SharedEnsembleHeader *>(m_base);
+    }
+
+    [[nodiscard]] auto slot(uint64_t chunk) const -> SharedSlotHeader * {
+        const auto *h = header();
+        auto *bytes = static_cast<std::byte *>(m_base) + sizeof(SharedEnsembleHeader) +
+                      ((chunk % h->slots) * h->slot_bytes);
+        return std::launder(reinterpret_cast<SharedSlotHeader *>(bytes));
+    }
+
+    [[nodiscard]] auto values(uint64_t chunk) const -> double * {
+        return reinterpret_cast<double *>(reinterpret_cast<std::byte *>(slot(chunk)) +
+                                          sizeof(SharedSlotHeader));
+    }
+};
+
+/**
+ * @brief Checks a segment name
+ */
+auto check_shared_name(const string &name) -> Result<int> {
+    if (name.size() < 2 || name[0] != '/' || name.find('/', 1) != string::npos) {
+        return Err(Error::InvalidArgument(std::format(
+            "Shared memory names must be of the form /name, but got '{}'", name)));
+    }
+    return Ok(0);
+}
+
+/**
+ * @brief Producer side of a shared ensemble
+ *
+ * Chunks are filled in place: `next_chunk` returns the storage of the next
+ * slot and `publish` makes it visible to readers. Only one producer may
+ * write to a segment.
+ */
+export class SharedEnsembleWriter {
+    SharedMapping m_mapping; ///< The mapped segment
+    string m_name; ///< Name of the segment
+    SharedEnsembleOptions m_options; ///< Producer options
+    uint64_t m_next = 0; ///< Number of the chunk being written
+    bool m_open = false; ///< Whether a chunk is being written
+
+    SharedEnsembleWriter(SharedMapping mapping, string name, SharedEnsembleOptions options)
+        : m_mapping(std::move(mapping)), m_name(std::move(name)), m_options(options) {
+    }
+
+public:
+    SharedEnsembleWriter(SharedEnsembleWriter &&) noexcept = default;
+    auto operator=(SharedEnsembleWriter &&) noexcept -> SharedEnsembleWriter & = default;
+
+    ~SharedEnsembleWriter() {
+        if (m_mapping.header() == nullptr) {
+            return;
+        }
+        close();
+        m_mapping.reset();
+#if defined(DIFFUSIONX_HAS_SHM)
+        if (m_options.unlink_on_close) {
+            shm_unlink(m_name.c_str());
+        }
+#endif
+    }
+
+    /**
+     * @brief Creates a named segment, replacing any segment of the same name
+     * @param name Name of the form "/name"
+     * @param layout Shape of the ring
+     * @param options Producer options
+     * @return Result containing the producer, or an Error
+     */
+    static auto create(const string &name, SharedEnsembleLayout layout,
+                       SharedEnsembleOptions options = {}) -> Result<SharedEnsembleWriter> {
+        if (auto res = check_shared_name(name); !res) {
+            return Err(res.error());
+        }
+        if (layout.slots == 0 || layout.rows == 0 || layout.columns == 0) {
+            return Err(Error::InvalidArgument("Slots, rows and columns must be positive"));
+        }
+#if defined(DIFFUSIONX_HAS_SHM)
+        size_t value_bytes = layout.rows * layout.columns * sizeof(double);
+        size_t slot_bytes = sizeof(SharedSlotHeader) + ((value_bytes + 63) / 64 * 64);
+        size_t bytes = sizeof(SharedEnsembleHeader) + (layout.slots * slot_bytes);
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            return Err(Error::IoError(
+                std::format("shm_open('{}') failed: {}", name, std::strerror(errno))));
+        }
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            int err = errno;
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return Err(Error::IoError(
+                std::format("Cannot size '{}' to {} bytes: {}", name, bytes, std::strerror(err))));
+        }
+        void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            shm_unlink(name.c_str());
+            return Err(Error::IoError(
+                std::format("mmap of '{}' failed: {}", name, std::strerror(errno))));
+        }
+        SharedMapping mapping(base, bytes);
+        auto *header = new(base) SharedEnsembleHeader{};
+        header->version = shared_ensemble_version;
+        header->slots = layout.slots;
+        header->rows = layout.rows;
+        header->columns = layout.columns;
+        header->slot_bytes = slot_bytes;
+        for (size_t s = 0; s < layout.slots; ++s) {
+            new(static_cast<std::byte *>(base) + sizeof(SharedEnsembleHeader) + (s * slot_bytes))
+                SharedSlotHeader{};
+        }
+        // Readers accept the segment once the magic number is visible
+        std::atomic_ref(header->magic).store(shared_ensemble_magic, std::memory_order_release);
+        return Ok(SharedEnsembleWriter(std::move(mapping), name, options));
+#else
+        return Err(Error::NotImplemented("Shared memory is not supported on this platform"));
+#endif
+    }
+
+    /**
+     * @brief Removes a named segment
+     * @param name Name of the form "/name"
+     * @return Result containing 0 on success, or an Error
+     *
+     * Processes that have the segment mapped keep their mapping.
+     */
+    static auto remove(const string &name) -> Result<int> {
+        if (auto res = check_shared_name(name); !res) {
+            return res;
+        }
+#if defined(DIFFUSIONX_HAS_SHM)
+        if (shm_unlink(name.c_str()) != 0) {
+            return Err(Error::IoError(
+                std::format("shm_unlink('{}') failed: {}", name, std::strerror(errno))));
+        }
+        return Ok(0);
+#else
+        return Err(Error::NotImplemented("Shared memory is not supported on this platform"));
+#endif
+    }
+
+    /**
+     * @brief Gets the shape of the ring
+     * @return The layout
+     */
+    [[nodiscard]] auto layout() const -> SharedEnsembleLayout {
+        const auto *h = m_mapping.header();
+        return {h->slots, h->rows, h->columns};
+    }
+
+    /**
+     * @brief Gets the number of published chunks
+     * @return The number of the next chunk
+     */
+    [[nodiscard]] auto published() const -> uint64_t {
+        return m_next;
+    }
+
+    /**
+     * @brief Starts the next chunk
+     * @return Result containing storage for rows × columns values, row-major,
+     * valid until `publish`, or an Error
+     *
+     * With `wait_for_readers` this blocks while the ring is full of chunks
+     * that readers have not acknowledged. If the acknowledgements do not
+     * advance for `reader_timeout`, the readers are taken as gone and an
+     * `Error::IoError` is returned.
+     */
+    auto next_chunk() -> Result<std::span<double> > {
+        auto *h = m_mapping.header();
+        if (m_options.wait_for_readers) {
+            uint64_t acknowledged = h->acknowledged.load(std::memory_order_acquire);
+            auto deadline = std::chrono::steady_clock::now() + m_options.reader_timeout;
+            while (m_next >= acknowledged + h->slots) {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= deadline) {
+                    return Err(Error::IoError(std::format(
+                        "No reader acknowledged chunk {} within {} ms", acknowledged,
+                        m_options.reader_timeout.count())));
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                uint64_t current = h->acknowledged.load(std::memory_order_acquire);
+                if (current != acknowledged) {
+                    acknowledged = current;
+                    deadline = now + m_options.reader_timeout;
+                }
+            }
+        }
+        auto *slot = m_mapping.slot(m_next);
+        slot->sequence.store((2 * m_next) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_open = true;
+        return Ok(std::span<double>(m_mapping.values(m_next), h->rows * h->columns));
+    }
+
+    /**
+     * @brief Publishes the chunk started by `next_chunk`
+     * @param rows Number of rows filled (at most the layout rows)
+     * @param tag Producer-defined tag, e.g. the index of the first step
+     */
+    void publish(size_t rows, uint64_t tag = 0) {
+        if (!m_open) {
+            return;
+        }
+        auto *h = m_mapping.header();
+        auto *slot = m_mapping.slot(m_next);
+        slot->rows = std::min<uint64_t>(rows, h->rows);
+        slot->tag = tag;
+        slot->sequence.store((2 * m_next) + 2, std::memory_order_release);
+        ++m_next;
+        h->published.store(m_next, std::memory_order_release);
+        m_open = false;
+    }
+
+    /**
+     * @brief Marks the ensemble as complete, so readers stop waiting
+     */
+    void close() {
+        m_mapping.header()->closed.store(1, std::memory_order_release);
+    }
+};
+
+/**
+ * @brief Consumer side of a shared ensemble
+ *
+ * Any number of readers may map a segment. Chunk values are read in place;
+ * a reader calls `validate` after using a chunk to check that the producer
+ * did not overwrite it in the meantime, and `acknowledge` to let a producer
+ * created with `wait_for_readers` reuse the slots.
+ */
+export class SharedEnsembleReader {
+    SharedMapping m_mapping; ///< The mapped segment
+
+    explicit SharedEnsembleReader(SharedMapping mapping) : m_mapping(std::move(mapping)) {
+    }
+
+public:
+    /**
+     * @brief Maps an existing segment
+     * @param name Name of the form "/name"
+     * @return Result containing the reader, or an Error if the segment does
+     * not exist or is not a shared ensemble
+     */
+    static auto open(const string &name) -> Result<SharedEnsembleReader> {
+        if (auto res = check_shared_name(name); !res) {
+            return Err(res.error());
+        }
+#if defined(DIFFUSIONX_HAS_SHM)
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            return Err(Error::IoError(
+                std::format("shm_open('{}') failed: {}", name, std::strerror(errno))));
+        }
+        struct stat info{};
+        if (fstat(fd, &info) != 0 ||
+            static_cast<size_t>(info.st_size) < sizeof(SharedEnsembleHeader)) {
+            ::close(fd);
+            return Err(Error::IoError(std::format("'{}' is not a shared ensemble", name)));
+        }
+        auto bytes = static_cast<size_t>(info.st_size);
+        // Read-write only for the acknowledgement counter
+        void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            return Err(Error::IoError(
+                std::format("mmap of '{}' failed: {}", name, std::strerror(errno))));
+        }
+        SharedMapping mapping(base, bytes);
+        auto *h = mapping.header();
+        if (std::atomic_ref(h->magic).load(std::memory_order_acquire) != shared_ensemble_magic ||
+            h->version != shared_ensemble_version ||
+            sizeof(SharedEnsembleHeader) + (h->slots * h->slot_bytes) > bytes) {
+            return Err(Error::IoError(std::format("'{}' is not a shared ensemble", name)));
+        }
+        return Ok(SharedEnsembleReader(std::move(mapping)));
+#else
+        return Err(Error::NotImplemented("Shared memory is not supported on this platform"));
+#endif
+    }
+
+    /**
+     * @brief Gets the shape of the ring
+     * @return The layout
+     */
+    [[nodiscard]] auto layout() const -> SharedEnsembleLayout {
+        const auto *h = m_mapping.header();
+        return {h->slots, h->rows, h->columns};
+    }
+
+    /**
+     * @brief Gets the number of published chunks
+     * @return The number of chunks completed so far
+     */
+    [[nodiscard]] auto published() const -> uint64_t {
+        return m_mapping.header()->published.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Checks whether the producer has closed the ensemble
+     * @return True once no more chunks will be published
+     */
+    [[nodiscard]] auto closed() const -> bool {
+        return m_mapping.header()->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    /**
+     * @brief Views a chunk if it is complete
+     * @param index The chunk number
+     * @return Result containing the chunk, None if it is not complete yet, or
+     * an Error if the producer has already overwritten it
+     */
+    [[nodiscard]] auto try_read(uint64_t index) const -> Result<Option<SharedChunk> > {
+        const auto *h = m_mapping.header();
+        uint64_t sequence = m_mapping.slot(index)->sequence.load(std::memory_order_acquire);
+        uint64_t expected = (2 * index) + 2;
+        if (sequence > expected) {
+            return Err(Error::SimulationFailed(
+                std::format("Chunk {} was overwritten before it was read", index)));
+        }
+        if (sequence < expected) {
+            return Ok(Option<SharedChunk>(std::nullopt));
+        }
+        const auto *slot = m_mapping.slot(index);
+        SharedChunk chunk;
+        chunk.index = index;
+        chunk.tag = slot->tag;
+        chunk.rows = slot->rows;
+        chunk.columns = h->columns;
+        chunk.values = std::span<const double>(m_mapping.values(index), chunk.rows * chunk.columns);
+        return Ok(Option<SharedChunk>(chunk));
+    }
+
+    /**
+     * @brief Waits for a chunk
+     * @param index The chunk number
+     * @param timeout How long to wait at most
+     * @return Result containing the chunk, None on timeout or if the
+     * ensemble was closed before the chunk was published, or an Error if it
+     * was overwritten
+     */
+    [[nodiscard]] auto wait(uint64_t index,
+                            std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+        const -> Result<Option<SharedChunk> > {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true) {
+            auto chunk = try_read(index);
+            if (!chunk || chunk->has_value()) {
+                return chunk;
+            }
+            if ((closed() && published() <= index) || std::chrono::steady_clock::now() > deadline) {
+                return chunk;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    /**
+     * @brief Checks that a chunk was not overwritten while it was used
+     * @param chunk A chunk returned by `try_read` or `wait`
+     * @return True if the values seen were the published ones
+     */
+    [[nodiscard]] auto validate(const SharedChunk &chunk) const -> bool {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_mapping.slot(chunk.index)->sequence.load(std::memory_order_relaxed) ==
+               (2 * chunk.index) + 2;
+    }
+
+    /**
+     * @brief Tells a waiting producer that all chunks before index are done
+     * @param index One past the last chunk this reader no longer needs
+     *
+     * With several readers, the slowest one should acknowledge.
+     */
+    void acknowledge(uint64_t index) {
+        auto &acknowledged = m_mapping.header()->acknowledged;
+        uint64_t current = acknowledged.load(std::memory_order_relaxed);
+        while (current < index &&
+               !acknowledged.compare_exchange_weak(current, index, std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
+        }
+    }
+};
+
+/**
+ * @brief Streams an ensemble of paths into a shared ensemble
+ * @param process The process to simulate
+ * @param duration The duration of each path
+ * @param time_step The time step of the grid
+ * @param writer The producer; each column of its layout is one particle
+ * @return Result containing the number of published chunks, or an Error
+ *
+ * One stepper per column advances in lockstep; each chunk holds `rows`
+ * consecutive time steps of all particles (row-major, time by particle),
+ * tagged with the index of its first step. The last step is shortened so
+ * that the last row lies at duration. The ensemble is closed at the end,
+ * also when waiting for readers times out.
+ */
+export auto stream_ensemble(ContinuousProcess &process, double duration, double time_step,
+                            SharedEnsembleWriter &writer) -> Result<uint64_t> {
+    if (duration <= 0) {
+        return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    auto layout = writer.layout();
+    vector<std::unique_ptr<Stepper> > steppers;
+    steppers.reserve(layout.columns);
+    for (size_t c = 0; c < layout.columns; ++c) {
+        auto stepper = process.stepper(time_step);
+        if (!stepper) {
+            return Err(stepper.error());
+        }
+        steppers.push_back(std::move(stepper.value()));
+    }
+    auto num_steps = count_steps(duration, time_step);
+    double end_time = steppers.front()->get_time() + duration;
+    vector<double> column(layout.rows);
+    uint64_t chunks = 0;
+    for (size_t done = 0; done < num_steps;) {
+        size_t rows = std::min(layout.rows, num_steps - done);
+        bool last = done + rows == num_steps;
+        auto values = writer.next_chunk();
+        if (!values) {
+            writer.close();
+            return Err(values.error());
+        }
+        for (size_t c = 0; c < layout.columns; ++c) {
+            auto block = std::span(column).first(rows);
+            if (last) {
+                steppers[c]->finish(block, end_time);
+            } else {
+                steppers[c]->advance(block);
+            }
+            for (size_t r = 0; r < rows; ++r) {
+                (*values)[(r * layout.columns) + c] = block[r];
+            }
+        }
+        writer.publish(rows, done + 1);
+        done += rows;
+        ++chunks;
+    }
+    writer.close();
+    return Ok(chunks);
+}
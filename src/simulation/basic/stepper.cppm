@@ -0,0 +1,247 @@
+/**
+ * @file stepper.cppm
+ * @brief Block-wise stepping interface for streaming path generation
+ *
+ * This module provides an incremental alternative to `simulate`: a stepper
+ * holds the current state of a single path on a uniform time grid and
+ * generates the next points into caller-provided buffers, so arbitrarily
+ * long paths can be consumed in constant memory.
+ */
+
+module;
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.simulation.basic.stepper;
+
+import diffusionx.error;
+import diffusionx.memory;
+
+/**
+ * @brief Default number of points generated per block by `stream_path`
+ */
+export constexpr size_t stepper_block_size = 4096;
+
+/**
+ * @brief Last steps shorter than this many time steps are dropped
+ *
+ * When the duration is a multiple of the time step, rounding can leave a
+ * last step of zero or almost zero length.
+ */
+export constexpr double step_tolerance = 1e-9;
+
+/**
+ * @brief Gets the number of steps of a path of the given duration
+ * @param duration The duration (must be positive)
+ * @param time_step The time step (must be positive)
+ * @return ceil(duration / time_step), not counting a last step shorter than
+ * `step_tolerance` time steps, and at least 1
+ */
+export auto count_steps(double duration, double time_step) -> size_t {
+    auto steps = static_cast<size_t>(std::ceil((duration / time_step) - step_tolerance));
+    return std::max<size_t>(steps, 1);
+}
+
+/**
+ * @brief Abstract base class for incremental path generators
+ *
+ * A stepper starts at (start_time, start_position) and every call to
+ * `advance` generates the next points of the path on the grid
+ * t_k = start_time + k * time_step. `finish` ends a path at an arbitrary
+ * time with a shorter last step. Derived classes implement `step_positions`
+ * and `step_partial` and keep `m_position` equal to the last generated value.
+ */
+export class Stepper {
+    double m_grid_time; ///< Time of the grid origin (start or last short step)
+    double m_time_step; ///< Time step of the grid
+    size_t m_grid_steps = 0; ///< Number of grid points generated since the origin
+    size_t m_steps = 0; ///< Number of points generated so far
+
+protected:
+    double m_position; ///< Position at the current time
+
+    /**
+     * @brief Generates the next positions.size() positions of the path
+     * @param positions Output buffer
+     */
+    virtual void step_positions(std::span<double> positions) = 0;
+
+    /**
+     * @brief Generates the position after a single step of the given length
+     * @param time_step The length of the step, in (0, get_time_step()]
+     * @return The new position
+     */
+    virtual auto step_partial(double time_step) -> double = 0;
+
+public:
+    /**
+     * @brief Constructor
+     * @param start_position The starting position
+     * @param time_step The time step of the grid
+     * @param start_time The starting time
+     * @throws std::invalid_argument if time_step is not positive
+     */
+    Stepper(double start_position, double time_step, double start_time = 0.0)
+        : m_grid_time(start_time), m_time_step(time_step),
+          m_position(start_position) {
+        if (time_step <= 0) {
+            throw std::invalid_argument("Time step must be positive");
+        }
+    }
+
+    virtual ~Stepper() = default;
+
+    /**
+     * @brief Generates the next positions.size() positions of the path
+     * @param positions Output buffer
+     */
+    void advance(std::span<double> positions) {
+        if (positions.empty()) {
+            return;
+        }
+        step_positions(positions);
+        m_grid_steps += positions.size();
+        m_steps += positions.size();
+    }
+
+    /**
+     * @brief Generates the next points of the path
+     * @param times Output buffer for the time points
+     * @param positions Output buffer for the positions, same size as times
+     */
+    void advance(std::span<double> times, std::span<double> positions) {
+        for (size_t i = 0; i < times.size(); ++i) {
+            times[i] = m_grid_time +
+                       (static_cast<double>(m_grid_steps + i + 1) * m_time_step);
+        }
+        advance(positions);
+    }
+
+    /**
+     * @brief Generates the last positions of a path ending at end_time
+     * @param positions Output buffer
+     * @param end_time The time of the last point, at most one time step
+     * after the time of the second-to-last point
+     *
+     * All points but the last lie on the grid; the last one is reached with
+     * a shorter step, like the last point of `simulate`. If end_time is
+     * within `step_tolerance` time steps of the second-to-last point, the
+     * last point repeats its position instead. The grid restarts at
+     * end_time, so the stepper can go on afterwards.
+     */
+    void finish(std::span<double> positions, double end_time) {
+        if (positions.empty()) {
+            return;
+        }
+        advance(positions.first(positions.size() - 1));
+        double last_step = std::min(end_time - get_time(), m_time_step);
+        positions.back() =
+            last_step > step_tolerance * m_time_step ? step_partial(last_step) : m_position;
+        m_grid_time = end_time;
+        m_grid_steps = 0;
+        ++m_steps;
+    }
+
+    /**
+     * @brief Generates the last points of a path ending at end_time
+     * @param times Output buffer for the time points
+     * @param positions Output buffer for the positions, same size as times
+     * @param end_time The time of the last point
+     */
+    void finish(std::span<double> times, std::span<double> positions, double end_time) {
+        if (times.empty()) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < times.size(); ++i) {
+            times[i] = m_grid_time +
+                       (static_cast<double>(m_grid_steps + i + 1) * m_time_step);
+        }
+        times.back() = end_time;
+        finish(positions, end_time);
+    }
+
+    /**
+     * @brief Gets the current time
+     * @return The time of the last generated point
+     */
+    [[nodiscard]] auto get_time() const -> double {
+        return m_grid_time + (static_cast<double>(m_grid_steps) * m_time_step);
+    }
+
+    /**
+     * @brief Gets the current position
+     * @return The position of the last generated point
+     */
+    [[nodiscard]] auto get_position() const -> double {
+        return m_position;
+    }
+
+    /**
+     * @brief Gets the time step of the grid
+     * @return The time step
+     */
+    [[nodiscard]] auto get_time_step() const -> double {
+        return m_time_step;
+    }
+
+    /**
+     * @brief Gets the number of generated points
+     * @return The number of steps taken since the start
+     */
+    [[nodiscard]] auto get_steps() const -> size_t {
+        return m_steps;
+    }
+};
+
+/**
+ * @brief Streams a path of the given duration block by block into a sink
+ * @tparam F Callable taking (span<const double> times, span<const double> positions)
+ * @param stepper The stepper generating the path
+ * @param duration The duration to simulate, from the current time
+ * @param sink The consumer of the generated blocks
+ * @param block_size The number of points per block
+ * @return Result containing the number of points passed to the sink, or an Error
+ *
+ * The first block holds only the current point of the stepper. The other
+ * points lie on the grid of the stepper, except the last one, which is
+ * reached with a shorter step so that it lands exactly at the current time
+ * plus duration, like the last point of `simulate`. Memory use is
+ * O(block_size) regardless of the duration.
+ */
+export template<typename F>
+    requires std::invocable<F &, std::span<const double>, std::span<const double> >
+auto stream_path(Stepper &stepper, double duration, F &&sink,
+                 size_t block_size = stepper_block_size) -> Result<size_t> {
+    if (duration <= 0) {
+        return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    if (block_size == 0) {
+        return Err(Error::InvalidArgument("Block size must be positive"));
+    }
+    auto num_steps = count_steps(duration, stepper.get_time_step());
+    double t0 = stepper.get_time();
+    double x0 = stepper.get_position();
+    double end_time = t0 + duration;
+    sink(std::span<const double>(&t0, 1), std::span<const double>(&x0, 1));
+
+    buffer<double> times(std::min(block_size, num_steps));
+    buffer<double> positions(times.size());
+    for (size_t done = 0; done < num_steps;) {
+        size_t count = std::min(times.size(), num_steps - done);
+        auto t = std::span(times).first(count);
+        auto x = std::span(positions).first(count);
+        if (done + count == num_steps) {
+            stepper.finish(t, x, end_time);
+        } else {
+            stepper.advance(t, x);
+        }
+        sink(std::span<const double>(t), std::span<const double>(x));
+        done += count;
+    }
+    return Ok(num_steps + 1);
+}
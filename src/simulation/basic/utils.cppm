@@ -8,6 +8,7 @@
 
 module;
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <thread>
@@ -17,6 +18,7 @@ module;
 export module diffusionx.simulation.basic.utils;
 
 import diffusionx.error;
+import diffusionx.parallel;
 
 using std::vector;
 
@@ -56,44 +58,30 @@ auto parallel_monte_carlo(size_t particles, F func) -> Result<double> {
         return Err(Error::InvalidArgument("The number of particles must be greater than 0"));
     }
 
-    size_t num_threads = std::thread::hardware_concurrency();
-    if (num_threads == 0) {
-        num_threads = 1;
-    }
-    if (std::cmp_less(particles, num_threads)) {
-        num_threads = particles;
-    }
-
-    vector<std::thread> threads;
-    threads.reserve(num_threads);
-
-    vector<double> partial_results(num_threads, 0.0);
-
+    // One partial sum per worker, padded to avoid false sharing
+    struct alignas(64) PartialSum {
+        double value = 0.0;
+    };
+    size_t num_threads = std::min(default_workers(), particles);
+    vector<PartialSum> partial_results(num_threads);
     size_t chunk_size = (particles + num_threads - 1) / num_threads;
 
-    for (unsigned int i = 0; i < num_threads; ++i) {
-        size_t start = i * chunk_size;
-        size_t end = std::min(start + chunk_size, particles);
-
-        threads.emplace_back([&, i, start, end]() {
-            double local_sum = 0.0;
-            for (size_t j = start; j < end; ++j) {
-                double result = func();
-                local_sum += result;
-            }
-            partial_results[i] = local_sum;
-        });
-    }
-
-    for (auto &thread: threads) {
-        if (thread.joinable())
-            thread.join();
-    }
+    run_placed(particles, num_threads, [&](size_t start, size_t end) {
+        if (start == end) {
+            return;
+        }
+        double local_sum = 0.0;
+        for (size_t j = start; j < end; ++j) {
+            double result = func();
+            local_sum += result;
+        }
+        partial_results[start / chunk_size].value = local_sum;
+    });
 
     // Sum up partial results
     double total_sum = 0.0;
-    for (double partial: partial_results) {
-        total_sum += partial;
+    for (const auto &partial: partial_results) {
+        total_sum += partial.value;
     }
 
     return total_sum / static_cast<double>(particles);
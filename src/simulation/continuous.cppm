@@ -11,11 +11,15 @@ export module diffusionx.simulation.continuous;
 export import diffusionx.simulation.continuous.bm;
 export import diffusionx.simulation.continuous.ou;
 export import diffusionx.simulation.continuous.fbm;
+export import diffusionx.simulation.continuous.markovian_fgn;
 export import diffusionx.simulation.continuous.gamma;
 export import diffusionx.simulation.continuous.levy;
 export import diffusionx.simulation.continuous.subordinator;
+export import diffusionx.simulation.continuous.subordinated_bm;
 export import diffusionx.simulation.continuous.cauchy;
 export import diffusionx.simulation.continuous.langevin;
+export import diffusionx.simulation.continuous.landscape;
+export import diffusionx.simulation.continuous.resetting;
 export import diffusionx.simulation.continuous.brownian_excursion;
 export import diffusionx.simulation.continuous.brownian_meander;
 export import diffusionx.simulation.continuous.brownian_bridge;
@@ -1,18 +1,68 @@
 module;
 
 #include <cmath>
+#include <memory>
 #include <optional>
+#include <random>
+#include <span>
 #include <vector>
 
 export module diffusionx.simulation.continuous.bm;
 
 import diffusionx.error;
+import diffusionx.memory;
 import diffusionx.random.normal;
+import diffusionx.random.utils;
 import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
 import diffusionx.simulation.basic.utils;
 
 using std::vector;
 
+/**
+ * @brief Stepper generating a Brownian motion path block by block
+ *
+ * X(t + dt) = X(t) + √(2D * dt) * Z, where Z ~ N(0, 1)
+ */
+export class BmStepper final : public Stepper {
+    std::mt19937 m_gen = generator(); ///< Random number generator of the path
+    std::normal_distribution<double> m_increment; ///< Increment distribution
+
+protected:
+    void step_positions(std::span<double> positions) override {
+        double x = m_position;
+        for (auto &position: positions) {
+            x += m_increment(m_gen);
+            position = x;
+        }
+        m_position = x;
+    }
+
+    auto step_partial(double time_step) -> double override {
+        m_position += m_increment(m_gen) * std::sqrt(time_step / get_time_step());
+        return m_position;
+    }
+
+public:
+    /**
+     * @brief Constructor
+     * @param start_position Initial position of the path
+     * @param diffusion_coefficient Diffusion coefficient (must be positive)
+     * @param time_step The time step of the grid (must be positive)
+     * @throws std::invalid_argument if a parameter is not positive
+     */
+    BmStepper(double start_position, double diffusion_coefficient,
+              double time_step)
+        : Stepper(start_position, time_step) {
+        if (diffusion_coefficient <= 0) {
+            throw std::invalid_argument(
+                "Diffusion coefficient must be positive");
+        }
+        m_increment = std::normal_distribution<double>(
+            0.0, std::sqrt(2.0 * diffusion_coefficient * time_step));
+    }
+};
+
 /**
  * @brief Brownian motion (Wiener process) implementation
  *
@@ -103,13 +153,12 @@ public:
         positions[0] = m_start_position;
 
         // Generate increments
-        auto increments_result =
-            randn(num_steps-1, 0.0,
-                  std::sqrt(2.0 * m_diffusion_coefficient * time_step));
-        if (!increments_result.has_value()) {
-            return Err(increments_result.error());
+        buffer<double> increments(num_steps - 1);
+        if (auto res = randn(std::span(increments), 0.0,
+                             std::sqrt(2.0 * m_diffusion_coefficient * time_step));
+            !res) {
+            return Err(res.error());
         }
-        auto &increments = increments_result.value();
 
         // Simulate trajectory
         for (size_t i = 1; i < num_steps; ++i) {
@@ -140,13 +189,12 @@ public:
         double current_x = m_start_position;
 
         // Generate increments
-        auto increments_result =
-            randn(num_steps-1, 0.0,
-                  std::sqrt(2.0 * m_diffusion_coefficient * time_step));
-        if (!increments_result.has_value()) {
-            return Err(increments_result.error());
+        buffer<double> increments(num_steps - 1);
+        if (auto res = randn(std::span(increments), 0.0,
+                             std::sqrt(2.0 * m_diffusion_coefficient * time_step));
+            !res) {
+            return Err(res.error());
         }
-        auto &increments = increments_result.value();
 
         // Simulate trajectory
         for (const auto increment: increments) {
@@ -160,6 +208,19 @@ public:
         return Ok(current_x - m_start_position);
     }
 
+    /**
+     * @brief Creates a stepper that generates the path block by block
+     * @param time_step The time step for discretization
+     * @return Result containing the stepper, or an Error
+     */
+    Result<std::unique_ptr<Stepper> > stepper(double time_step = 0.01) override {
+        if (time_step <= 0) {
+            return Err(Error::InvalidArgument("Time step must be positive"));
+        }
+        return Ok(std::unique_ptr<Stepper>(std::make_unique<BmStepper>(
+            m_start_position, m_diffusion_coefficient, time_step)));
+    }
+
     // /**
     //  * @brief Computes the first passage time through a domain
     //  * @param domain The domain boundaries as a pair (lower, upper)
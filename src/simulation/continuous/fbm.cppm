@@ -1,20 +1,379 @@
 module;
 
+#include <algorithm>
 #include <cmath>
 #include <complex>
 #include <fftw3.h>
+#include <format>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 export module diffusionx.simulation.continuous.fbm;
 
 import diffusionx.error;
+import diffusionx.memory;
+import diffusionx.parallel;
 import diffusionx.random.normal;
+import diffusionx.random.utils;
 import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.fft;
+import diffusionx.simulation.basic.stepper;
 import diffusionx.simulation.basic.utils;
+import diffusionx.simulation.continuous.markovian_fgn;
 
 using std::complex;
 using std::vector;
 
+/**
+ * @brief Circulant embedding spectra shared by all FBM objects
+ *
+ * The square roots of the circulant eigenvalues depend only on the number of
+ * steps and the Hurst parameter, so they are computed once and reused by
+ * every later path. The FFTW plans come from the shared cache of
+ * `diffusionx.simulation.basic.fft`, which serializes the planner.
+ */
+class FbmSpectrumCache {
+  struct Spectrum {
+    size_t n;                                         ///< Number of steps
+    double hurst;                                     ///< Hurst parameter
+    std::shared_ptr<const vector<double>> amplitudes; ///< sqrt(eigenvalues)
+  };
+
+  static constexpr size_t max_spectra = 16; ///< Spectra kept, most recent last
+
+  std::mutex m_mutex;         ///< Protects the cache
+  vector<Spectrum> m_spectra; ///< Cached spectra
+
+public:
+  /**
+   * @brief Gets the square roots of the circulant eigenvalues of fGn
+   * @return Result containing the 2n amplitudes, or an Error if the
+   * embedding is not positive semidefinite
+   */
+  auto spectrum(size_t n, double hurst)
+      -> Result<std::shared_ptr<const vector<double>>> {
+    std::lock_guard lock(m_mutex);
+    auto it = std::find_if(m_spectra.begin(), m_spectra.end(),
+                           [&](const Spectrum &s) {
+                             return s.n == n && s.hurst == hurst;
+                           });
+    if (it != m_spectra.end()) {
+      std::rotate(it, it + 1, m_spectra.end());
+      return Ok(m_spectra.back().amplitudes);
+    }
+
+    auto covariance = [hurst](double k) -> double {
+      if (k == 0)
+        return 1.0;
+      return 0.5 * (std::pow(std::abs(k + 1), 2 * hurst) +
+                    std::pow(std::abs(k - 1), 2 * hurst) -
+                    2 * std::pow(std::abs(k), 2 * hurst));
+    };
+    size_t m = 2 * n;
+    fftw_complex *in = fftw_alloc_complex(m);
+    fftw_complex *out = fftw_alloc_complex(m);
+    for (size_t i = 0; i < m; ++i) {
+      in[i][0] = covariance(static_cast<double>(i < n ? i : m - i));
+      in[i][1] = 0.0;
+    }
+    fftw_execute_dft(fft_plan(m, FFTW_FORWARD), in, out);
+
+    auto amplitudes = std::make_shared<vector<double>>(m);
+    for (size_t i = 0; i < m; ++i) {
+      if (out[i][0] < -1e-10) { // Allow small numerical errors
+        fftw_free(in);
+        fftw_free(out);
+        return Err(Error::InvalidArgument(
+            "Circulant matrix is not positive semidefinite"));
+      }
+      (*amplitudes)[i] = std::sqrt(std::max(0.0, out[i][0]));
+    }
+    fftw_free(in);
+    fftw_free(out);
+
+    if (m_spectra.size() == max_spectra) {
+      m_spectra.erase(m_spectra.begin());
+    }
+    m_spectra.push_back({n, hurst, amplitudes});
+    return Ok(std::shared_ptr<const vector<double>>(std::move(amplitudes)));
+  }
+
+  /**
+   * @brief Gets the number of cached spectra
+   */
+  auto size() -> size_t {
+    std::lock_guard lock(m_mutex);
+    return m_spectra.size();
+  }
+
+  /**
+   * @brief Drops all spectra
+   */
+  void clear() {
+    std::lock_guard lock(m_mutex);
+    m_spectra.clear();
+  }
+};
+
+auto fbm_spectrum_cache() -> FbmSpectrumCache & {
+  static FbmSpectrumCache cache;
+  return cache;
+}
+
+/**
+ * @brief Largest number of observation times accepted by `FBM::sample_at`
+ *
+ * The packed Cholesky factor of 8192 times takes 256 MiB.
+ */
+export constexpr size_t fbm_max_observation_times = 8192;
+
+/**
+ * @brief Cholesky factor of the fBm covariance at a set of times
+ *
+ * Row i of the lower-triangular factor is stored packed at offset
+ * i(i+1)/2, so the dot products of the factorization and the rows of the
+ * sampling product are contiguous.
+ */
+struct FbmCholeskyFactor {
+  double hurst;          ///< Hurst parameter
+  vector<double> times;  ///< Positive observation times
+  buffer<double> lower;  ///< Packed rows of L, C = L Lᵀ
+};
+
+/**
+ * @brief Computes the packed Cholesky factor of Cov[B_H(s), B_H(t)]
+ * @param times Positive, strictly increasing times
+ * @param covariance Cov[B_H(s), B_H(t)]
+ * @return Result containing the packed factor, or an Error if the matrix is
+ * numerically singular
+ *
+ * Rows are factorized in panels of `panel` rows. The part of a panel left
+ * of its diagonal block only depends on finished rows and is computed in
+ * parallel, one row per task; the diagonal block is finished serially.
+ */
+template<typename C>
+auto fbm_cholesky(std::span<const double> times, C &&covariance)
+    -> Result<buffer<double>> {
+  constexpr size_t panel = 64;
+  size_t n = times.size();
+  buffer<double> lower(n * (n + 1) / 2);
+  auto row = [&](size_t i) { return lower.data() + (i * (i + 1) / 2); };
+  auto entry = [&](size_t i, size_t j) {
+    const double *li = row(i);
+    const double *lj = row(j);
+    double sum = 0.0;
+    for (size_t k = 0; k < j; ++k) {
+      sum += li[k] * lj[k];
+    }
+    return covariance(times[i], times[j]) - sum;
+  };
+  for (size_t i0 = 0; i0 < n; i0 += panel) {
+    size_t i1 = std::min(n, i0 + panel);
+    if (i0 > 0) {
+      run_placed(i1 - i0, default_workers(), [&](size_t begin, size_t end) {
+        for (size_t i = i0 + begin; i < i0 + end; ++i) {
+          double *li = row(i);
+          for (size_t j = 0; j < i0; ++j) {
+            li[j] = entry(i, j) / row(j)[j];
+          }
+        }
+      });
+    }
+    for (size_t i = i0; i < i1; ++i) {
+      double *li = row(i);
+      for (size_t j = i0; j < i; ++j) {
+        li[j] = entry(i, j) / row(j)[j];
+      }
+      double pivot = entry(i, i);
+      if (!(pivot > 1e-14 * covariance(times[i], times[i]))) {
+        return Err(Error::SimulationFailed(std::format(
+            "The covariance matrix is numerically singular at t = {}; "
+            "observation times are too close",
+            times[i])));
+      }
+      li[i] = std::sqrt(pivot);
+    }
+  }
+  return Ok(std::move(lower));
+}
+
+/**
+ * @brief Cholesky factors of recently used observation time sets
+ *
+ * Factors are shared by all FBM objects with the same Hurst parameter.
+ * Lookups hold the mutex only briefly; factorizations run outside it, so a
+ * long factorization does not block requests for other time sets. A time
+ * set being factorized is marked in flight, and concurrent requests for it
+ * wait for that factorization instead of computing it again.
+ */
+class FbmCholeskyCache {
+  using Shared = Result<std::shared_ptr<const FbmCholeskyFactor>>;
+
+  struct Pending {
+    double hurst;                       ///< Hurst parameter
+    vector<double> times;               ///< Observation times
+    std::shared_future<Shared> factor;  ///< Ready when the factorization ends
+  };
+
+  static constexpr size_t max_factors = 4; ///< Factors kept, most recent last
+
+  std::mutex m_mutex;                                       ///< Protects the lists
+  vector<std::shared_ptr<const FbmCholeskyFactor>> m_factors; ///< Cached factors
+  vector<Pending> m_pending;                                ///< In-flight factorizations
+
+  /// Removes the in-flight marker of a time set; the mutex must be held
+  void drop_pending(double hurst, std::span<const double> times) {
+    std::erase_if(m_pending, [&](const Pending &p) {
+      return p.hurst == hurst && std::ranges::equal(p.times, times);
+    });
+  }
+
+public:
+  /**
+   * @brief Gets the factor of a time set, computing it on a miss
+   */
+  template<typename C>
+  auto get(double hurst, std::span<const double> times, C &&covariance) -> Shared {
+    std::promise<Shared> promise;
+    {
+      std::unique_lock lock(m_mutex);
+      auto it = std::find_if(m_factors.begin(), m_factors.end(), [&](const auto &f) {
+        return f->hurst == hurst && std::ranges::equal(f->times, times);
+      });
+      if (it != m_factors.end()) {
+        std::rotate(it, it + 1, m_factors.end());
+        return Ok(m_factors.back());
+      }
+      auto pending = std::find_if(m_pending.begin(), m_pending.end(), [&](const Pending &p) {
+        return p.hurst == hurst && std::ranges::equal(p.times, times);
+      });
+      if (pending != m_pending.end()) {
+        auto factor = pending->factor;
+        lock.unlock();
+        return factor.get();
+      }
+      m_pending.push_back(
+          {hurst, vector<double>(times.begin(), times.end()), promise.get_future().share()});
+    }
+    auto factorize = [&]() -> Shared {
+      auto lower = fbm_cholesky(times, covariance);
+      if (!lower.has_value()) {
+        return Err(lower.error());
+      }
+      return Ok(std::make_shared<const FbmCholeskyFactor>(FbmCholeskyFactor{
+          hurst, vector<double>(times.begin(), times.end()), std::move(lower.value())}));
+    };
+    Shared result;
+    try {
+      result = factorize();
+    } catch (...) {
+      {
+        std::lock_guard lock(m_mutex);
+        drop_pending(hurst, times);
+      }
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+    {
+      std::lock_guard lock(m_mutex);
+      if (result.has_value()) {
+        if (m_factors.size() == max_factors) {
+          m_factors.erase(m_factors.begin());
+        }
+        m_factors.push_back(result.value());
+      }
+      drop_pending(hurst, times);
+    }
+    promise.set_value(result);
+    return result;
+  }
+
+  /**
+   * @brief Gets the number of cached factors
+   */
+  auto size() -> size_t {
+    std::lock_guard lock(m_mutex);
+    return m_factors.size();
+  }
+
+  /**
+   * @brief Drops all factors
+   */
+  void clear() {
+    std::lock_guard lock(m_mutex);
+    m_factors.clear();
+  }
+};
+
+auto fbm_cholesky_cache() -> FbmCholeskyCache & {
+  static FbmCholeskyCache cache;
+  return cache;
+}
+
+/**
+ * @brief Computes X = L Z for a batch of particles
+ * @param lower Packed rows of the n × n factor L
+ * @param z n × batch standard normals, row-major
+ * @param x n × batch output, row-major
+ *
+ * Z is walked in tiles of rows that stay in cache while every later row of
+ * L consumes them; the innermost loop runs over the particles of the batch.
+ */
+void fbm_lower_product(std::span<const double> lower, std::span<const double> z,
+                       std::span<double> x, size_t n, size_t batch) {
+  constexpr size_t tile = 128;
+  std::fill(x.begin(), x.end(), 0.0);
+  for (size_t k0 = 0; k0 < n; k0 += tile) {
+    size_t k1 = std::min(n, k0 + tile);
+    for (size_t i = k0; i < n; ++i) {
+      const double *li = lower.data() + (i * (i + 1) / 2);
+      double *xi = x.data() + (i * batch);
+      size_t kend = std::min(k1, i + 1);
+      for (size_t k = k0; k < kend; ++k) {
+        double l = li[k];
+        const double *zk = z.data() + (k * batch);
+        for (size_t p = 0; p < batch; ++p) {
+          xi[p] += l * zk[p];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Gets the number of cached fGn spectra and FFTW plans
+ * @return The pair (spectra, plans)
+ */
+export auto fbm_cache_entries() -> std::pair<size_t, size_t> {
+  return {fbm_spectrum_cache().size(), fft_plan_entries()};
+}
+
+/**
+ * @brief Gets the number of cached Cholesky factors of observation times
+ * @return The number of factors
+ */
+export auto fbm_cholesky_entries() -> size_t {
+  return fbm_cholesky_cache().size();
+}
+
+/**
+ * @brief Drops the cached fGn spectra, FFTW plans and Cholesky factors
+ *
+ * Must not be called while FBM paths are being simulated or other FFTW
+ * users of the shared plans (e.g. correlated landscapes) are running.
+ */
+export void clear_fbm_cache() {
+  fbm_spectrum_cache().clear();
+  clear_fft_plans();
+  fbm_cholesky_cache().clear();
+}
+
 /**
  * @brief Fractional Brownian Motion implementation
  *
@@ -112,83 +471,149 @@ public:
     return Ok(std::make_pair(std::move(times), std::move(positions)));
   }
 
-private:
   /**
-   * @brief Generates fBm using circulant embedding method
-   * @param n Number of time steps
-   * @param hurst Hurst parameter
-   * @return Result containing fBm values, or an Error
+   * @brief Creates a constant-memory stepper of an approximate fBm path
+   * @param time_step The time step of the grid
+   * @param horizon Number of steps over which the covariance must hold
+   * @param tolerance Largest relative MSD error at any lag up to the horizon
+   * @return Result containing the stepper, or an Error
+   *
+   * `simulate` is exact but needs the whole path up front; this stepper uses
+   * the sum-of-OU approximation of `MarkovianFgn`, costs O(K) per step with
+   * K ~ log(horizon), and can extend a path indefinitely. Use
+   * `MarkovianFgn::report` for its covariance error against the exact fGn.
    */
-  Result<vector<double>> generate_fbm_circulant_embedding(size_t n,
-                                                          double hurst) {
-    // Compute covariance function for fBm
-    auto covariance = [hurst](double k) -> double {
-      if (k == 0)
-        return 1.0;
-      return 0.5 * (std::pow(std::abs(k + 1), 2 * hurst) +
-                    std::pow(std::abs(k - 1), 2 * hurst) -
-                    2 * std::pow(std::abs(k), 2 * hurst));
-    };
-
-    // Create circulant matrix (first row)
-    size_t m = 2 * n; // Size for circulant embedding
-    vector<double> c(m);
-
-    for (size_t i = 0; i < n; ++i) {
-      c[i] = covariance(static_cast<double>(i));
+  auto markovian_stepper(double time_step, size_t horizon,
+                         double tolerance = 1e-2) const
+      -> Result<std::unique_ptr<Stepper>> {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
     }
-    for (size_t i = n; i < m; ++i) {
-      c[i] = covariance(static_cast<double>(m - i));
+    auto model = MarkovianFgn::fit(m_hurst, horizon, tolerance);
+    if (!model.has_value()) {
+      return Err(model.error());
     }
+    return Ok(std::unique_ptr<Stepper>(std::make_unique<MarkovianFbmStepper>(
+        model.value(), m_start_position, time_step)));
+  }
 
-    // Compute eigenvalues using FFT
-    vector<complex<double>> c_complex(m);
-    for (size_t i = 0; i < m; ++i) {
-      c_complex[i] = complex<double>(c[i], 0.0);
+  /**
+   * @brief Samples paths at arbitrary observation times
+   * @param times Observation times, non-negative and strictly increasing
+   * @param particles The number of independent paths
+   * @return Result containing one (times, positions) pair per path, or an
+   * Error
+   *
+   * Exact for any time set, e.g. log-spaced camera times: the positions are
+   * L Z with L the Cholesky factor of `theoretical_covariance` at the given
+   * times and Z standard normal. The O(n³) factorization is done once per
+   * time set and cached, shared by every path and every FBM object with the
+   * same Hurst parameter; each path then costs an O(n²) triangular product,
+   * computed for batches of particles at once. Meant for up to a few
+   * thousand times (at most `fbm_max_observation_times`).
+   */
+  auto sample_at(std::span<const double> times, size_t particles = 1) const
+      -> Result<vector<vec_pair>> {
+    if (times.empty()) {
+      return Err(Error::InvalidArgument("At least one observation time is required"));
+    }
+    if (times.size() > fbm_max_observation_times) {
+      return Err(Error::InvalidArgument(std::format(
+          "At most {} observation times are supported, but got {}",
+          fbm_max_observation_times, times.size())));
+    }
+    if (particles == 0) {
+      return Err(Error::InvalidArgument("The number of particles must be positive"));
+    }
+    if (!(times[0] >= 0)) {
+      return Err(Error::InvalidArgument("Observation times must be non-negative"));
+    }
+    for (size_t i = 1; i < times.size(); ++i) {
+      if (!(times[i] > times[i - 1]) || !std::isfinite(times[i])) {
+        return Err(Error::InvalidArgument(
+            "Observation times must be finite and strictly increasing"));
+      }
     }
 
-    fftw_complex *in = reinterpret_cast<fftw_complex *>(c_complex.data());
-    fftw_complex *out = fftw_alloc_complex(m);
-    fftw_plan plan = fftw_plan_dft_1d(static_cast<int>(m), in, out,
-                                      FFTW_FORWARD, FFTW_ESTIMATE);
-
-    fftw_execute(plan);
+    // B_H(0) is the start position; only positive times enter the factor
+    size_t offset = times[0] == 0.0 ? 1 : 0;
+    auto positive = times.subspan(offset);
+    size_t n = positive.size();
+    std::shared_ptr<const FbmCholeskyFactor> factor;
+    if (n > 0) {
+      auto cached = fbm_cholesky_cache().get(
+          m_hurst, positive,
+          [this](double s, double t) { return theoretical_covariance(s, t); });
+      if (!cached.has_value()) {
+        return Err(cached.error());
+      }
+      factor = std::move(cached.value());
+    }
 
-    // Check if all eigenvalues are non-negative
-    vector<double> eigenvalues(m);
-    for (size_t i = 0; i < m; ++i) {
-      eigenvalues[i] = out[i][0];    // Real part
-      if (eigenvalues[i] < -1e-10) { // Allow small numerical errors
-        fftw_destroy_plan(plan);
-        fftw_free(out);
-        return Err(Error::InvalidArgument(
-            "Circulant matrix is not positive semidefinite"));
+    vector<vec_pair> paths(particles);
+    constexpr size_t batch = 32;
+    size_t num_batches = (particles + batch - 1) / batch;
+    run_placed(num_batches, default_workers(), [&](size_t begin, size_t end) {
+      thread_local static std::mt19937 gen = generator();
+      std::normal_distribution<double> normal(0.0, 1.0);
+      buffer<double> z(n * batch);
+      buffer<double> x(n * batch);
+      for (size_t b = begin; b < end; ++b) {
+        size_t first = b * batch;
+        size_t count = std::min(batch, particles - first);
+        for (auto &v : z) {
+          v = normal(gen);
+        }
+        if (n > 0) {
+          fbm_lower_product(factor->lower, z, x, n, batch);
+        }
+        for (size_t p = 0; p < count; ++p) {
+          auto &[t, pos] = paths[first + p];
+          t.assign(times.begin(), times.end());
+          pos.assign(times.size(), m_start_position);
+          for (size_t i = 0; i < n; ++i) {
+            pos[offset + i] += x[(i * batch) + p];
+          }
+        }
       }
-      eigenvalues[i] = std::max(0.0, eigenvalues[i]); // Ensure non-negative
+    });
+    return Ok(std::move(paths));
+  }
+
+private:
+  /**
+   * @brief Generates fBm using circulant embedding method
+   * @param n Number of time steps
+   * @param hurst Hurst parameter
+   * @return Result containing fBm values, or an Error
+   */
+  Result<vector<double>> generate_fbm_circulant_embedding(size_t n,
+                                                          double hurst) {
+    // Eigenvalues of the circulant embedding, shared across paths
+    auto spectrum = fbm_spectrum_cache().spectrum(n, hurst);
+    if (!spectrum.has_value()) {
+      return Err(spectrum.error());
     }
+    const auto &amplitudes = *spectrum.value();
+    size_t m = 2 * n; // Size for circulant embedding
 
     // Generate random Gaussian vector
     auto gaussian_result = randn(m, 0.0, 1.0);
     if (!gaussian_result.has_value()) {
-      fftw_destroy_plan(plan);
-      fftw_free(out);
       return Err(gaussian_result.error());
     }
     auto gaussian = gaussian_result.value();
 
     // Apply square root of eigenvalues
-    vector<complex<double>> z(m);
+    fftw_complex *z = fftw_alloc_complex(m);
+    fftw_complex *z_out = fftw_alloc_complex(m);
     for (size_t i = 0; i < m; ++i) {
-      z[i] = complex<double>(std::sqrt(eigenvalues[i]) * gaussian[i], 0.0);
+      z[i][0] = amplitudes[i] * gaussian[i];
+      z[i][1] = 0.0;
     }
 
     // Inverse FFT
-    fftw_complex *z_in = reinterpret_cast<fftw_complex *>(z.data());
-    fftw_complex *z_out = fftw_alloc_complex(m);
-    fftw_plan inv_plan = fftw_plan_dft_1d(static_cast<int>(m), z_in, z_out,
-                                          FFTW_BACKWARD, FFTW_ESTIMATE);
-
-    fftw_execute(inv_plan);
+    fftw_execute_dft(fft_plan(m, FFTW_BACKWARD), z, z_out);
 
     // Extract the first n values and scale
     vector<double> result(n);
@@ -197,10 +622,7 @@ private:
       result[i] = z_out[i][0] * scale; // Real part
     }
 
-    // Cleanup
-    fftw_destroy_plan(plan);
-    fftw_destroy_plan(inv_plan);
-    fftw_free(out);
+    fftw_free(z);
     fftw_free(z_out);
 
     return Ok(std::move(result));
@@ -1,17 +1,81 @@
 module;
 
 #include <cmath>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 export module diffusionx.simulation.continuous.geometric_brownian_motion;
 
 import diffusionx.error;
+import diffusionx.memory;
 import diffusionx.random.normal;
+import diffusionx.random.utils;
 import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
 import diffusionx.simulation.basic.utils;
+import diffusionx.simd;
 
 using std::vector;
 
+/**
+ * @brief Stepper generating a GBM path block by block
+ *
+ * Uses the exact solution: the log-path is accumulated over the block and
+ * exponentiated in one batch, so the time step only sets the output grid.
+ */
+export class GeometricBrownianMotionStepper final : public Stepper {
+  std::mt19937 m_gen = generator();         ///< Random number generator
+  std::normal_distribution<double> m_noise; ///< Increment of the log-path
+  double m_log_position = 0.0;              ///< log S at the current time
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    double y = m_log_position;
+    for (auto &position : positions) {
+      y += m_noise(m_gen);
+      position = y;
+    }
+    m_log_position = y;
+    vexp(positions, positions);
+    m_position = positions.back();
+  }
+
+  auto step_partial(double time_step) -> double override {
+    double ratio = time_step / get_time_step();
+    std::normal_distribution<double> noise(m_noise.mean() * ratio,
+                                           m_noise.stddev() * std::sqrt(ratio));
+    m_log_position += noise(m_gen);
+    m_position = std::exp(m_log_position);
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param start_position Initial value S(0) (must be positive)
+   * @param mu Drift parameter μ
+   * @param sigma Volatility parameter σ (must be positive)
+   * @param time_step The time step of the grid (must be positive)
+   * @throws std::invalid_argument if a parameter is invalid
+   */
+  GeometricBrownianMotionStepper(double start_position, double mu,
+                                 double sigma, double time_step)
+      : Stepper(start_position, time_step) {
+    if (start_position <= 0) {
+      throw std::invalid_argument("Initial value must be positive");
+    }
+    if (sigma <= 0) {
+      throw std::invalid_argument("Volatility sigma must be positive");
+    }
+    m_noise = std::normal_distribution<double>(
+        (mu - 0.5 * sigma * sigma) * time_step, sigma * std::sqrt(time_step));
+    m_log_position = std::log(start_position);
+  }
+};
+
 /**
  * @brief Geometric Brownian Motion implementation
  *
@@ -85,8 +149,9 @@ public:
    * @return Result containing time and position vectors, or an Error
    *
    * Uses the exact solution:
-   * S(t + dt) = S(t) * exp((μ - σ²/2) * dt + σ * √dt * Z)
-   * where Z ~ N(0, 1)
+   * S(t_i) = S(0) * exp(Σ_{j≤i} [(μ - σ²/2) * dt + σ * √dt * Z_j])
+   * where Z_j ~ N(0, 1). The log-path is accumulated first and exponentiated
+   * in one batch with the vector math kernels.
    */
   Result<vec_pair> simulate(double duration, double time_step = 0.01) override {
     if (duration <= 0) {
@@ -100,31 +165,46 @@ public:
     vector<double> times(num_steps + 1);
     vector<double> positions(num_steps + 1);
 
-    // Initialize
-    times[0] = 0.0;
-    positions[0] = m_start_position;
-
     // Precompute constants
     double drift_term = (m_mu - 0.5 * m_sigma * m_sigma) * time_step;
     double diffusion_term = m_sigma * std::sqrt(time_step);
 
-    // Generate random increments
-    auto increments_result = randn(num_steps, 0.0, 1.0);
-    if (!increments_result.has_value()) {
-      return Err(increments_result.error());
+    // Generate random increments of the log-path
+    buffer<double> increments(num_steps);
+    if (auto res = randn(std::span(increments), drift_term, diffusion_term); !res) {
+      return Err(res.error());
     }
-    auto increments = increments_result.value();
 
-    // Simulate trajectory using exact solution
+    // Accumulate the log-path, then exponentiate it
+    times[0] = 0.0;
+    positions[0] = 0.0;
     for (size_t i = 1; i <= num_steps; ++i) {
       times[i] = i * time_step;
-      double log_increment = drift_term + diffusion_term * increments[i - 1];
-      positions[i] = positions[i - 1] * std::exp(log_increment);
+      positions[i] = positions[i - 1] + increments[i - 1];
+    }
+    auto path = std::span(positions);
+    vexp(path, path);
+    for (double &x : path) {
+      x *= m_start_position;
     }
 
     return Ok(std::make_pair(std::move(times), std::move(positions)));
   }
 
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(
+        std::make_unique<GeometricBrownianMotionStepper>(
+            m_start_position, m_mu, m_sigma, time_step)));
+  }
+
   /**
    * @brief Computes the theoretical mean at time t
    * @param t Time point
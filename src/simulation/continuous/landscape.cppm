@@ -0,0 +1,620 @@
+/**
+ * @file landscape.cppm
+ * @brief Diffusion in a quenched random potential
+ *
+ * A quenched landscape U(x) is drawn once and then shared, read-only, by
+ * every particle and every worker thread of an ensemble (Sinai diffusion,
+ * rough-potential Langevin dynamics). The landscape is sampled on a uniform
+ * grid, either as a Brownian path or as a stationary Gaussian field with a
+ * given covariance (circulant embedding), and stored as a force table of
+ * (force, slope) cells so that F(x) = -U'(x) is one linear interpolation
+ * from a single 16-byte load.
+ *
+ * The table is consumed directly by
+ * - `LandscapeForce`, a drift functor for `Langevin` that inlines the lookup,
+ * - `LandscapeDiffusion`, whose ensemble and first-passage engines advance
+ *   batches of particles with a vectorized force lookup.
+ */
+
+module;
+
+#include <algorithm>
+#include <cmath>
+#include <fftw3.h>
+#include <format>
+#include <functional>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+export module diffusionx.simulation.continuous.landscape;
+
+import diffusionx.error;
+import diffusionx.memory;
+import diffusionx.random.utils;
+import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.fft;
+import diffusionx.simulation.basic.stepper;
+import diffusionx.simulation.basic.utils;
+
+using std::vector;
+
+/**
+ * @brief Number of particles advanced together by the ensemble engines
+ */
+export constexpr size_t landscape_batch_size = 512;
+
+/**
+ * @brief Continuation of a landscape outside its grid
+ */
+export enum class LandscapeBoundary {
+  Periodic, ///< U(x + L) = U(x), with L the number of points times the spacing
+  Clamp,    ///< The force of the nearest end point is used
+};
+
+/**
+ * @brief One cell of a force table, F(x) = force + slope * (x - x_k) / h
+ */
+struct alignas(16) ForceCell {
+  double force; ///< Force at the left node
+  double slope; ///< Force difference to the right node
+};
+
+/**
+ * @brief Immutable force table of a quenched potential
+ *
+ * The potential is given at nodes x_k = origin + k * spacing. The force at
+ * a node is the central difference -(U_{k+1} - U_{k-1}) / (2h) and is
+ * interpolated linearly between nodes. Instances are created by the
+ * factories and shared through `std::shared_ptr<const QuenchedLandscape>`.
+ */
+export class QuenchedLandscape {
+  vector<double> m_potential;   ///< U at the nodes
+  buffer<ForceCell> m_cells;    ///< Force table
+  double m_origin;              ///< Position of node 0
+  double m_spacing;             ///< Grid spacing h
+  double m_inverse_spacing;     ///< 1 / h
+  LandscapeBoundary m_boundary; ///< Continuation outside the grid
+
+public:
+  /**
+   * @brief Builds the force table of a sampled potential
+   * @param potential U at the nodes, at least 3 finite values
+   * @param spacing The grid spacing h (must be positive)
+   * @param origin The position of the first node
+   * @param boundary The continuation outside the grid
+   * @throws std::invalid_argument if an argument is invalid
+   */
+  QuenchedLandscape(vector<double> potential, double spacing,
+                    double origin = 0.0,
+                    LandscapeBoundary boundary = LandscapeBoundary::Periodic)
+      : m_potential(std::move(potential)), m_origin(origin),
+        m_spacing(spacing), m_inverse_spacing(1.0 / spacing),
+        m_boundary(boundary) {
+    size_t n = m_potential.size();
+    if (n < 3) {
+      throw std::invalid_argument(std::format(
+          "A landscape needs at least 3 points, but got {}", n));
+    }
+    if (!(spacing > 0) || !std::isfinite(spacing)) {
+      throw std::invalid_argument("Spacing must be positive and finite");
+    }
+    for (double u : m_potential) {
+      if (!std::isfinite(u)) {
+        throw std::invalid_argument("Potential values must be finite");
+      }
+    }
+
+    bool periodic = boundary == LandscapeBoundary::Periodic;
+    vector<double> nodal(n);
+    for (size_t k = 0; k < n; ++k) {
+      double left, right, width = 2.0 * spacing;
+      if (k == 0) {
+        left = periodic ? m_potential[n - 1] : m_potential[0];
+        width = periodic ? width : spacing;
+      } else {
+        left = m_potential[k - 1];
+      }
+      if (k == n - 1) {
+        right = periodic ? m_potential[0] : m_potential[n - 1];
+        width = periodic ? width : spacing;
+      } else {
+        right = m_potential[k + 1];
+      }
+      nodal[k] = -(right - left) / width;
+    }
+    // Periodic tables have a cell from the last node back to node 0
+    size_t cells = periodic ? n : n - 1;
+    m_cells.resize(cells + 1);
+    for (size_t k = 0; k < cells; ++k) {
+      double next = nodal[(k + 1) % n];
+      m_cells[k] = ForceCell{nodal[k], next - nodal[k]};
+    }
+    // Sentinel for clamped positions at the right end
+    m_cells[cells] = ForceCell{nodal[periodic ? 0 : n - 1], 0.0};
+  }
+
+  /**
+   * @brief Draws a Brownian (Sinai) landscape
+   * @param num_points The number of nodes
+   * @param spacing The grid spacing h
+   * @param strength The variance of U per unit length
+   * @param origin The position of the first node
+   * @param boundary The continuation outside the grid; periodic landscapes
+   *        are Brownian bridges so that U is continuous across the period
+   * @return Result containing the shared landscape, or an Error
+   */
+  static auto brownian(size_t num_points, double spacing, double strength,
+                       double origin = 0.0,
+                       LandscapeBoundary boundary = LandscapeBoundary::Clamp)
+      -> Result<std::shared_ptr<const QuenchedLandscape>> {
+    if (num_points < 3) {
+      return Err(Error::InvalidArgument("A landscape needs at least 3 points"));
+    }
+    if (!(spacing > 0) || !(strength > 0)) {
+      return Err(Error::InvalidArgument(
+          "Spacing and strength must be positive"));
+    }
+    std::mt19937 gen = generator();
+    std::normal_distribution<double> normal(0.0, std::sqrt(strength * spacing));
+    vector<double> u(num_points);
+    u[0] = 0.0;
+    for (size_t k = 1; k < num_points; ++k) {
+      u[k] = u[k - 1] + normal(gen);
+    }
+    if (boundary == LandscapeBoundary::Periodic) {
+      // Bridge over the period n * h, closing with one more increment
+      double end = u[num_points - 1] + normal(gen);
+      double n = static_cast<double>(num_points);
+      for (size_t k = 0; k < num_points; ++k) {
+        u[k] -= end * static_cast<double>(k) / n;
+      }
+    }
+    return Ok(std::make_shared<const QuenchedLandscape>(std::move(u), spacing,
+                                                        origin, boundary));
+  }
+
+  /**
+   * @brief Draws a stationary Gaussian landscape by circulant embedding
+   * @param num_points The number of nodes
+   * @param spacing The grid spacing h
+   * @param covariance The covariance C(r) of U at distance r >= 0
+   * @param origin The position of the first node
+   * @param boundary Periodic landscapes embed the covariance on the period
+   *        itself; clamped ones use an embedding of twice the length
+   * @return Result containing the shared landscape, or an Error if the
+   *         embedding is not positive semidefinite
+   */
+  static auto correlated(size_t num_points, double spacing,
+                         const std::function<double(double)> &covariance,
+                         double origin = 0.0,
+                         LandscapeBoundary boundary = LandscapeBoundary::Periodic)
+      -> Result<std::shared_ptr<const QuenchedLandscape>> {
+    if (num_points < 3) {
+      return Err(Error::InvalidArgument("A landscape needs at least 3 points"));
+    }
+    if (!(spacing > 0)) {
+      return Err(Error::InvalidArgument("Spacing must be positive"));
+    }
+    size_t m = boundary == LandscapeBoundary::Periodic ? num_points
+                                                       : 2 * num_points;
+    // The planner is not thread-safe; the plan comes from the shared cache
+    fftw_plan plan = fft_plan(m, FFTW_FORWARD);
+    fftw_complex *in = fftw_alloc_complex(m);
+    fftw_complex *out = fftw_alloc_complex(m);
+    for (size_t k = 0; k < m; ++k) {
+      double lag = static_cast<double>(std::min(k, m - k)) * spacing;
+      in[k][0] = covariance(lag);
+      in[k][1] = 0.0;
+    }
+    fftw_execute_dft(plan, in, out);
+
+    double largest = 0.0;
+    for (size_t k = 0; k < m; ++k) {
+      largest = std::max(largest, out[k][0]);
+    }
+    std::mt19937 gen = generator();
+    std::normal_distribution<double> normal(0.0, 1.0);
+    for (size_t k = 0; k < m; ++k) {
+      double lambda = out[k][0];
+      if (lambda < -1e-8 * largest) {
+        fftw_free(in);
+        fftw_free(out);
+        return Err(Error::InvalidArgument(std::format(
+            "Circulant embedding is not positive semidefinite (eigenvalue {})",
+            lambda)));
+      }
+      double scale = std::sqrt(std::max(lambda, 0.0) / static_cast<double>(m));
+      double re = normal(gen);
+      double im = normal(gen);
+      in[k][0] = scale * re;
+      in[k][1] = scale * im;
+    }
+
+    fftw_execute_dft(plan, in, out);
+    vector<double> u(num_points);
+    for (size_t k = 0; k < num_points; ++k) {
+      u[k] = out[k][0];
+    }
+    fftw_free(in);
+    fftw_free(out);
+    return Ok(std::make_shared<const QuenchedLandscape>(std::move(u), spacing,
+                                                        origin, boundary));
+  }
+
+  /**
+   * @brief Gets the number of nodes
+   * @return The number of nodes
+   */
+  [[nodiscard]] auto size() const -> size_t { return m_potential.size(); }
+
+  /**
+   * @brief Gets the grid spacing
+   * @return The spacing h
+   */
+  [[nodiscard]] auto get_spacing() const -> double { return m_spacing; }
+
+  /**
+   * @brief Gets the position of the first node
+   * @return The origin
+   */
+  [[nodiscard]] auto get_origin() const -> double { return m_origin; }
+
+  /**
+   * @brief Gets the continuation outside the grid
+   * @return The boundary
+   */
+  [[nodiscard]] auto get_boundary() const -> LandscapeBoundary {
+    return m_boundary;
+  }
+
+  /**
+   * @brief Gets the potential at the nodes
+   * @return U at the nodes
+   */
+  [[nodiscard]] auto get_potential() const -> const vector<double> & {
+    return m_potential;
+  }
+
+  /**
+   * @brief Maps a position to a cell index and the fraction within the cell
+   * @param x The position
+   * @return The cell index and the fraction in [0, 1]
+   */
+  [[nodiscard]] auto locate(double x) const -> std::pair<size_t, double> {
+    double u = (x - m_origin) * m_inverse_spacing;
+    auto cells = static_cast<double>(m_cells.size() - 1);
+    if (m_boundary == LandscapeBoundary::Periodic) {
+      u -= std::floor(u / cells) * cells;
+    }
+    u = std::clamp(u, 0.0, cells);
+    double k = std::floor(u);
+    return {static_cast<size_t>(k), u - k};
+  }
+
+  /**
+   * @brief Evaluates the force F(x) = -U'(x)
+   * @param x The position
+   * @return The interpolated force
+   */
+  [[nodiscard]] auto force(double x) const -> double {
+    auto [k, fraction] = locate(x);
+    const ForceCell cell = m_cells[k];
+    return cell.force + cell.slope * fraction;
+  }
+
+  /**
+   * @brief Evaluates the force at many positions
+   * @param x The positions
+   * @param out The forces, same size as x
+   *
+   * The loop is branch-free, so compilers vectorize it with gathers.
+   */
+  void force_batch(std::span<const double> x, std::span<double> out) const {
+    const ForceCell *cells = m_cells.data();
+    double origin = m_origin;
+    double inverse = m_inverse_spacing;
+    auto count = static_cast<double>(m_cells.size() - 1);
+    double period = m_boundary == LandscapeBoundary::Periodic ? count : 0.0;
+    double inverse_period = period > 0 ? 1.0 / period : 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+      double u = (x[i] - origin) * inverse;
+      u -= std::floor(u * inverse_period) * period;
+      u = std::min(std::max(u, 0.0), count);
+      double k = std::floor(u);
+      const ForceCell cell = cells[static_cast<size_t>(k)];
+      out[i] = cell.force + cell.slope * (u - k);
+    }
+  }
+
+  /**
+   * @brief Evaluates the potential U(x) by linear interpolation
+   * @param x The position
+   * @return The interpolated potential
+   */
+  [[nodiscard]] auto potential(double x) const -> double {
+    auto [k, fraction] = locate(x);
+    size_t n = m_potential.size();
+    double left = m_potential[k % n];
+    double right = m_potential[(k + 1) % n];
+    if (m_boundary == LandscapeBoundary::Clamp && k + 1 >= n) {
+      right = left;
+    }
+    return left + (right - left) * fraction;
+  }
+};
+
+/**
+ * @brief Drift functor F(x) of a shared landscape, for `Langevin`
+ *
+ * @example
+ * ```cpp
+ * auto landscape = QuenchedLandscape::brownian(1 << 16, 0.01, 1.0).value();
+ * auto noise = [](double, double) { return std::sqrt(2.0); };
+ * Langevin langevin(LandscapeForce{landscape}, noise);
+ * ```
+ */
+export struct LandscapeForce {
+  std::shared_ptr<const QuenchedLandscape> landscape; ///< The shared landscape
+
+  auto operator()(double x, double) const -> double {
+    return landscape->force(x);
+  }
+};
+
+/**
+ * @brief Stepper generating a path in a quenched landscape block by block
+ */
+export class LandscapeStepper final : public Stepper {
+  std::shared_ptr<const QuenchedLandscape> m_landscape; ///< The landscape
+  std::mt19937 m_gen = generator();                     ///< Random number generator
+  std::normal_distribution<double> m_noise;             ///< Noise increment
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    double dt = get_time_step();
+    double x = m_position;
+    for (auto &position : positions) {
+      x += m_landscape->force(x) * dt + m_noise(m_gen);
+      position = x;
+    }
+    m_position = x;
+  }
+
+  auto step_partial(double time_step) -> double override {
+    m_position += m_landscape->force(m_position) * time_step +
+                  m_noise(m_gen) * std::sqrt(time_step / get_time_step());
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param landscape The shared landscape
+   * @param diffusion_coefficient The diffusion coefficient D
+   * @param start_position Initial position
+   * @param time_step The time step of the grid
+   */
+  LandscapeStepper(std::shared_ptr<const QuenchedLandscape> landscape,
+                   double diffusion_coefficient, double start_position,
+                   double time_step)
+      : Stepper(start_position, time_step), m_landscape(std::move(landscape)),
+        m_noise(0.0, std::sqrt(2.0 * diffusion_coefficient * time_step)) {}
+};
+
+/**
+ * @brief Overdamped diffusion in a quenched landscape
+ *
+ * dX = F(X) dt + √(2D) dW with F = -U' from a shared `QuenchedLandscape`,
+ * integrated with the Euler-Maruyama scheme. The landscape is the same for
+ * all particles, i.e. averages are thermal averages in one disorder
+ * realization.
+ */
+export class LandscapeDiffusion : public ContinuousProcess {
+  std::shared_ptr<const QuenchedLandscape> m_landscape; ///< The shared landscape
+  double m_diffusion_coefficient = 1.0;                 ///< Diffusion coefficient D
+  double m_start_position = 0.0;                        ///< Initial position
+
+  /// Advances a batch of particles by one Euler-Maruyama step
+  void step_batch(std::span<double> x, std::span<double> scratch,
+                  double time_step, std::mt19937 &gen) const {
+    std::normal_distribution<double> normal(
+        0.0, std::sqrt(2.0 * m_diffusion_coefficient * time_step));
+    m_landscape->force_batch(x, scratch);
+    for (size_t i = 0; i < x.size(); ++i) {
+      scratch[i] = scratch[i] * time_step + normal(gen);
+    }
+    for (size_t i = 0; i < x.size(); ++i) {
+      x[i] += scratch[i];
+    }
+  }
+
+public:
+  /**
+   * @brief Constructs the process
+   * @param landscape The shared landscape
+   * @param diffusion_coefficient The diffusion coefficient D (must be positive)
+   * @param start_position Initial position
+   * @throws std::invalid_argument if the landscape is null or D is not positive
+   */
+  LandscapeDiffusion(std::shared_ptr<const QuenchedLandscape> landscape,
+                     double diffusion_coefficient = 1.0,
+                     double start_position = 0.0)
+      : m_landscape(std::move(landscape)),
+        m_diffusion_coefficient(diffusion_coefficient),
+        m_start_position(start_position) {
+    if (!m_landscape) {
+      throw std::invalid_argument("Landscape must not be null");
+    }
+    if (!(diffusion_coefficient > 0)) {
+      throw std::invalid_argument("Diffusion coefficient must be positive");
+    }
+  }
+
+  /**
+   * @brief Gets the landscape
+   * @return The shared landscape
+   */
+  [[nodiscard]] auto get_landscape() const
+      -> const std::shared_ptr<const QuenchedLandscape> & {
+    return m_landscape;
+  }
+
+  /**
+   * @brief Gets the diffusion coefficient
+   * @return The diffusion coefficient D
+   */
+  [[nodiscard]] auto get_diffusion_coefficient() const -> double {
+    return m_diffusion_coefficient;
+  }
+
+  /**
+   * @brief Gets the initial position
+   * @return The initial position
+   */
+  [[nodiscard]] auto get_start_position() const -> double {
+    return m_start_position;
+  }
+
+  double start() override { return m_start_position; }
+
+  /**
+   * @brief Simulates a trajectory
+   * @param duration The total simulation time
+   * @param time_step The time step for discretization
+   * @return Result containing time and position vectors, or an Error
+   */
+  Result<vec_pair> simulate(double duration, double time_step = 0.01) override {
+    if (duration <= 0) {
+      return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    auto path = stepper(time_step);
+    if (!path) {
+      return Err(path.error());
+    }
+    auto num_steps = count_steps(duration, time_step);
+    vector<double> times(num_steps + 1);
+    vector<double> positions(num_steps + 1);
+    times[0] = 0.0;
+    positions[0] = m_start_position;
+    path.value()->finish(std::span(times).subspan(1),
+                         std::span(positions).subspan(1), duration);
+    return Ok(std::make_pair(std::move(times), std::move(positions)));
+  }
+
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(std::make_unique<LandscapeStepper>(
+        m_landscape, m_diffusion_coefficient, m_start_position, time_step)));
+  }
+
+  /**
+   * @brief Simulates the positions of many particles at a given time
+   * @param duration The time
+   * @param particles The number of particles
+   * @param time_step The time step for discretization
+   * @return Result containing the final positions, or an Error
+   *
+   * Particles are advanced in batches of `landscape_batch_size` with a
+   * vectorized force lookup; workers share the landscape read-only.
+   */
+  [[nodiscard]] auto ensemble_positions(double duration, size_t particles,
+                                        double time_step = 0.01) const
+      -> Result<vector<double>> {
+    if (duration <= 0) {
+      return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    auto num_steps = count_steps(duration, time_step);
+    double last_step = duration - (static_cast<double>(num_steps - 1) * time_step);
+    vector<double> result(particles, m_start_position);
+    run_placed(particles, default_workers(), [&](size_t begin, size_t end) {
+      thread_local static std::mt19937 gen = generator();
+      vector<double> scratch(landscape_batch_size);
+      for (size_t first = begin; first < end; first += landscape_batch_size) {
+        size_t count = std::min(landscape_batch_size, end - first);
+        auto x = std::span(result).subspan(first, count);
+        auto s = std::span(scratch).first(count);
+        for (size_t step = 1; step < num_steps; ++step) {
+          step_batch(x, s, time_step, gen);
+        }
+        step_batch(x, s, last_step, gen);
+      }
+    });
+    return Ok(std::move(result));
+  }
+
+  /**
+   * @brief Simulates first exit times from an interval for many particles
+   * @param domain The interval (a, b) containing the starting position
+   * @param particles The number of particles
+   * @param max_duration The maximum simulated time
+   * @param time_step The time step for discretization
+   * @return Result containing, per particle, the first time X ∉ (a, b), or
+   *         None if the particle was still inside at max_duration
+   *
+   * Particles that have exited are swapped out of their batch, so the batch
+   * stays dense for the vectorized update.
+   */
+  [[nodiscard]] auto first_passage_times(double_pair domain, size_t particles,
+                                         double max_duration,
+                                         double time_step = 0.01) const
+      -> Result<vector<Option<double>>> {
+    auto [a, b] = domain;
+    if (!(a < m_start_position && m_start_position < b)) {
+      return Err(Error::InvalidArgument(std::format(
+          "The domain ({}, {}) must contain the starting position {}", a, b,
+          m_start_position)));
+    }
+    if (max_duration <= 0 || time_step <= 0) {
+      return Err(Error::InvalidArgument(
+          "Maximum duration and time step must be positive"));
+    }
+    auto num_steps = count_steps(max_duration, time_step);
+    double last_step =
+        max_duration - (static_cast<double>(num_steps - 1) * time_step);
+    vector<Option<double>> result(particles);
+    run_placed(particles, default_workers(), [&](size_t begin, size_t end) {
+      thread_local static std::mt19937 gen = generator();
+      vector<double> x(landscape_batch_size);
+      vector<double> scratch(landscape_batch_size);
+      vector<size_t> ids(landscape_batch_size);
+      for (size_t first = begin; first < end; first += landscape_batch_size) {
+        size_t alive = std::min(landscape_batch_size, end - first);
+        for (size_t i = 0; i < alive; ++i) {
+          x[i] = m_start_position;
+          ids[i] = first + i;
+        }
+        for (size_t step = 1; step <= num_steps && alive > 0; ++step) {
+          bool last = step == num_steps;
+          step_batch(std::span(x).first(alive), std::span(scratch).first(alive),
+                     last ? last_step : time_step, gen);
+          double t = last ? max_duration : static_cast<double>(step) * time_step;
+          for (size_t i = 0; i < alive;) {
+            if (x[i] > a && x[i] < b) {
+              ++i;
+              continue;
+            }
+            result[ids[i]] = t;
+            --alive;
+            x[i] = x[alive];
+            ids[i] = ids[alive];
+          }
+        }
+      }
+    });
+    return Ok(std::move(result));
+  }
+};
@@ -2,7 +2,9 @@ module;
 
 #include <cmath>
 #include <functional>
+#include <memory>
 #include <random>
+#include <span>
 #include <vector>
 
 export module diffusionx.simulation.continuous.langevin;
@@ -10,12 +12,67 @@ export module diffusionx.simulation.continuous.langevin;
 import diffusionx.error;
 import diffusionx.random.normal;
 import diffusionx.random.stable;
+import diffusionx.random.utils;
 import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
 import diffusionx.simulation.basic.utils;
 
 using std::function;
 using std::vector;
 
+/**
+ * @brief Stepper generating a Langevin path block by block
+ *
+ * Uses the Euler-Maruyama scheme of `Langevin::simulate`:
+ * X(t + dt) = X(t) + f(X(t), t) * dt + g(X(t), t) * sqrt(dt) * Z
+ */
+export template <typename DriftFunc, typename DiffusionFunc>
+class LangevinStepper final : public Stepper {
+  DriftFunc m_drift_func;                   ///< Drift function f(x, t)
+  DiffusionFunc m_diffusion_func;           ///< Diffusion function g(x, t)
+  std::mt19937 m_gen = generator();         ///< Random number generator
+  std::normal_distribution<double> m_noise; ///< Standard normal noise
+  double m_sqrt_dt;                         ///< sqrt(dt)
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    double dt = get_time_step();
+    double t = get_time();
+    double x = m_position;
+    for (auto &position : positions) {
+      x += m_drift_func(x, t) * dt +
+           m_diffusion_func(x, t) * m_sqrt_dt * m_noise(m_gen);
+      t += dt;
+      position = x;
+    }
+    m_position = x;
+  }
+
+  auto step_partial(double time_step) -> double override {
+    double t = get_time();
+    m_position += m_drift_func(m_position, t) * time_step +
+                  m_diffusion_func(m_position, t) * std::sqrt(time_step) *
+                      m_noise(m_gen);
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param drift_func The drift function f(x, t)
+   * @param diffusion_func The diffusion function g(x, t)
+   * @param start_position Initial position
+   * @param time_step The time step of the grid (must be positive)
+   * @throws std::invalid_argument if time_step is not positive
+   */
+  LangevinStepper(DriftFunc drift_func, DiffusionFunc diffusion_func,
+                  double start_position, double time_step)
+      : Stepper(start_position, time_step),
+        m_drift_func(std::move(drift_func)),
+        m_diffusion_func(std::move(diffusion_func)), m_noise(0.0, 1.0),
+        m_sqrt_dt(std::sqrt(time_step)) {}
+};
+
 /**
  * @brief Langevin equation implementation
  *
@@ -124,6 +181,20 @@ public:
 
     return Ok(std::make_pair(std::move(times), std::move(positions)));
   }
+
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(
+        std::make_unique<LangevinStepper<DriftFunc, DiffusionFunc>>(
+            m_drift_func, m_diffusion_func, m_start_position, time_step)));
+  }
 };
 
 /**
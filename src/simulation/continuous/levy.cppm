@@ -1,17 +1,70 @@
 module;
 
 #include <cmath>
+#include <memory>
+#include <span>
 #include <vector>
 
 export module diffusionx.simulation.continuous.levy;
 
 import diffusionx.error;
+import diffusionx.memory;
 import diffusionx.random.stable;
 import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
 import diffusionx.simulation.basic.utils;
 
 using std::vector;
 
+/**
+ * @brief Stepper generating a Lévy process path block by block
+ *
+ * X(t + dt) = X(t) + S(α, β, σ * dt^(1/α), μ * dt)
+ */
+export class LevyStepper final : public Stepper {
+  Stable m_increment; ///< Distribution of one increment, S(α, β, σ dt^(1/α), μ dt)
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    m_increment.fill(positions);
+    double x = m_position;
+    for (auto &position : positions) {
+      x += position;
+      position = x;
+    }
+    m_position = x;
+  }
+
+  auto step_partial(double time_step) -> double override {
+    double ratio = time_step / get_time_step();
+    auto increment = rand_stable(m_increment.get_alpha(), m_increment.get_beta(),
+                                 m_increment.get_sigma() *
+                                     std::pow(ratio, 1.0 / m_increment.get_alpha()),
+                                 m_increment.get_mu() * ratio);
+    if (increment.has_value()) {
+      m_position += increment.value();
+    }
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param alpha Stability parameter α (must be in (0, 2])
+   * @param beta Skewness parameter β (must be in [-1, 1])
+   * @param sigma Scale parameter σ (must be positive)
+   * @param mu Location parameter μ
+   * @param start_position Initial position
+   * @param time_step The time step of the grid (must be positive)
+   * @throws std::invalid_argument if a parameter is invalid
+   */
+  LevyStepper(double alpha, double beta, double sigma, double mu,
+              double start_position, double time_step)
+      : Stepper(start_position, time_step),
+        m_increment(alpha, beta, sigma * std::pow(time_step, 1.0 / alpha),
+                    mu * time_step) {}
+};
+
 /**
  * @brief Lévy process implementation using stable distributions
  *
@@ -126,12 +179,12 @@ public:
     double scaled_mu = m_mu * time_step;
 
     // Generate stable increments
-    auto increments_result =
-        rand_stable(num_steps, m_alpha, m_beta, scaled_sigma, scaled_mu);
-    if (!increments_result.has_value()) {
-      return Err(increments_result.error());
+    buffer<double> increments(num_steps);
+    if (auto res = rand_stable(std::span(increments), m_alpha, m_beta,
+                               scaled_sigma, scaled_mu);
+        !res) {
+      return Err(res.error());
     }
-    auto increments = increments_result.value();
 
     // Simulate trajectory
     for (size_t i = 1; i <= num_steps; ++i) {
@@ -142,6 +195,19 @@ public:
     return Ok(std::make_pair(std::move(times), std::move(positions)));
   }
 
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(std::make_unique<LevyStepper>(
+        m_alpha, m_beta, m_sigma, m_mu, m_start_position, time_step)));
+  }
+
   /**
    * @brief Computes the theoretical mean at time t (when it exists)
    * @param t Time point
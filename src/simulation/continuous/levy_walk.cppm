@@ -1,7 +1,9 @@
 module;
 
 #include <cmath>
+#include <memory>
 #include <random>
+#include <span>
 #include <vector>
 
 export module diffusionx.simulation.continuous.levy_walk;
@@ -9,11 +11,83 @@ export module diffusionx.simulation.continuous.levy_walk;
 import diffusionx.error;
 import diffusionx.random.stable;
 import diffusionx.random.exponential;
+import diffusionx.random.utils;
 import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
 import diffusionx.simulation.basic.utils;
 
 using std::vector;
 
+/**
+ * @brief Stepper generating a Lévy walk path block by block
+ *
+ * Keeps the remaining time and direction of the current flight, so the path
+ * is sampled exactly on the grid without storing the event times.
+ */
+export class LevyWalkStepper final : public Stepper {
+  double m_alpha;       ///< Flight time distribution exponent
+  double m_velocity;    ///< Constant velocity
+  double m_flight_left; ///< Remaining time of the current flight
+  double m_direction;   ///< Direction of the current flight (±1)
+  std::mt19937 m_gen = generator();                 ///< Random number generator
+  std::uniform_real_distribution<double> m_uniform; ///< U(0, 1)
+
+  void new_flight() {
+    // Inverse transform sampling: τ = (1 - U)^(-1/α) - 1
+    m_flight_left = std::pow(1.0 - m_uniform(m_gen), -1.0 / m_alpha) - 1.0;
+    m_direction = m_uniform(m_gen) < 0.5 ? -1.0 : 1.0;
+  }
+
+  auto walk(double x, double duration) -> double {
+    while (duration > m_flight_left) {
+      x += m_direction * m_velocity * m_flight_left;
+      duration -= m_flight_left;
+      new_flight();
+    }
+    m_flight_left -= duration;
+    return x + (m_direction * m_velocity * duration);
+  }
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    double x = m_position;
+    double dt = get_time_step();
+    for (auto &position : positions) {
+      x = walk(x, dt);
+      position = x;
+    }
+    m_position = x;
+  }
+
+  auto step_partial(double time_step) -> double override {
+    m_position = walk(m_position, time_step);
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param alpha Flight time distribution exponent (0 < α < 1)
+   * @param velocity Constant velocity (must be positive)
+   * @param start_position Starting position
+   * @param time_step The time step of the grid (must be positive)
+   * @throws std::invalid_argument if a parameter is invalid
+   */
+  LevyWalkStepper(double alpha, double velocity, double start_position,
+                  double time_step)
+      : Stepper(start_position, time_step), m_alpha(alpha),
+        m_velocity(velocity), m_flight_left(0.0), m_direction(1.0),
+        m_uniform(0.0, 1.0) {
+    if (m_alpha <= 0.0 || m_alpha >= 1.0) {
+      throw std::invalid_argument("Alpha must be in range (0, 1)");
+    }
+    if (m_velocity <= 0.0) {
+      throw std::invalid_argument("Velocity must be positive");
+    }
+    new_flight();
+  }
+};
+
 /**
  * @brief Lévy walk implementation
  *
@@ -143,6 +217,19 @@ public:
     return Ok(std::make_pair(std::move(times), std::move(positions)));
   }
 
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(std::make_unique<LevyWalkStepper>(
+        m_alpha, m_velocity, m_start_position, time_step)));
+  }
+
 private:
   /**
    * @brief Interpolates position at given time using piecewise linear
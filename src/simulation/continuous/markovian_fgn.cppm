@@ -0,0 +1,566 @@
+/**
+ * @file markovian_fgn.cppm
+ * @brief Constant-memory streaming fGn through a sum of OU processes
+ *
+ * Circulant embedding needs the whole path length up front and O(n)
+ * memory. This module approximates fractional Gaussian noise on a grid by a
+ * finite-dimensional Markov process: K Ornstein-Uhlenbeck components
+ * sampled exactly at the grid points (AR(1) sequences φ_j = e^{-λ_j}), with
+ * rates on a geometric grid and nonnegative weights fitted so that the
+ * covariance is reproduced up to a horizon of N steps.
+ *
+ * - H > 1/2: the fGn autocovariance ρ(k) is completely monotone, so
+ *   ρ(k) ≈ Σ_j c_j φ_j^k for k ≥ 1 and fGn = Σ_j √c_j A_j + √c_0 ε. The
+ *   weights are fitted on the MSD k^{2H}, which is linear in them, so the
+ *   variance c_0 + Σ_j c_j is 1 up to the tolerance.
+ * - H < 1/2: the fBm variogram k^{2H} is a Bernstein function, so
+ *   k^{2H} ≈ Σ_j 2 b_j (1 - φ_j^k) + 2 b_0, i.e. the variogram of
+ *   X = Σ_j √b_j A_j + √b_0 ε, and fGn is the increment of X.
+ *
+ * Each step costs O(K) and the state is K numbers, so paths can be
+ * extended indefinitely. Rates span the horizon geometrically, so K grows
+ * like log N; K is chosen as the smallest that meets the requested
+ * relative MSD error at every lag up to N. Beyond the horizon the
+ * approximation degrades (diffusive for H > 1/2, saturating for H < 1/2).
+ */
+
+module;
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.simulation.continuous.markovian_fgn;
+
+import diffusionx.error;
+import diffusionx.random.utils;
+import diffusionx.simulation.basic.stepper;
+
+using std::vector;
+
+/**
+ * @brief Exact autocovariance of unit fractional Gaussian noise
+ */
+auto fgn_autocovariance(double hurst, double k) -> double {
+  if (k == 0) {
+    return 1.0;
+  }
+  if (k < 2) {
+    return 0.5 * (std::pow(k + 1, 2 * hurst) + std::pow(k - 1, 2 * hurst) -
+                  2 * std::pow(k, 2 * hurst));
+  }
+  // Factored form, free of the cancellation between O(k^{2H}) terms
+  double up = std::expm1(2 * hurst * std::log1p(1.0 / k));
+  double down = std::expm1(2 * hurst * std::log1p(-1.0 / k));
+  return 0.5 * std::pow(k, 2 * hurst) * (up + down);
+}
+
+/**
+ * @brief Lags 1..16 and then `per_decade` log-spaced lags up to horizon
+ */
+auto fgn_lags(size_t horizon, size_t per_decade) -> vector<size_t> {
+  vector<size_t> lags;
+  for (size_t k = 1; k <= std::min<size_t>(horizon, 16); ++k) {
+    lags.push_back(k);
+  }
+  double decades = std::log10(static_cast<double>(horizon));
+  auto points = static_cast<size_t>(std::ceil(decades * static_cast<double>(per_decade)));
+  for (size_t i = 1; i <= points; ++i) {
+    auto k = static_cast<size_t>(std::llround(
+        std::pow(10.0, decades * static_cast<double>(i) / static_cast<double>(points))));
+    if (k > lags.back() && k <= horizon) {
+      lags.push_back(k);
+    }
+  }
+  return lags;
+}
+
+/**
+ * @brief Least-squares solution of A x = b by Householder QR
+ * @param a Column-major m × n matrix, m ≥ n, overwritten
+ * @param b Right-hand side of length m, overwritten
+ * @return The n coefficients (zero for numerically dependent columns)
+ */
+auto householder_least_squares(vector<double> a, vector<double> b, size_t m,
+                               size_t n) -> vector<double> {
+  vector<double> diagonal(n, 0.0);
+  for (size_t j = 0; j < n; ++j) {
+    double *col = a.data() + (j * m);
+    double norm = 0.0;
+    for (size_t i = j; i < m; ++i) {
+      norm += col[i] * col[i];
+    }
+    norm = std::sqrt(norm);
+    if (norm == 0.0) {
+      continue;
+    }
+    double alpha = col[j] > 0 ? -norm : norm;
+    col[j] -= alpha;
+    double vnorm = 0.0;
+    for (size_t i = j; i < m; ++i) {
+      vnorm += col[i] * col[i];
+    }
+    diagonal[j] = alpha;
+    auto reflect = [&](double *v) {
+      double dot = 0.0;
+      for (size_t i = j; i < m; ++i) {
+        dot += col[i] * v[i];
+      }
+      double f = 2.0 * dot / vnorm;
+      for (size_t i = j; i < m; ++i) {
+        v[i] -= f * col[i];
+      }
+    };
+    for (size_t k = j + 1; k < n; ++k) {
+      reflect(a.data() + (k * m));
+    }
+    reflect(b.data());
+  }
+  vector<double> x(n, 0.0);
+  double scale = 0.0;
+  for (double d : diagonal) {
+    scale = std::max(scale, std::abs(d));
+  }
+  for (size_t j = n; j-- > 0;) {
+    if (std::abs(diagonal[j]) <= 1e-13 * scale) {
+      continue;
+    }
+    double sum = b[j];
+    for (size_t k = j + 1; k < n; ++k) {
+      sum -= a[(k * m) + j] * x[k];
+    }
+    x[j] = sum / diagonal[j];
+  }
+  return x;
+}
+
+/**
+ * @brief Nonnegative least squares min ||A x - b||, x ≥ 0 (Lawson-Hanson)
+ * @param a Column-major m × n matrix
+ * @param b Right-hand side of length m
+ * @return The n nonnegative coefficients
+ *
+ * Columns are scaled to unit norm first, so that neither the choice of the
+ * entering column nor the rank cutoff depends on their magnitudes.
+ */
+auto nonnegative_least_squares(vector<double> a, const vector<double> &b,
+                               size_t m, size_t n) -> vector<double> {
+  vector<double> norms(n, 0.0);
+  for (size_t j = 0; j < n; ++j) {
+    double *col = a.data() + (j * m);
+    for (size_t i = 0; i < m; ++i) {
+      norms[j] += col[i] * col[i];
+    }
+    norms[j] = std::sqrt(norms[j]);
+    if (norms[j] > 0) {
+      for (size_t i = 0; i < m; ++i) {
+        col[i] /= norms[j];
+      }
+    }
+  }
+  vector<double> x(n, 0.0);
+  vector<char> passive(n, 0);
+  auto gradient = [&] {
+    vector<double> r = b;
+    for (size_t j = 0; j < n; ++j) {
+      for (size_t i = 0; i < m; ++i) {
+        r[i] -= a[(j * m) + i] * x[j];
+      }
+    }
+    vector<double> w(n, 0.0);
+    for (size_t j = 0; j < n; ++j) {
+      for (size_t i = 0; i < m; ++i) {
+        w[j] += a[(j * m) + i] * r[i];
+      }
+    }
+    return w;
+  };
+  auto solve_passive = [&] {
+    vector<size_t> columns;
+    for (size_t j = 0; j < n; ++j) {
+      if (passive[j] != 0) {
+        columns.push_back(j);
+      }
+    }
+    vector<double> sub(m * columns.size());
+    for (size_t c = 0; c < columns.size(); ++c) {
+      std::copy_n(a.data() + (columns[c] * m), m, sub.data() + (c * m));
+    }
+    auto coefficients = householder_least_squares(std::move(sub), b, m, columns.size());
+    vector<double> z(n, 0.0);
+    for (size_t c = 0; c < columns.size(); ++c) {
+      z[columns[c]] = coefficients[c];
+    }
+    return z;
+  };
+  for (size_t iteration = 0; iteration < 3 * n; ++iteration) {
+    auto w = gradient();
+    size_t best = n;
+    double largest = 1e-12;
+    for (size_t j = 0; j < n; ++j) {
+      if (passive[j] == 0 && w[j] > largest) {
+        largest = w[j];
+        best = j;
+      }
+    }
+    if (best == n) {
+      break;
+    }
+    passive[best] = 1;
+    while (true) {
+      auto z = solve_passive();
+      double step = 1.0;
+      for (size_t j = 0; j < n; ++j) {
+        if (passive[j] != 0 && z[j] <= 0) {
+          step = std::min(step, x[j] / (x[j] - z[j]));
+        }
+      }
+      for (size_t j = 0; j < n; ++j) {
+        x[j] += step * (z[j] - x[j]);
+      }
+      if (step == 1.0) {
+        break;
+      }
+      for (size_t j = 0; j < n; ++j) {
+        if (passive[j] != 0 && x[j] <= 1e-15) {
+          passive[j] = 0;
+          x[j] = 0.0;
+        }
+      }
+    }
+  }
+  for (size_t j = 0; j < n; ++j) {
+    x[j] = norms[j] > 0 ? x[j] / norms[j] : 0.0;
+  }
+  return x;
+}
+
+/**
+ * @brief Σ_{m=1}^{k-1} (k - m) e^{-λm}, accurate for small λk
+ */
+auto geometric_pair_sum(double lambda, double k) -> double {
+  if (lambda * k < 1e-4) {
+    return (k * (k - 1) / 2) - (lambda * (k * k * k - k) / 6) +
+           (lambda * lambda * k * k * (k * k - 1) / 24);
+  }
+  double phi = std::exp(-lambda);
+  double u = -std::expm1(-lambda);
+  double v = -std::expm1(-lambda * k);
+  return phi * ((k * u) - v) / (u * u);
+}
+
+/**
+ * @brief Comparison of a Markovian fGn approximation with the exact fGn
+ */
+export struct FgnEmbeddingReport {
+  double hurst = 0.5;       ///< Hurst parameter
+  size_t horizon = 0;       ///< Number of steps the fit covers
+  size_t components = 0;    ///< Number of OU components K
+  vector<size_t> lags;      ///< Lags k of the comparison, in steps
+  vector<double> exact;     ///< Exact fGn autocovariance ρ(k)
+  vector<double> approximate; ///< Autocovariance of the approximation
+  vector<double> msd_ratio; ///< MSD of the approximate fBm over k^{2H}
+  double max_covariance_error = 0.0; ///< max_k |ρ̂(k) - ρ(k)|, with ρ(0) = 1
+  double max_msd_error = 0.0; ///< max_k |msd_ratio - 1|
+};
+
+/**
+ * @brief Markovian (sum-of-OU) approximation of fractional Gaussian noise
+ *
+ * Describes unit fGn on a grid of unit steps; `MarkovianFbmStepper` scales
+ * it by dt^H. Exact for H = 1/2 (no components).
+ */
+export class MarkovianFgn {
+  double m_hurst = 0.5;    ///< Hurst parameter H ∈ (0, 1)
+  size_t m_horizon = 1;    ///< Number of steps the fit covers
+  vector<double> m_rates;  ///< Rates λ_j per step, φ_j = e^{-λ_j}
+  vector<double> m_weights; ///< c_j (H > 1/2) or b_j (H < 1/2)
+  double m_white = 1.0;    ///< c_0 (H > 1/2) or b_0 (H < 1/2)
+
+  MarkovianFgn(double hurst, size_t horizon) : m_hurst(hurst), m_horizon(horizon) {}
+
+  /**
+   * @brief Fits K components on a geometric grid of rates
+   */
+  static auto fit_components(double hurst, size_t horizon, size_t components)
+      -> MarkovianFgn {
+    MarkovianFgn model(hurst, horizon);
+    double lo = 0.1 / static_cast<double>(horizon);
+    double hi = 10.0;
+    for (size_t j = 0; j < components; ++j) {
+      double f = components == 1 ? 0.0
+                                 : static_cast<double>(j) /
+                                       static_cast<double>(components - 1);
+      model.m_rates.push_back(lo * std::pow(hi / lo, f));
+    }
+    auto lags = fgn_lags(horizon, 12);
+    size_t m = lags.size();
+    bool persistent = hurst > 0.5;
+    size_t n = components + 1;
+    vector<double> a(m * n);
+    vector<double> b(m);
+    for (size_t i = 0; i < m; ++i) {
+      auto k = static_cast<double>(lags[i]);
+      // Relative error of the MSD, which is linear in the weights
+      double target = std::pow(k, 2 * hurst);
+      double weight = 1.0 / target;
+      b[i] = 1.0;
+      for (size_t j = 0; j < components; ++j) {
+        double rate = model.m_rates[j];
+        a[(j * m) + i] = weight * (persistent ? k + (2.0 * geometric_pair_sum(rate, k))
+                                              : 2.0 * -std::expm1(-rate * k));
+      }
+      a[(components * m) + i] = weight * (persistent ? k : 2.0);
+    }
+    auto x = nonnegative_least_squares(a, b, m, n);
+    model.m_weights.assign(x.begin(), x.begin() + static_cast<std::ptrdiff_t>(components));
+    model.m_white = x[components];
+    return model;
+  }
+
+public:
+  /**
+   * @brief Fits an approximation with error control
+   * @param hurst Hurst parameter H (must be in (0, 1))
+   * @param horizon Number of steps the approximation must cover (at least 2)
+   * @param tolerance Largest relative MSD error |msd(k) / k^{2H} - 1|
+   * allowed at any lag k ≤ horizon
+   * @param max_components Largest number of OU components to try
+   * @return Result containing the approximation with the fewest components
+   * that meets the tolerance, or an Error if none up to max_components does
+   */
+  static auto fit(double hurst, size_t horizon, double tolerance = 1e-2,
+                  size_t max_components = 64) -> Result<MarkovianFgn> {
+    if (hurst <= 0.0 || hurst >= 1.0) {
+      return Err(Error::InvalidArgument("Hurst parameter must be in (0, 1)"));
+    }
+    if (horizon < 2) {
+      return Err(Error::InvalidArgument("The horizon must be at least 2 steps"));
+    }
+    if (!(tolerance > 0)) {
+      return Err(Error::InvalidArgument("The tolerance must be positive"));
+    }
+    if (hurst == 0.5) {
+      return Ok(MarkovianFgn(hurst, horizon));
+    }
+    double best = std::numeric_limits<double>::infinity();
+    for (size_t k = 1; k <= max_components; ++k) {
+      auto model = fit_components(hurst, horizon, k);
+      double error = model.report(24).max_msd_error;
+      if (error <= tolerance) {
+        return Ok(std::move(model));
+      }
+      best = std::min(best, error);
+    }
+    return Err(Error::SimulationFailed(std::format(
+        "No approximation with at most {} components reaches the MSD tolerance "
+        "{}; the best has error {}",
+        max_components, tolerance, best)));
+  }
+
+  /**
+   * @brief Gets the Hurst parameter
+   * @return The Hurst parameter H
+   */
+  [[nodiscard]] auto get_hurst() const -> double { return m_hurst; }
+
+  /**
+   * @brief Gets the horizon of the fit
+   * @return The number of steps the fit covers
+   */
+  [[nodiscard]] auto get_horizon() const -> size_t { return m_horizon; }
+
+  /**
+   * @brief Gets the number of OU components
+   * @return K
+   */
+  [[nodiscard]] auto components() const -> size_t { return m_rates.size(); }
+
+  /**
+   * @brief Gets the rates of the components
+   * @return λ_j per step
+   */
+  [[nodiscard]] auto get_rates() const -> const vector<double> & { return m_rates; }
+
+  /**
+   * @brief Gets the weights of the components
+   * @return c_j for H > 1/2, b_j for H < 1/2
+   */
+  [[nodiscard]] auto get_weights() const -> const vector<double> & { return m_weights; }
+
+  /**
+   * @brief Gets the weight of the white-noise part
+   * @return c_0 for H > 1/2, b_0 for H < 1/2
+   */
+  [[nodiscard]] auto get_white_weight() const -> double { return m_white; }
+
+  /**
+   * @brief Computes the autocovariance of the approximate fGn
+   * @param k The lag in steps
+   * @return ρ̂(k)
+   */
+  [[nodiscard]] auto autocovariance(size_t k) const -> double {
+    auto lag = static_cast<double>(k);
+    double sum = 0.0;
+    if (m_hurst >= 0.5) {
+      for (size_t j = 0; j < m_rates.size(); ++j) {
+        sum += m_weights[j] * std::exp(-m_rates[j] * lag);
+      }
+      return k == 0 ? sum + m_white : sum;
+    }
+    // Second difference of the variogram of X
+    if (k == 0) {
+      return msd(1);
+    }
+    for (size_t j = 0; j < m_rates.size(); ++j) {
+      double u = -std::expm1(-m_rates[j]);
+      sum -= m_weights[j] * std::exp(-m_rates[j] * (lag - 1)) * u * u;
+    }
+    return k == 1 ? sum - m_white : sum;
+  }
+
+  /**
+   * @brief Computes the MSD of the approximate fBm (unit steps)
+   * @param k The lag in steps
+   * @return Var[X(n + k) - X(n)], to compare with k^{2H}
+   */
+  [[nodiscard]] auto msd(size_t k) const -> double {
+    auto lag = static_cast<double>(k);
+    if (k == 0) {
+      return 0.0;
+    }
+    double sum = 0.0;
+    if (m_hurst >= 0.5) {
+      sum = lag * autocovariance(0);
+      for (size_t j = 0; j < m_rates.size(); ++j) {
+        sum += 2.0 * m_weights[j] * geometric_pair_sum(m_rates[j], lag);
+      }
+      return sum;
+    }
+    for (size_t j = 0; j < m_rates.size(); ++j) {
+      sum += 2.0 * m_weights[j] * -std::expm1(-m_rates[j] * lag);
+    }
+    return sum + (2.0 * m_white);
+  }
+
+  /**
+   * @brief Compares the approximation with exact fGn up to the horizon
+   * @param lags_per_decade Log-spaced comparison lags per decade, after
+   * lags 1 to 16
+   * @return The report
+   *
+   * Exact fGn is what circulant embedding (`FBM::simulate`) samples, so the
+   * report is the covariance error against that method.
+   */
+  [[nodiscard]] auto report(size_t lags_per_decade = 10) const -> FgnEmbeddingReport {
+    FgnEmbeddingReport r;
+    r.hurst = m_hurst;
+    r.horizon = m_horizon;
+    r.components = components();
+    r.lags = fgn_lags(m_horizon, lags_per_decade);
+    r.lags.insert(r.lags.begin(), 0);
+    for (size_t k : r.lags) {
+      double exact = fgn_autocovariance(m_hurst, static_cast<double>(k));
+      double approximate = autocovariance(k);
+      r.exact.push_back(exact);
+      r.approximate.push_back(approximate);
+      r.max_covariance_error = std::max(r.max_covariance_error, std::abs(approximate - exact));
+      if (k > 0) {
+        double ratio = msd(k) / std::pow(static_cast<double>(k), 2 * m_hurst);
+        r.msd_ratio.push_back(ratio);
+        r.max_msd_error = std::max(r.max_msd_error, std::abs(ratio - 1.0));
+      } else {
+        r.msd_ratio.push_back(1.0);
+      }
+    }
+    return r;
+  }
+};
+
+/**
+ * @brief Stepper generating an approximate fBm path in constant memory
+ *
+ * Each step draws K + 1 standard normals and updates K AR(1) states, so a
+ * path of any length costs O(K) per step and O(K) memory. Components start
+ * in their stationary law, so the increments are stationary from the first
+ * step. The MSD is accurate to the fit's tolerance up to its horizon.
+ */
+export class MarkovianFbmStepper final : public Stepper {
+  std::mt19937 m_gen = generator();         ///< Random number generator
+  std::normal_distribution<double> m_noise; ///< Standard normal noise
+  vector<double> m_state;                   ///< AR(1) states A_j
+  vector<double> m_decay;                   ///< φ_j
+  vector<double> m_innovation;              ///< √(1 - φ_j²)
+  vector<double> m_amplitude;               ///< √c_j or √b_j
+  double m_white;                           ///< √c_0 or √b_0
+  double m_scale;                           ///< dt^H
+  double m_hurst;                           ///< Hurst exponent H
+  double m_previous = 0.0;                  ///< X of the last step (H < 1/2)
+  bool m_differenced;                       ///< fGn is the increment of X
+
+  auto next_noise() -> double {
+    double x = m_white * m_noise(m_gen);
+    for (size_t j = 0; j < m_state.size(); ++j) {
+      m_state[j] = (m_decay[j] * m_state[j]) + (m_innovation[j] * m_noise(m_gen));
+      x += m_amplitude[j] * m_state[j];
+    }
+    if (!m_differenced) {
+      return x;
+    }
+    double increment = x - m_previous;
+    m_previous = x;
+    return increment;
+  }
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    double x = m_position;
+    for (auto &position : positions) {
+      x += m_scale * next_noise();
+      position = x;
+    }
+    m_position = x;
+  }
+
+  /// The AR(1) states advance by a whole step; only the increment is rescaled
+  auto step_partial(double time_step) -> double override {
+    m_position += m_scale * std::pow(time_step / get_time_step(), m_hurst) * next_noise();
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param model The fitted approximation
+   * @param start_position Initial position
+   * @param time_step The time step of the grid (must be positive)
+   * @throws std::invalid_argument if time_step is not positive
+   */
+  MarkovianFbmStepper(const MarkovianFgn &model, double start_position,
+                      double time_step)
+      : Stepper(start_position, time_step), m_noise(0.0, 1.0),
+        m_white(std::sqrt(model.get_white_weight())),
+        m_scale(std::pow(time_step, model.get_hurst())),
+        m_hurst(model.get_hurst()),
+        m_differenced(model.get_hurst() < 0.5) {
+    for (size_t j = 0; j < model.components(); ++j) {
+      double phi = std::exp(-model.get_rates()[j]);
+      m_decay.push_back(phi);
+      m_innovation.push_back(std::sqrt(-std::expm1(-2.0 * model.get_rates()[j])));
+      m_amplitude.push_back(std::sqrt(model.get_weights()[j]));
+      m_state.push_back(m_noise(m_gen));
+    }
+    if (m_differenced) {
+      m_previous = m_white * m_noise(m_gen);
+      for (size_t j = 0; j < m_state.size(); ++j) {
+        m_previous += m_amplitude[j] * m_state[j];
+      }
+    }
+  }
+};
@@ -1,17 +1,83 @@
 module;
 
 #include <cmath>
+#include <memory>
+#include <random>
+#include <span>
 #include <vector>
 
 export module diffusionx.simulation.continuous.ou;
 
 import diffusionx.error;
+import diffusionx.memory;
 import diffusionx.random.normal;
+import diffusionx.random.utils;
 import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
 import diffusionx.simulation.basic.utils;
 
 using std::vector;
 
+/**
+ * @brief Stepper generating an Ornstein-Uhlenbeck path block by block
+ *
+ * Uses the exact discretization, so the time step only sets the output grid.
+ */
+export class OrnsteinUhlenbeckStepper final : public Stepper {
+  std::mt19937 m_gen = generator();             ///< Random number generator
+  std::normal_distribution<double> m_noise;     ///< Standard normal noise
+  double m_decay;                               ///< exp(-θ dt)
+  double m_drift;                               ///< μ (1 - exp(-θ dt))
+  double m_scale;                               ///< Stationary noise scale
+  double m_theta;                               ///< Mean reversion speed θ
+  double m_mu;                                  ///< Long-term mean μ
+  double m_variance;                            ///< Stationary variance σ²/(2θ)
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    double x = m_position;
+    for (auto &position : positions) {
+      x = x * m_decay + m_drift + m_scale * m_noise(m_gen);
+      position = x;
+    }
+    m_position = x;
+  }
+
+  auto step_partial(double time_step) -> double override {
+    double decay = std::exp(-m_theta * time_step);
+    m_position = m_position * decay + m_mu * (1.0 - decay) +
+                 std::sqrt(m_variance * -std::expm1(-2.0 * m_theta * time_step)) *
+                     m_noise(m_gen);
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param theta Mean reversion speed (must be positive)
+   * @param mu Long-term mean
+   * @param sigma Volatility parameter (must be positive)
+   * @param start_position Initial position
+   * @param time_step The time step of the grid (must be positive)
+   * @throws std::invalid_argument if a parameter is invalid
+   */
+  OrnsteinUhlenbeckStepper(double theta, double mu, double sigma,
+                           double start_position, double time_step)
+      : Stepper(start_position, time_step), m_noise(0.0, 1.0),
+        m_decay(std::exp(-theta * time_step)), m_drift(mu * (1.0 - m_decay)),
+        m_scale(sigma * std::sqrt((1.0 - std::exp(-2.0 * theta * time_step)) /
+                                  (2.0 * theta))),
+        m_theta(theta), m_mu(mu), m_variance(sigma * sigma / (2.0 * theta)) {
+    if (theta <= 0) {
+      throw std::invalid_argument(
+          "Mean reversion speed theta must be positive");
+    }
+    if (sigma <= 0) {
+      throw std::invalid_argument("Volatility sigma must be positive");
+    }
+  }
+};
+
 /**
  * @brief Ornstein-Uhlenbeck process implementation
  *
@@ -121,11 +187,10 @@ public:
                             (2.0 * m_theta));
 
     // Generate random increments
-    auto increments_result = randn(num_steps, 0.0, 1.0);
-    if (!increments_result.has_value()) {
-      return Err(increments_result.error());
+    buffer<double> increments(num_steps);
+    if (auto res = randn(std::span(increments), 0.0, 1.0); !res) {
+      return Err(res.error());
     }
-    auto increments = increments_result.value();
 
     // Simulate trajectory using exact discretization
     for (size_t i = 1; i <= num_steps; ++i) {
@@ -137,6 +202,19 @@ public:
     return Ok(std::make_pair(std::move(times), std::move(positions)));
   }
 
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(std::make_unique<OrnsteinUhlenbeckStepper>(
+        m_theta, m_mu, m_sigma, m_start_position, time_step)));
+  }
+
   /**
    * @brief Computes the theoretical mean at time t
    * @param t Time point
@@ -0,0 +1,580 @@
+/**
+ * @file resetting.cppm
+ * @brief Stochastic resetting of Brownian, Ornstein-Uhlenbeck, Lévy and Lévy
+ * walk processes
+ *
+ * Under resetting a process is returned to its starting position at the
+ * epochs of a renewal process, either Poisson with rate r or periodic with
+ * period 1/r, and then restarts afresh. Everything before the last reset is
+ * forgotten, so X(t) has the law of the free process at the age
+ * A(t) = t - (time of the last reset). For Poisson resetting
+ * A(t) = min(t, E) with E ~ Exp(r) by the memorylessness of the exponential
+ * law, and for periodic resetting A(t) = t mod (1/r); the endpoint therefore
+ * costs one free endpoint at time A(t), whatever the number of resets.
+ *
+ * The first passage time splits the same way: the epochs between resets are
+ * independent trials of the free process, and the first trial whose free
+ * path leaves the domain before it is reset ends the walk.
+ */
+
+module;
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <format>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.simulation.continuous.resetting;
+
+import diffusionx.error;
+import diffusionx.random.stable;
+import diffusionx.random.utils;
+import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
+import diffusionx.simulation.basic.utils;
+import diffusionx.simulation.continuous.bm;
+import diffusionx.simulation.continuous.levy;
+import diffusionx.simulation.continuous.levy_walk;
+import diffusionx.simulation.continuous.ou;
+
+using std::vector;
+
+/**
+ * @brief Exact sampler of a freshly restarted path of a process
+ *
+ * Specializations hold the state of one free path started at the reset
+ * position and provide:
+ * - `start()`, the reset position;
+ * - `restart(gen)`, which returns the path to the reset position;
+ * - `advance(h, gen)`, which moves the path forward by a time h >= 0 and
+ *   returns the new position, exactly in law for any h;
+ * - optionally `passage_time(domain, gen)`, an exact sample of the first
+ *   exit time of the free path, or None when not available for the domain.
+ *
+ * The primary template is empty, which makes `Resettable` false for other
+ * processes.
+ */
+template <typename P> struct ResetKernel {};
+
+template <> struct ResetKernel<Bm> {
+  double m_start;                           ///< Reset position
+  double m_two_d;                           ///< 2 D
+  double m_x;                               ///< Current position
+  std::normal_distribution<double> m_noise; ///< Standard normal noise
+
+  explicit ResetKernel(const Bm &process)
+      : m_start(process.get_start_position()),
+        m_two_d(2.0 * process.get_diffusion_coefficient()), m_x(m_start),
+        m_noise(0.0, 1.0) {}
+
+  [[nodiscard]] auto start() const -> double { return m_start; }
+
+  void restart(std::mt19937 & /*gen*/) { m_x = m_start; }
+
+  auto advance(double h, std::mt19937 &gen) -> double {
+    m_x += std::sqrt(m_two_d * h) * m_noise(gen);
+    return m_x;
+  }
+
+  /// Lévy-Smirnov: the hitting time of a level at distance d is d² / (2D Z²)
+  auto passage_time(double_pair domain, std::mt19937 &gen) -> Option<double> {
+    auto [a, b] = domain;
+    double distance = 0.0;
+    if (std::isinf(a)) {
+      distance = b - m_start;
+    } else if (std::isinf(b)) {
+      distance = m_start - a;
+    } else {
+      return std::nullopt;
+    }
+    double z = m_noise(gen);
+    return distance * distance / (m_two_d * z * z);
+  }
+};
+
+template <> struct ResetKernel<OrnsteinUhlenbeck> {
+  double m_start; ///< Reset position
+  double m_theta; ///< Mean reversion speed θ
+  double m_mu;    ///< Long-term mean μ
+  double m_sigma; ///< Volatility σ
+  double m_x;     ///< Current position
+  double m_h = -1.0;    ///< Time step of the cached coefficients
+  double m_decay = 0.0; ///< exp(-θ h)
+  double m_scale = 0.0; ///< σ √((1 - exp(-2θh)) / (2θ))
+  std::normal_distribution<double> m_noise; ///< Standard normal noise
+
+  explicit ResetKernel(const OrnsteinUhlenbeck &process)
+      : m_start(process.get_start_position()), m_theta(process.get_theta()),
+        m_mu(process.get_mu()), m_sigma(process.get_sigma()), m_x(m_start),
+        m_noise(0.0, 1.0) {}
+
+  [[nodiscard]] auto start() const -> double { return m_start; }
+
+  void restart(std::mt19937 & /*gen*/) { m_x = m_start; }
+
+  auto advance(double h, std::mt19937 &gen) -> double {
+    if (h != m_h) {
+      m_h = h;
+      m_decay = std::exp(-m_theta * h);
+      m_scale = m_sigma * std::sqrt(-std::expm1(-2.0 * m_theta * h) /
+                                    (2.0 * m_theta));
+    }
+    m_x = m_mu + ((m_x - m_mu) * m_decay) + (m_scale * m_noise(gen));
+    return m_x;
+  }
+};
+
+template <> struct ResetKernel<Levy> {
+  double m_start; ///< Reset position
+  double m_alpha; ///< Stability parameter α
+  double m_beta;  ///< Skewness parameter β
+  double m_sigma; ///< Scale parameter σ
+  double m_mu;    ///< Location parameter μ
+  double m_x;     ///< Current position
+
+  explicit ResetKernel(const Levy &process)
+      : m_start(process.get_start_position()), m_alpha(process.get_alpha()),
+        m_beta(process.get_beta()), m_sigma(process.get_sigma()),
+        m_mu(process.get_mu()), m_x(m_start) {}
+
+  [[nodiscard]] auto start() const -> double { return m_start; }
+
+  void restart(std::mt19937 & /*gen*/) { m_x = m_start; }
+
+  auto advance(double h, std::mt19937 & /*gen*/) -> double {
+    if (h > 0) {
+      m_x += rand_stable(m_alpha, m_beta, m_sigma * std::pow(h, 1.0 / m_alpha),
+                         m_mu * h)
+                 .value();
+    }
+    return m_x;
+  }
+};
+
+template <> struct ResetKernel<LevyWalk> {
+  double m_start;    ///< Reset position
+  double m_alpha;    ///< Flight time exponent α
+  double m_velocity; ///< Speed
+  double m_x;        ///< Current position
+  double m_flight_left = 0.0; ///< Remaining time of the current flight
+  double m_direction = 1.0;   ///< Direction of the current flight (±1)
+  std::uniform_real_distribution<double> m_uniform; ///< U(0, 1)
+
+  explicit ResetKernel(const LevyWalk &process)
+      : m_start(process.get_start_position()), m_alpha(process.get_alpha()),
+        m_velocity(process.get_velocity()), m_x(m_start), m_uniform(0.0, 1.0) {
+  }
+
+  void new_flight(std::mt19937 &gen) {
+    m_flight_left = std::pow(1.0 - m_uniform(gen), -1.0 / m_alpha) - 1.0;
+    m_direction = m_uniform(gen) < 0.5 ? -1.0 : 1.0;
+  }
+
+  [[nodiscard]] auto start() const -> double { return m_start; }
+
+  /// A reset also ends the current flight
+  void restart(std::mt19937 &gen) {
+    m_x = m_start;
+    new_flight(gen);
+  }
+
+  auto advance(double h, std::mt19937 &gen) -> double {
+    while (h > m_flight_left) {
+      m_x += m_direction * m_velocity * m_flight_left;
+      h -= m_flight_left;
+      new_flight(gen);
+    }
+    m_x += m_direction * m_velocity * h;
+    m_flight_left -= h;
+    return m_x;
+  }
+};
+
+/**
+ * @brief Processes that `Resetting` supports: `Bm`, `OrnsteinUhlenbeck`,
+ * `Levy` and `LevyWalk`
+ */
+export template <typename P>
+concept Resettable = std::constructible_from<ResetKernel<P>, const P &>;
+
+/**
+ * @brief Renewal process of the reset epochs
+ */
+export enum class ResetProtocol {
+  Poisson,  ///< Exponential intervals with mean 1 / rate
+  Periodic, ///< Resets at the multiples of 1 / rate
+};
+
+/**
+ * @brief Draws the interval until the next reset
+ * @param protocol The renewal process
+ * @param rate The reset rate r
+ * @param gen The random number generator
+ * @return An Exp(r) variate, or 1 / r for periodic resetting
+ */
+auto next_reset_interval(ResetProtocol protocol, double rate,
+                         std::mt19937 &gen) -> double {
+  if (protocol == ResetProtocol::Periodic) {
+    return 1.0 / rate;
+  }
+  return std::exponential_distribution<double>(rate)(gen);
+}
+
+/**
+ * @brief Stepper of a process under resetting
+ * @tparam P The reset process
+ *
+ * Each grid step is cut at the reset epochs that fall inside it; the part
+ * after the last reset is sampled from the restarted free path, so every
+ * grid point has the exact law of the reset process.
+ */
+export template <Resettable P> class ResettingStepper final : public Stepper {
+  ResetKernel<P> m_kernel;          ///< Free path since the last reset
+  ResetProtocol m_protocol;         ///< Renewal process of the resets
+  double m_rate;                    ///< Reset rate r
+  double m_until_reset;             ///< Time left until the next reset
+  std::mt19937 m_gen = generator(); ///< Random number generator
+
+  auto walk(double duration) -> double {
+    while (m_until_reset <= duration) {
+      duration -= m_until_reset;
+      m_kernel.restart(m_gen);
+      m_until_reset = next_reset_interval(m_protocol, m_rate, m_gen);
+    }
+    m_until_reset -= duration;
+    return m_kernel.advance(duration, m_gen);
+  }
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    double dt = get_time_step();
+    for (auto &position : positions) {
+      position = walk(dt);
+    }
+    m_position = positions.back();
+  }
+
+  auto step_partial(double time_step) -> double override {
+    m_position = walk(time_step);
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param process The process to reset
+   * @param rate The reset rate (must be positive)
+   * @param protocol The renewal process of the resets
+   * @param time_step The time step of the grid (must be positive)
+   */
+  ResettingStepper(const P &process, double rate, ResetProtocol protocol,
+                   double time_step)
+      : Stepper(process.get_start_position(), time_step), m_kernel(process),
+        m_protocol(protocol), m_rate(rate) {
+    m_kernel.restart(m_gen);
+    m_until_reset = next_reset_interval(m_protocol, m_rate, m_gen);
+  }
+};
+
+/**
+ * @brief A process reset to its starting position at a constant rate
+ * @tparam P The process, one of `Bm`, `OrnsteinUhlenbeck`, `Levy` and
+ * `LevyWalk`
+ *
+ * Endpoints, and through `displacement` the inherited moments, cost O(1)
+ * free samples per particle (O(flights) for the Lévy walk) independent of
+ * the time step. With Poisson resetting a Brownian motion reaches the
+ * non-equilibrium steady state p(x) = (α0 / 2) exp(-α0 |x - x0|),
+ * α0 = √(r / D), and has the finite mean first passage time
+ * (exp(α0 L) - 1) / r to a target at distance L.
+ */
+export template <Resettable P> class Resetting : public ContinuousProcess {
+  P m_process;              ///< The free process
+  double m_rate = 1.0;      ///< Reset rate r
+  ResetProtocol m_protocol; ///< Renewal process of the resets
+
+public:
+  /**
+   * @brief Constructor
+   * @param process The free process, reset to its starting position
+   * @param rate The reset rate r: the Poisson rate, or the inverse period
+   * @param protocol The renewal process of the resets
+   * @throws std::invalid_argument if rate is not positive and finite
+   */
+  Resetting(P process, double rate,
+            ResetProtocol protocol = ResetProtocol::Poisson)
+      : m_process(std::move(process)), m_rate(rate), m_protocol(protocol) {
+    if (!(rate > 0) || !std::isfinite(rate)) {
+      throw std::invalid_argument(std::format(
+          "The reset rate must be positive and finite, but got {}", rate));
+    }
+  }
+
+  /**
+   * @brief Gets the free process
+   * @return The process between resets
+   */
+  [[nodiscard]] auto get_process() const -> const P & { return m_process; }
+
+  /**
+   * @brief Gets the reset rate
+   * @return The rate r
+   */
+  [[nodiscard]] auto get_rate() const -> double { return m_rate; }
+
+  /**
+   * @brief Gets the renewal process of the resets
+   * @return The reset protocol
+   */
+  [[nodiscard]] auto get_protocol() const -> ResetProtocol {
+    return m_protocol;
+  }
+
+  double start() override { return m_process.get_start_position(); }
+
+  /**
+   * @brief Samples the time since the last reset
+   * @param t The time (non-negative)
+   * @param gen The random number generator
+   * @return A(t), equal to t if there was no reset before t
+   */
+  [[nodiscard]] auto sample_age(double t, std::mt19937 &gen) const -> double {
+    if (m_protocol == ResetProtocol::Periodic) {
+      double period = 1.0 / m_rate;
+      return t - (std::floor(t / period) * period);
+    }
+    return std::min(t, std::exponential_distribution<double>(m_rate)(gen));
+  }
+
+  /**
+   * @brief Samples the position at a given time
+   * @param duration The time (must be positive)
+   * @return Result containing X(duration), or an Error
+   */
+  auto endpoint(double duration) const -> Result<double> {
+    if (duration <= 0) {
+      return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    thread_local static std::mt19937 gen = generator();
+    ResetKernel<P> kernel(m_process);
+    kernel.restart(gen);
+    return Ok(kernel.advance(sample_age(duration, gen), gen));
+  }
+
+  /**
+   * @brief Samples the positions of independent particles at a given time
+   * @param duration The time (must be positive)
+   * @param particles The number of particles
+   * @return Result containing the positions X(duration), or an Error
+   */
+  auto endpoints(double duration, size_t particles) const
+      -> Result<vector<double>> {
+    if (duration <= 0) {
+      return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    vector<double> result(particles);
+    run_placed(particles, default_workers(), [&](size_t begin, size_t end) {
+      thread_local static std::mt19937 gen = generator();
+      ResetKernel<P> kernel(m_process);
+      for (size_t i = begin; i < end; ++i) {
+        kernel.restart(gen);
+        result[i] = kernel.advance(sample_age(duration, gen), gen);
+      }
+    });
+    return Ok(std::move(result));
+  }
+
+  /**
+   * @brief Samples the displacement from the starting position
+   * @param duration The time (must be positive)
+   * @param time_step Unused, the endpoint is exact
+   * @return Result containing X(duration) - X(0), or an Error
+   */
+  Result<double> displacement(double duration,
+                              double /*time_step*/ = 0.01) override {
+    auto x = endpoint(duration);
+    if (!x) {
+      return Err(x.error());
+    }
+    return Ok(x.value() - m_process.get_start_position());
+  }
+
+  /**
+   * @brief Simulates a trajectory of the reset process
+   * @param duration The total simulation time
+   * @param time_step The time step for discretization
+   * @return Result containing time and position vectors, or an Error
+   *
+   * The output holds the grid points k * time_step, the end point at
+   * duration and, merged in time order, one point per reset at the reset
+   * epoch with the reset position. Every point has the exact law of the
+   * reset process.
+   */
+  Result<vec_pair> simulate(double duration, double time_step = 0.01) override {
+    if (duration <= 0) {
+      return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    thread_local static std::mt19937 gen = generator();
+    auto num_steps = static_cast<size_t>(std::ceil(duration / time_step));
+    vector<double> times;
+    vector<double> positions;
+    times.reserve(num_steps + 1);
+    positions.reserve(num_steps + 1);
+    ResetKernel<P> kernel(m_process);
+    kernel.restart(gen);
+    times.push_back(0.0);
+    positions.push_back(kernel.start());
+    double t = 0.0;
+    double next_reset = next_reset_interval(m_protocol, m_rate, gen);
+    for (size_t i = 1; i <= num_steps; ++i) {
+      double target = i == num_steps ? duration
+                                     : static_cast<double>(i) * time_step;
+      while (next_reset <= target) {
+        kernel.advance(next_reset - t, gen);
+        kernel.restart(gen);
+        t = next_reset;
+        times.push_back(t);
+        positions.push_back(kernel.start());
+        next_reset += next_reset_interval(m_protocol, m_rate, gen);
+      }
+      double x = kernel.advance(target - t, gen);
+      t = target;
+      if (times.back() == t) {
+        positions.back() = x;
+      } else {
+        times.push_back(t);
+        positions.push_back(x);
+      }
+    }
+    return Ok(std::make_pair(std::move(times), std::move(positions)));
+  }
+
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(std::make_unique<ResettingStepper<P>>(
+        m_process, m_rate, m_protocol, time_step)));
+  }
+
+  /**
+   * @brief Samples first passage times out of a domain under resetting
+   * @param domain The interval (a, b) containing the starting position; a
+   * may be -∞ or b +∞ for a single target
+   * @param particles The number of particles
+   * @param max_duration The maximum simulated time
+   * @param time_step The time step for discretization
+   * @return Result containing, per particle, the first time X ∉ (a, b), or
+   *         None if the particle was still inside at max_duration
+   *
+   * The walk is split at the reset epochs into independent trials of the
+   * free process. A trial samples the exact free exit time when the
+   * process provides one (`Bm` with a single target), so such passage
+   * times are exact and cost O(number of resets); otherwise the free path
+   * is stepped on the grid, with the last step of each trial cut at the
+   * reset epoch.
+   */
+  [[nodiscard]] auto first_passage_times(double_pair domain, size_t particles,
+                                         double max_duration,
+                                         double time_step = 0.01) const
+      -> Result<vector<Option<double>>> {
+    auto [a, b] = domain;
+    double x0 = m_process.get_start_position();
+    if (!(a < x0 && x0 < b)) {
+      return Err(Error::InvalidArgument(std::format(
+          "The domain ({}, {}) must contain the starting position {}", a, b,
+          x0)));
+    }
+    if (max_duration <= 0 || time_step <= 0) {
+      return Err(Error::InvalidArgument(
+          "Maximum duration and time step must be positive"));
+    }
+    vector<Option<double>> result(particles);
+    run_placed(particles, default_workers(), [&](size_t begin, size_t end) {
+      thread_local static std::mt19937 gen = generator();
+      ResetKernel<P> kernel(m_process);
+      for (size_t i = begin; i < end; ++i) {
+        double elapsed = 0.0;
+        while (elapsed < max_duration) {
+          double trial = std::min(next_reset_interval(m_protocol, m_rate, gen),
+                                  max_duration - elapsed);
+          kernel.restart(gen);
+          Option<double> exit;
+          bool exact = false;
+          if constexpr (requires { kernel.passage_time(domain, gen); }) {
+            if (auto tau = kernel.passage_time(domain, gen)) {
+              exact = true;
+              if (*tau <= trial) {
+                exit = *tau;
+              }
+            }
+          }
+          if (!exact) {
+            for (double t = 0.0; t < trial;) {
+              double h = std::min(time_step, trial - t);
+              double x = kernel.advance(h, gen);
+              t += h;
+              if (!(x > a && x < b)) {
+                exit = t;
+                break;
+              }
+            }
+          }
+          if (exit) {
+            result[i] = elapsed + *exit;
+            break;
+          }
+          elapsed += trial;
+        }
+      }
+    });
+    return Ok(std::move(result));
+  }
+
+  /**
+   * @brief Computes the mean first passage time under resetting
+   * @param domain The interval (a, b) containing the starting position
+   * @param particles The number of particles
+   * @param max_duration The maximum simulated time
+   * @param time_step The time step for discretization
+   * @return Result containing the mean over particles that exited, or None
+   * if none did, or an Error
+   */
+  [[nodiscard]] auto mean_first_passage_time(double_pair domain,
+                                             size_t particles,
+                                             double max_duration,
+                                             double time_step = 0.01) const
+      -> Result<Option<double>> {
+    auto times = first_passage_times(domain, particles, max_duration,
+                                     time_step);
+    if (!times) {
+      return Err(times.error());
+    }
+    double sum = 0.0;
+    size_t count = 0;
+    for (const auto &tau : times.value()) {
+      if (tau) {
+        sum += *tau;
+        ++count;
+      }
+    }
+    if (count == 0) {
+      return Ok(Option<double>(std::nullopt));
+    }
+    return Ok(Option<double>(sum / static_cast<double>(count)));
+  }
+};
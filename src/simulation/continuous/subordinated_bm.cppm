@@ -0,0 +1,502 @@
+/**
+ * @file subordinated_bm.cppm
+ * @brief Brownian motion run with a Lévy subordinator clock
+ *
+ * X(t) = x0 + μt + θS(t) + σW(S(t)), where S is a subordinator independent
+ * of the Brownian motion W. Given an increment s of the clock, the
+ * increment of X is exactly normal with mean μdt + θs and variance σ²s, so
+ * paths, end points and values at arbitrary times are sampled without
+ * discretization error. Two choices of clock are provided:
+ *
+ * - `VarianceGamma`: gamma clock, the variance-gamma (VG) process
+ * - `NormalInverseGaussian`: inverse Gaussian clock, the NIG process
+ */
+
+module;
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.simulation.continuous.subordinated_bm;
+
+import diffusionx.error;
+import diffusionx.memory;
+import diffusionx.random.inverse_gaussian;
+import diffusionx.random.utils;
+import diffusionx.simulation.basic.abstract;
+import diffusionx.simulation.basic.stepper;
+import diffusionx.simulation.basic.utils;
+
+using std::vector;
+
+/**
+ * @brief Base class of Brownian motions subordinated to a Lévy clock
+ *
+ * Derived classes provide the clock increments and the cumulants per unit
+ * time, from which the closed-form moments follow.
+ */
+export class SubordinatedBm : public ContinuousProcess {
+protected:
+  double m_start_position = 0.0; ///< Initial position x0
+  double m_drift = 0.0;          ///< Drift μ in calendar time
+  double m_skew = 0.0;           ///< Drift θ in clock time
+  double m_sigma = 1.0;          ///< Volatility σ in clock time
+
+public:
+  /**
+   * @brief Constructor
+   * @param start_position Initial position x0
+   * @param drift Drift μ in calendar time
+   * @param skew Drift θ in clock time
+   * @param sigma Volatility σ in clock time (must be positive)
+   * @throws std::invalid_argument if sigma is not positive
+   */
+  SubordinatedBm(double start_position, double drift, double skew, double sigma)
+      : m_start_position(start_position), m_drift(drift), m_skew(skew),
+        m_sigma(sigma) {
+    if (!(sigma > 0)) {
+      throw std::invalid_argument("Volatility sigma must be positive");
+    }
+  }
+
+  /**
+   * @brief Fills a buffer with independent clock increments
+   * @param out The output buffer
+   * @param time_step The calendar time of each increment
+   * @param gen The random number generator
+   */
+  virtual void fill_clock(std::span<double> out, double time_step,
+                          std::mt19937 &gen) const = 0;
+
+  /**
+   * @brief Gets a cumulant of X(1) - X(0)
+   * @param order The order, from 1 to 4
+   * @return The cumulant per unit time
+   */
+  [[nodiscard]] virtual auto cumulant(int order) const -> double = 0;
+
+  /**
+   * @brief Fills a buffer with independent increments of X
+   * @param out The output buffer
+   * @param time_step The calendar time of each increment
+   * @param gen The random number generator
+   */
+  void fill_increments(std::span<double> out, double time_step,
+                       std::mt19937 &gen) const {
+    fill_clock(out, time_step, gen);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    double shift = m_drift * time_step;
+    for (auto &x : out) {
+      double s = x;
+      x = shift + m_skew * s + m_sigma * std::sqrt(s) * normal(gen);
+    }
+  }
+
+  /**
+   * @brief Gets the initial position
+   * @return The initial position x0
+   */
+  [[nodiscard]] auto get_start_position() const -> double {
+    return m_start_position;
+  }
+
+  double start() override { return m_start_position; }
+
+  /**
+   * @brief Simulates a trajectory
+   * @param duration The total simulation time
+   * @param time_step The time step of the output grid
+   * @return Result containing time and position vectors, or an Error
+   *
+   * The increments are exact, the last one covering the remainder of the
+   * duration. A remainder shorter than `step_tolerance` time steps is
+   * merged into the previous step.
+   */
+  Result<vec_pair> simulate(double duration, double time_step = 0.01) override {
+    if (duration <= 0) {
+      return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    thread_local static std::mt19937 gen = generator();
+    auto num_steps = count_steps(duration, time_step);
+    vector<double> times(num_steps + 1);
+    vector<double> positions(num_steps + 1);
+    times[0] = 0.0;
+    positions[0] = m_start_position;
+    fill_increments(std::span(positions).subspan(1, num_steps - 1), time_step,
+                    gen);
+    double last_step = duration - static_cast<double>(num_steps - 1) * time_step;
+    fill_increments(std::span(positions).subspan(num_steps, 1), last_step, gen);
+    for (size_t i = 1; i <= num_steps; ++i) {
+      times[i] = i < num_steps ? static_cast<double>(i) * time_step : duration;
+      positions[i] += positions[i - 1];
+    }
+    return Ok(std::make_pair(std::move(times), std::move(positions)));
+  }
+
+  /**
+   * @brief Samples the displacement X(duration) - X(0) exactly
+   * @param duration The time
+   * @param time_step Unused, the displacement is a single exact draw
+   * @return Result containing the displacement, or an Error
+   */
+  Result<double> displacement(double duration, double time_step = 0.01) override {
+    if (duration <= 0) {
+      return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    thread_local static std::mt19937 gen = generator();
+    double x = 0.0;
+    fill_increments(std::span(&x, 1), duration, gen);
+    return Ok(x);
+  }
+
+  /**
+   * @brief Samples X(duration) of many independent paths in parallel
+   * @param duration The time
+   * @param particles The number of paths
+   * @return Result containing the end points, or an Error
+   */
+  [[nodiscard]] auto endpoints(double duration, size_t particles) const
+      -> Result<vector<double>> {
+    if (duration <= 0) {
+      return Err(Error::InvalidArgument("Duration must be positive"));
+    }
+    vector<double> result(particles);
+    run_placed(particles, default_workers(),
+               [this, &result, duration](size_t begin, size_t end) {
+                 thread_local static std::mt19937 gen = generator();
+                 auto out = std::span(result).subspan(begin, end - begin);
+                 fill_increments(out, duration, gen);
+                 for (auto &x : out) {
+                   x += m_start_position;
+                 }
+               });
+    return Ok(std::move(result));
+  }
+
+  /**
+   * @brief Samples one path at the given times
+   * @param times Non-negative, non-decreasing times
+   * @return Result containing X at every time, or an Error
+   */
+  [[nodiscard]] auto sample_at(const vector<double> &times) const
+      -> Result<vector<double>> {
+    for (size_t i = 0; i < times.size(); ++i) {
+      if (!(times[i] >= 0) || (i > 0 && times[i] < times[i - 1])) {
+        return Err(Error::InvalidArgument(
+            "Times must be non-negative and non-decreasing"));
+      }
+    }
+    thread_local static std::mt19937 gen = generator();
+    vector<double> result(times.size());
+    double t = 0.0;
+    double x = m_start_position;
+    for (size_t i = 0; i < times.size(); ++i) {
+      if (times[i] > t) {
+        double dx = 0.0;
+        fill_increments(std::span(&dx, 1), times[i] - t, gen);
+        x += dx;
+        t = times[i];
+      }
+      result[i] = x;
+    }
+    return Ok(std::move(result));
+  }
+
+  /**
+   * @brief Computes the theoretical mean at time t
+   * @param t Time point
+   * @return The theoretical mean E[X(t)]
+   */
+  [[nodiscard]] auto theoretical_mean(double t) const -> double {
+    return m_start_position + cumulant(1) * t;
+  }
+
+  /**
+   * @brief Computes the theoretical variance at time t
+   * @param t Time point
+   * @return The theoretical variance Var[X(t)]
+   */
+  [[nodiscard]] auto theoretical_variance(double t) const -> double {
+    return cumulant(2) * t;
+  }
+
+  /**
+   * @brief Computes a theoretical central moment at time t
+   * @param t Time point
+   * @param order The order, from 0 to 4
+   * @return Result containing E[(X(t) - E[X(t)])^order], or an Error
+   */
+  [[nodiscard]] auto theoretical_central_moment(double t, int order) const
+      -> Result<double> {
+    switch (order) {
+    case 0:
+      return Ok(1.0);
+    case 1:
+      return Ok(0.0);
+    case 2:
+      return Ok(cumulant(2) * t);
+    case 3:
+      return Ok(cumulant(3) * t);
+    case 4:
+      return Ok(cumulant(4) * t + 3.0 * std::pow(cumulant(2) * t, 2));
+    default:
+      return Err(Error::InvalidArgument(
+          std::format("The order must be in [0, 4], but got {}", order)));
+    }
+  }
+};
+
+/**
+ * @brief Stepper generating a subordinated Brownian motion path block by block
+ * @tparam P The process type, copied into the stepper
+ */
+export template <typename P>
+class SubordinatedBmStepper final : public Stepper {
+  P m_process;                      ///< The process
+  std::mt19937 m_gen = generator(); ///< Random number generator
+
+protected:
+  void step_positions(std::span<double> positions) override {
+    m_process.fill_increments(positions, get_time_step(), m_gen);
+    double x = m_position;
+    for (auto &position : positions) {
+      x += position;
+      position = x;
+    }
+    m_position = x;
+  }
+
+  auto step_partial(double time_step) -> double override {
+    if (time_step <= 0) {
+      return m_position;
+    }
+    double increment = 0.0;
+    m_process.fill_increments(std::span(&increment, 1), time_step, m_gen);
+    m_position += increment;
+    return m_position;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param process The process
+   * @param time_step The time step of the grid (must be positive)
+   */
+  SubordinatedBmStepper(P process, double time_step)
+      : Stepper(process.get_start_position(), time_step),
+        m_process(std::move(process)) {}
+};
+
+/**
+ * @brief Variance-gamma process
+ *
+ * X(t) = x0 + θG(t) + σW(G(t)), where G is a gamma process with
+ * E[G(t)] = t and Var[G(t)] = νt, i.e. G(t + dt) - G(t) ~ Gamma(dt/ν, ν).
+ *
+ * Cumulants per unit time:
+ * - κ1 = θ
+ * - κ2 = σ² + θ²ν
+ * - κ3 = 2θ³ν² + 3σ²θν
+ * - κ4 = 3σ⁴ν + 12σ²θ²ν² + 6θ⁴ν³
+ */
+export class VarianceGamma : public SubordinatedBm {
+  double m_nu = 1.0; ///< Variance rate ν of the gamma clock
+
+public:
+  /**
+   * @brief Default constructor, σ = 1, ν = 1, θ = 0
+   */
+  VarianceGamma() : SubordinatedBm(0.0, 0.0, 0.0, 1.0) {}
+
+  /**
+   * @brief Constructs a variance-gamma process
+   * @param sigma Volatility σ (must be positive)
+   * @param nu Variance rate ν of the gamma clock (must be positive)
+   * @param theta Drift θ in clock time
+   * @param start_position Initial position
+   * @throws std::invalid_argument if sigma or nu is not positive
+   */
+  VarianceGamma(double sigma, double nu, double theta,
+                double start_position = 0.0)
+      : SubordinatedBm(start_position, 0.0, theta, sigma), m_nu(nu) {
+    if (!(nu > 0)) {
+      throw std::invalid_argument("Variance rate nu must be positive");
+    }
+  }
+
+  /**
+   * @brief Gets the volatility
+   * @return The volatility σ
+   */
+  [[nodiscard]] auto get_sigma() const -> double { return m_sigma; }
+
+  /**
+   * @brief Gets the variance rate of the gamma clock
+   * @return The variance rate ν
+   */
+  [[nodiscard]] auto get_nu() const -> double { return m_nu; }
+
+  /**
+   * @brief Gets the drift in clock time
+   * @return The drift θ
+   */
+  [[nodiscard]] auto get_theta() const -> double { return m_skew; }
+
+  void fill_clock(std::span<double> out, double time_step,
+                  std::mt19937 &gen) const override {
+    std::gamma_distribution<double> gamma(time_step / m_nu, m_nu);
+    for (auto &s : out) {
+      s = gamma(gen);
+    }
+  }
+
+  [[nodiscard]] auto cumulant(int order) const -> double override {
+    double s2 = m_sigma * m_sigma;
+    double th = m_skew;
+    switch (order) {
+    case 1:
+      return th;
+    case 2:
+      return s2 + th * th * m_nu;
+    case 3:
+      return 2.0 * th * th * th * m_nu * m_nu + 3.0 * s2 * th * m_nu;
+    case 4:
+      return 3.0 * s2 * s2 * m_nu + 12.0 * s2 * th * th * m_nu * m_nu +
+             6.0 * std::pow(th, 4) * std::pow(m_nu, 3);
+    default:
+      return 0.0;
+    }
+  }
+
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(
+        std::make_unique<SubordinatedBmStepper<VarianceGamma>>(*this,
+                                                               time_step)));
+  }
+};
+
+/**
+ * @brief Normal-inverse-Gaussian process
+ *
+ * X(t) = x0 + μt + βI(t) + W(I(t)), where I is an inverse Gaussian clock
+ * with I(t + dt) - I(t) ~ IG(δdt/γ, δ²dt²) and γ = √(α² - β²).
+ *
+ * Cumulants per unit time:
+ * - κ1 = μ + δβ/γ
+ * - κ2 = δα²/γ³
+ * - κ3 = 3δβα²/γ⁵
+ * - κ4 = 3δα²(α² + 4β²)/γ⁷
+ */
+export class NormalInverseGaussian : public SubordinatedBm {
+  double m_alpha = 1.0; ///< Tail heaviness α
+  double m_delta = 1.0; ///< Scale δ
+  double m_gamma = 1.0; ///< √(α² - β²)
+
+public:
+  /**
+   * @brief Default constructor, α = 1, β = 0, δ = 1, μ = 0
+   */
+  NormalInverseGaussian() : SubordinatedBm(0.0, 0.0, 0.0, 1.0) {}
+
+  /**
+   * @brief Constructs a normal-inverse-Gaussian process
+   * @param alpha Tail heaviness α (must exceed |β|)
+   * @param beta Asymmetry β
+   * @param delta Scale δ (must be positive)
+   * @param mu Drift μ
+   * @param start_position Initial position
+   * @throws std::invalid_argument if α <= |β| or δ <= 0
+   */
+  NormalInverseGaussian(double alpha, double beta, double delta,
+                        double mu = 0.0, double start_position = 0.0)
+      : SubordinatedBm(start_position, mu, beta, 1.0), m_alpha(alpha),
+        m_delta(delta) {
+    if (!(alpha > std::abs(beta))) {
+      throw std::invalid_argument(std::format(
+          "alpha must exceed |beta|, but got alpha = {}, beta = {}", alpha,
+          beta));
+    }
+    if (!(delta > 0)) {
+      throw std::invalid_argument("Scale delta must be positive");
+    }
+    m_gamma = std::sqrt(alpha * alpha - beta * beta);
+  }
+
+  /**
+   * @brief Gets the tail heaviness
+   * @return The parameter α
+   */
+  [[nodiscard]] auto get_alpha() const -> double { return m_alpha; }
+
+  /**
+   * @brief Gets the asymmetry
+   * @return The parameter β
+   */
+  [[nodiscard]] auto get_beta() const -> double { return m_skew; }
+
+  /**
+   * @brief Gets the scale
+   * @return The parameter δ
+   */
+  [[nodiscard]] auto get_delta() const -> double { return m_delta; }
+
+  /**
+   * @brief Gets the drift
+   * @return The drift μ
+   */
+  [[nodiscard]] auto get_mu() const -> double { return m_drift; }
+
+  void fill_clock(std::span<double> out, double time_step,
+                  std::mt19937 &gen) const override {
+    double scale = m_delta * time_step;
+    fill_inverse_gaussian(out, scale / m_gamma, scale * scale, gen);
+  }
+
+  [[nodiscard]] auto cumulant(int order) const -> double override {
+    double a2 = m_alpha * m_alpha;
+    double b = m_skew;
+    switch (order) {
+    case 1:
+      return m_drift + m_delta * b / m_gamma;
+    case 2:
+      return m_delta * a2 / std::pow(m_gamma, 3);
+    case 3:
+      return 3.0 * m_delta * b * a2 / std::pow(m_gamma, 5);
+    case 4:
+      return 3.0 * m_delta * a2 * (a2 + 4.0 * b * b) / std::pow(m_gamma, 7);
+    default:
+      return 0.0;
+    }
+  }
+
+  /**
+   * @brief Creates a stepper that generates the path block by block
+   * @param time_step The time step for discretization
+   * @return Result containing the stepper, or an Error
+   */
+  Result<std::unique_ptr<Stepper>> stepper(double time_step = 0.01) override {
+    if (time_step <= 0) {
+      return Err(Error::InvalidArgument("Time step must be positive"));
+    }
+    return Ok(std::unique_ptr<Stepper>(
+        std::make_unique<SubordinatedBmStepper<NormalInverseGaussian>>(
+            *this, time_step)));
+  }
+};
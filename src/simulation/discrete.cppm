@@ -7,4 +7,9 @@
 
 export module diffusionx.simulation.discrete;
 
-export import diffusionx.simulation.discrete.random_walk; 
\ No newline at end of file
+export import diffusionx.simulation.discrete.exclusion;
+export import diffusionx.simulation.discrete.graph;
+export import diffusionx.simulation.discrete.lattice;
+export import diffusionx.simulation.discrete.multispin;
+export import diffusionx.simulation.discrete.random_walk;
+export import diffusionx.simulation.discrete.trap; 
\ No newline at end of file
@@ -0,0 +1,463 @@
+/**
+ * @file exclusion.cppm
+ * @brief Simple exclusion processes (SSEP, ASEP, TASEP) on a ring
+ *
+ * Particles hop between nearest-neighbour sites of a ring of L sites, at
+ * most one particle per site. The occupation numbers are stored as a bitset,
+ * so systems of 10^7 sites fit in cache-friendly 1.25 MB. Time is measured in
+ * sweeps: one sweep is L random bond updates, so an isolated particle hops
+ * at total rate 1 (rate p to the right, 1 - p to the left).
+ *
+ * Single-file motion preserves the order of the particles, which makes the
+ * tagged-particle displacement subdiffusive (MSD ~ t^{1/2} for the SSEP).
+ * Tagged trajectories are returned as `discrete_pair`, ready for the TAMSD
+ * functions and the `DiscreteProcess` moments.
+ */
+
+module;
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+export module diffusionx.simulation.discrete.exclusion;
+
+import diffusionx.error;
+import diffusionx.random.utils;
+import diffusionx.simulation.basic.abstract;
+
+using std::vector;
+
+/**
+ * @brief Draws an index in [0, n) and a uniform word from one random word
+ * @param word A uniformly random 64-bit word
+ * @param n The number of indices
+ * @return The index (high half of word * n) and the low half of the product,
+ * which is uniform given the index up to O(n / 2^64)
+ */
+auto exclusion_split(uint64_t word, uint64_t n) -> std::pair<size_t, uint64_t> {
+  auto product = static_cast<unsigned __int128>(word) * n;
+  return {static_cast<size_t>(product >> 64), static_cast<uint64_t>(product)};
+}
+
+/**
+ * @brief Exclusion process on a ring with tagged particles
+ *
+ * Every bond (i, i + 1 mod L) is updated at rate 1: if exactly one of its
+ * sites is occupied, the particle hops across the bond with probability p
+ * when moving right and 1 - p when moving left. p = 1/2 gives the SSEP and
+ * p = 1 the TASEP.
+ *
+ * `sweep(num_workers)` with one worker performs random-sequential updates.
+ * With more workers the ring is cut into contiguous domains of whole 64-bit
+ * words, one per worker, which are updated concurrently; the bond leaving
+ * each domain is the only one shared with a neighbour, so its updates are
+ * deferred to a short serial pass after the domains finish. The domain
+ * boundaries are shifted by a random offset every sweep so that no bond is
+ * systematically treated differently.
+ */
+export class ExclusionProcess {
+  size_t m_num_sites;           ///< Number of sites L of the ring
+  size_t m_num_particles;       ///< Number of particles
+  double m_forward_probability; ///< Probability p of a hop to the right
+  vector<uint64_t> m_occupied;  ///< Occupation bitset
+  vector<uint64_t> m_tagged;    ///< Bitset of the sites holding a tagged particle
+  vector<size_t> m_tag_sites;   ///< Current site of each tagged particle
+  vector<int64_t> m_tag_displacements; ///< Unwrapped displacement of each tagged particle
+  size_t m_time = 0;            ///< Number of sweeps performed
+  std::mt19937_64 m_gen;        ///< Generator of the serial parts
+  vector<std::mt19937_64> m_worker_gens; ///< Generators of the domain workers
+
+  [[nodiscard]] static auto test(const vector<uint64_t> &bits, size_t site)
+      -> bool {
+    return ((bits[site >> 6] >> (site & 63)) & 1) != 0;
+  }
+
+  static void flip(vector<uint64_t> &bits, size_t site) {
+    bits[site >> 6] ^= uint64_t{1} << (site & 63);
+  }
+
+  /**
+   * @brief Updates the bond (site, next)
+   * @param site Left site of the bond
+   * @param next Right site of the bond, site + 1 mod L
+   * @param uniform Uniform random word deciding the direction
+   * @param move_tag Called as move_tag(from, to, delta) when a tagged
+   * particle hops
+   */
+  template <typename F>
+  void update_bond(size_t site, size_t next, uint64_t uniform, F &&move_tag) {
+    uint64_t left = (m_occupied[site >> 6] >> (site & 63)) & 1;
+    uint64_t right = (m_occupied[next >> 6] >> (next & 63)) & 1;
+    bool forward =
+        static_cast<double>(uniform >> 11) * 0x1.0p-53 < m_forward_probability;
+    // Branch-free: a particle hops iff the bond holds one particle and the
+    // drawn direction points away from it (10 and forward, 01 and backward)
+    uint64_t hop = (left ^ right) & (forward ? left : right);
+    m_occupied[site >> 6] ^= hop << (site & 63);
+    m_occupied[next >> 6] ^= hop << (next & 63);
+    size_t from = left != 0 ? site : next;
+    if ((hop & (m_tagged[from >> 6] >> (from & 63))) != 0) {
+      size_t to = left != 0 ? next : site;
+      flip(m_tagged, from);
+      flip(m_tagged, to);
+      move_tag(from, to, left != 0 ? 1 : -1);
+    }
+  }
+
+  /**
+   * @brief Moves a tagged particle
+   *
+   * Particles never overtake each other, so m_tag_sites stays sorted up to
+   * a rotation and the tag at `from` is found by binary search.
+   */
+  void move_global_tag(size_t from, size_t to, int delta) {
+    const auto &sites = m_tag_sites;
+    size_t lo = 0;
+    size_t hi = sites.size() - 1;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (sites[mid] > sites[hi]) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    auto smallest = sites.begin() + static_cast<std::ptrdiff_t>(lo);
+    auto it = from <= sites.back()
+                  ? std::lower_bound(smallest, sites.end(), from)
+                  : std::lower_bound(sites.begin(), smallest, from);
+    auto j = static_cast<size_t>(it - sites.begin());
+    m_tag_sites[j] = to;
+    m_tag_displacements[j] += delta;
+  }
+
+  void sweep_serial() {
+    auto move = [this](size_t from, size_t to, int delta) {
+      move_global_tag(from, to, delta);
+    };
+    // A local copy keeps the generator state out of reach of the bitset
+    // stores, which could otherwise alias it
+    auto gen = m_gen;
+    size_t num_sites = m_num_sites;
+    for (size_t a = 0; a < num_sites; ++a) {
+      auto [site, uniform] = exclusion_split(gen(), num_sites);
+      update_bond(site, site + 1 == num_sites ? 0 : site + 1, uniform, move);
+    }
+    m_gen = gen;
+  }
+
+  void sweep_domains(size_t num_domains) {
+    size_t words = m_occupied.size();
+    size_t offset = exclusion_split(m_gen(), words).first;
+    struct Domain {
+      size_t first_site;  ///< First site of the domain
+      size_t num_sites;   ///< Number of sites (and of bonds)
+      size_t deferred;    ///< Deferred updates of the boundary bond
+      vector<std::pair<size_t, size_t> > tags; ///< (site, tag) pairs inside
+      vector<int64_t> moves; ///< Displacement of each entry of tags
+    };
+    vector<Domain> domains(num_domains);
+    vector<size_t> owner(words);
+    for (size_t d = 0; d < num_domains; ++d) {
+      size_t begin = (d * words) / num_domains;
+      size_t end = ((d + 1) * words) / num_domains;
+      auto &domain = domains[d];
+      size_t first_word = (offset + begin) % words;
+      domain.first_site = first_word * 64;
+      domain.num_sites = 0;
+      for (size_t w = begin; w < end; ++w) {
+        size_t word = (offset + w) % words;
+        owner[word] = d;
+        domain.num_sites += std::min<size_t>(64, m_num_sites - (word * 64));
+      }
+      domain.deferred = 0;
+    }
+    for (size_t j = 0; j < m_tag_sites.size(); ++j) {
+      auto &domain = domains[owner[m_tag_sites[j] >> 6]];
+      domain.tags.emplace_back(m_tag_sites[j], j);
+      domain.moves.push_back(0);
+    }
+
+    run_placed(num_domains, num_domains, [&](size_t begin, size_t end) {
+      for (size_t d = begin; d < end; ++d) {
+        auto &domain = domains[d];
+        auto gen = m_worker_gens[d];
+        auto move = [&domain](size_t from, size_t to, int delta) {
+          for (size_t e = 0; e < domain.tags.size(); ++e) {
+            if (domain.tags[e].first == from) {
+              domain.tags[e].first = to;
+              domain.moves[e] += delta;
+              return;
+            }
+          }
+        };
+        size_t num_sites = m_num_sites;
+        size_t first_site = domain.first_site;
+        size_t bonds = domain.num_sites;
+        size_t deferred = 0;
+        for (size_t a = 0; a < bonds; ++a) {
+          auto [k, uniform] = exclusion_split(gen(), bonds);
+          if (k + 1 == bonds) {
+            ++deferred;
+            continue;
+          }
+          size_t site = first_site + k;
+          site = site >= num_sites ? site - num_sites : site;
+          update_bond(site, site + 1 == num_sites ? 0 : site + 1, uniform,
+                      move);
+        }
+        domain.deferred = deferred;
+        m_worker_gens[d] = gen;
+      }
+    });
+
+    for (const auto &domain : domains) {
+      for (size_t e = 0; e < domain.tags.size(); ++e) {
+        size_t j = domain.tags[e].second;
+        m_tag_sites[j] = domain.tags[e].first;
+        m_tag_displacements[j] += domain.moves[e];
+      }
+    }
+    auto move = [this](size_t from, size_t to, int delta) {
+      move_global_tag(from, to, delta);
+    };
+    for (const auto &domain : domains) {
+      size_t site = domain.first_site + domain.num_sites - 1;
+      site = site >= m_num_sites ? site - m_num_sites : site;
+      size_t next = site + 1 == m_num_sites ? 0 : site + 1;
+      for (size_t a = 0; a < domain.deferred; ++a) {
+        update_bond(site, next, m_gen(), move);
+      }
+    }
+  }
+
+public:
+  /**
+   * @brief Constructs a ring with randomly placed particles
+   * @param num_sites Number of sites L (at least 2)
+   * @param num_particles Number of particles (at most L)
+   * @param forward_probability Probability p of a hop to the right (default
+   * 0.5, the SSEP)
+   * @param num_tagged Number of tagged particles, evenly spaced in label order
+   * (default 1, at most num_particles)
+   * @throws std::invalid_argument if the parameters are out of range
+   *
+   * The initial configuration is a uniformly random subset of the sites.
+   */
+  ExclusionProcess(size_t num_sites, size_t num_particles,
+                   double forward_probability = 0.5, size_t num_tagged = 1)
+      : m_num_sites(num_sites), m_num_particles(num_particles),
+        m_forward_probability(forward_probability),
+        m_occupied((num_sites + 63) / 64, 0), m_tagged(m_occupied.size(), 0),
+        m_gen(generator()()) {
+    if (num_sites < 2) {
+      throw std::invalid_argument("Number of sites must be at least 2");
+    }
+    if (num_particles > num_sites) {
+      throw std::invalid_argument(
+          "Number of particles must not exceed the number of sites");
+    }
+    if (forward_probability < 0.0 || forward_probability > 1.0) {
+      throw std::invalid_argument("Forward probability must be in [0, 1]");
+    }
+    if (num_tagged > num_particles) {
+      throw std::invalid_argument(
+          "Number of tagged particles must not exceed the number of particles");
+    }
+    // Selection sampling: site s is occupied with probability
+    // (particles still to place) / (sites left)
+    size_t placed = 0;
+    for (size_t s = 0; s < num_sites && placed < num_particles; ++s) {
+      uint64_t left = num_sites - s;
+      if (exclusion_split(m_gen(), left).first < num_particles - placed) {
+        flip(m_occupied, s);
+        if (num_tagged > 0 &&
+            (placed * num_tagged) % num_particles < num_tagged) {
+          flip(m_tagged, s);
+          m_tag_sites.push_back(s);
+        }
+        ++placed;
+      }
+    }
+    m_tag_displacements.assign(m_tag_sites.size(), 0);
+  }
+
+  /**
+   * @brief Advances the system by one sweep (L bond updates)
+   * @param num_workers Number of concurrent domains (default 1, the exact
+   * random-sequential dynamics)
+   *
+   * The number of domains is limited so that every domain holds at least
+   * 1024 words (65536 sites).
+   */
+  void sweep(size_t num_workers = 1) {
+    size_t domains = std::min(num_workers, m_occupied.size() / 1024);
+    if (domains <= 1) {
+      sweep_serial();
+    } else {
+      while (m_worker_gens.size() < domains) {
+        m_worker_gens.emplace_back(m_gen());
+      }
+      sweep_domains(domains);
+    }
+    ++m_time;
+  }
+
+  /**
+   * @brief Runs the system and records the tagged-particle trajectories
+   * @param num_sweeps The number of sweeps to simulate
+   * @param num_workers Number of concurrent domains per sweep (default 1)
+   * @return Result containing one (sweep numbers, displacements) pair per
+   * tagged particle, num_sweeps + 1 points each, or an Error
+   *
+   * Displacements are unwrapped and measured from the position at the start
+   * of the run.
+   */
+  auto run(size_t num_sweeps, size_t num_workers = 1)
+      -> Result<vector<discrete_pair> > {
+    if (num_workers == 0) {
+      return Err(Error::InvalidArgument("Number of workers must be positive"));
+    }
+    vector<int64_t> start = m_tag_displacements;
+    vector<discrete_pair> trajectories(m_tag_sites.size());
+    for (auto &[steps, positions] : trajectories) {
+      steps.resize(num_sweeps + 1);
+      positions.resize(num_sweeps + 1);
+      positions[0] = 0.0;
+    }
+    for (size_t n = 0; n <= num_sweeps; ++n) {
+      if (n > 0) {
+        sweep(num_workers);
+      }
+      for (size_t j = 0; j < trajectories.size(); ++j) {
+        trajectories[j].first[n] = n;
+        trajectories[j].second[n] =
+            static_cast<double>(m_tag_displacements[j] - start[j]);
+      }
+    }
+    return Ok(std::move(trajectories));
+  }
+
+  /**
+   * @brief Checks whether a site is occupied
+   * @param site The site index
+   * @return True if a particle sits at the site
+   */
+  [[nodiscard]] auto is_occupied(size_t site) const -> bool {
+    return test(m_occupied, site);
+  }
+
+  /**
+   * @brief Gets the current sites of the tagged particles
+   * @return The site of each tagged particle
+   */
+  [[nodiscard]] auto get_tagged_sites() const -> const vector<size_t> & {
+    return m_tag_sites;
+  }
+
+  /**
+   * @brief Gets the unwrapped displacements of the tagged particles
+   * @return The displacement of each tagged particle since construction
+   */
+  [[nodiscard]] auto get_tagged_displacements() const
+      -> const vector<int64_t> & {
+    return m_tag_displacements;
+  }
+
+  /**
+   * @brief Gets the number of sites
+   * @return The ring length L
+   */
+  [[nodiscard]] auto get_num_sites() const -> size_t { return m_num_sites; }
+
+  /**
+   * @brief Gets the number of particles
+   * @return The number of particles
+   */
+  [[nodiscard]] auto get_num_particles() const -> size_t {
+    return m_num_particles;
+  }
+
+  /**
+   * @brief Gets the probability of a hop to the right
+   * @return The forward probability p
+   */
+  [[nodiscard]] auto get_forward_probability() const -> double {
+    return m_forward_probability;
+  }
+
+  /**
+   * @brief Gets the elapsed time
+   * @return The number of sweeps performed
+   */
+  [[nodiscard]] auto get_time() const -> size_t { return m_time; }
+};
+
+/**
+ * @brief Displacement of a tagged particle in an exclusion process
+ *
+ * Each call to `simulate` builds a fresh ring with a random initial
+ * configuration and returns the displacement of one tagged particle, one
+ * point per sweep, so the `DiscreteProcess` moments average over both the
+ * dynamics and the initial condition.
+ */
+export class TaggedExclusion : public DiscreteProcess {
+  size_t m_num_sites = 1000;          ///< Number of sites
+  size_t m_num_particles = 500;       ///< Number of particles
+  double m_forward_probability = 0.5; ///< Probability of a hop to the right
+  size_t m_num_workers = 1;           ///< Concurrent domains per sweep
+
+public:
+  /**
+   * @brief Default constructor: SSEP at density 1/2 on 1000 sites
+   */
+  TaggedExclusion() = default;
+
+  /**
+   * @brief Constructor
+   * @param num_sites Number of sites (at least 2)
+   * @param num_particles Number of particles (between 1 and num_sites)
+   * @param forward_probability Probability of a hop to the right
+   * @param num_workers Concurrent domains per sweep (default 1)
+   * @throws std::invalid_argument if the parameters are out of range
+   */
+  TaggedExclusion(size_t num_sites, size_t num_particles,
+                  double forward_probability = 0.5, size_t num_workers = 1)
+      : m_num_sites(num_sites), m_num_particles(num_particles),
+        m_forward_probability(forward_probability), m_num_workers(num_workers) {
+    if (num_sites < 2) {
+      throw std::invalid_argument("Number of sites must be at least 2");
+    }
+    if (num_particles == 0 || num_particles > num_sites) {
+      throw std::invalid_argument(
+          "Number of particles must be between 1 and the number of sites");
+    }
+    if (forward_probability < 0.0 || forward_probability > 1.0) {
+      throw std::invalid_argument("Forward probability must be in [0, 1]");
+    }
+    if (num_workers == 0) {
+      throw std::invalid_argument("Number of workers must be positive");
+    }
+  }
+
+  /**
+   * @brief Simulates the displacement of a tagged particle
+   * @param num_steps The number of sweeps to simulate
+   * @return Result containing a pair of sweep numbers and displacements, or an
+   * Error
+   */
+  Result<discrete_pair> simulate(size_t num_steps) override {
+    ExclusionProcess system(m_num_sites, m_num_particles,
+                            m_forward_probability, 1);
+    auto trajectories = system.run(num_steps, m_num_workers);
+    if (!trajectories.has_value()) {
+      return Err(trajectories.error());
+    }
+    return Ok(std::move(trajectories.value()[0]));
+  }
+};
@@ -0,0 +1,824 @@
+/**
+ * @file graph.cppm
+ * @brief Random walks on graphs stored in compressed sparse row (CSR) form
+ *
+ * This module provides a CSR graph that can be built from an edge list in
+ * memory or in a text file, and a random-walk engine on it with lazy and
+ * teleporting variants, weighted transitions and parallel ensemble drivers
+ * for hitting times, cover times and the walker distribution (mixing).
+ *
+ * The ensemble drivers move batches of walkers in lockstep. For graphs
+ * larger than the caches, each batch is periodically sorted by node so that
+ * the adjacency lists are read in increasing address order.
+ */
+
+module;
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+export module diffusionx.simulation.discrete.graph;
+
+import diffusionx.error;
+import diffusionx.random.utils;
+import diffusionx.simulation.discrete.lattice;
+import diffusionx.simulation.discrete.multispin;
+
+using std::vector;
+
+/**
+ * @brief Number of walkers moved in lockstep by one worker
+ */
+export constexpr size_t graph_batch_size = size_t{1} << 16;
+
+/**
+ * @brief Number of arcs above which walker batches are sorted by node
+ */
+constexpr size_t graph_sort_threshold = size_t{1} << 20;
+
+/**
+ * @brief Number of steps between two sorts of a walker batch
+ */
+constexpr size_t graph_sort_interval = 8;
+
+/**
+ * @brief Reads the edges of a text edge list
+ * @param path The file path
+ * @param edge Called as edge(u, v, weight) for every edge
+ * @return Result containing the number of edges, or an Error
+ *
+ * Every non-empty line not starting with '#' or '%' holds two node ids and
+ * an optional non-negative weight (default 1), separated by blanks or
+ * commas. The file is read in large chunks and parsed with std::from_chars.
+ */
+template <typename F>
+auto read_edge_list(const std::string &path, F &&edge) -> Result<size_t> {
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(
+      std::fopen(path.c_str(), "rb"), &std::fclose);
+  if (!file) {
+    return Err(Error::IoError("Failed to open file for reading: " + path));
+  }
+  constexpr size_t chunk = size_t{1} << 24;
+  vector<char> data(chunk);
+  size_t kept = 0;
+  size_t line_number = 0;
+  size_t edges = 0;
+  bool done = false;
+  while (!done) {
+    size_t read = std::fread(data.data() + kept, 1, data.size() - kept,
+                             file.get());
+    size_t size = kept + read;
+    done = read == 0;
+    if (done && kept > 0) {
+      // Terminate the last line of a file without a trailing newline
+      data[size++] = '\n';
+    }
+    const char *p = data.data();
+    const char *end = data.data() + size;
+    while (true) {
+      const auto *eol = static_cast<const char *>(
+          std::memchr(p, '\n', static_cast<size_t>(end - p)));
+      if (eol == nullptr) {
+        break;
+      }
+      ++line_number;
+      auto skip = [&](const char *q) {
+        while (q < eol && (*q == ' ' || *q == '\t' || *q == ',' ||
+                           *q == '\r')) {
+          ++q;
+        }
+        return q;
+      };
+      const char *q = skip(p);
+      if (q < eol && *q != '#' && *q != '%') {
+        uint32_t u = 0;
+        uint32_t v = 0;
+        double w = 1.0;
+        auto [q1, e1] = std::from_chars(q, eol, u);
+        auto [q2, e2] = std::from_chars(skip(q1), eol, v);
+        const char *q3 = skip(q2);
+        std::errc e3{};
+        if (q3 < eol) {
+          e3 = std::from_chars(q3, eol, w).ec;
+        }
+        if (e1 != std::errc{} || e2 != std::errc{} || e3 != std::errc{} ||
+            u == UINT32_MAX || v == UINT32_MAX || !(w >= 0.0)) {
+          return Err(Error::InvalidArgument(
+              std::format("Malformed edge on line {} of {}", line_number,
+                          path)));
+        }
+        edge(u, v, w);
+        ++edges;
+      }
+      p = eol + 1;
+    }
+    kept = static_cast<size_t>(end - p);
+    if (kept == data.size()) {
+      return Err(Error::InvalidArgument(
+          std::format("Line {} of {} is too long", line_number + 1, path)));
+    }
+    std::memmove(data.data(), p, kept);
+  }
+  return Ok(edges);
+}
+
+/**
+ * @brief Builds the alias table of one node's out-arcs in place
+ * @param weights The arc weights
+ * @param threshold Output acceptance thresholds, scaled by 2^32
+ * @param alias Output aliases, as positions within the node's arcs
+ */
+void build_node_alias(std::span<const float> weights,
+                      std::span<uint32_t> threshold,
+                      std::span<uint32_t> alias) {
+  size_t n = weights.size();
+  double total = 0.0;
+  for (float w : weights) {
+    total += w;
+  }
+  vector<double> scaled(n);
+  vector<uint32_t> small;
+  vector<uint32_t> large;
+  for (size_t i = 0; i < n; ++i) {
+    // A node whose arcs all have zero weight picks them uniformly
+    scaled[i] = total > 0 ? weights[i] * static_cast<double>(n) / total : 1.0;
+    threshold[i] = UINT32_MAX;
+    alias[i] = static_cast<uint32_t>(i);
+    (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+  }
+  while (!small.empty() && !large.empty()) {
+    uint32_t s = small.back();
+    uint32_t l = large.back();
+    small.pop_back();
+    large.pop_back();
+    threshold[s] = static_cast<uint32_t>(scaled[s] * 0x1.0p32);
+    alias[s] = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    (scaled[l] < 1.0 ? small : large).push_back(l);
+  }
+}
+
+/**
+ * @brief Directed or undirected graph in compressed sparse row form
+ *
+ * Node ids are 0..num_nodes()-1 and the out-arcs of node v are
+ * targets[offsets[v] .. offsets[v+1]). An undirected edge {u, v} is stored
+ * as the two arcs u -> v and v -> u. Weighted graphs keep, instead of the
+ * weights, a per-node alias table over the arcs (8 bytes per arc), so that
+ * a weighted step costs the same as an unweighted one.
+ */
+export class CsrGraph {
+  vector<uint64_t> m_offsets{0}; ///< Start of the arcs of each node
+  vector<uint32_t> m_targets;    ///< Arc targets
+  vector<uint32_t> m_threshold;  ///< Alias thresholds (weighted graphs only)
+  vector<uint32_t> m_alias;      ///< Alias arcs (weighted graphs only)
+
+  /**
+   * @brief Builds the CSR arrays from two passes over the edges
+   * @param for_each_edge Called twice with a callback taking (u, v, weight)
+   * @param directed Whether an edge is a single arc
+   *
+   * The graph is weighted if any weight differs from 1.
+   */
+  template <typename F>
+  static auto build(F &&for_each_edge, bool directed) -> Result<CsrGraph> {
+    CsrGraph graph;
+    vector<uint64_t> &offsets = graph.m_offsets;
+    bool weighted = false;
+    auto count = [&](uint32_t u, uint32_t v, double w) {
+      weighted |= w != 1.0;
+      size_t needed = static_cast<size_t>(std::max(u, v)) + 2;
+      if (offsets.size() < needed) {
+        offsets.resize(needed, 0);
+      }
+      ++offsets[u + 1];
+      if (!directed) {
+        ++offsets[v + 1];
+      }
+    };
+    if (auto res = for_each_edge(count); !res) {
+      return Err(res.error());
+    }
+    for (size_t v = 1; v < offsets.size(); ++v) {
+      offsets[v] += offsets[v - 1];
+    }
+    size_t arcs = offsets.back();
+    graph.m_targets.resize(arcs);
+    vector<float> weights(weighted ? arcs : 0);
+    vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+    auto fill = [&](uint32_t u, uint32_t v, double w) {
+      uint64_t a = next[u]++;
+      graph.m_targets[a] = v;
+      if (weighted) {
+        weights[a] = static_cast<float>(w);
+      }
+      if (!directed) {
+        uint64_t b = next[v]++;
+        graph.m_targets[b] = u;
+        if (weighted) {
+          weights[b] = static_cast<float>(w);
+        }
+      }
+    };
+    if (auto res = for_each_edge(fill); !res) {
+      return Err(res.error());
+    }
+    if (weighted) {
+      graph.m_threshold.resize(arcs);
+      graph.m_alias.resize(arcs);
+      size_t nodes = offsets.size() - 1;
+      run_placed(nodes, default_workers(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+          size_t first = offsets[v];
+          size_t degree = offsets[v + 1] - first;
+          build_node_alias(std::span(weights).subspan(first, degree),
+                           std::span(graph.m_threshold).subspan(first, degree),
+                           std::span(graph.m_alias).subspan(first, degree));
+        }
+      });
+    }
+    return Ok(std::move(graph));
+  }
+
+public:
+  /**
+   * @brief Marker of `neighbor_batch` for nodes without out-arcs
+   */
+  static constexpr uint64_t no_arc = UINT64_MAX;
+
+  /**
+   * @brief Default constructor creating an empty graph
+   */
+  CsrGraph() = default;
+
+  /**
+   * @brief Builds a graph from an edge list in memory
+   * @param num_nodes Number of nodes (at least 1 + the largest id in edges)
+   * @param edges The edges (u, v)
+   * @param weights Non-negative edge weights, empty for an unweighted graph;
+   * the graph is weighted if any weight differs from 1
+   * @param directed Whether (u, v) is the arc u -> v only (default false)
+   * @return Result containing the graph, or an Error
+   */
+  static auto from_edges(size_t num_nodes,
+                         const vector<std::pair<uint32_t, uint32_t> > &edges,
+                         const vector<double> &weights = {},
+                         bool directed = false) -> Result<CsrGraph> {
+    if (num_nodes == 0 || num_nodes >= UINT32_MAX) {
+      return Err(Error::InvalidArgument(
+          "Number of nodes must be in [1, 2^32 - 1)"));
+    }
+    if (!weights.empty() && weights.size() != edges.size()) {
+      return Err(Error::InvalidArgument(
+          "Edges and weights must have the same size"));
+    }
+    for (size_t e = 0; e < edges.size(); ++e) {
+      if (edges[e].first >= num_nodes || edges[e].second >= num_nodes) {
+        return Err(Error::InvalidArgument(std::format(
+            "Edge {} refers to a node outside [0, {})", e, num_nodes)));
+      }
+      if (!weights.empty() && !(weights[e] >= 0.0)) {
+        return Err(Error::InvalidArgument(
+            std::format("Weight of edge {} must be non-negative", e)));
+      }
+    }
+    auto result = build(
+        [&](auto &&edge) -> Result<size_t> {
+          for (size_t e = 0; e < edges.size(); ++e) {
+            edge(edges[e].first, edges[e].second,
+                 weights.empty() ? 1.0 : weights[e]);
+          }
+          return Ok(edges.size());
+        },
+        directed);
+    if (result.has_value()) {
+      result->m_offsets.resize(num_nodes + 1, result->m_offsets.back());
+    }
+    return result;
+  }
+
+  /**
+   * @brief Loads a graph from a text edge list
+   * @param path The file path
+   * @param directed Whether a line "u v" is the arc u -> v only (default
+   * false)
+   * @return Result containing the graph, or an Error
+   *
+   * See `read_edge_list` for the format. The graph is weighted if any line
+   * has a weight other than 1. The file is read twice, once to count the degrees
+   * and once to fill the arcs, so apart from the graph itself memory use is
+   * 4 bytes per arc for the weights of a weighted graph. The number of nodes
+   * is one more than the largest id.
+   */
+  static auto load_edge_list(const std::string &path, bool directed = false)
+      -> Result<CsrGraph> {
+    return build(
+        [&](auto &&edge) -> Result<size_t> {
+          return read_edge_list(path, edge);
+        },
+        directed);
+  }
+
+  /**
+   * @brief Gets the number of nodes
+   * @return The number of nodes
+   */
+  [[nodiscard]] auto num_nodes() const -> size_t {
+    return m_offsets.size() - 1;
+  }
+
+  /**
+   * @brief Gets the number of arcs
+   * @return The number of arcs (twice the number of undirected edges)
+   */
+  [[nodiscard]] auto num_arcs() const -> size_t { return m_targets.size(); }
+
+  /**
+   * @brief Gets the out-degree of a node
+   * @param v The node
+   * @return The number of arcs leaving v
+   */
+  [[nodiscard]] auto degree(uint32_t v) const -> size_t {
+    return m_offsets[v + 1] - m_offsets[v];
+  }
+
+  /**
+   * @brief Gets the out-neighbours of a node
+   * @param v The node
+   * @return The targets of the arcs leaving v
+   */
+  [[nodiscard]] auto neighbors(uint32_t v) const -> std::span<const uint32_t> {
+    return std::span(m_targets).subspan(m_offsets[v], degree(v));
+  }
+
+  /**
+   * @brief Checks whether transitions are weighted
+   * @return True if the graph was built with weights
+   */
+  [[nodiscard]] auto is_weighted() const -> bool { return !m_alias.empty(); }
+
+  /**
+   * @brief Picks a random out-neighbour
+   * @param v The node, with at least one arc
+   * @param word A uniformly random 32-bit word
+   * @return The target of an arc chosen uniformly, or in proportion to the
+   * arc weights for a weighted graph
+   */
+  [[nodiscard]] auto neighbor(uint32_t v, uint32_t word) const -> uint32_t {
+    uint64_t first = m_offsets[v];
+    uint64_t product = static_cast<uint64_t>(word) * (m_offsets[v + 1] - first);
+    uint64_t arc = first + (product >> 32);
+    if (!m_alias.empty() &&
+        static_cast<uint32_t>(product) >= m_threshold[arc]) {
+      arc = first + m_alias[arc];
+    }
+    return m_targets[arc];
+  }
+
+  /**
+   * @brief Picks random out-neighbours of a batch of nodes
+   * @param nodes The nodes, replaced by the neighbours
+   * @param words One uniformly random 32-bit word per node
+   * @param arcs Output: the arc taken by each node, or `no_arc` for nodes
+   * without out-arcs, which are left unchanged
+   *
+   * Same result as `neighbor` on every node, but the dependent loads
+   * (offsets, then alias table, then target) are done in separate passes
+   * that prefetch a few nodes ahead, so that on graphs larger than the
+   * caches the memory latencies of different walkers overlap.
+   */
+  void neighbor_batch(std::span<uint32_t> nodes,
+                      std::span<const uint32_t> words,
+                      std::span<uint64_t> arcs) const {
+    constexpr size_t ahead = 16;
+    size_t n = nodes.size();
+    const uint64_t *offsets = m_offsets.data();
+    for (size_t k = 0; k < n; ++k) {
+      if (k + ahead < n) {
+        __builtin_prefetch(offsets + nodes[k + ahead]);
+      }
+      uint64_t first = offsets[nodes[k]];
+      uint64_t degree = offsets[nodes[k] + 1] - first;
+      if (degree == 0) {
+        arcs[k] = no_arc;
+        continue;
+      }
+      arcs[k] = first + ((static_cast<uint64_t>(words[k]) * degree) >> 32);
+      // Keep the degree for the alias pass, which recomputes the product
+      nodes[k] = static_cast<uint32_t>(degree);
+    }
+    if (!m_alias.empty()) {
+      for (size_t k = 0; k < n; ++k) {
+        if (k + ahead < n && arcs[k + ahead] != no_arc) {
+          __builtin_prefetch(m_threshold.data() + arcs[k + ahead]);
+          __builtin_prefetch(m_alias.data() + arcs[k + ahead]);
+        }
+        uint64_t arc = arcs[k];
+        if (arc == no_arc) {
+          continue;
+        }
+        uint64_t product = static_cast<uint64_t>(words[k]) * nodes[k];
+        if (static_cast<uint32_t>(product) >= m_threshold[arc]) {
+          arcs[k] = (arc - (product >> 32)) + m_alias[arc];
+        }
+      }
+    }
+    for (size_t k = 0; k < n; ++k) {
+      if (k + ahead < n && arcs[k + ahead] != no_arc) {
+        __builtin_prefetch(m_targets.data() + arcs[k + ahead]);
+      }
+      if (arcs[k] != no_arc) {
+        nodes[k] = m_targets[arcs[k]];
+      }
+    }
+  }
+};
+
+/**
+ * @brief Cover times of an ensemble of graph walks
+ */
+export struct GraphCoverTimes {
+  vector<size_t> times; ///< Cover time of each walk that covered the graph
+  size_t uncovered = 0; ///< Walks that did not cover the graph within max_steps
+
+  /**
+   * @brief Computes the mean cover time
+   * @return The mean over walks that covered the graph, or None if none did
+   */
+  [[nodiscard]] auto mean() const -> Option<double> {
+    if (times.empty()) {
+      return std::nullopt;
+    }
+    double sum = 0.0;
+    for (size_t t : times) {
+      sum += static_cast<double>(t);
+    }
+    return sum / static_cast<double>(times.size());
+  }
+};
+
+/**
+ * @brief Per-worker scratch space of the batched graph walk
+ */
+struct GraphScratch {
+  vector<uint32_t> moving; ///< Nodes of the walkers that follow an arc
+  vector<uint32_t> words;  ///< Their random words
+  vector<uint32_t> slots;  ///< Their positions in the batch
+  vector<uint64_t> arcs;   ///< Chosen arcs
+};
+
+/**
+ * @brief Random walk on a CSR graph
+ *
+ * At every step the walker stays put with probability `laziness`, jumps to
+ * a uniformly random node with probability `teleport`, and otherwise moves
+ * along a random out-arc (uniform, or weighted). A walker on a node without
+ * out-arcs teleports if teleport > 0 and stays put otherwise.
+ */
+export class GraphRandomWalk {
+  std::shared_ptr<const CsrGraph> m_graph; ///< The graph
+  double m_laziness = 0.0;  ///< Probability of staying put
+  double m_teleport = 0.0;  ///< Probability of jumping to a uniform node
+  uint64_t m_stay_below;    ///< laziness scaled by 2^32
+  uint64_t m_teleport_below; ///< (laziness + teleport) scaled by 2^32
+
+  /**
+   * @brief Moves a walker by one step
+   * @param v The current node
+   * @param word A uniformly random 64-bit word
+   * @return The next node
+   */
+  [[nodiscard]] auto step(uint32_t v, uint64_t word) const -> uint32_t {
+    auto choice = static_cast<uint32_t>(word >> 32);
+    auto pick = static_cast<uint32_t>(word);
+    if (choice < m_stay_below) {
+      return v;
+    }
+    bool dangling = m_graph->degree(v) == 0;
+    if (choice < m_teleport_below || (dangling && m_teleport > 0)) {
+      return static_cast<uint32_t>(
+          (static_cast<uint64_t>(pick) * m_graph->num_nodes()) >> 32);
+    }
+    return dangling ? v : m_graph->neighbor(v, pick);
+  }
+
+  /**
+   * @brief Moves a batch of walkers by one step
+   * @param nodes The walkers' nodes
+   * @param gen The random number generator
+   * @param step_number The number of the step, to schedule sorting
+   * @param scratch Scratch space reused across calls
+   *
+   * Walkers that stay put or teleport are settled first; the others are
+   * gathered and moved by `CsrGraph::neighbor_batch`.
+   */
+  void step_batch(std::span<uint32_t> nodes, std::mt19937_64 &gen,
+                  size_t step_number, GraphScratch &scratch) const {
+    if (m_graph->num_arcs() > graph_sort_threshold &&
+        step_number % graph_sort_interval == 1) {
+      std::sort(nodes.begin(), nodes.end());
+    }
+    scratch.moving.clear();
+    scratch.words.clear();
+    scratch.slots.clear();
+    for (size_t k = 0; k < nodes.size(); ++k) {
+      uint64_t word = gen();
+      auto choice = static_cast<uint32_t>(word >> 32);
+      auto pick = static_cast<uint32_t>(word);
+      if (choice < m_stay_below) {
+        continue;
+      }
+      if (choice < m_teleport_below) {
+        nodes[k] = static_cast<uint32_t>(
+            (static_cast<uint64_t>(pick) * m_graph->num_nodes()) >> 32);
+        continue;
+      }
+      scratch.moving.push_back(nodes[k]);
+      scratch.words.push_back(pick);
+      scratch.slots.push_back(static_cast<uint32_t>(k));
+    }
+    scratch.arcs.resize(scratch.moving.size());
+    m_graph->neighbor_batch(scratch.moving, scratch.words, scratch.arcs);
+    for (size_t m = 0; m < scratch.moving.size(); ++m) {
+      uint32_t v = scratch.moving[m];
+      if (scratch.arcs[m] == CsrGraph::no_arc && m_teleport > 0) {
+        v = static_cast<uint32_t>(
+            (static_cast<uint64_t>(scratch.words[m]) * m_graph->num_nodes()) >>
+            32);
+      }
+      nodes[scratch.slots[m]] = v;
+    }
+  }
+
+  [[nodiscard]] auto check_nodes(const vector<uint32_t> &nodes,
+                                 const char *what) const -> Result<int> {
+    if (nodes.empty()) {
+      return Err(Error::InvalidArgument(std::format("{} must not be empty", what)));
+    }
+    for (uint32_t v : nodes) {
+      if (v >= m_graph->num_nodes()) {
+        return Err(Error::InvalidArgument(
+            std::format("{} contain node {} outside [0, {})", what, v,
+                        m_graph->num_nodes())));
+      }
+    }
+    return Ok(0);
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param graph The graph, shared so that large graphs are never copied
+   * @param laziness Probability of staying put (default 0)
+   * @param teleport Probability of jumping to a uniform node (default 0)
+   * @throws std::invalid_argument if the graph is missing or empty, or the
+   * probabilities are negative or sum to more than 1
+   */
+  explicit GraphRandomWalk(std::shared_ptr<const CsrGraph> graph,
+                           double laziness = 0.0, double teleport = 0.0)
+      : m_graph(std::move(graph)), m_laziness(laziness), m_teleport(teleport) {
+    if (!m_graph || m_graph->num_nodes() == 0) {
+      throw std::invalid_argument("Graph must have at least one node");
+    }
+    if (laziness < 0.0 || teleport < 0.0 || laziness + teleport > 1.0) {
+      throw std::invalid_argument(
+          "Laziness and teleport must be non-negative with sum at most 1");
+    }
+    m_stay_below = static_cast<uint64_t>(laziness * 0x1.0p32);
+    m_teleport_below = static_cast<uint64_t>((laziness + teleport) * 0x1.0p32);
+  }
+
+  /**
+   * @brief Gets the graph
+   * @return The shared graph
+   */
+  [[nodiscard]] auto get_graph() const -> const std::shared_ptr<const CsrGraph> & {
+    return m_graph;
+  }
+
+  /**
+   * @brief Gets the laziness
+   * @return The probability of staying put
+   */
+  [[nodiscard]] auto get_laziness() const -> double { return m_laziness; }
+
+  /**
+   * @brief Gets the teleport probability
+   * @return The probability of jumping to a uniform node
+   */
+  [[nodiscard]] auto get_teleport() const -> double { return m_teleport; }
+
+  /**
+   * @brief Simulates a trajectory
+   * @param start The starting node
+   * @param num_steps The number of steps to simulate
+   * @return Result containing the visited nodes (num_steps + 1), or an Error
+   */
+  auto simulate(uint32_t start, size_t num_steps) const
+      -> Result<vector<uint32_t> > {
+    if (start >= m_graph->num_nodes()) {
+      return Err(Error::InvalidArgument("Start node is outside the graph"));
+    }
+    std::mt19937_64 gen(generator()());
+    vector<uint32_t> nodes(num_steps + 1);
+    nodes[0] = start;
+    for (size_t n = 1; n <= num_steps; ++n) {
+      nodes[n] = step(nodes[n - 1], gen());
+    }
+    return Ok(std::move(nodes));
+  }
+
+  /**
+   * @brief Hitting-time histogram of a set of target nodes
+   * @param starts Starting nodes; walker k starts at starts[k % size]
+   * @param targets The target nodes
+   * @param num_walkers Number of walkers
+   * @param max_steps Maximum number of steps
+   * @return Result containing the histogram, or an Error
+   *
+   * A walker is absorbed at the first step at which it sits on a target
+   * (step 0 if it starts on one). Walkers are moved in batches of
+   * `graph_batch_size` per worker; absorbed walkers are dropped from the
+   * batch and only the histogram is kept, which stops growing once every
+   * walker is absorbed.
+   */
+  auto hitting_times(const vector<uint32_t> &starts,
+                     const vector<uint32_t> &targets, size_t num_walkers,
+                     size_t max_steps) const -> Result<FirstPassageHistogram> {
+    if (auto res = check_nodes(starts, "Starts"); !res) {
+      return Err(res.error());
+    }
+    if (auto res = check_nodes(targets, "Targets"); !res) {
+      return Err(res.error());
+    }
+    if (num_walkers == 0) {
+      return Err(Error::InvalidArgument("Number of walkers must be positive"));
+    }
+    vector<uint64_t> is_target((m_graph->num_nodes() + 63) / 64, 0);
+    for (uint32_t v : targets) {
+      is_target[v >> 6] |= uint64_t{1} << (v & 63);
+    }
+    auto hit = [&is_target](uint32_t v) {
+      return ((is_target[v >> 6] >> (v & 63)) & 1) != 0;
+    };
+
+    size_t workers = std::min(default_workers(), num_walkers);
+    vector<vector<size_t> > partial(workers);
+    run_placed(workers, workers, [&](size_t begin, size_t end) {
+      std::mt19937_64 gen(generator()());
+      GraphScratch scratch;
+      vector<uint32_t> batch;
+      for (size_t i = begin; i < end; ++i) {
+        auto &counts = partial[i];
+        size_t first = (i * num_walkers) / workers;
+        size_t last = ((i + 1) * num_walkers) / workers;
+        for (size_t b = first; b < last; b += graph_batch_size) {
+          size_t size = std::min(graph_batch_size, last - b);
+          batch.resize(size);
+          for (size_t k = 0; k < size; ++k) {
+            batch[k] = starts[(b + k) % starts.size()];
+          }
+          for (size_t n = 0; n <= max_steps && !batch.empty(); ++n) {
+            if (n > 0) {
+              step_batch(batch, gen, n, scratch);
+            }
+            if (counts.size() <= n) {
+              counts.resize(n + 1, 0);
+            }
+            for (size_t k = 0; k < batch.size();) {
+              if (hit(batch[k])) {
+                ++counts[n];
+                batch[k] = batch.back();
+                batch.pop_back();
+              } else {
+                ++k;
+              }
+            }
+          }
+        }
+      }
+    });
+
+    FirstPassageHistogram result;
+    result.num_walkers = num_walkers;
+    size_t absorbed = 0;
+    for (const auto &counts : partial) {
+      if (result.counts.size() < counts.size()) {
+        result.counts.resize(counts.size(), 0);
+      }
+      for (size_t n = 0; n < counts.size(); ++n) {
+        result.counts[n] += counts[n];
+        absorbed += counts[n];
+      }
+    }
+    result.survivors = num_walkers - absorbed;
+    return Ok(std::move(result));
+  }
+
+  /**
+   * @brief Distribution of the walker position after a number of steps
+   * @param starts Starting nodes; walker k starts at starts[k % size]
+   * @param num_walkers Number of walkers
+   * @param num_steps Number of steps
+   * @return Result containing the fraction of walkers on each node, or an
+   * Error
+   *
+   * Comparing the result with the stationary distribution measures mixing.
+   */
+  auto distribution(const vector<uint32_t> &starts, size_t num_walkers,
+                    size_t num_steps) const -> Result<vector<double> > {
+    if (auto res = check_nodes(starts, "Starts"); !res) {
+      return Err(res.error());
+    }
+    if (num_walkers == 0) {
+      return Err(Error::InvalidArgument("Number of walkers must be positive"));
+    }
+    vector<uint32_t> final_nodes(num_walkers);
+    size_t workers = std::min(default_workers(), num_walkers);
+    run_placed(workers, workers, [&](size_t begin, size_t end) {
+      std::mt19937_64 gen(generator()());
+      GraphScratch scratch;
+      for (size_t i = begin; i < end; ++i) {
+        size_t first = (i * num_walkers) / workers;
+        size_t last = ((i + 1) * num_walkers) / workers;
+        for (size_t b = first; b < last; b += graph_batch_size) {
+          auto batch = std::span(final_nodes)
+                           .subspan(b, std::min(graph_batch_size, last - b));
+          for (size_t k = 0; k < batch.size(); ++k) {
+            batch[k] = starts[(b + k) % starts.size()];
+          }
+          for (size_t n = 1; n <= num_steps; ++n) {
+            step_batch(batch, gen, n, scratch);
+          }
+        }
+      }
+    });
+    vector<double> result(m_graph->num_nodes(), 0.0);
+    double weight = 1.0 / static_cast<double>(num_walkers);
+    for (uint32_t v : final_nodes) {
+      result[v] += weight;
+    }
+    return Ok(std::move(result));
+  }
+
+  /**
+   * @brief Cover times of independent walks
+   * @param start The starting node
+   * @param num_walkers Number of walks
+   * @param max_steps Maximum number of steps per walk
+   * @return Result containing the cover times, or an Error
+   *
+   * The cover time is the number of steps until every node has been
+   * visited. Each worker reuses one `SiteBitmap` over the nodes.
+   */
+  auto cover_times(uint32_t start, size_t num_walkers, size_t max_steps) const
+      -> Result<GraphCoverTimes> {
+    if (start >= m_graph->num_nodes()) {
+      return Err(Error::InvalidArgument("Start node is outside the graph"));
+    }
+    if (num_walkers == 0) {
+      return Err(Error::InvalidArgument("Number of walkers must be positive"));
+    }
+    size_t nodes = m_graph->num_nodes();
+    vector<Option<size_t> > times(num_walkers);
+    run_placed(num_walkers, default_workers(), [&](size_t begin, size_t end) {
+      std::mt19937_64 gen(generator()());
+      SiteBitmap visited(nodes);
+      for (size_t k = begin; k < end; ++k) {
+        visited.clear();
+        uint32_t v = start;
+        visited.insert(v);
+        size_t n = 0;
+        while (visited.size() < nodes && n < max_steps) {
+          v = step(v, gen());
+          visited.insert(v);
+          ++n;
+        }
+        if (visited.size() == nodes) {
+          times[k] = n;
+        }
+      }
+    });
+    GraphCoverTimes result;
+    for (const auto &t : times) {
+      if (t.has_value()) {
+        result.times.push_back(*t);
+      } else {
+        ++result.uncovered;
+      }
+    }
+    return Ok(std::move(result));
+  }
+};
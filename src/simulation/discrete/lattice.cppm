@@ -0,0 +1,563 @@
+/**
+ * @file lattice.cppm
+ * @brief Random walks on the d-dimensional hypercubic lattice (d = 1, 2, 3)
+ *
+ * This module provides nearest-neighbour random walks on Z^d together with
+ * the visited-site bookkeeping needed for the number of distinct sites
+ * visited S(n), return probabilities and cover times:
+ * - `SiteSet`, an open-addressing hash set of packed lattice sites, for
+ *   walks on the infinite lattice;
+ * - `SiteBitmap`, a bitmap for bounded regions such as a periodic box.
+ *
+ * Both are cleared in time proportional to the work done since the last
+ * clear, so the ensemble drivers reuse one instance per worker thread.
+ */
+
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.simulation.discrete.lattice;
+
+import diffusionx.error;
+import diffusionx.random.utils;
+
+using std::vector;
+
+/**
+ * @brief Largest supported |coordinate| of a site packed into a `SiteSet` key
+ */
+export constexpr int64_t lattice_coordinate_limit = (int64_t{1} << 20) - 1;
+
+/**
+ * @brief Packs a site of Z^d (d <= 3, |x_i| <= lattice_coordinate_limit)
+ * @param site The coordinates
+ * @return A 63-bit key, 21 bits per coordinate
+ */
+export auto pack_site(const std::array<int64_t, 3> &site) -> uint64_t {
+  constexpr int64_t offset = int64_t{1} << 20;
+  return static_cast<uint64_t>(site[0] + offset) |
+         (static_cast<uint64_t>(site[1] + offset) << 21) |
+         (static_cast<uint64_t>(site[2] + offset) << 42);
+}
+
+/**
+ * @brief Open-addressing hash set of packed lattice sites
+ *
+ * Linear probing over a power-of-two table kept at most half full; since
+ * packed sites are never zero, zero marks an empty slot. A walk mostly
+ * revisits recent sites, so almost every lookup ends at the first probed
+ * slot. The occupied slots are remembered, so `clear` costs O(size())
+ * instead of O(capacity) and one set can be reused across many walks.
+ */
+export class SiteSet {
+  vector<uint64_t> m_keys;  ///< Packed sites, 0 for empty slots
+  vector<size_t> m_touched; ///< Indices of the occupied slots
+  size_t m_mask;            ///< Table size - 1
+
+  [[nodiscard]] static auto hash(uint64_t key) -> uint64_t {
+    key ^= key >> 31;
+    key *= 0x9e3779b97f4a7c15ULL;
+    return key ^ (key >> 29);
+  }
+
+  void place(uint64_t key) {
+    size_t slot = hash(key) & m_mask;
+    while (m_keys[slot] != 0) {
+      slot = (slot + 1) & m_mask;
+    }
+    m_keys[slot] = key;
+    m_touched.push_back(slot);
+  }
+
+  void grow() {
+    vector<uint64_t> keys;
+    keys.reserve(m_touched.size());
+    for (size_t slot : m_touched) {
+      keys.push_back(m_keys[slot]);
+    }
+    m_keys.assign(2 * m_keys.size(), 0);
+    m_mask = m_keys.size() - 1;
+    m_touched.clear();
+    for (uint64_t key : keys) {
+      place(key);
+    }
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param expected_size Expected number of sites, to size the table
+   */
+  explicit SiteSet(size_t expected_size = 1024)
+      : m_keys(std::bit_ceil(std::max<size_t>(16, 2 * expected_size)), 0),
+        m_mask(m_keys.size() - 1) {
+    m_touched.reserve(expected_size);
+  }
+
+  /**
+   * @brief Inserts a site
+   * @param key The packed site (see `pack_site`)
+   * @return True if the site was not in the set
+   */
+  auto insert(uint64_t key) -> bool {
+    size_t slot = hash(key) & m_mask;
+    while (true) {
+      uint64_t current = m_keys[slot];
+      if (current == key) {
+        return false;
+      }
+      if (current == 0) {
+        break;
+      }
+      slot = (slot + 1) & m_mask;
+    }
+    if (2 * (m_touched.size() + 1) > m_keys.size()) {
+      grow();
+      place(key);
+    } else {
+      m_keys[slot] = key;
+      m_touched.push_back(slot);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Checks whether a site is in the set
+   * @param key The packed site
+   * @return True if the site has been inserted since the last clear
+   */
+  [[nodiscard]] auto contains(uint64_t key) const -> bool {
+    size_t slot = hash(key) & m_mask;
+    while (m_keys[slot] != 0) {
+      if (m_keys[slot] == key) {
+        return true;
+      }
+      slot = (slot + 1) & m_mask;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Removes all sites, keeping the allocated table
+   */
+  void clear() {
+    for (size_t slot : m_touched) {
+      m_keys[slot] = 0;
+    }
+    m_touched.clear();
+  }
+
+  /**
+   * @brief Gets the number of sites in the set
+   * @return The number of distinct sites inserted since the last clear
+   */
+  [[nodiscard]] auto size() const -> size_t { return m_touched.size(); }
+};
+
+/**
+ * @brief Bitmap of the sites of a bounded region
+ *
+ * Sites are identified by an index in [0, capacity). The words set since
+ * the last clear are remembered, so `clear` costs O(words touched).
+ */
+export class SiteBitmap {
+  vector<uint64_t> m_bits;    ///< One bit per site
+  vector<uint32_t> m_touched; ///< Indices of the non-zero words
+  size_t m_size = 0;          ///< Number of set bits
+
+public:
+  /**
+   * @brief Constructor
+   * @param capacity Number of sites of the region
+   */
+  explicit SiteBitmap(size_t capacity) : m_bits((capacity + 63) / 64, 0) {}
+
+  /**
+   * @brief Marks a site as visited
+   * @param index The site index
+   * @return True if the site was not marked before
+   */
+  auto insert(size_t index) -> bool {
+    uint64_t &word = m_bits[index / 64];
+    uint64_t bit = uint64_t{1} << (index % 64);
+    if ((word & bit) != 0) {
+      return false;
+    }
+    if (word == 0) {
+      m_touched.push_back(static_cast<uint32_t>(index / 64));
+    }
+    word |= bit;
+    ++m_size;
+    return true;
+  }
+
+  /**
+   * @brief Checks whether a site is marked
+   * @param index The site index
+   * @return True if the site was marked since the last clear
+   */
+  [[nodiscard]] auto contains(size_t index) const -> bool {
+    return ((m_bits[index / 64] >> (index % 64)) & 1) != 0;
+  }
+
+  /**
+   * @brief Unmarks all sites
+   */
+  void clear() {
+    for (uint32_t w : m_touched) {
+      m_bits[w] = 0;
+    }
+    m_touched.clear();
+    m_size = 0;
+  }
+
+  /**
+   * @brief Gets the number of marked sites
+   * @return The number of distinct sites marked since the last clear
+   */
+  [[nodiscard]] auto size() const -> size_t { return m_size; }
+};
+
+/**
+ * @brief Source of uniformly random nearest-neighbour moves on Z^d
+ *
+ * Moves are drawn 3 bits at a time from 64-bit words; in 3D the two values
+ * that do not correspond to a move are rejected, so all 2d moves are exactly
+ * equally likely.
+ */
+export class LatticeMoves {
+  std::mt19937_64 m_gen; ///< Source of random words
+  uint64_t m_word = 0;   ///< Unused random bits
+  int m_left = 0;        ///< Number of unused 3-bit groups in m_word
+  uint64_t m_choices;    ///< 2 d
+
+public:
+  explicit LatticeMoves(size_t dimension)
+      : m_gen(generator()()), m_choices(2 * dimension) {}
+
+  /**
+   * @brief Draws a move
+   * @return Axis in bits 1.., direction (1 positive) in bit 0
+   */
+  auto next() -> uint64_t {
+    while (true) {
+      if (m_left == 0) {
+        m_word = m_gen();
+        m_left = 21;
+      }
+      uint64_t v = m_word & 7;
+      m_word >>= 3;
+      --m_left;
+      // For 2 d = 2 or 4 fold the 3 bits, for 6 reject the values 6 and 7
+      if (m_choices == 6) {
+        if (v < 6) {
+          return v;
+        }
+      } else {
+        return v & (m_choices - 1);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Nearest-neighbour random walk on Z^d, d = 1, 2 or 3
+ *
+ * At every step the walker moves to one of its 2d neighbours, chosen
+ * uniformly. Walks start at the origin.
+ */
+export class LatticeRandomWalk {
+  size_t m_dimension = 2; ///< Lattice dimension
+
+public:
+  /**
+   * @brief Default constructor creating a walk on the square lattice
+   */
+  LatticeRandomWalk() = default;
+
+  /**
+   * @brief Constructs a walk on Z^dimension
+   * @param dimension Lattice dimension (1, 2 or 3)
+   * @throws std::invalid_argument if the dimension is not 1, 2 or 3
+   */
+  explicit LatticeRandomWalk(size_t dimension) : m_dimension(dimension) {
+    if (dimension < 1 || dimension > 3) {
+      throw std::invalid_argument("Dimension must be 1, 2 or 3");
+    }
+  }
+
+  /**
+   * @brief Gets the lattice dimension
+   * @return The lattice dimension
+   */
+  [[nodiscard]] auto get_dimension() const -> size_t { return m_dimension; }
+
+  /**
+   * @brief Simulates a trajectory of the walk
+   * @param num_steps The number of steps to simulate
+   * @return Result containing the visited sites, row-major with
+   * get_dimension() coordinates per step (num_steps + 1 sites), or an Error
+   */
+  auto simulate(size_t num_steps) const -> Result<vector<int64_t> > {
+    vector<int64_t> sites((num_steps + 1) * m_dimension, 0);
+    LatticeMoves moves(m_dimension);
+    for (size_t n = 1; n <= num_steps; ++n) {
+      std::copy_n(&sites[(n - 1) * m_dimension], m_dimension,
+                  &sites[n * m_dimension]);
+      uint64_t move = moves.next();
+      sites[(n * m_dimension) + (move >> 1)] += (move & 1) != 0 ? 1 : -1;
+    }
+    return Ok(std::move(sites));
+  }
+
+  /**
+   * @brief Simulates a walk and records the number of distinct visited sites
+   * @param num_steps The number of steps to simulate
+   * @param visited Scratch set, cleared before use
+   * @return Result containing S(n) for n = 0..num_steps, or an Error
+   */
+  auto distinct_sites(size_t num_steps, SiteSet &visited) const
+      -> Result<vector<size_t> > {
+    if (static_cast<int64_t>(num_steps) > lattice_coordinate_limit) {
+      return Err(Error::InvalidArgument(std::format(
+          "Number of steps must be at most {}", lattice_coordinate_limit)));
+    }
+    vector<size_t> distinct(num_steps + 1);
+    std::array<int64_t, 3> site{0, 0, 0};
+    LatticeMoves moves(m_dimension);
+    visited.clear();
+    visited.insert(pack_site(site));
+    distinct[0] = 1;
+    for (size_t n = 1; n <= num_steps; ++n) {
+      uint64_t move = moves.next();
+      site[move >> 1] += (move & 1) != 0 ? 1 : -1;
+      visited.insert(pack_site(site));
+      distinct[n] = visited.size();
+    }
+    return Ok(std::move(distinct));
+  }
+
+  /**
+   * @brief Simulates a walk and records the number of distinct visited sites
+   * @param num_steps The number of steps to simulate
+   * @return Result containing S(n) for n = 0..num_steps, or an Error
+   */
+  auto distinct_sites(size_t num_steps) const -> Result<vector<size_t> > {
+    SiteSet visited(num_steps + 1);
+    return distinct_sites(num_steps, visited);
+  }
+};
+
+/**
+ * @brief Ensemble statistics of lattice walks started at the origin
+ */
+export struct LatticeVisitStatistics {
+  size_t dimension = 0;   ///< Lattice dimension
+  size_t num_walkers = 0; ///< Number of walks
+  vector<double> mean_distinct;     ///< ⟨S(n)⟩ for n = 0..num_steps
+  vector<double> variance_distinct; ///< Var[S(n)]
+  vector<double> first_return;      ///< P(first return to the origin at step n)
+  vector<double> return_probability; ///< P(return to the origin by step n)
+};
+
+/**
+ * @brief Distinct-site and return statistics of an ensemble of lattice walks
+ * @param dimension Lattice dimension (1, 2 or 3)
+ * @param num_walkers Number of walks
+ * @param num_steps Number of steps per walk
+ * @return Result containing the statistics, or an Error
+ *
+ * Walks are split over the placed worker threads; each worker reuses a
+ * single `SiteSet` for all its walks.
+ */
+export auto lattice_visit_statistics(size_t dimension, size_t num_walkers,
+                                     size_t num_steps)
+    -> Result<LatticeVisitStatistics> {
+  if (dimension < 1 || dimension > 3) {
+    return Err(Error::InvalidArgument("Dimension must be 1, 2 or 3"));
+  }
+  if (num_walkers == 0) {
+    return Err(Error::InvalidArgument("Number of walkers must be positive"));
+  }
+  if (static_cast<int64_t>(num_steps) > lattice_coordinate_limit) {
+    return Err(Error::InvalidArgument(std::format(
+        "Number of steps must be at most {}", lattice_coordinate_limit)));
+  }
+  size_t workers = std::min(default_workers(), num_walkers);
+  struct Partial {
+    vector<double> sum;
+    vector<double> sum_sq;
+    vector<size_t> first_return;
+  };
+  vector<Partial> partial(workers);
+  run_placed(workers, workers, [&](size_t begin, size_t end) {
+    SiteSet visited(num_steps + 1);
+    LatticeMoves moves(dimension);
+    for (size_t i = begin; i < end; ++i) {
+      auto &p = partial[i];
+      p.sum.assign(num_steps + 1, 0.0);
+      p.sum_sq.assign(num_steps + 1, 0.0);
+      p.first_return.assign(num_steps + 1, 0);
+      size_t share =
+          (num_walkers / workers) + (i < num_walkers % workers ? 1 : 0);
+      for (size_t k = 0; k < share; ++k) {
+        std::array<int64_t, 3> site{0, 0, 0};
+        visited.clear();
+        visited.insert(pack_site(site));
+        bool returned = false;
+        p.sum[0] += 1.0;
+        p.sum_sq[0] += 1.0;
+        for (size_t n = 1; n <= num_steps; ++n) {
+          uint64_t move = moves.next();
+          site[move >> 1] += (move & 1) != 0 ? 1 : -1;
+          visited.insert(pack_site(site));
+          auto s = static_cast<double>(visited.size());
+          p.sum[n] += s;
+          p.sum_sq[n] += s * s;
+          if (!returned && site[0] == 0 && site[1] == 0 && site[2] == 0) {
+            returned = true;
+            ++p.first_return[n];
+          }
+        }
+      }
+    }
+  });
+
+  LatticeVisitStatistics result;
+  result.dimension = dimension;
+  result.num_walkers = num_walkers;
+  result.mean_distinct.assign(num_steps + 1, 0.0);
+  result.variance_distinct.assign(num_steps + 1, 0.0);
+  result.first_return.assign(num_steps + 1, 0.0);
+  result.return_probability.assign(num_steps + 1, 0.0);
+  auto total = static_cast<double>(num_walkers);
+  vector<double> sum_sq(num_steps + 1, 0.0);
+  for (const auto &p : partial) {
+    for (size_t n = 0; n <= num_steps; ++n) {
+      result.mean_distinct[n] += p.sum[n];
+      sum_sq[n] += p.sum_sq[n];
+      result.first_return[n] += static_cast<double>(p.first_return[n]);
+    }
+  }
+  double returned = 0.0;
+  for (size_t n = 0; n <= num_steps; ++n) {
+    result.mean_distinct[n] /= total;
+    result.variance_distinct[n] = std::max(
+        0.0, (sum_sq[n] / total) -
+                 (result.mean_distinct[n] * result.mean_distinct[n]));
+    returned += result.first_return[n];
+    result.first_return[n] /= total;
+    result.return_probability[n] = returned / total;
+  }
+  return Ok(std::move(result));
+}
+
+/**
+ * @brief Cover times of lattice walks on a periodic box
+ */
+export struct CoverTimeStatistics {
+  size_t dimension = 0; ///< Lattice dimension
+  size_t side = 0;      ///< Side length of the periodic box
+  vector<size_t> cover_times; ///< Cover time of each walk that covered the box
+  size_t uncovered = 0; ///< Walks that did not cover the box within max_steps
+
+  /**
+   * @brief Computes the mean cover time
+   * @return The mean over walks that covered the box, or None if there are none
+   */
+  [[nodiscard]] auto mean() const -> Option<double> {
+    if (cover_times.empty()) {
+      return std::nullopt;
+    }
+    double sum = 0.0;
+    for (size_t t : cover_times) {
+      sum += static_cast<double>(t);
+    }
+    return sum / static_cast<double>(cover_times.size());
+  }
+};
+
+/**
+ * @brief Cover times of lattice walks on the periodic box (Z / side Z)^d
+ * @param dimension Lattice dimension (1, 2 or 3)
+ * @param side Side length of the box (at least 2)
+ * @param num_walkers Number of walks
+ * @param max_steps Maximum number of steps per walk
+ * @return Result containing the cover times, or an Error
+ *
+ * The cover time is the number of steps until every site of the box has
+ * been visited. Each worker reuses a single `SiteBitmap` of side^d bits.
+ */
+export auto lattice_cover_time(size_t dimension, size_t side,
+                               size_t num_walkers, size_t max_steps)
+    -> Result<CoverTimeStatistics> {
+  if (dimension < 1 || dimension > 3) {
+    return Err(Error::InvalidArgument("Dimension must be 1, 2 or 3"));
+  }
+  if (side < 2) {
+    return Err(Error::InvalidArgument("Side length must be at least 2"));
+  }
+  if (num_walkers == 0) {
+    return Err(Error::InvalidArgument("Number of walkers must be positive"));
+  }
+  size_t sites = 1;
+  for (size_t d = 0; d < dimension; ++d) {
+    sites *= side;
+  }
+  if (sites > (size_t{1} << 32)) {
+    return Err(Error::InvalidArgument("Box must have at most 2^32 sites"));
+  }
+  std::array<size_t, 3> stride{1, side, side * side};
+
+  vector<size_t> times(num_walkers, 0);
+  run_placed(num_walkers, default_workers(), [&](size_t begin, size_t end) {
+    SiteBitmap visited(sites);
+    LatticeMoves moves(dimension);
+    for (size_t k = begin; k < end; ++k) {
+      std::array<size_t, 3> site{0, 0, 0};
+      size_t index = 0;
+      visited.clear();
+      visited.insert(index);
+      size_t n = 0;
+      while (visited.size() < sites && n < max_steps) {
+        uint64_t move = moves.next();
+        size_t axis = move >> 1;
+        size_t &x = site[axis];
+        if ((move & 1) != 0) {
+          x = x + 1 == side ? 0 : x + 1;
+          index = x == 0 ? index - ((side - 1) * stride[axis])
+                         : index + stride[axis];
+        } else {
+          x = x == 0 ? side - 1 : x - 1;
+          index = x == side - 1 ? index + ((side - 1) * stride[axis])
+                                : index - stride[axis];
+        }
+        visited.insert(index);
+        ++n;
+      }
+      times[k] = visited.size() == sites ? n : 0;
+    }
+  });
+
+  CoverTimeStatistics result;
+  result.dimension = dimension;
+  result.side = side;
+  for (size_t t : times) {
+    if (t == 0) {
+      ++result.uncovered;
+    } else {
+      result.cover_times.push_back(t);
+    }
+  }
+  return Ok(std::move(result));
+}
@@ -0,0 +1,505 @@
+/**
+ * @file multispin.cppm
+ * @brief Multi-spin coded lattice random walks (64 walkers per machine word)
+ *
+ * Ensembles of independent nearest-neighbour walkers on the 1D or 2D lattice
+ * are stored bit-sliced: bit j of plane b of coordinate d of word w is bit b
+ * of the coordinate d of walker 64 w + j, relative to the lower corner of the
+ * region. One step of 64 walkers takes one or two random words and a ripple
+ * carry/borrow over the bit planes, and boundary hits are detected with
+ * word-wide masks, so the per-walker cost is a small fraction of a
+ * `SimpleRandomWalk` step.
+ */
+
+module;
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.simulation.discrete.multispin;
+
+import diffusionx.error;
+import diffusionx.random.utils;
+
+using std::vector;
+
+/**
+ * @brief Ensemble of walkers on a box of the 1D or 2D lattice, bit-sliced
+ *
+ * Each walker moves to one of its 2d nearest neighbours per step, choosing
+ * the axis uniformly and the positive direction with a given probability.
+ * Walkers start at the same site inside the box [lower, upper]; in absorbing
+ * mode a walker stops when one of its coordinates reaches lower or upper.
+ */
+export class MultiSpinWalkers {
+  size_t m_dimension;             ///< Lattice dimension (1 or 2)
+  size_t m_num_walkers;           ///< Number of walkers
+  size_t m_words;                 ///< Number of 64-walker words
+  size_t m_bits;                  ///< Bit planes per coordinate
+  bool m_absorbing;               ///< Whether walkers stop at the boundary
+  vector<int64_t> m_lower;        ///< Lower corner of the box
+  vector<uint64_t> m_extent;      ///< upper - lower per dimension
+  vector<uint64_t> m_planes;      ///< Planes, index ((w * dim) + d) * bits + b
+  vector<uint64_t> m_alive;       ///< Walkers still moving, one bit per walker
+  uint64_t m_threshold;           ///< P(positive direction) * 2^32
+  size_t m_steps = 0;             ///< Number of steps taken
+  std::mt19937_64 m_gen;          ///< Source of random words
+
+  /**
+   * @brief Draws a word whose bits are 1 with probability m_threshold / 2^32
+   */
+  auto biased_word() -> uint64_t {
+    if (m_threshold >= (uint64_t{1} << 32)) {
+      return ~uint64_t{0};
+    }
+    uint64_t word = 0;
+    for (int k = std::countr_zero(m_threshold); k < 32; ++k) {
+      uint64_t r = m_gen();
+      word = ((m_threshold >> k) & 1) != 0 ? (word | r) : (word & r);
+    }
+    return word;
+  }
+
+public:
+  /**
+   * @brief Constructor
+   * @param lower Lower corner of the box, one entry per dimension (1 or 2)
+   * @param upper Upper corner of the box
+   * @param start Starting site of every walker, inside the box
+   * @param num_walkers Number of walkers
+   * @param probability Probability of a step in the positive direction
+   * @param absorbing Whether walkers stop when they reach the boundary
+   * @throws std::invalid_argument if the parameters are inconsistent
+   *
+   * The number of bit planes is the bit width of upper - lower. In
+   * non-absorbing mode the walkers must not leave the box, e.g. a box of
+   * half-width n around the start for n steps.
+   */
+  MultiSpinWalkers(vector<int64_t> lower, vector<int64_t> upper,
+                   vector<int64_t> start, size_t num_walkers,
+                   double probability = 0.5, bool absorbing = true)
+      : m_dimension(lower.size()), m_num_walkers(num_walkers),
+        m_words((num_walkers + 63) / 64), m_absorbing(absorbing),
+        m_lower(std::move(lower)), m_gen(generator()()) {
+    if (m_dimension != 1 && m_dimension != 2) {
+      throw std::invalid_argument("Dimension must be 1 or 2");
+    }
+    if (upper.size() != m_dimension || start.size() != m_dimension) {
+      throw std::invalid_argument("Lower, upper and start must have the same size");
+    }
+    if (num_walkers == 0) {
+      throw std::invalid_argument("Number of walkers must be positive");
+    }
+    if (probability < 0.0 || probability > 1.0) {
+      throw std::invalid_argument("Probability must be in [0, 1]");
+    }
+    uint64_t widest = 1;
+    for (size_t d = 0; d < m_dimension; ++d) {
+      if (start[d] <= m_lower[d] || start[d] >= upper[d]) {
+        throw std::invalid_argument("Start must lie strictly inside the box");
+      }
+      m_extent.push_back(static_cast<uint64_t>(upper[d] - m_lower[d]));
+      widest = std::max(widest, m_extent.back());
+    }
+    m_bits = static_cast<size_t>(std::bit_width(widest));
+    m_threshold =
+        static_cast<uint64_t>(std::llround(probability * 4294967296.0));
+
+    m_planes.assign(m_words * m_dimension * m_bits, 0);
+    for (size_t w = 0; w < m_words; ++w) {
+      for (size_t d = 0; d < m_dimension; ++d) {
+        auto offset = static_cast<uint64_t>(start[d] - m_lower[d]);
+        for (size_t b = 0; b < m_bits; ++b) {
+          m_planes[((w * m_dimension) + d) * m_bits + b] =
+              ((offset >> b) & 1) != 0 ? ~uint64_t{0} : 0;
+        }
+      }
+    }
+    m_alive.assign(m_words, ~uint64_t{0});
+    if (num_walkers % 64 != 0) {
+      m_alive.back() = (uint64_t{1} << (num_walkers % 64)) - 1;
+    }
+  }
+
+  /**
+   * @brief Advances every moving walker by one step
+   * @return The number of walkers absorbed in this step
+   */
+  auto step() -> size_t {
+    size_t absorbed = 0;
+    for (size_t w = 0; w < m_words; ++w) {
+      uint64_t alive = m_alive[w];
+      if (alive == 0) {
+        continue;
+      }
+      uint64_t axis = m_dimension == 2 ? m_gen() : 0;
+      uint64_t positive = m_threshold == (uint64_t{1} << 31) ? m_gen()
+                                                             : biased_word();
+      uint64_t hit = 0;
+      for (size_t d = 0; d < m_dimension; ++d) {
+        uint64_t moving = alive & (d == 0 ? ~axis : axis);
+        uint64_t carry = moving & positive;
+        uint64_t borrow = moving & ~positive;
+        uint64_t *planes = &m_planes[((w * m_dimension) + d) * m_bits];
+        uint64_t at_zero = ~uint64_t{0};
+        uint64_t at_extent = ~uint64_t{0};
+        for (size_t b = 0; b < m_bits; ++b) {
+          uint64_t p = planes[b];
+          uint64_t q = p ^ (carry | borrow);
+          carry &= p;
+          borrow &= ~p;
+          planes[b] = q;
+          at_zero &= ~q;
+          at_extent &= ((m_extent[d] >> b) & 1) != 0 ? q : ~q;
+        }
+        hit |= at_zero | at_extent;
+      }
+      if (m_absorbing) {
+        hit &= alive;
+        m_alive[w] = alive & ~hit;
+        absorbed += static_cast<size_t>(std::popcount(hit));
+      }
+    }
+    ++m_steps;
+    return absorbed;
+  }
+
+  /**
+   * @brief Gets the number of walkers that are still moving
+   * @return The number of walkers not absorbed so far
+   */
+  [[nodiscard]] auto get_alive() const -> size_t {
+    size_t alive = 0;
+    for (uint64_t word : m_alive) {
+      alive += static_cast<size_t>(std::popcount(word));
+    }
+    return alive;
+  }
+
+  /**
+   * @brief Gets the number of steps taken
+   * @return The number of calls to `step`
+   */
+  [[nodiscard]] auto get_steps() const -> size_t { return m_steps; }
+
+  /**
+   * @brief Gets the number of walkers
+   * @return The number of walkers
+   */
+  [[nodiscard]] auto get_num_walkers() const -> size_t {
+    return m_num_walkers;
+  }
+
+  /**
+   * @brief Gets the lattice dimension
+   * @return 1 or 2
+   */
+  [[nodiscard]] auto get_dimension() const -> size_t { return m_dimension; }
+
+  /**
+   * @brief Checks whether a walker is still moving
+   * @param walker The walker index
+   * @return True if the walker has not been absorbed
+   */
+  [[nodiscard]] auto is_alive(size_t walker) const -> bool {
+    return ((m_alive[walker / 64] >> (walker % 64)) & 1) != 0;
+  }
+
+  /**
+   * @brief Decodes the position of one walker
+   * @param walker The walker index
+   * @param d The coordinate (0 or 1)
+   * @return The coordinate d of the walker
+   */
+  [[nodiscard]] auto position(size_t walker, size_t d) const -> int64_t {
+    size_t w = walker / 64;
+    size_t j = walker % 64;
+    const uint64_t *planes = &m_planes[((w * m_dimension) + d) * m_bits];
+    uint64_t offset = 0;
+    for (size_t b = 0; b < m_bits; ++b) {
+      offset |= ((planes[b] >> j) & 1) << b;
+    }
+    return m_lower[d] + static_cast<int64_t>(offset);
+  }
+
+  /**
+   * @brief Decodes the positions of all walkers
+   * @return Row-major positions, get_dimension() coordinates per walker
+   */
+  [[nodiscard]] auto positions() const -> vector<int64_t> {
+    vector<int64_t> result(m_num_walkers * m_dimension);
+    for (size_t i = 0; i < m_num_walkers; ++i) {
+      for (size_t d = 0; d < m_dimension; ++d) {
+        result[(i * m_dimension) + d] = position(i, d);
+      }
+    }
+    return result;
+  }
+};
+
+/**
+ * @brief First-passage time histogram of an ensemble of walkers
+ */
+export struct FirstPassageHistogram {
+  vector<size_t> counts; ///< counts[n] walkers were absorbed at step n
+  size_t survivors = 0;  ///< Walkers not absorbed within the simulated steps
+  size_t num_walkers = 0; ///< Total number of walkers
+
+  /**
+   * @brief Computes the survival probability
+   * @return S(n), the fraction of walkers not absorbed after n steps
+   */
+  [[nodiscard]] auto survival() const -> vector<double> {
+    vector<double> result(counts.size());
+    size_t remaining = num_walkers;
+    for (size_t n = 0; n < counts.size(); ++n) {
+      remaining -= counts[n];
+      result[n] = static_cast<double>(remaining) /
+                  static_cast<double>(num_walkers);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Computes the mean first-passage time
+   * @return The mean over absorbed walkers, or None if none was absorbed
+   */
+  [[nodiscard]] auto mean() const -> Option<double> {
+    double sum = 0.0;
+    size_t absorbed = 0;
+    for (size_t n = 0; n < counts.size(); ++n) {
+      sum += static_cast<double>(n) * static_cast<double>(counts[n]);
+      absorbed += counts[n];
+    }
+    if (absorbed == 0) {
+      return std::nullopt;
+    }
+    return sum / static_cast<double>(absorbed);
+  }
+};
+
+/**
+ * @brief Histogram of walker positions after a fixed number of steps
+ */
+export struct EndpointHistogram {
+  size_t dimension = 1;  ///< Lattice dimension
+  vector<int64_t> lower; ///< Smallest reached coordinate per axis
+  vector<int64_t> upper; ///< Largest reached coordinate per axis
+  vector<size_t> counts; ///< Row-major counts over the box [lower, upper]
+
+  /**
+   * @brief Gets the count of a site
+   * @param x The first coordinate, relative to the start
+   * @param y The second coordinate (2D only)
+   * @return The number of walkers that ended at the site
+   */
+  [[nodiscard]] auto at(int64_t x, int64_t y = 0) const -> size_t {
+    if (x < lower[0] || x > upper[0]) {
+      return 0;
+    }
+    auto i = static_cast<size_t>(x - lower[0]);
+    if (dimension == 1) {
+      return counts[i];
+    }
+    if (y < lower[1] || y > upper[1]) {
+      return 0;
+    }
+    auto width = static_cast<size_t>(upper[1] - lower[1] + 1);
+    return counts[(i * width) + static_cast<size_t>(y - lower[1])];
+  }
+};
+
+auto check_multispin_box(const vector<int64_t> &lower,
+                         const vector<int64_t> &upper,
+                         const vector<int64_t> &start) -> Result<int> {
+  if (lower.size() != 1 && lower.size() != 2) {
+    return Err(Error::InvalidArgument("Dimension must be 1 or 2"));
+  }
+  if (upper.size() != lower.size() || start.size() != lower.size()) {
+    return Err(Error::InvalidArgument(
+        "Lower, upper and start must have the same size"));
+  }
+  for (size_t d = 0; d < lower.size(); ++d) {
+    if (start[d] <= lower[d] || start[d] >= upper[d]) {
+      return Err(Error::InvalidArgument(std::format(
+          "Start {} must lie strictly inside ({}, {})", start[d], lower[d],
+          upper[d])));
+    }
+  }
+  return Ok(0);
+}
+
+/**
+ * @brief Splits num_walkers into per-worker ensembles of whole words
+ */
+auto multispin_shares(size_t num_walkers) -> vector<size_t> {
+  size_t words = (num_walkers + 63) / 64;
+  size_t workers = std::min(default_workers(), words);
+  vector<size_t> shares(workers, 0);
+  size_t remaining = num_walkers;
+  for (size_t i = 0; i < workers; ++i) {
+    size_t share_words = (words / workers) + (i < words % workers ? 1 : 0);
+    shares[i] = std::min(remaining, share_words * 64);
+    remaining -= shares[i];
+  }
+  return shares;
+}
+
+/**
+ * @brief First-passage times of lattice walkers out of a box
+ * @param lower Lower corner of the box (1 or 2 entries)
+ * @param upper Upper corner of the box
+ * @param start Starting site, strictly inside the box
+ * @param num_walkers Number of walkers
+ * @param max_steps Maximum number of steps
+ * @param probability Probability of a step in the positive direction
+ * @return Result containing the first-passage histogram, or an Error
+ *
+ * A walker is absorbed at the first step at which one of its coordinates
+ * equals lower or upper. The ensemble is split over worker threads in
+ * multiples of 64 walkers, and stepping stops once every walker is absorbed.
+ */
+export auto multispin_first_passage(const vector<int64_t> &lower,
+                                    const vector<int64_t> &upper,
+                                    const vector<int64_t> &start,
+                                    size_t num_walkers, size_t max_steps,
+                                    double probability = 0.5)
+    -> Result<FirstPassageHistogram> {
+  if (auto res = check_multispin_box(lower, upper, start); !res) {
+    return Err(res.error());
+  }
+  if (num_walkers == 0) {
+    return Err(Error::InvalidArgument("Number of walkers must be positive"));
+  }
+  if (probability < 0.0 || probability > 1.0) {
+    return Err(Error::InvalidArgument("Probability must be in [0, 1]"));
+  }
+  auto shares = multispin_shares(num_walkers);
+  vector<vector<size_t> > partial(shares.size());
+  vector<size_t> survivors(shares.size(), 0);
+  run_placed(shares.size(), shares.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      MultiSpinWalkers walkers(lower, upper, start, shares[i], probability);
+      auto &counts = partial[i];
+      counts.assign(max_steps + 1, 0);
+      size_t alive = shares[i];
+      for (size_t n = 1; n <= max_steps && alive > 0; ++n) {
+        counts[n] = walkers.step();
+        alive -= counts[n];
+      }
+      survivors[i] = alive;
+    }
+  });
+
+  FirstPassageHistogram result;
+  result.num_walkers = num_walkers;
+  result.counts.assign(max_steps + 1, 0);
+  for (size_t i = 0; i < shares.size(); ++i) {
+    for (size_t n = 0; n <= max_steps; ++n) {
+      result.counts[n] += partial[i][n];
+    }
+    result.survivors += survivors[i];
+  }
+  return Ok(std::move(result));
+}
+
+/**
+ * @brief Endpoint histogram of free lattice walkers after a number of steps
+ * @param dimension Lattice dimension (1 or 2)
+ * @param num_walkers Number of walkers
+ * @param num_steps Number of steps
+ * @param probability Probability of a step in the positive direction
+ * @return Result containing the endpoint histogram relative to the start, or an Error
+ */
+export auto multispin_endpoints(size_t dimension, size_t num_walkers,
+                                size_t num_steps, double probability = 0.5)
+    -> Result<EndpointHistogram> {
+  if (dimension != 1 && dimension != 2) {
+    return Err(Error::InvalidArgument("Dimension must be 1 or 2"));
+  }
+  if (num_walkers == 0) {
+    return Err(Error::InvalidArgument("Number of walkers must be positive"));
+  }
+  if (probability < 0.0 || probability > 1.0) {
+    return Err(Error::InvalidArgument("Probability must be in [0, 1]"));
+  }
+  auto radius = static_cast<int64_t>(num_steps);
+  vector<int64_t> lower(dimension, -radius - 1);
+  vector<int64_t> upper(dimension, radius + 1);
+  vector<int64_t> start(dimension, 0);
+
+  // Each share histograms the box its walkers actually reached, which is
+  // O(√n) wide rather than 2n + 1, and the boxes are merged once at the end
+  auto shares = multispin_shares(num_walkers);
+  vector<EndpointHistogram> partial(shares.size());
+  run_placed(shares.size(), shares.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      MultiSpinWalkers walkers(lower, upper, start, shares[i], probability,
+                               false);
+      for (size_t n = 0; n < num_steps; ++n) {
+        walkers.step();
+      }
+      auto positions = walkers.positions();
+      auto &h = partial[i];
+      h.dimension = dimension;
+      h.lower.assign(dimension, radius);
+      h.upper.assign(dimension, -radius);
+      for (size_t k = 0; k < positions.size(); ++k) {
+        size_t d = k % dimension;
+        h.lower[d] = std::min(h.lower[d], positions[k]);
+        h.upper[d] = std::max(h.upper[d], positions[k]);
+      }
+      auto width = static_cast<size_t>(h.upper.back() - h.lower.back() + 1);
+      auto rows = static_cast<size_t>(h.upper[0] - h.lower[0] + 1);
+      h.counts.assign(dimension == 1 ? rows : rows * width, 0);
+      for (size_t k = 0; k < shares[i]; ++k) {
+        auto x = static_cast<size_t>(positions[k * dimension] - h.lower[0]);
+        if (dimension == 1) {
+          ++h.counts[x];
+        } else {
+          auto y = static_cast<size_t>(positions[(k * 2) + 1] - h.lower[1]);
+          ++h.counts[(x * width) + y];
+        }
+      }
+    }
+  });
+
+  EndpointHistogram result;
+  result.dimension = dimension;
+  result.lower.assign(dimension, radius);
+  result.upper.assign(dimension, -radius);
+  for (const auto &h : partial) {
+    for (size_t d = 0; d < dimension; ++d) {
+      result.lower[d] = std::min(result.lower[d], h.lower[d]);
+      result.upper[d] = std::max(result.upper[d], h.upper[d]);
+    }
+  }
+  auto width = static_cast<size_t>(result.upper.back() - result.lower.back() + 1);
+  auto rows = static_cast<size_t>(result.upper[0] - result.lower[0] + 1);
+  result.counts.assign(dimension == 1 ? rows : rows * width, 0);
+  for (const auto &h : partial) {
+    auto x0 = static_cast<size_t>(h.lower[0] - result.lower[0]);
+    if (dimension == 1) {
+      for (size_t x = 0; x < h.counts.size(); ++x) {
+        result.counts[x0 + x] += h.counts[x];
+      }
+      continue;
+    }
+    auto y0 = static_cast<size_t>(h.lower[1] - result.lower[1]);
+    auto h_width = static_cast<size_t>(h.upper[1] - h.lower[1] + 1);
+    for (size_t x = 0; x < h.counts.size() / h_width; ++x) {
+      for (size_t y = 0; y < h_width; ++y) {
+        result.counts[((x0 + x) * width) + y0 + y] += h.counts[(x * h_width) + y];
+      }
+    }
+  }
+  return Ok(std::move(result));
+}
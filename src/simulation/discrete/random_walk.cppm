@@ -1,12 +1,20 @@
 module;
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <random>
+#include <span>
+#include <stdexcept>
+#include <variant>
 #include <vector>
 
 export module diffusionx.simulation.discrete.random_walk;
 
 import diffusionx.error;
+import diffusionx.random.alias;
 import diffusionx.random.uniform;
+import diffusionx.random.utils;
 import diffusionx.random.stable;
 import diffusionx.simulation.basic.abstract;
 import diffusionx.simulation.basic.utils;
@@ -339,4 +347,160 @@ public:
   [[nodiscard]] auto has_finite_variance() const -> bool {
     return std::abs(m_alpha - 2.0) < 1e-10;
   }
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Random walk with jumps from an arbitrary distribution
+ *
+ * The jumps are i.i.d. and either take finitely many values with a given
+ * probability mass function, sampled in O(1) with an alias table, or follow
+ * a continuous histogram distribution, sampled with a guide-table inverse
+ * CDF. Both replace linear scans of the CDF, whose cost grows with the
+ * number of bins.
+ */
+export class DiscreteJumpWalk : public DiscreteProcess {
+  std::variant<AliasTable, GuideTable> m_distribution; ///< Jump sampler
+  vector<double> m_jumps;        ///< Jump values of the alias table outcomes
+  double m_start_position = 0.0; ///< Initial position
+  double m_jump_mean = 0.0;      ///< Mean of one jump
+  double m_jump_variance = 1.0;  ///< Variance of one jump
+
+public:
+  /**
+   * @brief Default constructor creating a simple symmetric random walk
+   */
+  DiscreteJumpWalk() : DiscreteJumpWalk({-1.0, 1.0}, {0.5, 0.5}) {}
+
+  /**
+   * @brief Constructs a walk with finitely many jump values
+   * @param jumps The possible jumps
+   * @param pmf Their (unnormalized) probabilities, same size as jumps
+   * @param start_position Initial position
+   * @throws std::invalid_argument if the sizes differ or the pmf is invalid
+   */
+  DiscreteJumpWalk(vector<double> jumps, const vector<double> &pmf,
+                   double start_position = 0.0)
+      : m_distribution(AliasTable(pmf)), m_jumps(std::move(jumps)),
+        m_start_position(start_position) {
+    if (m_jumps.size() != pmf.size()) {
+      throw std::invalid_argument(
+          "Jumps and probabilities must have the same size");
+    }
+    const auto &table = std::get<AliasTable>(m_distribution);
+    double second = 0.0;
+    for (size_t i = 0; i < m_jumps.size(); ++i) {
+      m_jump_mean += table.probability(i) * m_jumps[i];
+      second += table.probability(i) * m_jumps[i] * m_jumps[i];
+    }
+    m_jump_variance = std::max(0.0, second - (m_jump_mean * m_jump_mean));
+  }
+
+  /**
+   * @brief Constructs a walk with jumps from a histogram distribution
+   * @param jumps The jump distribution
+   * @param start_position Initial position
+   */
+  explicit DiscreteJumpWalk(GuideTable jumps, double start_position = 0.0)
+      : m_distribution(std::move(jumps)), m_start_position(start_position) {
+    const auto &table = std::get<GuideTable>(m_distribution);
+    m_jump_mean = table.mean();
+    m_jump_variance = table.variance();
+  }
+
+  /**
+   * @brief Gets the initial position
+   * @return The initial position
+   */
+  [[nodiscard]] auto get_start_position() const -> double {
+    return m_start_position;
+  }
+
+  /**
+   * @brief Draws independent jumps
+   * @param out The output buffer
+   * @param gen The random number generator
+   */
+  void fill_jumps(std::span<double> out, std::mt19937 &gen) const {
+    if (const auto *table = std::get_if<AliasTable>(&m_distribution)) {
+      constexpr size_t block = 256;
+      std::array<uint32_t, block> indices{};
+      for (size_t done = 0; done < out.size(); done += block) {
+        size_t count = std::min(block, out.size() - done);
+        table->fill(std::span(indices).first(count), gen);
+        for (size_t k = 0; k < count; ++k) {
+          out[done + k] = m_jumps[indices[k]];
+        }
+      }
+    } else {
+      std::get<GuideTable>(m_distribution).fill(out, gen);
+    }
+  }
+
+  /**
+   * @brief Simulates a trajectory of the random walk
+   * @param num_steps The number of steps to simulate
+   * @return Result containing step numbers and position vectors, or an Error
+   */
+  Result<discrete_pair> simulate(size_t num_steps) override {
+    thread_local static std::mt19937 gen = generator();
+    vector<size_t> steps(num_steps + 1);
+    vector<double> positions(num_steps + 1);
+    fill_jumps(std::span(positions).subspan(1), gen);
+    steps[0] = 0;
+    positions[0] = m_start_position;
+    for (size_t i = 1; i <= num_steps; ++i) {
+      steps[i] = i;
+      positions[i] += positions[i - 1];
+    }
+    return Ok(std::make_pair(std::move(steps), std::move(positions)));
+  }
+
+  /**
+   * @brief Simulates the end points of an ensemble of walks
+   * @param num_steps The number of steps per walk
+   * @param num_walkers The number of walks
+   * @return Result containing X(num_steps) of each walk, or an Error
+   *
+   * Walks are split over the worker threads; each worker draws the jumps of
+   * its walks in blocks and never materializes a trajectory.
+   */
+  [[nodiscard]] auto endpoints(size_t num_steps, size_t num_walkers) const
+      -> Result<vector<double> > {
+    vector<double> result(num_walkers);
+    run_placed(num_walkers, default_workers(), [&](size_t begin, size_t end) {
+      thread_local static std::mt19937 gen = generator();
+      constexpr size_t block = 1024;
+      vector<double> jumps(std::min(block, num_steps));
+      for (size_t k = begin; k < end; ++k) {
+        double x = m_start_position;
+        for (size_t done = 0; done < num_steps; done += block) {
+          auto chunk = std::span(jumps).first(std::min(block, num_steps - done));
+          fill_jumps(chunk, gen);
+          for (double jump : chunk) {
+            x += jump;
+          }
+        }
+        result[k] = x;
+      }
+    });
+    return Ok(std::move(result));
+  }
+
+  /**
+   * @brief Computes the theoretical mean at step n
+   * @param n Step number
+   * @return The theoretical mean E[X(n)]
+   */
+  [[nodiscard]] auto theoretical_mean(size_t n) const -> double {
+    return m_start_position + (static_cast<double>(n) * m_jump_mean);
+  }
+
+  /**
+   * @brief Computes the theoretical variance at step n
+   * @param n Step number
+   * @return The theoretical variance Var[X(n)]
+   */
+  [[nodiscard]] auto theoretical_variance(size_t n) const -> double {
+    return static_cast<double>(n) * m_jump_variance;
+  }
+};
@@ -0,0 +1,451 @@
+/**
+ * @file trap.cppm
+ * @brief Bouchaud trap model on Z^d with hash-derived quenched disorder
+ *
+ * In the trap model every site x carries a depth τ_x drawn from the Pareto
+ * law P(τ > s) = s^(-α), s >= 1. A walker sits on x for an exponential time
+ * with mean τ_x and then jumps to a uniformly chosen nearest neighbour. With
+ * quenched disorder the depths are frozen, so a walker meets the same trap
+ * again whenever it revisits a site; with annealed disorder a fresh depth is
+ * drawn on every visit, which turns the model into a continuous-time random
+ * walk with Pareto waiting times.
+ *
+ * Storing the depths of an unbounded lattice is not possible, and not
+ * needed: the depth of a site is a pure function of a landscape seed and
+ * the packed site, computed with a counter-based hash whenever the walker
+ * arrives. Walks mostly return to recently visited sites, so each walker
+ * can keep a small direct-mapped `TrapCache` in front of the hash.
+ */
+
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+export module diffusionx.simulation.discrete.trap;
+
+import diffusionx.error;
+import diffusionx.random.utils;
+import diffusionx.simulation.discrete.lattice;
+
+using std::vector;
+
+/**
+ * @brief Counter-based hash of a landscape seed and a site key
+ * @param seed The landscape seed
+ * @param key The site key, e.g. a packed site (see `pack_site`)
+ * @return 64 well-mixed bits, a pure function of (seed, key)
+ *
+ * Two rounds of the splitmix64 finalizer over the key offset by the seed;
+ * nearby keys and nearby seeds give unrelated outputs.
+ */
+export constexpr auto trap_hash(uint64_t seed, uint64_t key) -> uint64_t {
+  uint64_t z = (key * 0x9e3779b97f4a7c15ULL) ^ seed;
+  for (int round = 0; round < 2; ++round) {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+  }
+  return z;
+}
+
+/**
+ * @brief Maps 64 random bits to a Pareto trap depth
+ * @param bits Random bits
+ * @param inverse_alpha 1 / α
+ * @return U^(-1/α) with U = the top 53 bits as a uniform in (0, 1]
+ */
+auto trap_depth_from_bits(uint64_t bits, double inverse_alpha) -> double {
+  double u = static_cast<double>((bits >> 11) + 1) * 0x1.0p-53;
+  return std::pow(u, -inverse_alpha);
+}
+
+/**
+ * @brief Small direct-mapped cache of trap depths
+ *
+ * Slot `hash & mask` holds the last depth looked up for any key mapping to
+ * it, so a lookup is one comparison and collisions simply evict. Since
+ * packed sites are never zero, zero marks an empty slot. A capacity of zero
+ * disables the cache.
+ */
+export class TrapCache {
+  vector<uint64_t> m_keys; ///< Cached keys, 0 for empty slots
+  vector<double> m_depths; ///< Depths of the cached keys
+  size_t m_mask = 0;       ///< Number of slots - 1
+  size_t m_hits = 0;       ///< Lookups answered from the cache
+  size_t m_lookups = 0;    ///< Lookups since construction
+
+public:
+  /**
+   * @brief Constructor
+   * @param capacity Number of slots, rounded up to a power of two (0
+   * disables the cache)
+   */
+  explicit TrapCache(size_t capacity = 64) {
+    if (capacity > 0) {
+      m_keys.assign(std::bit_ceil(capacity), 0);
+      m_depths.assign(m_keys.size(), 0.0);
+      m_mask = m_keys.size() - 1;
+    }
+  }
+
+  /**
+   * @brief Looks up a depth, computing and caching it on a miss
+   * @param key The packed site
+   * @param hash Hash of the key, used to pick the slot
+   * @param compute Callable returning the depth of the key
+   * @return The depth of the key
+   */
+  template <typename F>
+  auto lookup(uint64_t key, uint64_t hash, F &&compute) -> double {
+    ++m_lookups;
+    if (m_keys.empty()) {
+      return compute();
+    }
+    size_t slot = hash & m_mask;
+    if (m_keys[slot] == key) {
+      ++m_hits;
+      return m_depths[slot];
+    }
+    double depth = compute();
+    m_keys[slot] = key;
+    m_depths[slot] = depth;
+    return depth;
+  }
+
+  /**
+   * @brief Empties the cache, e.g. before switching landscapes
+   */
+  void clear() { std::fill(m_keys.begin(), m_keys.end(), 0); }
+
+  /**
+   * @brief Gets the number of slots
+   * @return The capacity, 0 if the cache is disabled
+   */
+  [[nodiscard]] auto capacity() const -> size_t { return m_keys.size(); }
+
+  /**
+   * @brief Gets the fraction of lookups answered from the cache
+   * @return The hit rate, 0 before the first lookup
+   */
+  [[nodiscard]] auto hit_rate() const -> double {
+    return m_lookups == 0 ? 0.0
+                          : static_cast<double>(m_hits) /
+                                static_cast<double>(m_lookups);
+  }
+};
+
+/**
+ * @brief How the depths seen by an ensemble of walkers are generated
+ */
+export enum class TrapDisorder {
+  Annealed, ///< A fresh depth on every visit (CTRW)
+  Quenched, ///< One frozen landscape shared by all walkers
+  QuenchedReplicas, ///< An independent frozen landscape per walker
+};
+
+/**
+ * @brief Trajectory of a trap-model walk
+ */
+export struct TrapTrajectory {
+  size_t dimension = 0;  ///< Lattice dimension
+  vector<double> times;  ///< Time of arrival at each site, starting at 0
+  vector<int64_t> sites; ///< Sites, row-major with dimension coordinates each
+  vector<double> depths; ///< Depth of each site at the time of the visit
+};
+
+/**
+ * @brief Ensemble statistics of trap-model walks on a time grid
+ */
+export struct TrapStatistics {
+  TrapDisorder disorder = TrapDisorder::Quenched; ///< Disorder of the run
+  size_t num_walkers = 0;   ///< Number of walks
+  vector<double> times;     ///< Observation times
+  vector<double> mean_squared_displacement; ///< ⟨|x(t)|²⟩
+  vector<double> mean_jumps; ///< ⟨n(t)⟩, the mean number of jumps
+  vector<double> mean_depth; ///< ⟨τ_x(t)⟩, the depth of the occupied trap
+  double cache_hit_rate = 0.0; ///< Fraction of depth lookups served by caches
+};
+
+/**
+ * @brief Bouchaud trap model on Z^d, d = 1, 2 or 3
+ *
+ * The landscape is identified by a seed: the depth of site x is
+ * `trap_hash(seed, pack_site(x))` mapped to a Pareto(α) variate, so walks
+ * with the same seed see the same traps without storing any of them. For
+ * α > 1 the mean depth α / (α - 1) is finite and the walk is diffusive at
+ * long times; for α < 1 it is subdiffusive, and quenched walks differ from
+ * annealed ones by the correlations between revisits.
+ */
+export class TrapModel {
+  size_t m_dimension = 1;  ///< Lattice dimension
+  double m_alpha = 0.5;    ///< Pareto exponent α of the depths
+  uint64_t m_seed = 0;     ///< Landscape seed
+  size_t m_cache_size = 64; ///< Slots of the per-walker depth cache
+
+  /**
+   * @brief Runs one walk started at the origin
+   *
+   * On every arrival visit(site, jumps, arrival, departure, depth) is called
+   * with the number of jumps so far and the time interval spent on the
+   * site; the walk stops as soon as visit returns false.
+   */
+  template <typename Visit>
+  auto walk(TrapDisorder disorder, uint64_t seed, TrapCache &cache,
+            LatticeMoves &moves, std::mt19937_64 &gen, Visit &&visit) const
+      -> Result<int> {
+    double inverse_alpha = 1.0 / m_alpha;
+    std::array<int64_t, 3> site{0, 0, 0};
+    double time = 0.0;
+    for (size_t jumps = 0;; ++jumps) {
+      double depth = 0.0;
+      if (disorder == TrapDisorder::Annealed) {
+        depth = trap_depth_from_bits(gen(), inverse_alpha);
+      } else {
+        uint64_t key = pack_site(site);
+        uint64_t bits = trap_hash(seed, key);
+        depth = cache.lookup(key, bits, [bits, inverse_alpha] {
+          return trap_depth_from_bits(bits, inverse_alpha);
+        });
+      }
+      double u = static_cast<double>((gen() >> 11) + 1) * 0x1.0p-53;
+      double departure = time - (depth * std::log(u));
+      if (!visit(site, jumps, time, departure, depth)) {
+        return Ok(0);
+      }
+      time = departure;
+      uint64_t move = moves.next();
+      int64_t &x = site[move >> 1];
+      x += (move & 1) != 0 ? 1 : -1;
+      if (std::abs(x) > lattice_coordinate_limit) {
+        return Err(Error::SimulationFailed(
+            std::format("Walk left the lattice region |x_i| <= {}",
+                        lattice_coordinate_limit)));
+      }
+    }
+  }
+
+public:
+  /**
+   * @brief Default constructor creating a 1D model with α = 1/2
+   */
+  TrapModel() = default;
+
+  /**
+   * @brief Constructor
+   * @param dimension Lattice dimension (1, 2 or 3)
+   * @param alpha Pareto exponent α of the depths (must be positive)
+   * @param seed Landscape seed
+   * @param cache_size Slots of the per-walker depth cache (0 disables it)
+   * @throws std::invalid_argument if the dimension or α is invalid
+   */
+  TrapModel(size_t dimension, double alpha, uint64_t seed,
+            size_t cache_size = 64)
+      : m_dimension(dimension), m_alpha(alpha), m_seed(seed),
+        m_cache_size(cache_size) {
+    if (dimension < 1 || dimension > 3) {
+      throw std::invalid_argument("Dimension must be 1, 2 or 3");
+    }
+    if (!(alpha > 0) || !std::isfinite(alpha)) {
+      throw std::invalid_argument(
+          std::format("alpha must be positive and finite, but got {}", alpha));
+    }
+  }
+
+  /**
+   * @brief Gets the lattice dimension
+   * @return The lattice dimension
+   */
+  [[nodiscard]] auto get_dimension() const -> size_t { return m_dimension; }
+
+  /**
+   * @brief Gets the Pareto exponent of the depths
+   * @return α
+   */
+  [[nodiscard]] auto get_alpha() const -> double { return m_alpha; }
+
+  /**
+   * @brief Gets the landscape seed
+   * @return The seed
+   */
+  [[nodiscard]] auto get_seed() const -> uint64_t { return m_seed; }
+
+  /**
+   * @brief Gets the size of the per-walker depth cache
+   * @return The number of cache slots requested
+   */
+  [[nodiscard]] auto get_cache_size() const -> size_t { return m_cache_size; }
+
+  /**
+   * @brief Computes the seed of the landscape of one replica
+   * @param replica The replica index
+   * @return The landscape seed used by walker `replica` under
+   * `TrapDisorder::QuenchedReplicas`
+   */
+  [[nodiscard]] auto replica_seed(uint64_t replica) const -> uint64_t {
+    return trap_hash(~m_seed, replica);
+  }
+
+  /**
+   * @brief Computes the depth of a site of the landscape
+   * @param site The coordinates (unused ones must be 0)
+   * @return The frozen depth τ_x >= 1
+   */
+  [[nodiscard]] auto depth(const std::array<int64_t, 3> &site) const
+      -> double {
+    return trap_depth_from_bits(trap_hash(m_seed, pack_site(site)),
+                                1.0 / m_alpha);
+  }
+
+  /**
+   * @brief Simulates one walk started at the origin
+   * @param duration The duration of the walk
+   * @param disorder Annealed or quenched depths; `QuenchedReplicas` uses the
+   * landscape of replica 0
+   * @return Result containing the jump trajectory up to the duration, or an
+   * Error
+   */
+  auto simulate(double duration,
+                TrapDisorder disorder = TrapDisorder::Quenched) const
+      -> Result<TrapTrajectory> {
+    if (!(duration > 0) || !std::isfinite(duration)) {
+      return Err(Error::InvalidArgument(std::format(
+          "Duration must be positive and finite, but got {}", duration)));
+    }
+    TrapTrajectory trajectory;
+    trajectory.dimension = m_dimension;
+    TrapCache cache(m_cache_size);
+    LatticeMoves moves(m_dimension);
+    std::mt19937_64 gen(generator()());
+    uint64_t seed =
+        disorder == TrapDisorder::QuenchedReplicas ? replica_seed(0) : m_seed;
+    auto visit = [&](const std::array<int64_t, 3> &site, size_t /*jumps*/,
+                     double arrival, double departure, double depth) {
+      trajectory.times.push_back(arrival);
+      trajectory.sites.insert(trajectory.sites.end(), site.begin(),
+                              site.begin() + m_dimension);
+      trajectory.depths.push_back(depth);
+      return departure <= duration;
+    };
+    auto res = walk(disorder, seed, cache, moves, gen, visit);
+    if (!res) {
+      return Err(res.error());
+    }
+    return Ok(std::move(trajectory));
+  }
+
+  /**
+   * @brief Displacement, jump and depth statistics of an ensemble of walks
+   * @param disorder How the depths are generated
+   * @param times Observation times (non-negative, non-decreasing)
+   * @param num_walkers Number of walks
+   * @return Result containing the statistics, or an Error
+   *
+   * Running the same model with `Annealed`, `Quenched` and
+   * `QuenchedReplicas` separates the effect of frozen traps from that of the
+   * waiting-time law: the annealed walk is a CTRW with the same single-visit
+   * statistics, and the replica run averages over landscapes as well as over
+   * walks. Walks are split over the placed worker threads, each with its own
+   * depth cache; under `QuenchedReplicas` the cache is cleared whenever its
+   * walker moves to a new landscape.
+   */
+  auto statistics(TrapDisorder disorder, const vector<double> &times,
+                  size_t num_walkers) const -> Result<TrapStatistics> {
+    if (num_walkers == 0) {
+      return Err(Error::InvalidArgument("Number of walkers must be positive"));
+    }
+    if (times.empty()) {
+      return Err(
+          Error::InvalidArgument("Observation times must not be empty"));
+    }
+    for (size_t k = 0; k < times.size(); ++k) {
+      if (!(times[k] >= 0) || !std::isfinite(times[k]) ||
+          (k > 0 && times[k] < times[k - 1])) {
+        return Err(Error::InvalidArgument("Observation times must be finite, "
+                                          "non-negative and non-decreasing"));
+      }
+    }
+    size_t n = times.size();
+    size_t workers = std::min(default_workers(), num_walkers);
+    struct Partial {
+      vector<double> squared;
+      vector<double> jumps;
+      vector<double> depth;
+      double hit_rate = 0.0;
+      Option<Error> error;
+    };
+    vector<Partial> partial(workers);
+    run_placed(workers, workers, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        auto &p = partial[i];
+        p.squared.assign(n, 0.0);
+        p.jumps.assign(n, 0.0);
+        p.depth.assign(n, 0.0);
+        TrapCache cache(m_cache_size);
+        LatticeMoves moves(m_dimension);
+        std::mt19937_64 gen(generator()());
+        size_t share =
+            (num_walkers / workers) + (i < num_walkers % workers ? 1 : 0);
+        size_t first = (i * (num_walkers / workers)) +
+                       std::min(i, num_walkers % workers);
+        for (size_t w = first; w < first + share; ++w) {
+          uint64_t seed = m_seed;
+          if (disorder == TrapDisorder::QuenchedReplicas) {
+            seed = replica_seed(w);
+            cache.clear();
+          }
+          size_t k = 0;
+          auto visit = [&](const std::array<int64_t, 3> &site, size_t jumps,
+                           double /*arrival*/, double departure,
+                           double depth) {
+            auto r2 = static_cast<double>((site[0] * site[0]) +
+                                          (site[1] * site[1]) +
+                                          (site[2] * site[2]));
+            for (; k < n && times[k] < departure; ++k) {
+              p.squared[k] += r2;
+              p.jumps[k] += static_cast<double>(jumps);
+              p.depth[k] += depth;
+            }
+            return k < n;
+          };
+          if (auto res = walk(disorder, seed, cache, moves, gen, visit);
+              !res) {
+            p.error = res.error();
+            return;
+          }
+        }
+        p.hit_rate = cache.hit_rate();
+      }
+    });
+
+    TrapStatistics result;
+    result.disorder = disorder;
+    result.num_walkers = num_walkers;
+    result.times = times;
+    result.mean_squared_displacement.assign(n, 0.0);
+    result.mean_jumps.assign(n, 0.0);
+    result.mean_depth.assign(n, 0.0);
+    auto total = static_cast<double>(num_walkers);
+    for (const auto &p : partial) {
+      if (p.error) {
+        return Err(*p.error);
+      }
+      for (size_t k = 0; k < n; ++k) {
+        result.mean_squared_displacement[k] += p.squared[k] / total;
+        result.mean_jumps[k] += p.jumps[k] / total;
+        result.mean_depth[k] += p.depth[k] / total;
+      }
+      result.cache_hit_rate += p.hit_rate / static_cast<double>(workers);
+    }
+    return Ok(std::move(result));
+  }
+};